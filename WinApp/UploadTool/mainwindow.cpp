@@ -12,11 +12,15 @@
 #include <QCloseEvent>
 
 #define UPDATE_SERVER "http://127.0.0.1:5000"
+#define FILE_LIST_PAGE 32           // 每页请求的项数，设备可能因数据报长度返回更少
+#define FILE_LIST_WINDOW 4          // 同时在途的分页请求数
+#define FILE_LIST_RETRY_MS 500      // 未收到回复时重发的间隔
 
 MainWindow::MainWindow(QWidget *parent)
         : QMainWindow(parent), ui(new Ui::MainWindow),
           tftp_process(new QProcess(this)), unzip_process(new QProcess(this)), udpSocket(new QUdpSocket(this)),
-          networkAccessManager(new QNetworkAccessManager(this)), downloadWin(new download_win()) {
+          networkAccessManager(new QNetworkAccessManager(this)), list_timer(new QTimer(this)),
+          downloadWin(new download_win()) {
     ui->setupUi(this);
 
     tftp_process->setProgram(QFileInfo("./tftp.exe").absoluteFilePath());
@@ -43,13 +47,17 @@ MainWindow::MainWindow(QWidget *parent)
     connect(downloadWin, SIGNAL(tftpDownload(const QString &, const QString &)),
             this, SLOT(tftpDownload(const QString &, const QString &)));
 
+    list_clock.start();
+    list_timer->setInterval(FILE_LIST_RETRY_MS / 2);
+    connect(list_timer, SIGNAL(timeout()), this, SLOT(fileList_timeout()));
+
     ui->textEditLog->document()->setMaximumBlockCount(200);
     on_pushButtonSetIP_clicked();
     udpSocket->bind(70);
     connect(udpSocket, SIGNAL(readyRead()),
             this, SLOT(udp_readyRead()));
     qDebug() << "tmp dir:" << temporaryDir.path();
-    udp_sendMsg(1, "0:/数字滤波器");
+    fileList_request("0:/数字滤波器");
 }
 
 MainWindow::~MainWindow() {
@@ -162,43 +170,162 @@ void MainWindow::unzip_process_finished(int exitCode, QProcess::ExitStatus exitS
 }
 
 void MainWindow::udp_readyRead() {
-    QHostAddress sender;
-    quint16 senderPort;
-    QByteArray datagram;
-    datagram.resize((int) udpSocket->pendingDatagramSize());
-    udpSocket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
-    if (datagram[0] != (char) UDP_COMM_CMD_CODE::UDP_COMM_ACK) {
-        log_printf("<font color=\"#2E86C1\">Device[%s:%d]--></font>", sender.toString().data(), senderPort);
-        log_println("<font color=\"#FF0033\">Error: %d, Message:%d</font>", datagram[0], datagram[1]);
-    }
-    uint8_t message_id = datagram[1];
-    QByteArray data = datagram.mid(2);
-    log_printf("<font color=\"#2E86C1\">Device[%s:%d]--></font>", sender.toString().data(), senderPort);
-    switch (message_id) {
-        case 0: {
-            fw_version = data;
-            log_println("<font color=\"#D4AC0D\">Firmware version: %s</font>", qUtf8Printable(fw_version));
-            update_fw();
-            break;
+    // 一次readyRead可能对应多个数据报，分页读取目录时尤其如此
+    while (udpSocket->hasPendingDatagrams()) {
+        QHostAddress sender;
+        quint16 senderPort;
+        QByteArray datagram;
+        datagram.resize((int) udpSocket->pendingDatagramSize());
+        udpSocket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
+        if (datagram.size() < 2) continue;
+
+        auto status = (uint8_t) datagram[0];
+        auto message_id = (uint8_t) datagram[1];
+        QByteArray data = datagram.mid(2);
+        log_printf("<font color=\"#2E86C1\">Device[%s:%d]--></font>", qUtf8Printable(sender.toString()), senderPort);
+        if (status != UDP_COMM_CMD_CODE::UDP_COMM_ACK) {
+            log_println("<font color=\"#FF0033\">Error: %d, Message:%d</font>", status, message_id);
+            if (message_id == 1) fileList_error(status);
+            continue;
         }
-        case 1: {
-            log_println("<font color=\"#D4AC0D\">file list</font>");
-            QJsonDocument jsonDom = QJsonDocument::fromJson(data);
-            QStringList file_list;
-            for (const auto &i: jsonDom.array())
-                file_list.append(i.toString());
-            emit receive_file_list(file_list);
+        switch (message_id) {
+            case 0: {
+                fw_version = data;
+                log_println("<font color=\"#D4AC0D\">Firmware version: %s</font>", qUtf8Printable(fw_version));
+                update_fw();
+                break;
+            }
+            case 1: {
+                QJsonDocument jsonDom = QJsonDocument::fromJson(data);
+                fileList_receive(jsonDom.object());
+                break;
+            }
         }
     }
 }
 
 void MainWindow::udp_sendMsg(uint8_t message_id, const QByteArray &data) {
+    // 目录列表需要分页读取
+    if (message_id == 1) fileList_request(QString::fromUtf8(data));
+    else udp_writeMsg(message_id, data);
+}
+
+void MainWindow::udp_writeMsg(uint8_t message_id, const QByteArray &data) {
     QByteArray _data = data;
     _data.push_front((char) message_id);
     _data.push_back('\0');
     udpSocket->writeDatagram(_data, address, 70);
 }
 
+void MainWindow::fileList_request(const QString &path) {
+    list_path = path;
+    list_id++;
+    list_end = -1;
+    list_issued = 0;
+    list_pages.clear();
+    list_pending.clear();
+    list_sent.clear();
+    fileList_issue();
+    list_timer->start();
+}
+
+void MainWindow::fileList_sendPage(quint32 offset, quint8 count) {
+    // [路径\0][offset u32][count u8][list_id u8]
+    QByteArray data = list_path.toUtf8();
+    data.push_back('\0');
+    for (int i = 0; i < 4; i++)
+        data.push_back((char) (offset >> (i * 8)));
+    data.push_back((char) count);
+    data.push_back((char) list_id);
+    list_pending[offset] = count;
+    list_sent[offset] = list_clock.elapsed();
+    udp_writeMsg(1, data);
+}
+
+void MainWindow::fileList_issue() {
+    // 不知道总数时按窗口预取，超出末尾的请求会收到空页
+    while (list_pending.size() < FILE_LIST_WINDOW && (list_end < 0 || list_issued < list_end)) {
+        fileList_sendPage(list_issued, FILE_LIST_PAGE);
+        list_issued += FILE_LIST_PAGE;
+    }
+}
+
+void MainWindow::fileList_receive(const QJsonObject &page) {
+    if (page["id"].toInt() != list_id) return;
+    auto offset = (quint32) page["offset"].toInt();
+    if (!list_pending.contains(offset)) return;
+    quint8 count = list_pending.take(offset);
+    list_sent.remove(offset);
+
+    // 设备仍在读取目录，稍后重新请求
+    if (page["pending"].toBool()) {
+        quint8 id = list_id;
+        QTimer::singleShot(100, this, [this, id, offset, count]() {
+            if (id == list_id && (list_end < 0 || offset < list_end) && !list_pending.contains(offset))
+                fileList_sendPage(offset, count);
+        });
+        return;
+    }
+
+    QStringList files;
+    for (const auto &i: page["files"].toArray())
+        files.append(i.toString());
+    if (!files.isEmpty()) list_pages[offset] = files;
+    int next = page["next"].toInt();
+    if (next < 0) {
+        list_end = page["total"].toInt();
+        // 超出目录末尾的在途请求不再需要
+        for (auto it = list_pending.begin(); it != list_pending.end();) {
+            if (it.key() >= list_end) {
+                list_sent.remove(it.key());
+                it = list_pending.erase(it);
+            } else it++;
+        }
+    } else if (next < (qint64) offset + count) {
+        // 数据报放不下时设备返回的项数少于请求，补齐剩余部分
+        fileList_sendPage(next, offset + count - next);
+    }
+    fileList_issue();
+
+    if (list_end < 0 || !list_pending.isEmpty()) return;
+    QStringList file_list;
+    qint64 pos = 0;
+    for (auto it = list_pages.cbegin(); it != list_pages.cend() && it.key() == pos; it++) {
+        file_list.append(it.value());
+        pos += it.value().size();
+    }
+    if (pos != list_end) return;
+    list_timer->stop();
+    log_println("<font color=\"#D4AC0D\">file list: %d</font>", file_list.size());
+    emit receive_file_list(file_list);
+}
+
+void MainWindow::fileList_error(uint8_t status) {
+    // 错误回复不带offset，无法对应到某一页；设备暂时分配不到回复时由定时器重发
+    if (status == UDP_COMM_CMD_CODE::UDP_COMM_ERR) return;
+    // 目录不存在或无法读取，放弃本次读取
+    list_pending.clear();
+    list_sent.clear();
+    list_timer->stop();
+    list_end = 0;
+    emit receive_file_list({});
+}
+
+void MainWindow::fileList_timeout() {
+    // 没有在途请求时(读取完成或已放弃)不需要定时重发
+    if (list_sent.isEmpty()) {
+        list_timer->stop();
+        return;
+    }
+    qint64 now = list_clock.elapsed();
+    QList<quint32> timeout;
+    for (auto it = list_sent.cbegin(); it != list_sent.cend(); it++) {
+        if (now - it.value() >= FILE_LIST_RETRY_MS) timeout.append(it.key());
+    }
+    for (quint32 offset: timeout)
+        fileList_sendPage(offset, list_pending[offset]);
+}
+
 void MainWindow::log_printf(const char *fmt, ...) {
     va_list ap;
             va_start(ap, fmt);
@@ -325,6 +452,7 @@ void MainWindow::closeEvent(QCloseEvent *event) {
         event->ignore();
         return;
     }
+    list_timer->stop();
     downloadWin->close();
     QWidget::closeEvent(event);
 }
@@ -7,6 +7,9 @@
 #include <QTemporaryDir>
 #include <QJsonArray>
 #include <QNetworkAccessManager>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QMap>
 #include "download_win.h"
 
 QT_BEGIN_NAMESPACE
@@ -58,6 +61,8 @@ private slots:
 
     void on_actionDownload_screen_shot_triggered();
 
+    void fileList_timeout();
+
 private:
     Ui::MainWindow *ui;
     QString log_buffer;
@@ -75,6 +80,17 @@ private:
     QJsonArray app_list;
     QList<tftp_uploadItem> tftp_fifo;
 
+    /* 目录分页读取，同时保持FILE_LIST_WINDOW个请求在途 */
+    QString list_path;
+    quint8 list_id = 0;
+    qint64 list_end = -1;                   //!< 目录总项数，收到最后一页前为-1
+    quint32 list_issued = 0;                //!< 下一个待请求的offset
+    QMap<quint32, QStringList> list_pages;  //!< offset -> 该页文件名
+    QMap<quint32, quint8> list_pending;     //!< 在途请求 offset -> count
+    QMap<quint32, qint64> list_sent;        //!< 在途请求发送时间
+    QElapsedTimer list_clock;
+    QTimer *list_timer;
+
     download_win *downloadWin;
 protected:
     void closeEvent(QCloseEvent *event) override;
@@ -85,6 +101,12 @@ private:
     void log_printf(const char *fmt, ...);
     void log_println(const char *fmt, ...);
     QList<MainWindow::tftp_uploadItem> searchDir(const QString &path, const QString &targetDir);
+    void udp_writeMsg(uint8_t message_id, const QByteArray &data);
+    void fileList_request(const QString &path);
+    void fileList_sendPage(quint32 offset, quint8 count);
+    void fileList_issue();
+    void fileList_receive(const QJsonObject &page);
+    void fileList_error(uint8_t status);
 
 Q_SIGNALS:
     void receive_file_list(const QStringList &list);
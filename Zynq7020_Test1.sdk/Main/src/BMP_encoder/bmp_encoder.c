@@ -6,6 +6,7 @@
 #include "src/misc/lv_color.h"
 #include "check.h"
 #include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "FileService/FileService.h"
 #include <ff.h>
 
 typedef struct {
@@ -44,7 +45,7 @@ typedef struct {
 int bmp_save(int w, int h, lv_color_t *img, const char *filename) {
     lv_color24_t *line_buf = NULL;
     FIL file;
-    FRESULT res = f_open(&file, filename, FA_WRITE | FA_CREATE_NEW);
+    FRESULT res = FileService_open(&file, filename, FA_WRITE | FA_CREATE_NEW);
     if (res != FR_OK) return XST_FAILURE;
     bmp_t bmp;
     bmp.header.bfType = 'B' | 'M' << 8;
@@ -63,7 +64,7 @@ int bmp_save(int w, int h, lv_color_t *img, const char *filename) {
     bmp.info.biClrImportant = 0;
 
     UINT bw;
-    res = f_write(&file, &bmp, sizeof(bmp_t), &bw);
+    res = FileService_write(&file, &bmp, sizeof(bmp_t), &bw);
     if (res != FR_OK || bw != sizeof(bmp_t)) goto err;
 
     UINT line_size = sizeof(lv_color24_t) * w;
@@ -77,17 +78,15 @@ int bmp_save(int w, int h, lv_color_t *img, const char *filename) {
             line_buf[j].green = line[j].ch.green;
             line_buf[j].blue = line[j].ch.blue;
         }
-        vPortEnterCritical();
-        res = f_write(&file, line_buf, line_size, &bw);
-        vPortExitCritical();
+        res = FileService_write(&file, line_buf, line_size, &bw);
         if (res != FR_OK || bw != line_size) goto err;
     }
     os_free(line_buf);
-    f_close(&file);
+    FileService_close(&file);
     return XST_SUCCESS;
 
     err:
     os_free(line_buf);
-    f_close(&file);
+    FileService_close(&file);
     return XST_FAILURE;
 }
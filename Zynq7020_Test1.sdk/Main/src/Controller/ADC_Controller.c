@@ -10,7 +10,8 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "math.h"
-#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "DMA_Driver/DMA_Mem.h"
+#include "LwIP_apps/udp_comm/udp_stream.h"
 
 #define ADC_RawToVoltage_mV(AdcData) ((AdcData) * 10000 / 256)
 #define TRIGGER_NUM_MAX 128
@@ -20,7 +21,11 @@ xSemaphoreHandle ADC_Mutex;
 static XAxiDma_BdRing *RingPtr;
 static XAxiDma_Bd *BdPtr;
 
-static int8_t ADC_OriginalData[8192] __attribute__((aligned(8)));
+#define ADC_ORIGINAL_LEN 8192
+#define ADC_DATA_RING 3
+
+static DMA_Mem_Buf ADC_Buffer;
+static int8_t *ADC_OriginalData;
 
 static int16_t trigger_level = 0;                             //!<@brief 触发电平，单位mV
 static int16_t trigger_hysteresis = 200;                      //!<@brief 触发滞回，单位mV
@@ -30,7 +35,14 @@ static int16_t trigger_position = 2048;                       //!<@brief 触发
 static int16_t trigger_num;                      //!<@brief 触发点数量
 static int16_t trigger_locate[TRIGGER_NUM_MAX];  //!<@brief 触发点位置
 
-int16_t ADC_Data[4096];
+/*
+ * 处理后的数据轮流写入环形缓冲区，网络推送直接引用其中一个，
+ * 每个流只有一帧在发送，3个槽保证总有一个既不是当前帧也不在发送中
+ */
+static int16_t ADC_Ring[ADC_DATA_RING][ADC_DATA_LEN];
+static volatile uint32_t ADC_RingBusy[ADC_DATA_RING];
+static int ADC_RingIndex;
+int16_t *ADC_Data = ADC_Ring[0];
 
 static void ADC_calibration();
 
@@ -40,9 +52,13 @@ int ADC_init_dma_channel(XAxiDma *interface) {
     RingPtr = XAxiDma_GetRxRing(interface);
     XAxiDma_BdRingEnableCyclicDMA(RingPtr);
 
+    CHECK_STATUS_RET(DMA_Mem_alloc(&ADC_Buffer, ADC_ORIGINAL_LEN, DMA_MEM_FROM_DEVICE));
+    ADC_OriginalData = ADC_Buffer.addr;
+    DMA_Mem_to_device(&ADC_Buffer, 0);
+
     CHECK_STATUS_RET(XAxiDma_BdRingAlloc(RingPtr, 1, &BdPtr));
     CHECK_STATUS_RET(XAxiDma_BdSetBufAddr(BdPtr, (UINTPTR) ADC_OriginalData));
-    CHECK_STATUS_RET(XAxiDma_BdSetLength(BdPtr, sizeof(ADC_OriginalData), RingPtr->MaxTransferLen));
+    CHECK_STATUS_RET(XAxiDma_BdSetLength(BdPtr, ADC_ORIGINAL_LEN, RingPtr->MaxTransferLen));
     XAxiDma_BdSetCtrl(BdPtr, XAXIDMA_BD_CTRL_ALL_MASK);
     XAxiDma_BdWrite(BdPtr, XAXIDMA_BD_NDESC_OFFSET, BdPtr);
     XAxiDma_BdSetId(BdPtr, (UINTPTR) ADC_OriginalData);
@@ -58,16 +74,22 @@ int ADC_init_dma_channel(XAxiDma *interface) {
     return XST_SUCCESS;
 }
 
-static bool ADC_data_copy(int16_t trigger_pos) {
-    if (trigger_pos >= trigger_position && trigger_pos < 4096 + trigger_position) {
-        for (int i = 0; i < 4096; i++) {
-            ADC_Data[i] = ADC_RawToVoltage_mV(ADC_OriginalData[i - trigger_position + trigger_pos]);
+static bool ADC_data_copy(int16_t *dst, int16_t trigger_pos) {
+    if (trigger_pos >= trigger_position && trigger_pos < ADC_DATA_LEN + trigger_position) {
+        for (int i = 0; i < ADC_DATA_LEN; i++) {
+            dst[i] = ADC_RawToVoltage_mV(ADC_OriginalData[i - trigger_position + trigger_pos]);
         }
         return true;
     } else return false;
 }
 
 static void ADC_process_data(bool *triggered) {
+    int index = ADC_RingIndex;
+    do {
+        index = (index + 1) % ADC_DATA_RING;
+    } while (__atomic_load_n(&ADC_RingBusy[index], __ATOMIC_ACQUIRE) && index != ADC_RingIndex);
+    int16_t *dst = ADC_Ring[index];
+
     bool t = false;
     int trigger_status = 0;
     int trigger_pos1 = 0;
@@ -85,7 +107,7 @@ static void ADC_process_data(bool *triggered) {
                     break;
                 case 1:
                     if (voltage > trigger_upper) {
-                        if (!t) t = ADC_data_copy(i);
+                        if (!t) t = ADC_data_copy(dst, i);
                         if (trigger_num < TRIGGER_NUM_MAX)
                             trigger_locate[trigger_num++] = i;
                         trigger_status = 0;
@@ -99,7 +121,7 @@ static void ADC_process_data(bool *triggered) {
                     if (voltage < trigger_lower)
                         trigger_status = 1;
                     else if (voltage > trigger_upper) {
-                        if (!t) t = ADC_data_copy((trigger_pos1 + i) / 2);
+                        if (!t) t = ADC_data_copy(dst, (trigger_pos1 + i) / 2);
                         if (trigger_num < TRIGGER_NUM_MAX)
                             trigger_locate[trigger_num++] = (trigger_pos1 + i) / 2;
                         trigger_status = 0;
@@ -108,8 +130,13 @@ static void ADC_process_data(bool *triggered) {
             }
         }
     }
-    if (!t) ADC_data_copy(trigger_position);
+    if (!t) ADC_data_copy(dst, trigger_position);
     if (triggered) *triggered = t;
+
+    ADC_RingIndex = index;
+    ADC_Data = dst;
+    udp_stream_publish(UDP_STREAM_ADC, dst, ADC_DATA_LEN * sizeof(int16_t),
+                       UDP_STREAM_FORMAT_INT16, ADC_SAMPLE_RATE, &ADC_RingBusy[index]);
 }
 
 int ADC_get_data_now(bool *triggered, TickType_t timeout) {
@@ -118,6 +145,7 @@ int ADC_get_data_now(bool *triggered, TickType_t timeout) {
     trigger_num = 0;
 
     /* 向ADC Packager发送启动信号 */
+    DMA_Mem_to_device(&ADC_Buffer, 0);
     SPU_SendPackPulse(ADC_PackPulse);
     do {
         vTaskDelay(1);
@@ -125,8 +153,8 @@ int ADC_get_data_now(bool *triggered, TickType_t timeout) {
         XAXIDMA_CACHE_INVALIDATE(BdPtr);
         vPortExitCritical();
         uint32_t receive_len = XAxiDma_BdGetActualLength(BdPtr, 0xffffff);
-        if (receive_len == sizeof(ADC_OriginalData)) {
-            os_DCacheInvalidateRange(ADC_OriginalData, sizeof(ADC_OriginalData));
+        if (receive_len == ADC_ORIGINAL_LEN) {
+            DMA_Mem_to_cpu(&ADC_Buffer, 0);
             ADC_process_data(triggered);
             return XST_SUCCESS;
         }
@@ -141,14 +169,15 @@ int ADC_get_data(bool *triggered) {
     XAXIDMA_CACHE_INVALIDATE(BdPtr);
     vPortExitCritical();
     uint32_t receive_len = XAxiDma_BdGetActualLength(BdPtr, 0xffffff);
-    if (receive_len == sizeof(ADC_OriginalData)) {
-        os_DCacheInvalidateRange(ADC_OriginalData, sizeof(ADC_OriginalData));
+    if (receive_len == ADC_ORIGINAL_LEN) {
+        DMA_Mem_to_cpu(&ADC_Buffer, 0);
         ADC_process_data(triggered);
     } else {
         xil_printf("warning: ADC data length is incorrect\r\n");
         status = XST_DATA_LOST;
     }
     /* 向ADC Packager发送启动信号 */
+    DMA_Mem_to_device(&ADC_Buffer, 0);
     SPU_SendPackPulse(ADC_PackPulse);
 
     return status;
@@ -158,7 +187,7 @@ float ADC_get_period() {
     if (trigger_num >= 2) {
         float diff_time_sum = 0;
         for (int i = 0; i < trigger_num - 1; i++) {
-            diff_time_sum += (trigger_locate[i + 1] - trigger_locate[i]) / 30e6;
+            diff_time_sum += (trigger_locate[i + 1] - trigger_locate[i]) / (float) ADC_SAMPLE_RATE;
         }
         return diff_time_sum / (trigger_num - 1);
     } else return NAN;
@@ -168,7 +197,7 @@ int ADC_get_max_min(float *max_p, float *min_p) {
     if (max_p == NULL || min_p == NULL)
         return XST_INVALID_PARAM;
     float max = -INFINITY, min = INFINITY;
-    for (int i = 0; i < 4096; i++) {
+    for (int i = 0; i < ADC_DATA_LEN; i++) {
         if (ADC_Data[i] > max) max = ADC_Data[i];
         if (ADC_Data[i] < min) min = ADC_Data[i];
     }
@@ -179,9 +208,9 @@ int ADC_get_max_min(float *max_p, float *min_p) {
 
 float ADC_get_mean() {
     double sum = 0;
-    for (int i = 0; i < 4096; i++)
+    for (int i = 0; i < ADC_DATA_LEN; i++)
         sum += ADC_Data[i];
-    return sum / 4096;
+    return sum / ADC_DATA_LEN;
 }
 
 float ADC_get_mean_cycle() {
@@ -195,8 +224,8 @@ float ADC_get_mean_cycle() {
 
 float ADC_get_rms() {
     double sum = 0;
-    for (int i = 0; i < 4096; i++)
-        sum += pow(ADC_Data[i], 2) / 4096;
+    for (int i = 0; i < ADC_DATA_LEN; i++)
+        sum += pow(ADC_Data[i], 2) / ADC_DATA_LEN;
     return sqrtl(sum);
 }
 
@@ -9,6 +9,9 @@
 #include "FreeRTOS.h"
 #include "semphr.h"
 
+#define ADC_SAMPLE_RATE (30000000)
+#define ADC_DATA_LEN 4096
+
 typedef enum {
     RISING_EDGE_TRIGGER = 0,
     FALLING_EDGE_TRIGGER = 1,
@@ -38,6 +41,7 @@ float ADC_get_rms_cycle();
 
 extern xSemaphoreHandle ADC_Mutex;
 
-extern int16_t ADC_Data[4096];
+/* 最近一次采集的数据，单位mV，ADC_DATA_LEN点，下次调用ADC_get_data前有效 */
+extern int16_t *ADC_Data;
 
 #endif //ZYNQ7020_ADC_CONTROLLER_H
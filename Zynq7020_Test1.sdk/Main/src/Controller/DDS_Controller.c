@@ -3,13 +3,12 @@
 //
 
 #include "DDS_Controller.h"
-#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "DMA_Driver/DMA_Mem.h"
 #include "arm_math.h"
 #include "check.h"
 
 #define USE_DDS_RAM 1
 #define DDS_RAM_LEN 0x400000
-#define DDS_RAM_ATTRIBUTE __attribute__((section(".DDS_RAM")))
 
 static inline double inRange(double _min, double _v, double _max) {
     return _v >= _max ? _max :
@@ -17,11 +16,9 @@ static inline double inRange(double _min, double _v, double _max) {
 }
 
 
-#if USE_DDS_RAM
-static int8_t DDS_BUFFER[DDS_RAM_LEN] DDS_RAM_ATTRIBUTE;
-#else
-static int8_t *DDS_BUFFER;
-static int8_t *NEW_BUFFER;
+static DMA_Mem_Buf DDS_BUFFER;
+#if !USE_DDS_RAM
+static DMA_Mem_Buf NEW_BUFFER;
 #endif
 
 static int64_t lcm(int64_t a, int64_t b) {
@@ -37,9 +34,9 @@ static int64_t lcm(int64_t a, int64_t b) {
  * 根据信号频率自动分配合适长度的缓冲区
  * @param freq 生成波形的频率
  * @param len_ptr 返回缓冲区长度
- * @return 分配的内存地址
+ * @return 分配的缓冲区，已归属CPU
  */
-static int8_t *DDS_buff_malloc(uint32_t freq, int *len_ptr) {
+static DMA_Mem_Buf *DDS_buff_malloc(uint32_t freq, int *len_ptr) {
     int len = DAC_CLK_FREQ / lcm(freq, DAC_CLK_FREQ);
 #if USE_DDS_RAM
     if (len > DDS_RAM_LEN)
@@ -53,38 +50,35 @@ static int8_t *DDS_buff_malloc(uint32_t freq, int *len_ptr) {
 
     if (len_ptr) *len_ptr = len;
 #if USE_DDS_RAM
-    return DDS_BUFFER;
-#else
-    int8_t *align_addr = NULL;
-    NEW_BUFFER = os_malloc(len + 16);
-    CHECK_FATAL_ERROR(NEW_BUFFER == NULL)
-    if (((uint32_t) NEW_BUFFER) % 8 == 0) {
-        align_addr = NEW_BUFFER;
-    } else {
-        align_addr = (int8_t *) (((uint32_t) NEW_BUFFER & ~0x07) + 0x08);
+    /* 固定缓冲区在第一次使用时分配，之后只切换归属 */
+    if (DDS_BUFFER.addr == NULL) {
+        CHECK_FATAL_ERROR(DMA_Mem_alloc(&DDS_BUFFER, DDS_RAM_LEN, DMA_MEM_TO_DEVICE) != XST_SUCCESS)
     }
-
-    return align_addr;
+    DMA_Mem_to_cpu(&DDS_BUFFER, 0);
+    return &DDS_BUFFER;
+#else
+    CHECK_FATAL_ERROR(DMA_Mem_alloc(&NEW_BUFFER, len, DMA_MEM_TO_DEVICE) != XST_SUCCESS)
+    return &NEW_BUFFER;
 #endif
 }
 
 /**
  * 替换缓冲区并启动启动DMA
- * @param buf_addr
- * @param len
+ * @param buf 缓冲区
+ * @param len 波形长度
  * @return
  */
-static int DDS_buff_replace(int8_t *buf_addr, int len) {
+static int DDS_buff_replace(DMA_Mem_Buf *buf, int len) {
     int res = XST_SUCCESS;
-    os_DCacheFlushRange(buf_addr, len);
-    res = DAC_start(buf_addr, len);
+    DMA_Mem_to_device(buf, len);
+    res = DAC_start(buf->addr, len);
 #if USE_DDS_RAM
 #else
     if (res != XST_SUCCESS) {
-        os_free(NEW_BUFFER);
+        DMA_Mem_free(&NEW_BUFFER);
         xil_printf("ERROR: File:'%s' Line:%d return %d\r\n", __FILE__, __LINE__, res);
     } else {
-        os_free(DDS_BUFFER);
+        DMA_Mem_free(&DDS_BUFFER);
         DDS_BUFFER = NEW_BUFFER;
     }
 #endif
@@ -93,7 +87,8 @@ static int DDS_buff_replace(int8_t *buf_addr, int len) {
 
 static int DDS_general_generator(DDS_sine_t *param, double (*core)(double, void *)) {
     int len = 0;
-    int8_t *align_addr = DDS_buff_malloc(param->base.freq, &len);
+    DMA_Mem_Buf *buf = DDS_buff_malloc(param->base.freq, &len);
+    int8_t *align_addr = buf->addr;
 
     double p = param->base.phase * M_PI * 2 / 3600;
     double w = M_PI * 2 * param->base.freq;
@@ -103,7 +98,7 @@ static int DDS_general_generator(DDS_sine_t *param, double (*core)(double, void
         align_addr[i] = inRange(-127, v * 256 / 1000 / 10, 127);
     }
 
-    CHECK_STATUS_RET(DDS_buff_replace(align_addr, len));
+    CHECK_STATUS_RET(DDS_buff_replace(buf, len));
     return XST_SUCCESS;
 }
 
@@ -167,20 +162,15 @@ int DDS_wav_from_data(int8_t *data, int len) {
     if (len < 512) copy = 512 / len + 1;
 #if USE_DDS_RAM
     if (len * copy >= DDS_RAM_LEN) return XST_FAILURE;
-    for(int i = 0; i < copy; i++)
-        memcpy(DDS_BUFFER + i * len, data, len);
-    return DDS_buff_replace(DDS_BUFFER, len * copy);
+    if (DDS_BUFFER.addr == NULL)
+        CHECK_STATUS_RET(DMA_Mem_alloc(&DDS_BUFFER, DDS_RAM_LEN, DMA_MEM_TO_DEVICE));
+    DMA_Mem_Buf *buf = &DDS_BUFFER;
+    DMA_Mem_to_cpu(buf, 0);
 #else
-    int8_t *align_addr = NULL;
-    NEW_BUFFER = os_malloc(len * copy + 16);
-    CHECK_FATAL_ERROR(NEW_BUFFER == NULL)
-    if (((uint32_t) NEW_BUFFER) % 8 == 0) {
-        align_addr = NEW_BUFFER;
-    } else {
-        align_addr = (int8_t *) (((uint32_t) NEW_BUFFER & ~0x07) + 0x08);
-    }
-    for(int i = 0; i < copy; i++)
-        memcpy(align_addr + i * len, data, len);
-    return DDS_buff_replace(align_addr, len * copy);
+    DMA_Mem_Buf *buf = &NEW_BUFFER;
+    CHECK_FATAL_ERROR(DMA_Mem_alloc(buf, len * copy, DMA_MEM_TO_DEVICE) != XST_SUCCESS)
 #endif
+    for(int i = 0; i < copy; i++)
+        memcpy((int8_t *) buf->addr + i * len, data, len);
+    return DDS_buff_replace(buf, len * copy);
 }
@@ -8,10 +8,21 @@
 #include "check.h"
 #include "FreeRTOS.h"
 #include "task.h"
-#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "DMA_Driver/DMA_Mem.h"
+#include "LwIP_apps/udp_comm/udp_stream.h"
+
+#define FFT_ORIGINAL_SIZE (8192 * sizeof(float))
+#define FFT_BUFFER_NUM 3
 
 static XAxiDma *dma;
-float FFT_OriginalData[8192] __attribute__((aligned(8)));
+/*
+ * DMA写入一个缓冲区时CPU读取另一个，第三个留给网络推送，
+ * 推送中的缓冲区不交给DMA
+ */
+static DMA_Mem_Buf FFT_Buffer[FFT_BUFFER_NUM];
+static volatile uint32_t FFT_BufferBusy[FFT_BUFFER_NUM];
+static int FFT_dma_index;
+float *FFT_OriginalData;
 
 
 /**
@@ -21,7 +32,12 @@ float FFT_OriginalData[8192] __attribute__((aligned(8)));
  */
 int FFT_init_dma_channel(XAxiDma *interface) {
 	dma = interface;
-	CHECK_STATUS_RET(XAxiDma_SimpleTransfer(dma, (UINTPTR)FFT_OriginalData, sizeof(FFT_OriginalData), XAXIDMA_DEVICE_TO_DMA));
+	for (int i = 0; i < FFT_BUFFER_NUM; i++)
+		CHECK_STATUS_RET(DMA_Mem_alloc(&FFT_Buffer[i], FFT_ORIGINAL_SIZE, DMA_MEM_FROM_DEVICE));
+	FFT_dma_index = 0;
+	FFT_OriginalData = FFT_Buffer[1].addr;
+	DMA_Mem_to_device(&FFT_Buffer[0], 0);
+	CHECK_STATUS_RET(XAxiDma_SimpleTransfer(dma, (UINTPTR)FFT_Buffer[0].addr, FFT_ORIGINAL_SIZE, XAXIDMA_DEVICE_TO_DMA));
     /* 向FFT Packager发送启动信号 */
     SPU_SendPackPulse(FFT_PackPulse);
     return XST_SUCCESS;
@@ -34,8 +50,21 @@ int FFT_init_dma_channel(XAxiDma *interface) {
 int FFT_get_data() {
 	int status = XST_SUCCESS;
 	if (!XAxiDma_Busy(dma, XAXIDMA_DEVICE_TO_DMA)) {
-		os_DCacheInvalidateRange((INTPTR) FFT_OriginalData, sizeof(FFT_OriginalData));
-		CHECK_STATUS_RET(XAxiDma_SimpleTransfer(dma, (UINTPTR)FFT_OriginalData, sizeof(FFT_OriginalData), XAXIDMA_DEVICE_TO_DMA));
+		/* 读取刚完成的一帧，下一个不在推送中的缓冲区交给DMA，最多一帧在推送中，总能找到 */
+		int done_index = FFT_dma_index;
+		DMA_Mem_Buf *done = &FFT_Buffer[done_index];
+		DMA_Mem_to_cpu(done, 0);
+		FFT_OriginalData = done->addr;
+		do {
+			FFT_dma_index = (FFT_dma_index + 1) % FFT_BUFFER_NUM;
+		} while (__atomic_load_n(&FFT_BufferBusy[FFT_dma_index], __ATOMIC_ACQUIRE) &&
+				 FFT_dma_index != done_index);
+		DMA_Mem_Buf *next = &FFT_Buffer[FFT_dma_index];
+		DMA_Mem_to_device(next, 0);
+		CHECK_STATUS_RET(XAxiDma_SimpleTransfer(dma, (UINTPTR)next->addr, FFT_ORIGINAL_SIZE, XAXIDMA_DEVICE_TO_DMA));
+		if (next != done)
+			udp_stream_publish(UDP_STREAM_FFT, done->addr, FFT_ORIGINAL_SIZE,
+							   UDP_STREAM_FORMAT_FLOAT, 0, &FFT_BufferBusy[done_index]);
 	} else status = XST_DEVICE_BUSY;
 	/* 向FFT Packager发送启动信号 */
 	SPU_SendPackPulse(FFT_PackPulse);
@@ -10,6 +10,7 @@
 int FFT_init_dma_channel(XAxiDma *interface);
 int FFT_get_data();
 
-extern float FFT_OriginalData[8192];
+/* 最近一帧完成的FFT数据，8192点，下次调用FFT_get_data前有效 */
+extern float *FFT_OriginalData;
 
 #endif //ZYNQ7020_FFT_CONTROLLER_H
@@ -6,12 +6,21 @@
 #include "check.h"
 #include "SPU_Controller.h"
 #include "DMA_Driver/DMA_Driver.h"
+#include <string.h>
+
+#define FIR_COE_SIZE (sizeof(uint16_t) * 33)
+
+xSemaphoreHandle FIR_Mutex;
 
 static XAxiDma *DmaInterface;
-static uint8_t fir_config __attribute__((aligned(8)));
+static DMA_Mem_Buf fir_coe;
+static DMA_Mem_Buf fir_config;
 
 int FIR_init_dma_channel(XAxiDma *interface) {
     DmaInterface = interface;
+    FIR_Mutex = xSemaphoreCreateMutex();
+    CHECK_STATUS_RET(DMA_Mem_alloc(&fir_coe, FIR_COE_SIZE, DMA_MEM_TO_DEVICE));
+    CHECK_STATUS_RET(DMA_Mem_alloc(&fir_config, 1, DMA_MEM_TO_DEVICE));
     return XST_SUCCESS;
 }
 
@@ -22,9 +31,10 @@ int FIR_reload_coe(int16_t *coe) {
             return XST_INVALID_PARAM;
     }
     SPU_SwitchChannelSource(CHANNEL_INDEX_FIR, FIR_RELOAD);
-    CHECK_STATUS_RET(DMA_send_package(DmaInterface, (UINTPTR) coe, sizeof(uint16_t) * 33));
+    memcpy(fir_coe.addr, coe, FIR_COE_SIZE);
+    CHECK_STATUS_RET(DMA_send_package(DmaInterface, &fir_coe, FIR_COE_SIZE));
     SPU_SwitchChannelSource(CHANNEL_INDEX_FIR, FIR_CONFIG);
-    CHECK_STATUS_RET(DMA_send_package(DmaInterface, (UINTPTR) &fir_config, 1));
+    CHECK_STATUS_RET(DMA_send_package(DmaInterface, &fir_config, 1));
     return XST_SUCCESS;
 }
 
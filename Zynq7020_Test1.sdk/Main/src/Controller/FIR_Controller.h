@@ -7,6 +7,8 @@
 
 #include <stdint-gcc.h>
 #include "xaxidma.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
 
 int FIR_init_dma_channel(XAxiDma *interface);
 
@@ -17,4 +19,7 @@ int FIR_init_dma_channel(XAxiDma *interface);
  */
 int FIR_reload_coe(int16_t *coe);
 
+/* 重载系数和设置移位时持有 */
+extern xSemaphoreHandle FIR_Mutex;
+
 #endif //ZYNQ7020_FIR_CONTROLLER_H
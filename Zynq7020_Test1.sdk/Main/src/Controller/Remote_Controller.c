@@ -0,0 +1,377 @@
+//
+// Created by yaoji on 2022/5/12.
+//
+
+#include "Remote_Controller.h"
+#include "ADC_Controller.h"
+#include "DDS_Controller.h"
+#include "FIR_Controller.h"
+#include "SPU_Controller.h"
+#include "LwIP_apps/udp_comm/udp_comm.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "xstatus.h"
+#include "xil_printf.h"
+#include <string.h>
+
+#define REMOTE_QUEUE_LEN        (4)
+#define REMOTE_STACK_SIZE       (1024)
+#define REMOTE_PRIORITY         (tskIDLE_PRIORITY + 2)
+
+#define REMOTE_RESP_ITEM_MAX    (3 + 4)     //!< 一条结果的最大长度
+#define REMOTE_FIR_HALF         (33)
+#define REMOTE_FIR_ORDER        (65)
+
+typedef union {
+    DDS_base_t base;
+    DDS_square_t square;
+    DDS_stair_step_t stair_step;
+} Remote_DDS;
+
+typedef struct {
+    uint8_t param;                  //!< REMOTE_PARAM_DDS_APPLY 或 REMOTE_PARAM_FIR_COE
+    union {
+        Remote_DDS dds;
+        int16_t coe[REMOTE_FIR_ORDER];
+    };
+} Remote_Job;
+
+typedef struct {
+    volatile uint32_t pending;      //!< 排队和执行中的任务数
+    volatile int32_t result;        //!< 上一次执行的结果
+} Remote_JobState;
+
+static QueueHandle_t job_queue;
+static Remote_JobState dds_state, fir_state;
+
+/* 暂存的DDS参数，REMOTE_PARAM_DDS_APPLY时生成波形 */
+static struct {
+    int32_t type;
+    int32_t freq;
+    int32_t amplitude;
+    int32_t offset;
+    int32_t phase;
+    int32_t duty_cycle;
+    int32_t rising;
+    int32_t falling;
+} dds_staged = {TYPE_SINE, 1000, 1000, 0, 0, 500, 4, 4};
+
+static inline int32_t Remote_read_i32(const uint8_t *p) {
+    return (int32_t) (p[0] | p[1] << 8 | p[2] << 16 | (uint32_t) p[3] << 24);
+}
+
+static inline void Remote_write_i32(uint8_t *p, int32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static inline bool Remote_try_take(SemaphoreHandle_t mutex) {
+    return mutex && xSemaphoreTake(mutex, 0) == pdTRUE;
+}
+
+static void Remote_task(void *pvParameters) {
+    LWIP_UNUSED_ARG(pvParameters);
+    static Remote_Job job;
+    for (;;) {
+        xQueueReceive(job_queue, &job, portMAX_DELAY);
+        Remote_JobState *state;
+        int ret;
+        if (job.param == REMOTE_PARAM_DDS_APPLY) {
+            state = &dds_state;
+            xSemaphoreTake(DAC_Mutex, portMAX_DELAY);
+            ret = DDS_wav_generator(&job.dds);
+            xSemaphoreGive(DAC_Mutex);
+        } else {
+            state = &fir_state;
+            xSemaphoreTake(FIR_Mutex, portMAX_DELAY);
+            ret = FIR_reload_coe(job.coe);
+            xSemaphoreGive(FIR_Mutex);
+        }
+        if (ret != XST_SUCCESS) xil_printf("Remote: param 0x%02x failed %d\r\n", job.param, ret);
+        state->result = ret;
+        __atomic_sub_fetch(&state->pending, 1, __ATOMIC_RELEASE);
+    }
+}
+
+static Remote_Status Remote_queue(Remote_Job *job, Remote_JobState *state) {
+    __atomic_add_fetch(&state->pending, 1, __ATOMIC_RELAXED);
+    if (xQueueSendToBack(job_queue, job, 0) != pdTRUE) {
+        __atomic_sub_fetch(&state->pending, 1, __ATOMIC_RELAXED);
+        return REMOTE_STATUS_BUSY;
+    }
+    return REMOTE_STATUS_QUEUED;
+}
+
+/**
+ * 排队中返回任务数，空闲时返回上次结果的相反数(0成功)
+ */
+static int32_t Remote_job_status(const Remote_JobState *state) {
+    uint32_t pending = state->pending;
+    return pending ? (int32_t) pending : -state->result;
+}
+
+static Remote_Status Remote_apply_dds() {
+    Remote_Job job = {.param = REMOTE_PARAM_DDS_APPLY};
+    job.dds.base.type = dds_staged.type;
+    job.dds.base.freq = dds_staged.freq;
+    job.dds.base.amplitude = dds_staged.amplitude;
+    job.dds.base.offset = dds_staged.offset;
+    job.dds.base.phase = dds_staged.phase;
+    if (dds_staged.type == TYPE_SQUARE) {
+        job.dds.square.duty_cycle = dds_staged.duty_cycle;
+    } else if (dds_staged.type == TYPE_STAIR_STEP) {
+        job.dds.stair_step.rising = dds_staged.rising;
+        job.dds.stair_step.falling = dds_staged.falling;
+    }
+    return Remote_queue(&job, &dds_state);
+}
+
+static Remote_Status Remote_reload_fir(const uint8_t *data, uint8_t len) {
+    if (len != REMOTE_FIR_HALF * sizeof(int16_t)) return REMOTE_STATUS_BAD_VALUE;
+    Remote_Job job = {.param = REMOTE_PARAM_FIR_COE};
+    for (int i = 0; i < REMOTE_FIR_HALF; i++) {
+        int16_t c = (int16_t) (data[i * 2] | data[i * 2 + 1] << 8);
+        job.coe[i] = c;
+        job.coe[REMOTE_FIR_ORDER - 1 - i] = c;
+    }
+    return Remote_queue(&job, &fir_state);
+}
+
+static Remote_Status Remote_route(Channel_Index index, int32_t channel) {
+    if (channel < 0 || channel > 1) return REMOTE_STATUS_BAD_VALUE;
+    /* 通路正被界面使用时不切换 */
+    SemaphoreHandle_t mutex = index == CHANNEL_INDEX_SCOPE ? ADC_Mutex :
+                              index == CHANNEL_INDEX_DAC ? DAC_Mutex :
+                              index == CHANNEL_INDEX_FIR ? FIR_Mutex : NULL;
+    if (mutex == NULL) {
+        SPU_SwitchChannelSource(index, channel);
+        return REMOTE_STATUS_OK;
+    }
+    if (!Remote_try_take(mutex)) return REMOTE_STATUS_BUSY;
+    SPU_SwitchChannelSource(index, channel);
+    xSemaphoreGive(mutex);
+    return REMOTE_STATUS_OK;
+}
+
+/**
+ * 触发设置与示波器采集共用ADC，采集进行中(ADC_Mutex被占用)时返回BUSY，不阻塞tcpip线程
+ */
+static Remote_Status Remote_set_trigger(uint8_t param, int32_t v) {
+    switch (param) {
+        case REMOTE_PARAM_TRIG_LEVEL:
+            if (v < -5000 || v > 5000) return REMOTE_STATUS_BAD_VALUE;
+            break;
+        case REMOTE_PARAM_TRIG_HYSTERESIS:
+            if (v < 0 || v > 10000) return REMOTE_STATUS_BAD_VALUE;
+            break;
+        case REMOTE_PARAM_TRIG_CONDITION:
+            if (v < RISING_EDGE_TRIGGER || v > AUTO_TRIGGER) return REMOTE_STATUS_BAD_VALUE;
+            break;
+        default:
+            if (v < 0 || v > ADC_DATA_LEN) return REMOTE_STATUS_BAD_VALUE;
+            break;
+    }
+    if (!Remote_try_take(ADC_Mutex)) return REMOTE_STATUS_BUSY;
+    switch (param) {
+        case REMOTE_PARAM_TRIG_LEVEL:
+            ADC_set_trigger_level(v);
+            break;
+        case REMOTE_PARAM_TRIG_HYSTERESIS:
+            ADC_set_trigger_hysteresis(v);
+            break;
+        case REMOTE_PARAM_TRIG_CONDITION:
+            ADC_set_trigger_condition(v);
+            break;
+        default:
+            ADC_set_trigger_position(v);
+            break;
+    }
+    xSemaphoreGive(ADC_Mutex);
+    return REMOTE_STATUS_OK;
+}
+
+static Remote_Status Remote_set(uint8_t param, const uint8_t *data, uint8_t len) {
+    if (param == REMOTE_PARAM_DDS_APPLY) return Remote_apply_dds();
+    if (param == REMOTE_PARAM_FIR_COE) return Remote_reload_fir(data, len);
+    if (len != 4) return REMOTE_STATUS_BAD_VALUE;
+
+    int32_t v = Remote_read_i32(data);
+    switch (param) {
+        case REMOTE_PARAM_TRIG_LEVEL:
+        case REMOTE_PARAM_TRIG_HYSTERESIS:
+        case REMOTE_PARAM_TRIG_CONDITION:
+        case REMOTE_PARAM_TRIG_POSITION:
+            return Remote_set_trigger(param, v);
+        case REMOTE_PARAM_DDS_TYPE:
+            if (v < TYPE_SINE || v >= TYPE_RAW_DATA) return REMOTE_STATUS_BAD_VALUE;
+            dds_staged.type = v;
+            break;
+        case REMOTE_PARAM_DDS_FREQ:
+            if (v < 30 || v > 5000000) return REMOTE_STATUS_BAD_VALUE;
+            dds_staged.freq = v;
+            break;
+        case REMOTE_PARAM_DDS_AMPLITUDE:
+            if (v < 0 || v > 10000) return REMOTE_STATUS_BAD_VALUE;
+            dds_staged.amplitude = v;
+            break;
+        case REMOTE_PARAM_DDS_OFFSET:
+            if (v < -5000 || v > 5000) return REMOTE_STATUS_BAD_VALUE;
+            dds_staged.offset = v;
+            break;
+        case REMOTE_PARAM_DDS_PHASE:
+            if (v < -1800 || v > 1800) return REMOTE_STATUS_BAD_VALUE;
+            dds_staged.phase = v;
+            break;
+        case REMOTE_PARAM_DDS_DUTY:
+            if (v < 0 || v > 1000) return REMOTE_STATUS_BAD_VALUE;
+            dds_staged.duty_cycle = v;
+            break;
+        case REMOTE_PARAM_DDS_RISING:
+            if (v < 1 || v > 256) return REMOTE_STATUS_BAD_VALUE;
+            dds_staged.rising = v;
+            break;
+        case REMOTE_PARAM_DDS_FALLING:
+            if (v < 1 || v > 256) return REMOTE_STATUS_BAD_VALUE;
+            dds_staged.falling = v;
+            break;
+        case REMOTE_PARAM_FIR_SHIFT:
+            if (v < 0 || v > 24) return REMOTE_STATUS_BAD_VALUE;
+            if (!Remote_try_take(FIR_Mutex)) return REMOTE_STATUS_BUSY;
+            SPU_SetFirShift(v);
+            xSemaphoreGive(FIR_Mutex);
+            break;
+        case REMOTE_PARAM_ROUTE_DAC:
+            return Remote_route(CHANNEL_INDEX_DAC, v);
+        case REMOTE_PARAM_ROUTE_FFT:
+            return Remote_route(CHANNEL_INDEX_FFT, v);
+        case REMOTE_PARAM_ROUTE_SCOPE:
+            return Remote_route(CHANNEL_INDEX_SCOPE, v);
+        case REMOTE_PARAM_ROUTE_FIR:
+            return Remote_route(CHANNEL_INDEX_FIR, v);
+        default:
+            return REMOTE_STATUS_UNKNOWN_PARAM;
+    }
+    return REMOTE_STATUS_OK;
+}
+
+static Remote_Status Remote_get(uint8_t param, int32_t *v) {
+    switch (param) {
+        case REMOTE_PARAM_TRIG_LEVEL:
+            *v = ADC_get_trigger_level();
+            break;
+        case REMOTE_PARAM_TRIG_HYSTERESIS:
+            *v = ADC_get_trigger_hysteresis();
+            break;
+        case REMOTE_PARAM_TRIG_CONDITION:
+            *v = ADC_get_trigger_condition();
+            break;
+        case REMOTE_PARAM_TRIG_POSITION:
+            *v = ADC_get_trigger_position();
+            break;
+        case REMOTE_PARAM_DDS_TYPE:
+            *v = dds_staged.type;
+            break;
+        case REMOTE_PARAM_DDS_FREQ:
+            *v = dds_staged.freq;
+            break;
+        case REMOTE_PARAM_DDS_AMPLITUDE:
+            *v = dds_staged.amplitude;
+            break;
+        case REMOTE_PARAM_DDS_OFFSET:
+            *v = dds_staged.offset;
+            break;
+        case REMOTE_PARAM_DDS_PHASE:
+            *v = dds_staged.phase;
+            break;
+        case REMOTE_PARAM_DDS_DUTY:
+            *v = dds_staged.duty_cycle;
+            break;
+        case REMOTE_PARAM_DDS_RISING:
+            *v = dds_staged.rising;
+            break;
+        case REMOTE_PARAM_DDS_FALLING:
+            *v = dds_staged.falling;
+            break;
+        case REMOTE_PARAM_DDS_APPLY:
+            *v = Remote_job_status(&dds_state);
+            break;
+        case REMOTE_PARAM_FIR_COE:
+            *v = Remote_job_status(&fir_state);
+            break;
+        case REMOTE_PARAM_FIR_SHIFT:
+            *v = SPU_GetFirShift();
+            break;
+        case REMOTE_PARAM_ROUTE_DAC:
+            *v = SPU_GetChannelSource(CHANNEL_INDEX_DAC);
+            break;
+        case REMOTE_PARAM_ROUTE_FFT:
+            *v = SPU_GetChannelSource(CHANNEL_INDEX_FFT);
+            break;
+        case REMOTE_PARAM_ROUTE_SCOPE:
+            *v = SPU_GetChannelSource(CHANNEL_INDEX_SCOPE);
+            break;
+        case REMOTE_PARAM_ROUTE_FIR:
+            *v = SPU_GetChannelSource(CHANNEL_INDEX_FIR);
+            break;
+        default:
+            return REMOTE_STATUS_UNKNOWN_PARAM;
+    }
+    return REMOTE_STATUS_OK;
+}
+
+static struct pbuf *remote_command_id6(struct pbuf *p) {
+    const uint8_t *req = p->payload;
+    if (p->len < 4) return send_err(UDP_COMM_ERR, REMOTE_MSG_ID);
+    uint8_t n = req[3];
+
+    uint8_t *resp;
+    struct pbuf *ret = udp_comm_alloc_resp(REMOTE_MSG_ID, 3 + n * REMOTE_RESP_ITEM_MAX, (void **) &resp);
+    if (ret == NULL) return send_err(UDP_COMM_ERR, REMOTE_MSG_ID);
+    resp[0] = req[1];
+    resp[1] = req[2];
+
+    uint32_t pos = 4, out = 3;
+    int i;
+    for (i = 0; i < n; i++) {
+        if (pos + 3 > p->len) break;
+        uint8_t op = req[pos], param = req[pos + 1], len = req[pos + 2];
+        const uint8_t *value = req + pos + 3;
+        if (pos + 3 + len > p->len) break;
+        pos += 3 + len;
+
+        int32_t v;
+        Remote_Status status;
+        if (op == REMOTE_OP_GET) status = Remote_get(param, &v);
+        else if (op == REMOTE_OP_SET) status = Remote_set(param, value, len);
+        else status = REMOTE_STATUS_UNSUPPORTED;
+
+        resp[out] = param;
+        resp[out + 1] = status;
+        if (op == REMOTE_OP_GET && status == REMOTE_STATUS_OK) {
+            resp[out + 2] = 4;
+            Remote_write_i32(resp + out + 3, v);
+            out += 7;
+        } else {
+            resp[out + 2] = 0;
+            out += 3;
+        }
+    }
+    /* 请求被截断时只回复完整解析的命令 */
+    resp[2] = i;
+    pbuf_realloc(ret, UDP_COMM_HEAD_LEN + out);
+    return ret;
+}
+
+int Remote_controller_init() {
+    job_queue = xQueueCreate(REMOTE_QUEUE_LEN, sizeof(Remote_Job));
+    if (job_queue == NULL) return XST_FAILURE;
+    if (xTaskCreate(Remote_task, "Remote", REMOTE_STACK_SIZE,
+                    NULL, REMOTE_PRIORITY, NULL) != pdPASS)
+        return XST_FAILURE;
+    udp_comm_RegMegProcessor(REMOTE_MSG_ID, remote_command_id6);
+    return XST_SUCCESS;
+}
@@ -0,0 +1,66 @@
+//
+// Created by yaoji on 2022/5/12.
+//
+
+#ifndef ZYNQ7020_REMOTE_CONTROLLER_H
+#define ZYNQ7020_REMOTE_CONTROLLER_H
+
+#include <stdint.h>
+
+/**
+ * 二进制远程控制
+ * 请求 [6][seq u16][n u8] 后跟n条命令 {op u8, param u8, len u8, value[len]}
+ * 回复 [ACK][6][seq u16][n u8] 后跟n条结果 {param u8, status u8, len u8, value[len]}
+ * 多字节数值均为小端，标量参数的value为4字节有符号整数，set的回复不带value，get的回复带当前值。
+ * 开销小的参数在协议栈线程中直接设置，DDS生成和FIR重载交给后台任务，回复REMOTE_STATUS_QUEUED，
+ * 可以读取REMOTE_PARAM_DDS_APPLY/REMOTE_PARAM_FIR_COE查询后台任务是否完成
+ */
+
+#define REMOTE_MSG_ID 6
+
+typedef enum {
+    REMOTE_OP_GET = 0,
+    REMOTE_OP_SET = 1,
+} Remote_Op;
+
+typedef enum {
+    REMOTE_STATUS_OK = 0,
+    REMOTE_STATUS_QUEUED = 1,           //!< 已交给后台任务
+    REMOTE_STATUS_UNKNOWN_PARAM = 2,
+    REMOTE_STATUS_BAD_VALUE = 3,
+    REMOTE_STATUS_BUSY = 4,             //!< 资源被界面占用或后台任务队列已满
+    REMOTE_STATUS_UNSUPPORTED = 5,      //!< 参数不支持该操作
+} Remote_Status;
+
+typedef enum {
+    REMOTE_PARAM_TRIG_LEVEL = 0x01,     //!< 触发电平 mV
+    REMOTE_PARAM_TRIG_HYSTERESIS = 0x02,//!< 触发滞回 mV
+    REMOTE_PARAM_TRIG_CONDITION = 0x03, //!< trigger_condition_e
+    REMOTE_PARAM_TRIG_POSITION = 0x04,  //!< 触发位置 采样点
+
+    REMOTE_PARAM_DDS_TYPE = 0x10,       //!< 波形类型，不支持TYPE_RAW_DATA
+    REMOTE_PARAM_DDS_FREQ = 0x11,       //!< 频率 Hz
+    REMOTE_PARAM_DDS_AMPLITUDE = 0x12,  //!< 峰峰值 mV
+    REMOTE_PARAM_DDS_OFFSET = 0x13,     //!< 偏置 mV
+    REMOTE_PARAM_DDS_PHASE = 0x14,      //!< 相位 0.1°，-1800~1800
+    REMOTE_PARAM_DDS_DUTY = 0x15,       //!< 方波占空比 0.1%
+    REMOTE_PARAM_DDS_RISING = 0x16,     //!< 阶梯波上升台阶数
+    REMOTE_PARAM_DDS_FALLING = 0x17,    //!< 阶梯波下降台阶数
+    REMOTE_PARAM_DDS_APPLY = 0x18,      //!< set按暂存的DDS参数生成波形，get返回后台任务是否忙
+
+    REMOTE_PARAM_FIR_COE = 0x20,        //!< set 33个int16系数(前32个加中心)，按偶对称补全为65阶；get返回后台任务是否忙
+    REMOTE_PARAM_FIR_SHIFT = 0x21,      //!< FIR输出移位
+
+    REMOTE_PARAM_ROUTE_DAC = 0x30,      //!< DAC_Channel
+    REMOTE_PARAM_ROUTE_FFT = 0x31,      //!< FFT_Channel
+    REMOTE_PARAM_ROUTE_SCOPE = 0x32,    //!< Scope_Channel
+    REMOTE_PARAM_ROUTE_FIR = 0x33,      //!< FIR_Channel
+} Remote_Param;
+
+/**
+ * 创建后台任务并注册远程控制消息，在udp_comm_controller_init中调用
+ * @return XST_SUCCESS 或 XST_FAILURE
+ */
+int Remote_controller_init();
+
+#endif //ZYNQ7020_REMOTE_CONTROLLER_H
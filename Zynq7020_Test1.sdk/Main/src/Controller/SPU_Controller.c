@@ -37,6 +37,20 @@ void SPU_SwitchChannelSource(Channel_Index index, int channel) {
     }
 }
 
+int SPU_GetChannelSource(Channel_Index index) {
+    switch (index) {
+        case CHANNEL_INDEX_DAC:
+            return AXI4IO->DAC_SignalSwitch;
+        case CHANNEL_INDEX_FFT:
+            return AXI4IO->FFT_SignalSwitch;
+        case CHANNEL_INDEX_SCOPE:
+            return AXI4IO->ADC_SignalSwitch;
+        case CHANNEL_INDEX_FIR:
+            return AXI4IO->FIR_SignalSwitch;
+    }
+    return -1;
+}
+
 void SPU_SendPackPulse(Pulse_Type pulseType) {
     switch (pulseType) {
         case ADC_PackPulse:
@@ -61,3 +75,7 @@ void SPU_SetDacOffset(int32_t offset) {
 void SPU_SetFirShift(uint32_t shift) {
     AXI4IO->FIR_Shift = shift;
 }
+
+uint32_t SPU_GetFirShift() {
+    return AXI4IO->FIR_Shift;
+}
@@ -43,9 +43,11 @@ typedef enum {
 } Scope_Channel;
 
 void SPU_SwitchChannelSource(Channel_Index index, int channel);
+int SPU_GetChannelSource(Channel_Index index);
 void SPU_SendPackPulse(Pulse_Type pulseType);
 void SPU_SetAdcOffset(int32_t offset);
 void SPU_SetDacOffset(int32_t offset);
 void SPU_SetFirShift(uint32_t shift);
+uint32_t SPU_GetFirShift();
 
 #endif //ZYNQ7020_SPU_CONTROLLER_H
@@ -4,53 +4,268 @@
  */
 
 #include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
 #include "UDP_comm_Controller.h"
 #include "SystemConfig/SystemConfig.h"
 #include "Fatfs_init/Fatfs_Driver.h"
+#include "Fatfs_init/Encoding.h"
+#include "FileService/DirSnapshot.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "DMA_Driver/DMA_Mem.h"
+#include "LwIP_apps/udp_comm/udp_stream.h"
+#include "Remote_Controller.h"
+#include "LVGL_Zynq_Init/zynq_lvgl_init.h"
+#include "xstatus.h"
+#include "xil_printf.h"
 #include "cJSON.h"
 
+#define MEM_STATS_TASK_MAX 24
+#define FILE_LIST_PAGE_DEFAULT 32
+#define FILE_LIST_RESP_MAX 1400         //!< 目录分页回复的最大长度，不超过一个以太网帧
+#define FILE_LIST_SUFFIX_MAX 64         //!< 为回复结尾预留的长度
+
 static struct pbuf *get_firmware_version_id0(struct pbuf *p) {
     LWIP_UNUSED_ARG(p);
     const char *version = getFirmwareVersion();
-    return send_data(0, version, strlen(version) + 1);
+    return send_data_ref(0, version, strlen(version) + 1);
 }
 
-static struct pbuf *get_filename_id1(struct pbuf *p) {
-    DIR dir;
-    cJSON *array = cJSON_CreateArray();
-    if (array == NULL) goto err;
+/**
+ * 写入一个JSON字符串，放不下时返回-1
+ */
+static int json_write_string(char *dst, int size, const char *str) {
+    int len = 0;
+    if (size < 2) return -1;
+    dst[len++] = '"';
+    for (; *str; str++) {
+        unsigned char c = *str;
+        if (size - len < 8) return -1;
+        if (c == '"' || c == '\\') {
+            dst[len++] = '\\';
+            dst[len++] = c;
+        } else if (c < 0x20) {
+            len += snprintf(dst + len, size - len, "\\u%04x", c);
+        } else dst[len++] = c;
+    }
+    if (size - len < 1) return -1;
+    dst[len++] = '"';
+    return len;
+}
 
+/**
+ * 分页读取目录
+ * 请求 [1][UTF-8路径\0][offset u32][count u8][list_id u8]，路径后的字段可省略，默认从0开始取FILE_LIST_PAGE_DEFAULT项
+ * 回复 {"id":list_id,"offset":offset,"files":[...],"next":下一页offset或-1,"pending":目录仍在读取且没有新项,
+ *       "total":目录项总数，读取完成前为-1}
+ * 逐项写入回复缓冲区，不构造完整列表，写满一个数据报或取满count项即返回
+ */
+static struct pbuf *get_filename_id1(struct pbuf *p) {
     char *data = p->payload;
-    if (data[p->len - 1] != 0) goto err;
+    char *path = data + 1;
+    char *path_end = memchr(path, 0, p->len - 1);
+    if (path_end == NULL) return send_err(4, 1);
 
-    char *gbk = UTF8_TO_GBK(data + 1);
-    FRESULT res = f_opendir(&dir, gbk);
-    os_free(gbk);
-    if (res != FR_OK) goto err;
+    uint32_t offset = 0;
+    uint32_t count = FILE_LIST_PAGE_DEFAULT;
+    uint8_t list_id = 0;
+    uint8_t *arg = (uint8_t *) path_end + 1;
+    if (arg + 6 <= (uint8_t *) data + p->len) {
+        offset = arg[0] | arg[1] << 8 | arg[2] << 16 | (uint32_t) arg[3] << 24;
+        if (arg[4]) count = arg[4];
+        list_id = arg[5];
+    }
 
-    while (1) {
-        FILINFO file_info;
-        res = f_readdir(&dir, &file_info);
-        if (res != FR_OK || file_info.fname[0] == 0) break;
-        char *utf8 = GBK_TO_UTF8(file_info.fname);
-        cJSON_AddItemToArray(array, cJSON_CreateString(utf8));
-        os_free(utf8);
+    DirSnapshot *snap = DirSnapshot_open(path);
+    if (snap == NULL) return send_err(4, 1);
+    uint8_t complete = snap->complete;
+    if (complete && snap->result != FR_OK) {
+        DirSnapshot_release(snap);
+        return send_err(4, 1);
     }
-    f_closedir(&dir);
 
-    char *json_str = cJSON_PrintUnformatted(array);
-    if (json_str == NULL) goto err;
-    printf("%s\r\n", json_str);
-    struct pbuf *ret = send_data(1, json_str, strlen(json_str));
-    cJSON_Delete(array);
-    cJSON_free(json_str);
+    char *buf;
+    struct pbuf *ret = udp_comm_alloc_resp(1, FILE_LIST_RESP_MAX, (void **) &buf);
+    if (ret == NULL) {
+        DirSnapshot_release(snap);
+        return send_err(UDP_COMM_ERR, 1);
+    }
+
+    // 只在UDP回调中使用，不需要放在栈上
+    static char utf8[ENCODING_GBK_TO_UTF8_SIZE(FF_MAX_LFN)];
+    const int limit = FILE_LIST_RESP_MAX - FILE_LIST_SUFFIX_MAX;
+    int len = snprintf(buf, limit, "{\"id\":%u,\"offset\":%u,\"files\":[", list_id, (unsigned) offset);
+    uint32_t index = offset;
+    for (; index < offset + count; index++) {
+        if (!DirSnapshot_get(snap, index, utf8, sizeof(utf8), NULL)) break;
+        if (index != offset) {
+            if (len >= limit) break;
+            buf[len++] = ',';
+        }
+        int n = json_write_string(buf + len, limit - len, utf8);
+        if (n < 0) {
+            if (index != offset) len--;
+            break;
+        }
+        len += n;
+    }
+
+    long total = complete ? (long) snap->count : -1;
+    long next = (complete && index >= snap->count) ? -1 : (long) index;
+    bool pending = !complete && index == offset;
+    DirSnapshot_release(snap);
+    len += snprintf(buf + len, FILE_LIST_RESP_MAX - len, "],\"next\":%ld,\"pending\":%s,\"total\":%ld}",
+                    next, pending ? "true" : "false", total);
+    pbuf_realloc(ret, UDP_COMM_HEAD_LEN + len);
     return ret;
+}
+
+static struct pbuf *get_mem_stats_id2(struct pbuf *p) {
+    LWIP_UNUSED_ARG(p);
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) goto err;
+
+    cJSON *tags = cJSON_AddArrayToObject(root, "tags");
+    for (int i = 0; i < OS_MEM_TAG_NUM; i++) {
+        os_mem_tag_stats_t tag_stats;
+        os_mem_get_tag_stats(i, &tag_stats);
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", os_mem_tag_name(i));
+        cJSON_AddNumberToObject(item, "used", tag_stats.used);
+        cJSON_AddNumberToObject(item, "peak", tag_stats.peak);
+        cJSON_AddNumberToObject(item, "count", tag_stats.count);
+        cJSON_AddItemToArray(tags, item);
+    }
+
+    os_mem_stats_t mem;
+    os_mem_get_stats(&mem);
+    cJSON *heap = cJSON_AddObjectToObject(root, "heap");
+    cJSON_AddNumberToObject(heap, "small_reserved", mem.small_reserved);
+    cJSON_AddNumberToObject(heap, "small_used", mem.small_used);
+    cJSON_AddNumberToObject(heap, "small_peak", mem.small_peak);
+    cJSON_AddNumberToObject(heap, "large_total", mem.large_total);
+    cJSON_AddNumberToObject(heap, "large_used", mem.large_used);
+    cJSON_AddNumberToObject(heap, "large_peak", mem.large_peak);
+    cJSON_AddNumberToObject(heap, "largest_free", mem.large_free_max);
+    cJSON_AddNumberToObject(heap, "fragmentation", mem.fragmentation);
+
+    DMA_Mem_Stats dma_stats;
+    DMA_Mem_get_stats(&dma_stats);
+    cJSON *dma = cJSON_AddObjectToObject(root, "dma");
+    cJSON_AddNumberToObject(dma, "total", DMA_MEM_SIZE);
+    cJSON_AddNumberToObject(dma, "used", dma_stats.used);
+    cJSON_AddNumberToObject(dma, "peak", dma_stats.peak);
+
+    lv_user_font_cache_stats_t font_stats;
+    lv_user_font_get_cache_stats(&font_stats);
+    cJSON *font = cJSON_AddObjectToObject(root, "font_cache");
+    cJSON_AddNumberToObject(font, "budget", font_stats.budget);
+    cJSON_AddNumberToObject(font, "used", font_stats.used);
+    cJSON_AddNumberToObject(font, "tables", font_stats.table_size);
+    cJSON_AddNumberToObject(font, "glyphs", font_stats.glyphs);
+    cJSON_AddNumberToObject(font, "hits", font_stats.hits);
+    cJSON_AddNumberToObject(font, "misses", font_stats.misses);
+    cJSON_AddNumberToObject(font, "evictions", font_stats.evictions);
+
+    // 只在UDP回调中使用，不需要放在栈上
+    static os_mem_task_stack_t stacks[MEM_STATS_TASK_MAX];
+    int task_num = os_mem_get_task_stacks(stacks, MEM_STATS_TASK_MAX);
+    cJSON *tasks = cJSON_AddArrayToObject(root, "tasks");
+    for (int i = 0; i < task_num; i++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", stacks[i].name);
+        cJSON_AddNumberToObject(item, "priority", stacks[i].priority);
+        cJSON_AddNumberToObject(item, "stack_free", stacks[i].free_min);
+        cJSON_AddItemToArray(tasks, item);
+    }
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    if (json_str == NULL) goto err;
+    cJSON_Delete(root);
+    return send_data_take(2, json_str, strlen(json_str), cJSON_free);
+    err:
+    cJSON_Delete(root);
+    return send_err(4, 2);
+}
+
+/**
+ * 消息处理耗时统计，之后是各波形流的推送和丢弃计数
+ * 回复 [{"id","count","last_us","max_us","avg_us"}..., {"stream","frames","busy_drops","frag_drops"}...]
+ */
+static struct pbuf *get_msg_stats_id3(struct pbuf *p) {
+    LWIP_UNUSED_ARG(p);
+    cJSON *root = cJSON_CreateArray();
+    if (root == NULL) goto err;
+
+    for (int id = 0; id < 256; id++) {
+        udp_comm_stats_t stats;
+        udp_comm_get_stats(id, &stats);
+        if (stats.count == 0) continue;
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "id", id);
+        cJSON_AddNumberToObject(item, "count", stats.count);
+        cJSON_AddNumberToObject(item, "last_us", stats.last_us);
+        cJSON_AddNumberToObject(item, "max_us", stats.max_us);
+        cJSON_AddNumberToObject(item, "avg_us", (double) stats.total_us / stats.count);
+        cJSON_AddItemToArray(root, item);
+    }
+    for (int stream = 0; stream < UDP_STREAM_NUM; stream++) {
+        udp_stream_stats_t stats;
+        udp_stream_get_stats(stream, &stats);
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "stream", stream);
+        cJSON_AddNumberToObject(item, "frames", stats.frames);
+        cJSON_AddNumberToObject(item, "busy_drops", stats.busy_drops);
+        cJSON_AddNumberToObject(item, "frag_drops", stats.frag_drops);
+        cJSON_AddItemToArray(root, item);
+    }
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    if (json_str == NULL) goto err;
+    cJSON_Delete(root);
+    return send_data_take(3, json_str, strlen(json_str), cJSON_free);
+    err:
+    cJSON_Delete(root);
+    return send_err(4, 3);
+}
+
+/**
+ * 帧耗时统计
+ * 请求 [7][目标帧率 u8]，帧率可省略，给出时先设置目标帧率
+ */
+static struct pbuf *get_frame_stats_id7(struct pbuf *p) {
+    if (p->len >= 2) zynq_lvgl_set_target_fps(((uint8_t *) p->payload)[1]);
+
+    zynq_lvgl_frame_stats_t stats;
+    zynq_lvgl_get_frame_stats(&stats);
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) goto err;
+    cJSON_AddNumberToObject(root, "target_fps", stats.target_fps);
+    cJSON_AddNumberToObject(root, "fps", stats.fps);
+    cJSON_AddNumberToObject(root, "frames", stats.frames);
+    cJSON_AddNumberToObject(root, "skipped", stats.skipped);
+    cJSON_AddNumberToObject(root, "timers_us", stats.timers_us);
+    cJSON_AddNumberToObject(root, "layout_us", stats.layout_us);
+    cJSON_AddNumberToObject(root, "draw_us", stats.draw_us);
+    cJSON_AddNumberToObject(root, "flush_us", stats.flush_us);
+    cJSON_AddNumberToObject(root, "frame_max_us", stats.frame_max_us);
+
+    char *json_str = cJSON_PrintUnformatted(root);
+    if (json_str == NULL) goto err;
+    cJSON_Delete(root);
+    return send_data_take(7, json_str, strlen(json_str), cJSON_free);
     err:
-    cJSON_Delete(array);
-    return send_err(4, 1);
+    cJSON_Delete(root);
+    return send_err(4, 7);
 }
 
 void udp_comm_controller_init() {
     udp_comm_RegMegProcessor(0, get_firmware_version_id0);
     udp_comm_RegMegProcessor(1, get_filename_id1);
+    udp_comm_RegMegProcessor(2, get_mem_stats_id2);
+    udp_comm_RegMegProcessor(3, get_msg_stats_id3);
+    udp_comm_RegMegProcessor(7, get_frame_stats_id7);
+    udp_stream_init();
+    if (Remote_controller_init() != XST_SUCCESS)
+        xil_printf("Remote controller init failed\r\n");
 }
@@ -102,20 +102,22 @@ void XAxiDma_MM2SIntrHandler(void *param) {
     }
 }
 
-int DMA_send_package(XAxiDma *InstancePtr, UINTPTR data, size_t size) {
+int DMA_send_package(XAxiDma *InstancePtr, DMA_Mem_Buf *buf, size_t size) {
     int status = XST_SUCCESS;
+    DMA_Mem_to_device(buf, size);
     vPortEnterCritical();
-    Xil_DCacheFlushRange(data, size);
-    status = XAxiDma_SimpleTransfer(InstancePtr, data, size, XAXIDMA_DMA_TO_DEVICE);
+    status = XAxiDma_SimpleTransfer(InstancePtr, (UINTPTR) buf->addr, size, XAXIDMA_DMA_TO_DEVICE);
 
     int start_time_ms = getTime_millis();
     while (XAxiDma_Busy(InstancePtr, XAXIDMA_DMA_TO_DEVICE)) {
         if (getTime_millis() - start_time_ms > 5) {
             vPortExitCritical();
+            DMA_Mem_to_cpu(buf, size);
             return XST_FAILURE;
         }
     }
 
     vPortExitCritical();
+    DMA_Mem_to_cpu(buf, size);
     return status;
 }
@@ -0,0 +1,109 @@
+//
+// Created by yaoji on 2022/5/9.
+//
+
+#include "DMA_Mem.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "xstatus.h"
+#include "xil_printf.h"
+#include "src/misc/lv_tlsf.h"
+#include <string.h>
+
+/*
+ * TLSF的块头位于块前一个缓存行的末尾，而缓冲区长度按缓存行对齐，
+ * 所以块头和其他缓冲区都不会落在某个缓冲区的缓存行内
+ */
+static uint8_t dma_ram[DMA_MEM_SIZE] __attribute__((section(".DMA_RAM"), aligned(DMA_MEM_ALIGN)));
+
+static lv_tlsf_t tlsf;
+static DMA_Mem_Stats stats;
+
+#define DMA_MEM_ROUND_UP(x) (((x) + DMA_MEM_ALIGN - 1) & ~(DMA_MEM_ALIGN - 1))
+
+int DMA_Mem_init() {
+    if (tlsf) return XST_SUCCESS;
+    tlsf = lv_tlsf_create_with_pool(dma_ram, sizeof(dma_ram));
+    if (tlsf == NULL) {
+        xil_printf("DMA_Mem: create pool failed\r\n");
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+int DMA_Mem_alloc(DMA_Mem_Buf *buf, size_t size, DMA_Mem_Dir dir) {
+    if (buf == NULL || size == 0 || tlsf == NULL) return XST_FAILURE;
+    size = DMA_MEM_ROUND_UP(size);
+
+    vTaskSuspendAll();
+    void *addr = lv_tlsf_memalign(tlsf, DMA_MEM_ALIGN, size);
+    if (addr) {
+        stats.used += size;
+        if (stats.used > stats.peak) stats.peak = stats.used;
+    }
+    xTaskResumeAll();
+    if (addr == NULL) {
+        xil_printf("DMA_Mem: alloc %d bytes failed\r\n", (int) size);
+        return XST_FAILURE;
+    }
+
+    /* 清掉之前使用者可能留下的脏行，此后只在归属切换时维护缓存 */
+    memset(addr, 0, size);
+    os_DCacheFlushRange(addr, size);
+
+    buf->addr = addr;
+    buf->size = size;
+    buf->dir = dir;
+    buf->owner = DMA_MEM_OWNER_CPU;
+    return XST_SUCCESS;
+}
+
+void DMA_Mem_free(DMA_Mem_Buf *buf) {
+    if (buf == NULL || buf->addr == NULL) return;
+    vTaskSuspendAll();
+    lv_tlsf_free(tlsf, buf->addr);
+    stats.used -= buf->size;
+    xTaskResumeAll();
+    buf->addr = NULL;
+    buf->size = 0;
+}
+
+static inline uint32_t DMA_Mem_sync_len(const DMA_Mem_Buf *buf, size_t len) {
+    if (len == 0 || len > buf->size) return buf->size;
+    return DMA_MEM_ROUND_UP(len);
+}
+
+void DMA_Mem_to_device(DMA_Mem_Buf *buf, size_t len) {
+    if (buf->owner == DMA_MEM_OWNER_DEVICE) {
+        __atomic_add_fetch(&stats.skipped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    /* FROM_DEVICE缓冲区CPU只读，缓存中没有脏行，不需要维护 */
+    if (buf->dir != DMA_MEM_FROM_DEVICE) {
+        uint32_t n = DMA_Mem_sync_len(buf, len);
+        os_DCacheFlushRange(buf->addr, n);
+        __atomic_add_fetch(&stats.flush_bytes, n, __ATOMIC_RELAXED);
+    }
+    buf->owner = DMA_MEM_OWNER_DEVICE;
+}
+
+void DMA_Mem_to_cpu(DMA_Mem_Buf *buf, size_t len) {
+    if (buf->owner == DMA_MEM_OWNER_CPU) {
+        __atomic_add_fetch(&stats.skipped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    /* 设备写入期间CPU可能预取了旧数据，交还时必须Invalidate */
+    if (buf->dir != DMA_MEM_TO_DEVICE) {
+        uint32_t n = DMA_Mem_sync_len(buf, len);
+        os_DCacheInvalidateRange(buf->addr, n);
+        __atomic_add_fetch(&stats.invalidate_bytes, n, __ATOMIC_RELAXED);
+    }
+    buf->owner = DMA_MEM_OWNER_CPU;
+}
+
+void DMA_Mem_get_stats(DMA_Mem_Stats *s) {
+    vTaskSuspendAll();
+    *s = stats;
+    xTaskResumeAll();
+}
@@ -0,0 +1,89 @@
+//
+// Created by yaoji on 2022/5/9.
+//
+
+#ifndef ZYNQ7020_DMA_MEM_H
+#define ZYNQ7020_DMA_MEM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * DMA缓冲区管理
+ * 从链接脚本保留的.DMA_RAM段分配，起始地址和长度都按缓存行对齐，
+ * 缓冲区所在的缓存行不与其他数据共享，Invalidate不会破坏相邻数据。
+ * 缓冲区记录当前归属(CPU/设备)，只在归属切换时按传输方向做缓存维护，
+ * 重复的切换调用直接返回
+ */
+
+#define DMA_MEM_ALIGN 32                    //!< Cortex-A9 L1/L2缓存行长度
+#define DMA_MEM_SIZE (8 * 1024 * 1024)      //!< 与链接脚本中ps7_dma_ram长度一致
+
+typedef enum {
+    DMA_MEM_TO_DEVICE,      //!< CPU写，设备读：交给设备前Flush
+    DMA_MEM_FROM_DEVICE,    //!< 设备写，CPU读：交还CPU后Invalidate，CPU不得写入
+    DMA_MEM_BIDIRECTIONAL,  //!< 双向：交给设备前Flush，交还CPU后Invalidate
+} DMA_Mem_Dir;
+
+typedef enum {
+    DMA_MEM_OWNER_CPU,
+    DMA_MEM_OWNER_DEVICE,
+} DMA_Mem_Owner;
+
+typedef struct {
+    void *addr;                     //!< 缓冲区地址，DMA_MEM_ALIGN对齐
+    uint32_t size;                  //!< 缓冲区长度，DMA_MEM_ALIGN的整数倍
+    DMA_Mem_Dir dir;
+    volatile DMA_Mem_Owner owner;
+} DMA_Mem_Buf;
+
+typedef struct {
+    uint32_t used;          //!< 已分配字节数
+    uint32_t peak;          //!< 分配峰值
+    uint32_t flush_bytes;   //!< 累计Flush字节数
+    uint32_t invalidate_bytes;  //!< 累计Invalidate字节数
+    uint32_t skipped;       //!< 归属未变化而跳过的切换次数
+} DMA_Mem_Stats;
+
+/**
+ * 初始化DMA内存池，需要在分配DMA缓冲区之前调用
+ * @return XST_SUCCESS 或 XST_FAILURE
+ */
+int DMA_Mem_init();
+
+/**
+ * 分配DMA缓冲区，分配后缓冲区内容为0，归属CPU
+ * @param buf [out] 缓冲区描述
+ * @param size 长度，向上对齐到缓存行
+ * @param dir 传输方向
+ * @return XST_SUCCESS 或 XST_FAILURE
+ */
+int DMA_Mem_alloc(DMA_Mem_Buf *buf, size_t size, DMA_Mem_Dir dir);
+
+/**
+ * 释放DMA缓冲区，调用前设备必须已停止访问
+ * @param buf 缓冲区描述
+ */
+void DMA_Mem_free(DMA_Mem_Buf *buf);
+
+/**
+ * 将缓冲区交给设备
+ * @param buf 缓冲区描述
+ * @param len 本次需要同步的长度，0表示整个缓冲区
+ */
+void DMA_Mem_to_device(DMA_Mem_Buf *buf, size_t len);
+
+/**
+ * 将缓冲区交还CPU
+ * @param buf 缓冲区描述
+ * @param len 本次需要同步的长度，0表示整个缓冲区
+ */
+void DMA_Mem_to_cpu(DMA_Mem_Buf *buf, size_t len);
+
+/**
+ * 获取统计数据
+ * @param stats [out] 统计数据
+ */
+void DMA_Mem_get_stats(DMA_Mem_Stats *stats);
+
+#endif //ZYNQ7020_DMA_MEM_H
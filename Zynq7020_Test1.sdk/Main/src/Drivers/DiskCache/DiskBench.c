@@ -0,0 +1,124 @@
+//
+// Created by yaoji on 2022/5/8.
+//
+
+#include "DiskBench.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "check.h"
+#include "Fatfs_init/Fatfs_Driver.h"
+#include "FileService/FileService.h"
+#include "Timer_Driver/Timer_Driver.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const bench_files[2] = {"0:/disk_bench.tmp", "1:/disk_bench.tmp"};
+static DiskBench_Result bench_result[2];
+static volatile int bench_running;
+
+static float DiskBench_speed(uint32_t bytes, uint64_t ms) {
+    if (ms == 0) ms = 1;
+    return (float) bytes * 1000.0f / (float) ms / (1024.0f * 1024.0f);
+}
+
+static FRESULT DiskBench_volume(const char *path, uint8_t *buf, DiskBench_Result *result) {
+    FIL file;
+    FRESULT res;
+    UINT done;
+    uint64_t start;
+
+    res = FileService_open(&file, path, FA_CREATE_ALWAYS | FA_READ | FA_WRITE);
+    if (res != FR_OK) return res;
+
+    for (uint32_t i = 0; i < DISK_BENCH_SEQ_BLOCK; i++) buf[i] = rand();
+
+    /* 顺序写，计入同步时间 */
+    start = getTime_millis();
+    for (uint32_t ofs = 0; ofs < DISK_BENCH_FILE_SIZE; ofs += DISK_BENCH_SEQ_BLOCK) {
+        res = FileService_write(&file, buf, DISK_BENCH_SEQ_BLOCK, &done);
+        if (res == FR_OK && done != DISK_BENCH_SEQ_BLOCK) res = FR_DENIED;  // 磁盘已满
+        if (res != FR_OK) goto ret;
+    }
+    res = FileService_sync(&file);
+    if (res != FR_OK) goto ret;
+    result->seq_write = DiskBench_speed(DISK_BENCH_FILE_SIZE, getTime_millis() - start);
+
+    /* 顺序读 */
+    res = FileService_lseek(&file, 0);
+    if (res != FR_OK) goto ret;
+    start = getTime_millis();
+    for (uint32_t ofs = 0; ofs < DISK_BENCH_FILE_SIZE; ofs += DISK_BENCH_SEQ_BLOCK) {
+        res = FileService_read(&file, buf, DISK_BENCH_SEQ_BLOCK, &done);
+        if (res == FR_OK && done != DISK_BENCH_SEQ_BLOCK) res = FR_INT_ERR;
+        if (res != FR_OK) goto ret;
+    }
+    result->seq_read = DiskBench_speed(DISK_BENCH_FILE_SIZE, getTime_millis() - start);
+
+    /* 随机写，块对齐 */
+    srand(xTaskGetTickCount());
+    start = getTime_millis();
+    for (int i = 0; i < DISK_BENCH_RAND_COUNT; i++) {
+        FSIZE_t ofs = (FSIZE_t) (rand() % (DISK_BENCH_FILE_SIZE / DISK_BENCH_RAND_BLOCK)) * DISK_BENCH_RAND_BLOCK;
+        res = FileService_lseek(&file, ofs);
+        if (res != FR_OK) goto ret;
+        res = FileService_write(&file, buf, DISK_BENCH_RAND_BLOCK, &done);
+        if (res != FR_OK) goto ret;
+    }
+    res = FileService_sync(&file);
+    if (res != FR_OK) goto ret;
+    result->rand_write = DiskBench_speed(DISK_BENCH_RAND_COUNT * DISK_BENCH_RAND_BLOCK, getTime_millis() - start);
+
+    /* 随机读 */
+    start = getTime_millis();
+    for (int i = 0; i < DISK_BENCH_RAND_COUNT; i++) {
+        FSIZE_t ofs = (FSIZE_t) (rand() % (DISK_BENCH_FILE_SIZE / DISK_BENCH_RAND_BLOCK)) * DISK_BENCH_RAND_BLOCK;
+        res = FileService_lseek(&file, ofs);
+        if (res != FR_OK) goto ret;
+        res = FileService_read(&file, buf, DISK_BENCH_RAND_BLOCK, &done);
+        if (res != FR_OK) goto ret;
+    }
+    result->rand_read = DiskBench_speed(DISK_BENCH_RAND_COUNT * DISK_BENCH_RAND_BLOCK, getTime_millis() - start);
+
+    ret:
+    FileService_close(&file);
+    FileService_unlink(path);
+    return res;
+}
+
+static void DiskBench_task(void *param) {
+    // 多申请一个cache行，让缓冲区按cache行对齐，大块读写可以直接DMA
+    uint8_t *raw = os_malloc(DISK_BENCH_SEQ_BLOCK + 32);
+    uint8_t *buf = (uint8_t *) (((uintptr_t) raw + 31) & ~(uintptr_t) 31);
+    for (int i = 0; i < 2; i++) {
+        memset(&bench_result[i], 0, sizeof(DiskBench_Result));
+        if (raw == NULL) {
+            bench_result[i].result = FR_NOT_ENOUGH_CORE;
+        } else if (Fatfs_GetMountStatus(i) != FR_OK) {
+            bench_result[i].result = FR_NOT_READY;
+        } else {
+            bench_result[i].result = DiskBench_volume(bench_files[i], buf, &bench_result[i]);
+            xil_printf("disk bench %s: res=%d\r\n", bench_files[i], bench_result[i].result);
+        }
+    }
+    os_free(raw);
+    bench_running = 0;
+    vTaskDelete(NULL);
+}
+
+int DiskBench_start() {
+    if (bench_running) return XST_FAILURE;
+    bench_running = 1;
+    if (xTaskCreate(DiskBench_task, "DiskBench", 1024, NULL, 1, NULL) != pdPASS) {
+        xil_printf("error create DiskBench task failed\r\n");
+        bench_running = 0;
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+int DiskBench_isfinished() { return !bench_running; }
+
+const DiskBench_Result *DiskBench_get_result(int index) {
+    return &bench_result[index ? 1 : 0];
+}
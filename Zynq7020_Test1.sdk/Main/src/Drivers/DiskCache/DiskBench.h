@@ -0,0 +1,42 @@
+//
+// Created by yaoji on 2022/5/8.
+//
+
+#ifndef ZYNQ7020_DISKBENCH_H
+#define ZYNQ7020_DISKBENCH_H
+
+#include "ff.h"
+
+#define DISK_BENCH_FILE_SIZE (16 * 1024 * 1024)    //!< 测试文件大小，大于磁盘缓存容量
+#define DISK_BENCH_SEQ_BLOCK (64 * 1024)           //!< 顺序读写块大小
+#define DISK_BENCH_RAND_BLOCK (4 * 1024)           //!< 随机读写块大小
+#define DISK_BENCH_RAND_COUNT 256                  //!< 随机读写次数
+
+typedef struct {
+    FRESULT result;     //!< 测试结果，卷未挂载或读写出错时不为FR_OK
+    float seq_write;    //!< 顺序写 MB/s
+    float seq_read;     //!< 顺序读 MB/s
+    float rand_write;   //!< 随机写 MB/s
+    float rand_read;    //!< 随机读 MB/s
+} DiskBench_Result;
+
+/**
+ * 创建存储测速任务，依次测试 0:/ 和 1:/，非阻塞函数
+ * @return 成功创建任务返回XST_SUCCESS，正在测试或创建失败返回XST_FAILURE
+ */
+int DiskBench_start();
+
+/**
+ * 判断测速是否完成
+ * @return 完成返回1
+ */
+int DiskBench_isfinished();
+
+/**
+ * 获取测速结果
+ * @param index 卷号 0:SD 1:EMMC
+ * @return 测速结果
+ */
+const DiskBench_Result *DiskBench_get_result(int index);
+
+#endif //ZYNQ7020_DISKBENCH_H
@@ -0,0 +1,441 @@
+//
+// Created by yaoji on 2022/5/6.
+//
+
+#include "DiskCache.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "check.h"
+#include "xil_printf.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DISK_CACHE_STACK_SIZE 512
+#define DISK_CACHE_PRIORITY (tskIDLE_PRIORITY + 1)
+#define DISK_CACHE_CHECK_PERIOD 200
+#define DISK_DMA_ALIGN 32               //!< Cortex-A9 L1/L2 cache行大小
+#define DISK_DMA_MAX_SECTORS 4096       //!< sdps的ADMA2描述符表为32项，每项最大64KB
+
+#if (DISK_CACHE_SETS & (DISK_CACHE_SETS - 1)) != 0
+#error "DISK_CACHE_SETS must be a power of 2"
+#endif
+
+/* 链接器 --wrap 生成的原始diskio函数 */
+DSTATUS __real_disk_initialize(BYTE pdrv);
+DRESULT __real_disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count);
+DRESULT __real_disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count);
+DRESULT __real_disk_ioctl(BYTE pdrv, BYTE cmd, void *buff);
+
+typedef struct {
+    DWORD sector;
+    uint32_t lru;       //!< 最近访问时间戳，越小越久未访问
+    uint8_t pdrv;
+    uint8_t valid;
+    uint8_t dirty;
+} DiskCache_Line;
+
+typedef struct {
+    DWORD next_sector;  //!< 上次读请求的结束位置，用于识别顺序读
+    DWORD sector_count; //!< 设备扇区数，0表示未知，不预读
+    uint32_t dirty;     //!< 脏扇区数
+    DiskCache_Stats stats;
+} DiskCache_Drive;
+
+static DiskCache_Line lines[DISK_CACHE_LINES];
+static uint8_t cache_data[DISK_CACHE_LINES][DISK_CACHE_SECTOR_SIZE] __attribute__((aligned(32)));
+/* 预读和回写合并共用的缓冲区，都在持有锁时使用 */
+static uint8_t stage_buf[DISK_CACHE_READ_AHEAD * DISK_CACHE_SECTOR_SIZE] __attribute__((aligned(32)));
+static uint8_t bounce_buf[DISK_CACHE_SECTOR_SIZE] __attribute__((aligned(DISK_DMA_ALIGN)));
+static uint32_t flush_index[DISK_CACHE_LINES];
+
+static DiskCache_Drive drives[DISK_CACHE_DRIVES];
+static uint32_t lru_clock;
+static TickType_t first_dirty_tick;
+static SemaphoreHandle_t cache_mutex;
+
+static inline uint32_t DiskCache_set_base(BYTE pdrv, DWORD sector) {
+    // 相邻扇区落在相邻的组，不同驱动器错开
+    return ((sector + pdrv * (DISK_CACHE_SETS / 2)) & (DISK_CACHE_SETS - 1)) * DISK_CACHE_WAYS;
+}
+
+static inline uint8_t *DiskCache_line_data(const DiskCache_Line *line) {
+    return cache_data[line - lines];
+}
+
+/**
+ * 从设备读取扇区，sdps驱动使用ADMA2多块传输，DMA前后按cache行维护缓存。
+ * 缓冲区没有按cache行对齐时，DMA会破坏首尾cache行中相邻的数据，
+ * 因此前count-1个扇区读到缓冲区内部对齐的位置后整体前移，最后一个扇区经中转缓冲区读取
+ */
+static DRESULT DiskCache_dev_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count) {
+    while (count) {
+        UINT n = count < DISK_DMA_MAX_SECTORS ? count : DISK_DMA_MAX_SECTORS;
+        uintptr_t offset = (uintptr_t) buff & (DISK_DMA_ALIGN - 1);
+        DRESULT res;
+        if (offset == 0) {
+            res = __real_disk_read(pdrv, buff, sector, n);
+            if (res != RES_OK) return res;
+        } else {
+            if (n > 1) {
+                BYTE *core = buff + DISK_DMA_ALIGN - offset;
+                res = __real_disk_read(pdrv, core, sector, n - 1);
+                if (res != RES_OK) return res;
+                memmove(buff, core, (n - 1) * DISK_CACHE_SECTOR_SIZE);
+            }
+            res = __real_disk_read(pdrv, bounce_buf, sector + n - 1, 1);
+            if (res != RES_OK) return res;
+            memcpy(buff + (n - 1) * DISK_CACHE_SECTOR_SIZE, bounce_buf, DISK_CACHE_SECTOR_SIZE);
+        }
+        buff += n * DISK_CACHE_SECTOR_SIZE;
+        sector += n;
+        count -= n;
+    }
+    return RES_OK;
+}
+
+/**
+ * 向设备写入扇区，写之前只需要刷新cache，不要求cache行对齐，
+ * 但ADMA2的地址需要4字节对齐，否则经对齐的缓冲区分段写入
+ */
+static DRESULT DiskCache_dev_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count) {
+    while (count) {
+        UINT n = count < DISK_DMA_MAX_SECTORS ? count : DISK_DMA_MAX_SECTORS;
+        DRESULT res;
+        if (((uintptr_t) buff & 3) == 0) {
+            res = __real_disk_write(pdrv, buff, sector, n);
+        } else {
+            if (n > DISK_CACHE_READ_AHEAD) n = DISK_CACHE_READ_AHEAD;
+            memcpy(stage_buf, buff, n * DISK_CACHE_SECTOR_SIZE);
+            res = __real_disk_write(pdrv, stage_buf, sector, n);
+        }
+        if (res != RES_OK) return res;
+        buff += n * DISK_CACHE_SECTOR_SIZE;
+        sector += n;
+        count -= n;
+    }
+    return RES_OK;
+}
+
+static DiskCache_Line *DiskCache_lookup(BYTE pdrv, DWORD sector) {
+    DiskCache_Line *set = &lines[DiskCache_set_base(pdrv, sector)];
+    for (int i = 0; i < DISK_CACHE_WAYS; i++) {
+        if (set[i].valid && set[i].sector == sector && set[i].pdrv == pdrv)
+            return &set[i];
+    }
+    return NULL;
+}
+
+static void DiskCache_set_dirty(DiskCache_Line *line, uint8_t dirty) {
+    if (line->dirty == dirty) return;
+    line->dirty = dirty;
+    if (dirty) {
+        if (drives[0].dirty + drives[1].dirty == 0)
+            first_dirty_tick = xTaskGetTickCount();
+        drives[line->pdrv].dirty++;
+    } else {
+        drives[line->pdrv].dirty--;
+    }
+}
+
+/**
+ * 选出组中最久未使用的行，脏行先写回
+ * @return 可用的行，写回失败返回NULL
+ */
+static DiskCache_Line *DiskCache_victim(BYTE pdrv, DWORD sector) {
+    DiskCache_Line *set = &lines[DiskCache_set_base(pdrv, sector)];
+    DiskCache_Line *victim = &set[0];
+    for (int i = 0; i < DISK_CACHE_WAYS; i++) {
+        if (!set[i].valid) {
+            victim = &set[i];
+            break;
+        }
+        if (set[i].lru < victim->lru) victim = &set[i];
+    }
+    if (victim->valid && victim->dirty) {
+        if (DiskCache_dev_write(victim->pdrv, DiskCache_line_data(victim), victim->sector, 1) != RES_OK)
+            return NULL;
+        drives[victim->pdrv].stats.writebacks++;
+        DiskCache_set_dirty(victim, 0);
+    }
+    victim->valid = 0;
+    return victim;
+}
+
+/**
+ * 将从设备读出的扇区放入缓存，已缓存的扇区保持不变(可能比设备中的数据新)
+ */
+static void DiskCache_fill(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count) {
+    for (UINT i = 0; i < count; i++) {
+        if (DiskCache_lookup(pdrv, sector + i)) continue;
+        DiskCache_Line *line = DiskCache_victim(pdrv, sector + i);
+        if (line == NULL) continue;
+        memcpy(DiskCache_line_data(line), buff + i * DISK_CACHE_SECTOR_SIZE, DISK_CACHE_SECTOR_SIZE);
+        line->pdrv = pdrv;
+        line->sector = sector + i;
+        line->lru = ++lru_clock;
+        line->valid = 1;
+    }
+}
+
+static int DiskCache_sector_cmp(const void *a, const void *b) {
+    DWORD sa = lines[*(const uint32_t *) a].sector;
+    DWORD sb = lines[*(const uint32_t *) b].sector;
+    return (sa > sb) - (sa < sb);
+}
+
+static DRESULT DiskCache_flush_locked(BYTE pdrv) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < DISK_CACHE_LINES; i++) {
+        if (lines[i].valid && lines[i].dirty && lines[i].pdrv == pdrv)
+            flush_index[n++] = i;
+    }
+    if (n == 0) return RES_OK;
+
+    qsort(flush_index, n, sizeof(uint32_t), DiskCache_sector_cmp);
+
+    // 按扇区号排序后合并连续扇区，一次写入多个扇区
+    uint32_t i = 0;
+    while (i < n) {
+        DWORD start = lines[flush_index[i]].sector;
+        uint32_t run = 0;
+        while (i + run < n && run < DISK_CACHE_READ_AHEAD &&
+               lines[flush_index[i + run]].sector == start + run) {
+            memcpy(stage_buf + run * DISK_CACHE_SECTOR_SIZE,
+                   DiskCache_line_data(&lines[flush_index[i + run]]), DISK_CACHE_SECTOR_SIZE);
+            run++;
+        }
+        DRESULT res = DiskCache_dev_write(pdrv, stage_buf, start, run);
+        if (res != RES_OK) return res;
+        for (uint32_t k = 0; k < run; k++)
+            DiskCache_set_dirty(&lines[flush_index[i + k]], 0);
+        drives[pdrv].stats.writebacks += run;
+        i += run;
+    }
+    return RES_OK;
+}
+
+/**
+ * 丢弃驱动器的全部缓存
+ */
+static void DiskCache_invalidate(BYTE pdrv) {
+    for (uint32_t i = 0; i < DISK_CACHE_LINES; i++) {
+        if (lines[i].valid && lines[i].pdrv == pdrv) {
+            DiskCache_set_dirty(&lines[i], 0);
+            lines[i].valid = 0;
+        }
+    }
+}
+
+static void DiskCache_task(void *p) {
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(DISK_CACHE_CHECK_PERIOD));
+        if (drives[0].dirty + drives[1].dirty == 0) continue;
+        if (xTaskGetTickCount() - first_dirty_tick < pdMS_TO_TICKS(DISK_CACHE_FLUSH_PERIOD)) continue;
+        xSemaphoreTake(cache_mutex, portMAX_DELAY);
+        for (BYTE pdrv = 0; pdrv < DISK_CACHE_DRIVES; pdrv++) {
+            if (DiskCache_flush_locked(pdrv) != RES_OK)
+                xil_printf("error: disk cache flush drive %d failed\r\n", pdrv);
+        }
+        // 写回失败时推迟下次重试
+        first_dirty_tick = xTaskGetTickCount();
+        xSemaphoreGive(cache_mutex);
+    }
+}
+
+int DiskCache_init() {
+    if (cache_mutex) return XST_SUCCESS;
+    cache_mutex = xSemaphoreCreateMutex();
+    if (cache_mutex == NULL) return XST_FAILURE;
+    if (xTaskCreate(DiskCache_task, "DiskCache", DISK_CACHE_STACK_SIZE,
+                    NULL, DISK_CACHE_PRIORITY, NULL) != pdPASS) {
+        vSemaphoreDelete(cache_mutex);
+        cache_mutex = NULL;
+        return XST_FAILURE;
+    }
+    xil_printf("disk cache %d KB, %d sets x %d ways\r\n", DISK_CACHE_SIZE / 1024, DISK_CACHE_SETS, DISK_CACHE_WAYS);
+    return XST_SUCCESS;
+}
+
+DRESULT DiskCache_flush(BYTE pdrv) {
+    if (cache_mutex == NULL || pdrv >= DISK_CACHE_DRIVES) return RES_OK;
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    DRESULT res = DiskCache_flush_locked(pdrv);
+    xSemaphoreGive(cache_mutex);
+    return res;
+}
+
+uint32_t DiskCache_get_stats(BYTE pdrv, DiskCache_Stats *stats) {
+    if (pdrv >= DISK_CACHE_DRIVES) {
+        memset(stats, 0, sizeof(DiskCache_Stats));
+        return 0;
+    }
+    // 只读统计值，不加锁
+    *stats = drives[pdrv].stats;
+    return drives[pdrv].dirty;
+}
+
+float DiskCache_hit_rate(const DiskCache_Stats *stats) {
+    uint32_t total = stats->read_hits + stats->read_misses;
+    if (total == 0) return 0;
+    return (float) stats->read_hits * 100.0f / (float) total;
+}
+
+DSTATUS __wrap_disk_initialize(BYTE pdrv) {
+    if (cache_mutex == NULL || pdrv >= DISK_CACHE_DRIVES)
+        return __real_disk_initialize(pdrv);
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    // 重新挂载前尽量写回，然后丢弃旧数据，设备可能已经更换
+    DiskCache_flush_locked(pdrv);
+    DiskCache_invalidate(pdrv);
+    DiskCache_Drive *drive = &drives[pdrv];
+    drive->next_sector = 0;
+    drive->sector_count = 0;
+    DSTATUS stat = __real_disk_initialize(pdrv);
+    if (!(stat & STA_NOINIT)) {
+        DWORD count;
+        if (__real_disk_ioctl(pdrv, GET_SECTOR_COUNT, &count) == RES_OK)
+            drive->sector_count = count;
+    }
+    xSemaphoreGive(cache_mutex);
+    return stat;
+}
+
+DRESULT __wrap_disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count) {
+    if (cache_mutex == NULL || pdrv >= DISK_CACHE_DRIVES)
+        return DiskCache_dev_read(pdrv, buff, sector, count);
+
+    DRESULT res = RES_OK;
+    DiskCache_Drive *drive = &drives[pdrv];
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+    int sequential = sector == drive->next_sector;
+    drive->next_sector = sector + count;
+
+    if (count >= DISK_CACHE_BYPASS) {
+        // 大块读直接访问设备，再用缓存中较新的脏扇区覆盖
+        res = DiskCache_dev_read(pdrv, buff, sector, count);
+        if (res == RES_OK && drive->dirty) {
+            for (UINT i = 0; i < count; i++) {
+                DiskCache_Line *line = DiskCache_lookup(pdrv, sector + i);
+                if (line && line->dirty)
+                    memcpy(buff + i * DISK_CACHE_SECTOR_SIZE, DiskCache_line_data(line), DISK_CACHE_SECTOR_SIZE);
+            }
+        }
+        drive->stats.bypass_sectors += count;
+        xSemaphoreGive(cache_mutex);
+        return res;
+    }
+
+    UINT i = 0;
+    while (i < count) {
+        DiskCache_Line *line = DiskCache_lookup(pdrv, sector + i);
+        if (line) {
+            memcpy(buff + i * DISK_CACHE_SECTOR_SIZE, DiskCache_line_data(line), DISK_CACHE_SECTOR_SIZE);
+            line->lru = ++lru_clock;
+            drive->stats.read_hits++;
+            i++;
+            continue;
+        }
+
+        // 连续未命中的扇区合并为一次读取
+        UINT run = 1;
+        while (i + run < count && DiskCache_lookup(pdrv, sector + i + run) == NULL) run++;
+        drive->stats.read_misses += run;
+
+        UINT fetch = run;
+        if (sequential && i + run == count && run < DISK_CACHE_READ_AHEAD && drive->sector_count) {
+            fetch = DISK_CACHE_READ_AHEAD;
+            if (sector + i + fetch > drive->sector_count)
+                fetch = drive->sector_count - (sector + i);
+            if (fetch < run) fetch = run;
+        }
+
+        BYTE *dst = buff + i * DISK_CACHE_SECTOR_SIZE;
+        if (fetch > run) {
+            res = DiskCache_dev_read(pdrv, stage_buf, sector + i, fetch);
+            if (res != RES_OK) break;
+            memcpy(dst, stage_buf, run * DISK_CACHE_SECTOR_SIZE);
+            DiskCache_fill(pdrv, stage_buf, sector + i, fetch);
+            drive->stats.prefetched += fetch - run;
+        } else {
+            res = DiskCache_dev_read(pdrv, dst, sector + i, run);
+            if (res != RES_OK) break;
+            DiskCache_fill(pdrv, dst, sector + i, run);
+        }
+        i += run;
+    }
+    xSemaphoreGive(cache_mutex);
+    return res;
+}
+
+DRESULT __wrap_disk_write(BYTE pdrv, const BYTE *buff, DWORD sector, UINT count) {
+    if (cache_mutex == NULL || pdrv >= DISK_CACHE_DRIVES)
+        return DiskCache_dev_write(pdrv, buff, sector, count);
+
+    DRESULT res = RES_OK;
+    DiskCache_Drive *drive = &drives[pdrv];
+    xSemaphoreTake(cache_mutex, portMAX_DELAY);
+
+    if (count >= DISK_CACHE_BYPASS) {
+        // 大块写直接写入设备，已缓存的扇区同步更新为干净状态
+        res = DiskCache_dev_write(pdrv, buff, sector, count);
+        if (res == RES_OK) {
+            for (UINT i = 0; i < count; i++) {
+                DiskCache_Line *line = DiskCache_lookup(pdrv, sector + i);
+                if (line == NULL) continue;
+                memcpy(DiskCache_line_data(line), buff + i * DISK_CACHE_SECTOR_SIZE, DISK_CACHE_SECTOR_SIZE);
+                DiskCache_set_dirty(line, 0);
+            }
+        }
+        drive->stats.bypass_sectors += count;
+        xSemaphoreGive(cache_mutex);
+        return res;
+    }
+
+    for (UINT i = 0; i < count; i++) {
+        const BYTE *src = buff + i * DISK_CACHE_SECTOR_SIZE;
+        DiskCache_Line *line = DiskCache_lookup(pdrv, sector + i);
+        if (line == NULL) line = DiskCache_victim(pdrv, sector + i);
+        if (line == NULL) {
+            // 无法腾出缓存行时直接写入
+            res = DiskCache_dev_write(pdrv, src, sector + i, 1);
+            if (res != RES_OK) break;
+            continue;
+        }
+        memcpy(DiskCache_line_data(line), src, DISK_CACHE_SECTOR_SIZE);
+        line->pdrv = pdrv;
+        line->sector = sector + i;
+        line->lru = ++lru_clock;
+        line->valid = 1;
+        DiskCache_set_dirty(line, 1);
+        drive->stats.write_sectors++;
+    }
+    xSemaphoreGive(cache_mutex);
+    return res;
+}
+
+DRESULT __wrap_disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+    if (cache_mutex && pdrv < DISK_CACHE_DRIVES) {
+        if (cmd == CTRL_SYNC) {
+            DRESULT res = DiskCache_flush(pdrv);
+            if (res != RES_OK) return res;
+        }
+#ifdef CTRL_TRIM
+        else if (cmd == CTRL_TRIM) {
+            // 被擦除的扇区不需要再写回
+            DWORD *range = buff;
+            xSemaphoreTake(cache_mutex, portMAX_DELAY);
+            for (uint32_t i = 0; i < DISK_CACHE_LINES; i++) {
+                if (lines[i].valid && lines[i].pdrv == pdrv &&
+                    lines[i].sector >= range[0] && lines[i].sector <= range[1]) {
+                    DiskCache_set_dirty(&lines[i], 0);
+                    lines[i].valid = 0;
+                }
+            }
+            xSemaphoreGive(cache_mutex);
+        }
+#endif
+    }
+    return __real_disk_ioctl(pdrv, cmd, buff);
+}
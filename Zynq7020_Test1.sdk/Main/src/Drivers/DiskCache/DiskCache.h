@@ -0,0 +1,67 @@
+//
+// Created by yaoji on 2022/5/6.
+//
+
+#ifndef ZYNQ7020_DISKCACHE_H
+#define ZYNQ7020_DISKCACHE_H
+
+#include "ff.h"
+#include "diskio.h"
+
+/**
+ * FatFs与SD/EMMC diskio之间的扇区缓存，通过链接选项
+ * -Wl,--wrap=disk_initialize,--wrap=disk_read,--wrap=disk_write,--wrap=disk_ioctl
+ * 截获FatFs对diskio的调用，组相联，回写，顺序读自动预读
+ */
+
+#ifndef DISK_CACHE_SIZE
+#define DISK_CACHE_SIZE (4 * 1024 * 1024)   //!< 缓存容量(字节)，放在DDR的.bss中，可在编译选项中覆盖
+#endif
+
+#define DISK_CACHE_SECTOR_SIZE 512
+#define DISK_CACHE_WAYS 8                   //!< 组相联路数
+#define DISK_CACHE_LINES (DISK_CACHE_SIZE / DISK_CACHE_SECTOR_SIZE)
+#define DISK_CACHE_SETS (DISK_CACHE_LINES / DISK_CACHE_WAYS)
+#define DISK_CACHE_DRIVES 2                 //!< 缓存的物理驱动器数量 0:SD 1:EMMC
+#define DISK_CACHE_READ_AHEAD 32            //!< 顺序读时一次预读的扇区数
+#define DISK_CACHE_BYPASS 64                //!< 单次读写扇区数不小于该值时直接访问设备
+#define DISK_CACHE_FLUSH_PERIOD 1000        //!< 脏扇区最长停留时间(ms)
+
+typedef struct {
+    uint32_t read_hits;         //!< 读命中扇区数
+    uint32_t read_misses;       //!< 读未命中扇区数
+    uint32_t prefetched;        //!< 预读扇区数
+    uint32_t write_sectors;     //!< 写入缓存的扇区数
+    uint32_t writebacks;        //!< 回写到设备的扇区数
+    uint32_t bypass_sectors;    //!< 大块直接读写的扇区数
+} DiskCache_Stats;
+
+/**
+ * 初始化缓存并创建定时回写任务，需要在Fatfs_Init之前调用
+ * @return XST_SUCCESS 或 XST_FAILURE
+ */
+int DiskCache_init();
+
+/**
+ * 将驱动器的脏扇区写回设备
+ * @param pdrv 物理驱动器号
+ * @return RES_OK 或设备返回的错误
+ */
+DRESULT DiskCache_flush(BYTE pdrv);
+
+/**
+ * 获取驱动器的缓存统计
+ * @param pdrv 物理驱动器号
+ * @param stats [out] 统计数据
+ * @return 当前缓存中该驱动器的脏扇区数
+ */
+uint32_t DiskCache_get_stats(BYTE pdrv, DiskCache_Stats *stats);
+
+/**
+ * 计算命中率
+ * @param stats 统计数据
+ * @return 命中率(0~100)，无读请求时返回0
+ */
+float DiskCache_hit_rate(const DiskCache_Stats *stats);
+
+#endif //ZYNQ7020_DISKCACHE_H
@@ -0,0 +1,181 @@
+//
+// Created by yaoji on 2022/5/10.
+//
+
+#include "Encoding.h"
+#include "ff.h"
+#include "xstatus.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include <stdint.h>
+#include <string.h>
+
+#define GBK_LEAD_MIN 0x81
+#define GBK_LEAD_MAX 0xFE
+#define GBK_TRAIL_MIN 0x40
+#define GBK_TRAIL_MAX 0xFE
+#define ENCODING_INVALID '?'
+
+/* GBK首字节 -> 尾字节 -> Unicode，0为无映射 */
+static uint16_t gbk2uni[GBK_LEAD_MAX - GBK_LEAD_MIN + 1][256];
+/* Unicode高字节 -> 低字节 -> GBK，没有映射的页指向全0页 */
+static const uint16_t *uni2gbk[256];
+static const uint16_t uni2gbk_empty[256];
+static uint16_t *uni2gbk_pages;
+static int encoding_ready;
+
+int Encoding_init() {
+    if (encoding_ready) return XST_SUCCESS;
+    uint8_t page_used[256] = {0};
+    int page_cnt = 0;
+
+    for (int lead = GBK_LEAD_MIN; lead <= GBK_LEAD_MAX; lead++) {
+        for (int trail = GBK_TRAIL_MIN; trail <= GBK_TRAIL_MAX; trail++) {
+            WCHAR uni = ff_oem2uni(lead << 8 | trail, FF_CODE_PAGE);
+            gbk2uni[lead - GBK_LEAD_MIN][trail] = uni;
+            if (uni >= 0x80 && !page_used[uni >> 8]) {
+                page_used[uni >> 8] = 1;
+                page_cnt++;
+            }
+        }
+    }
+
+    uni2gbk_pages = os_malloc(page_cnt * 256 * sizeof(uint16_t));
+    if (uni2gbk_pages == NULL) return XST_FAILURE;
+    memset(uni2gbk_pages, 0, page_cnt * 256 * sizeof(uint16_t));
+    uint16_t *page = uni2gbk_pages;
+    for (int i = 0; i < 256; i++) {
+        if (page_used[i]) {
+            uni2gbk[i] = page;
+            page += 256;
+        } else {
+            uni2gbk[i] = uni2gbk_empty;
+        }
+    }
+
+    for (int lead = GBK_LEAD_MIN; lead <= GBK_LEAD_MAX; lead++) {
+        for (int trail = GBK_TRAIL_MIN; trail <= GBK_TRAIL_MAX; trail++) {
+            uint16_t uni = gbk2uni[lead - GBK_LEAD_MIN][trail];
+            uint16_t *slot = (uint16_t *) &uni2gbk[uni >> 8][uni & 0xff];
+            // 同一个Unicode对应多个GBK编码时保留第一个，与ff_uni2oem一致
+            if (uni >= 0x80 && *slot == 0) *slot = lead << 8 | trail;
+        }
+    }
+    encoding_ready = 1;
+    return XST_SUCCESS;
+}
+
+static inline uint16_t Encoding_gbk_lookup(uint8_t lead, uint8_t trail) {
+    if (encoding_ready)
+        return (lead >= GBK_LEAD_MIN && lead <= GBK_LEAD_MAX) ? gbk2uni[lead - GBK_LEAD_MIN][trail] : 0;
+    return ff_oem2uni(lead << 8 | trail, FF_CODE_PAGE);
+}
+
+static inline uint16_t Encoding_uni_lookup(uint32_t uni) {
+    if (uni > 0xFFFF) return 0;
+    if (encoding_ready) return uni2gbk[uni >> 8][uni & 0xff];
+    return ff_uni2oem(uni, FF_CODE_PAGE);
+}
+
+int Encoding_gbk_to_utf8(char *dst, size_t size, const char *src) {
+    const uint8_t *p = (const uint8_t *) src;
+    size_t n = 0;
+    if (size == 0) return -1;
+
+    while (*p) {
+        /* ASCII连续复制 */
+        if (*p < 0x80) {
+            if (n + 1 >= size) goto overflow;
+            dst[n++] = *p++;
+            continue;
+        }
+
+        uint16_t uni = p[1] ? Encoding_gbk_lookup(p[0], p[1]) : 0;
+        p += p[1] ? 2 : 1;
+        if (uni < 0x80) {
+            if (n + 1 >= size) goto overflow;
+            dst[n++] = uni ? uni : ENCODING_INVALID;
+        } else if (uni < 0x800) {
+            if (n + 2 >= size) goto overflow;
+            dst[n++] = 0xC0 | (uni >> 6);
+            dst[n++] = 0x80 | (uni & 0x3F);
+        } else {
+            if (n + 3 >= size) goto overflow;
+            dst[n++] = 0xE0 | (uni >> 12);
+            dst[n++] = 0x80 | ((uni >> 6) & 0x3F);
+            dst[n++] = 0x80 | (uni & 0x3F);
+        }
+    }
+    dst[n] = 0;
+    return n;
+
+    overflow:
+    dst[n] = 0;
+    return -1;
+}
+
+/**
+ * 解码一个UTF-8字符
+ * @param p 输入，返回时指向下一个字符
+ * @return Unicode码点，非法序列返回0xFFFFFFFF并跳过一个字节
+ */
+static inline uint32_t Encoding_utf8_decode(const uint8_t **p) {
+    const uint8_t *s = *p;
+    uint32_t uni;
+    int len;
+    if (s[0] < 0xC2) {
+        *p = s + 1;
+        return 0xFFFFFFFF;
+    } else if (s[0] < 0xE0) {
+        uni = s[0] & 0x1F;
+        len = 2;
+    } else if (s[0] < 0xF0) {
+        uni = s[0] & 0x0F;
+        len = 3;
+    } else if (s[0] < 0xF5) {
+        uni = s[0] & 0x07;
+        len = 4;
+    } else {
+        *p = s + 1;
+        return 0xFFFFFFFF;
+    }
+    for (int i = 1; i < len; i++) {
+        // 结束符也不是后续字节，不会越界
+        if ((s[i] & 0xC0) != 0x80) {
+            *p = s + 1;
+            return 0xFFFFFFFF;
+        }
+        uni = uni << 6 | (s[i] & 0x3F);
+    }
+    *p = s + len;
+    return uni;
+}
+
+int Encoding_utf8_to_gbk(char *dst, size_t size, const char *src) {
+    const uint8_t *p = (const uint8_t *) src;
+    size_t n = 0;
+    if (size == 0) return -1;
+
+    while (*p) {
+        if (*p < 0x80) {
+            if (n + 1 >= size) goto overflow;
+            dst[n++] = *p++;
+            continue;
+        }
+
+        uint16_t gbk = Encoding_uni_lookup(Encoding_utf8_decode(&p));
+        if (gbk == 0) {
+            if (n + 1 >= size) goto overflow;
+            dst[n++] = ENCODING_INVALID;
+        } else {
+            if (n + 2 >= size) goto overflow;
+            dst[n++] = gbk >> 8;
+            dst[n++] = gbk & 0xff;
+        }
+    }
+    dst[n] = 0;
+    return n;
+
+    overflow:
+    dst[n] = 0;
+    return -1;
+}
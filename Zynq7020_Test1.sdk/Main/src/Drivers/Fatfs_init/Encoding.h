@@ -0,0 +1,46 @@
+//
+// Created by yaoji on 2022/5/10.
+//
+
+#ifndef ZYNQ7020_ENCODING_H
+#define ZYNQ7020_ENCODING_H
+
+#include <stddef.h>
+
+/**
+ * GBK(FatFs代码页936)与UTF-8互相转换，输出到调用者提供的缓冲区。
+ * Encoding_init在启动时由FatFs的代码页表生成直接索引的两级查找表，
+ * 之后每个字符只需两次数组访问；未初始化时退回逐字符调用ff_oem2uni/ff_uni2oem
+ */
+
+#define ENCODING_PATH_MAX 512   //!< 路径转换使用的缓冲区大小
+
+/* 输出缓冲区需要的最大长度(含结束符)，len为输入字符串长度(不含结束符) */
+#define ENCODING_GBK_TO_UTF8_SIZE(len) ((len) * 3 / 2 + 1)
+#define ENCODING_UTF8_TO_GBK_SIZE(len) ((len) + 1)
+
+/**
+ * 生成查找表，需要在使用文件系统之前调用
+ * @return XST_SUCCESS 或 XST_FAILURE
+ */
+int Encoding_init();
+
+/**
+ * GBK转UTF-8，无法转换的字符输出'?'
+ * @param dst 输出缓冲区
+ * @param size 输出缓冲区大小
+ * @param src GBK字符串
+ * @return 输出长度(不含结束符)，缓冲区不足时返回-1，此时输出在完整字符处截断
+ */
+int Encoding_gbk_to_utf8(char *dst, size_t size, const char *src);
+
+/**
+ * UTF-8转GBK，无法转换的字符输出'?'
+ * @param dst 输出缓冲区
+ * @param size 输出缓冲区大小
+ * @param src UTF-8字符串
+ * @return 输出长度(不含结束符)，缓冲区不足时返回-1，此时输出在完整字符处截断
+ */
+int Encoding_utf8_to_gbk(char *dst, size_t size, const char *src);
+
+#endif //ZYNQ7020_ENCODING_H
@@ -15,9 +15,10 @@ int Fatfs_Init();
 int Fatfs_GetVolSize(const char *path, FSIZE_t *total_size, FSIZE_t *free_size);
 FRESULT Fatfs_GetMountStatus(int index);
 
+/* 直接调用FatFs，只在文件服务任务中执行，其他任务使用FileService_mkdir_p / FileService_rm_rf */
 FRESULT Fatfs_mkdir_p(const char *path);
 FRESULT Fatfs_rm_rf(const char *path);
 char *Fatfs_GetFileDir(const char *filePath);
 
 char *UTF8_TO_GBK(const char *utf8_str);
-char *GBK_TO_UTF8(const char *gbk_str);
\ No newline at end of file
+char *GBK_TO_UTF8(const char *gbk_str);
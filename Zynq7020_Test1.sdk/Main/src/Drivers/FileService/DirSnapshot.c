@@ -0,0 +1,284 @@
+//
+// Created by yaoji on 2022/5/9.
+//
+
+#include "DirSnapshot.h"
+#include "FileService.h"
+#include "Fatfs_init/Fatfs_Driver.h"
+#include "Fatfs_init/Encoding.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "xstatus.h"
+#include <string.h>
+
+#define DIR_SNAPSHOT_QUEUE_LEN      (4)
+#define DIR_SNAPSHOT_STACK_SIZE     (1024)
+#define DIR_SNAPSHOT_PRIORITY       (tskIDLE_PRIORITY + 2)
+#define DIR_SNAPSHOT_PATH_MAX       (512)
+
+static DirSnapshot *cache[DIR_SNAPSHOT_CACHE_SIZE];  // cache[0]为最近使用
+static SemaphoreHandle_t snapshot_mutex;
+static QueueHandle_t scan_queue;
+
+static int DirSnapshot_is_lead(uint8_t c) {
+    return c >= 0x81 && c <= 0xFE;
+}
+
+/**
+ * 把路径转换为"N:/a/b"的形式：没有卷号时为卷0，'\'转换为'/'，
+ * 去掉重复和结尾的分隔符，处理"."和".."，根目录为"N:"
+ * @param dst 结果
+ * @param size dst大小
+ * @param path FatFs路径(GBK)
+ * @return 成功返回0，过长返回-1
+ */
+static int DirSnapshot_normalize(char *dst, size_t size, const char *path) {
+    size_t n = 0;
+    if (size < 3) return -1;
+    if (path[0] >= '0' && path[0] <= '9' && path[1] == ':') {
+        dst[n++] = path[0];
+        path += 2;
+    } else {
+        dst[n++] = '0';
+    }
+    dst[n++] = ':';
+    while (*path) {
+        while (*path == '/' || *path == '\\') path++;
+        if (*path == 0) break;
+        // GBK双字节字符的第二个字节可能是'\'
+        const char *start = path;
+        while (*path && *path != '/' && *path != '\\')
+            path += DirSnapshot_is_lead((uint8_t) *path) && path[1] ? 2 : 1;
+        size_t len = path - start;
+        if (len == 1 && start[0] == '.') continue;
+        if (len == 2 && start[0] == '.' && start[1] == '.') {
+            while (n > 2 && dst[n - 1] != '/') n--;
+            if (n > 2) n--;
+            continue;
+        }
+        if (n + len + 2 > size) return -1;
+        dst[n++] = '/';
+        memcpy(dst + n, start, len);
+        n += len;
+    }
+    dst[n] = 0;
+    return 0;
+}
+
+static void DirSnapshot_unref_locked(DirSnapshot *snap) {
+    if (--snap->refs) return;
+    os_free(snap->path);
+    os_free(snap->entries);
+    os_free(snap->names);
+    os_free(snap);
+}
+
+static void DirSnapshot_remove_locked(DirSnapshot *snap) {
+    for (int i = 0; i < DIR_SNAPSHOT_CACHE_SIZE; i++) {
+        if (cache[i] != snap) continue;
+        memmove(&cache[i], &cache[i + 1], (DIR_SNAPSHOT_CACHE_SIZE - i - 1) * sizeof(DirSnapshot *));
+        cache[DIR_SNAPSHOT_CACHE_SIZE - 1] = NULL;
+        DirSnapshot_unref_locked(snap);
+        return;
+    }
+}
+
+/**
+ * 追加一个目录项，数组扩容需要持有锁，读取方只访问count之前的目录项
+ */
+static int DirSnapshot_append(DirSnapshot *snap, uint32_t index, const char *name, BYTE attr) {
+    uint32_t name_len = strlen(name) + 1;
+    int ok = 1;
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+    if (index >= snap->capacity) {
+        uint32_t capacity = snap->capacity ? snap->capacity * 2 : 64;
+        DirSnapshot_Entry *entries = os_realloc(snap->entries, capacity * sizeof(DirSnapshot_Entry));
+        if (entries) {
+            snap->entries = entries;
+            snap->capacity = capacity;
+        } else ok = 0;
+    }
+    if (ok && snap->names_len + name_len > snap->names_cap) {
+        uint32_t cap = snap->names_cap ? snap->names_cap : 1024;
+        while (cap < snap->names_len + name_len) cap *= 2;
+        char *names = os_realloc(snap->names, cap);
+        if (names) {
+            snap->names = names;
+            snap->names_cap = cap;
+        } else ok = 0;
+    }
+    if (ok) {
+        snap->entries[index].name = snap->names_len;
+        snap->entries[index].attr = attr;
+        memcpy(snap->names + snap->names_len, name, name_len);
+        snap->names_len += name_len;
+    }
+    xSemaphoreGive(snapshot_mutex);
+    return ok;
+}
+
+static FRESULT DirSnapshot_scan(DirSnapshot *snap) {
+    static DIR dir;
+    static FILINFO info;
+    static char utf8[ENCODING_GBK_TO_UTF8_SIZE(FF_MAX_LFN)];
+    uint32_t index = 0;
+
+    FRESULT res = FileService_opendir(&dir, snap->path);
+    if (res != FR_OK) return res;
+    for (;;) {
+        // 没有其他使用者时放弃读取
+        if (snap->refs == 1) break;
+        res = FileService_readdir(&dir, &info);
+        if (res != FR_OK || info.fname[0] == 0) break;
+        /* 跳过系统文件和隐藏文件 */
+        if (info.fattrib & (AM_HID | AM_SYS)) continue;
+        if (index >= DIR_SNAPSHOT_MAX_ENTRIES) break;
+
+        Encoding_gbk_to_utf8(utf8, sizeof(utf8), info.fname);
+        if (!DirSnapshot_append(snap, index, utf8, info.fattrib)) {
+            res = FR_NOT_ENOUGH_CORE;
+            break;
+        }
+        index++;
+        if (index % DIR_SNAPSHOT_PAGE == 0) snap->count = index;
+    }
+    snap->count = index;
+    FileService_closedir(&dir);
+    return res;
+}
+
+static void DirSnapshot_task(void *p) {
+    DirSnapshot *snap;
+    for (;;) {
+        if (xQueueReceive(scan_queue, &snap, portMAX_DELAY) != pdTRUE) continue;
+        snap->result = DirSnapshot_scan(snap);
+        snap->complete = 1;
+        xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+        if (snap->result != FR_OK) DirSnapshot_remove_locked(snap);
+        DirSnapshot_unref_locked(snap);
+        xSemaphoreGive(snapshot_mutex);
+    }
+}
+
+int DirSnapshot_init() {
+    if (snapshot_mutex) return XST_SUCCESS;
+    snapshot_mutex = xSemaphoreCreateMutex();
+    scan_queue = xQueueCreate(DIR_SNAPSHOT_QUEUE_LEN, sizeof(DirSnapshot *));
+    if (snapshot_mutex == NULL || scan_queue == NULL) return XST_FAILURE;
+    if (xTaskCreate(DirSnapshot_task, "DirScan", DIR_SNAPSHOT_STACK_SIZE,
+                    NULL, DIR_SNAPSHOT_PRIORITY, NULL) != pdPASS)
+        return XST_FAILURE;
+    return XST_SUCCESS;
+}
+
+DirSnapshot *DirSnapshot_open(const char *dir) {
+    if (snapshot_mutex == NULL) return NULL;
+    char *gbk = UTF8_TO_GBK(dir);
+    if (gbk == NULL) return NULL;
+    // 与DirSnapshot_invalidate使用相同的形式，根目录为"0:"
+    size_t size = strlen(gbk) + 4;
+    char *path = os_malloc(size);
+    if (path == NULL || DirSnapshot_normalize(path, size, gbk) != 0) {
+        os_free(gbk);
+        os_free(path);
+        return NULL;
+    }
+    os_free(gbk);
+
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+    for (int i = 0; i < DIR_SNAPSHOT_CACHE_SIZE && cache[i]; i++) {
+        DirSnapshot *snap = cache[i];
+        if (snap->stale || strcmp(snap->path, path) != 0) continue;
+        memmove(&cache[1], &cache[0], i * sizeof(DirSnapshot *));
+        cache[0] = snap;
+        snap->refs++;
+        xSemaphoreGive(snapshot_mutex);
+        os_free(path);
+        return snap;
+    }
+
+    DirSnapshot *snap = os_malloc(sizeof(DirSnapshot));
+    if (snap == NULL) {
+        xSemaphoreGive(snapshot_mutex);
+        os_free(path);
+        return NULL;
+    }
+    memset(snap, 0, sizeof(DirSnapshot));
+    snap->path = path;
+    snap->refs = 3;  // 调用者、缓存、扫描任务
+    if (cache[DIR_SNAPSHOT_CACHE_SIZE - 1])
+        DirSnapshot_unref_locked(cache[DIR_SNAPSHOT_CACHE_SIZE - 1]);
+    memmove(&cache[1], &cache[0], (DIR_SNAPSHOT_CACHE_SIZE - 1) * sizeof(DirSnapshot *));
+    cache[0] = snap;
+
+    if (xQueueSendToBack(scan_queue, &snap, 0) != pdTRUE) {
+        snap->result = FR_TIMEOUT;
+        snap->complete = 1;
+        DirSnapshot_remove_locked(snap);
+        snap->refs--;
+    }
+    xSemaphoreGive(snapshot_mutex);
+    return snap;
+}
+
+void DirSnapshot_release(DirSnapshot *snap) {
+    if (snap == NULL) return;
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+    DirSnapshot_unref_locked(snap);
+    xSemaphoreGive(snapshot_mutex);
+}
+
+int DirSnapshot_get(DirSnapshot *snap, uint32_t index, char *name, size_t size, BYTE *attr) {
+    int ok = 0;
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+    if (index < snap->count) {
+        const DirSnapshot_Entry *entry = &snap->entries[index];
+        if (name && size) {
+            strncpy(name, snap->names + entry->name, size - 1);
+            name[size - 1] = 0;
+        }
+        if (attr) *attr = entry->attr;
+        ok = 1;
+    }
+    xSemaphoreGive(snapshot_mutex);
+    return ok;
+}
+
+/**
+ * a是b本身或b的上级目录，都已规范化，与FatFs相同ASCII不区分大小写
+ */
+static int DirSnapshot_is_ancestor(const char *a, const char *b) {
+    for (; *a; a++, b++) {
+        uint8_t ca = *a, cb = *b;
+        if (DirSnapshot_is_lead(ca) && a[1]) {
+            if (ca != cb || a[1] != b[1]) return 0;
+            a++;
+            b++;
+            continue;
+        }
+        if (ca >= 'a' && ca <= 'z') ca -= 'a' - 'A';
+        if (cb >= 'a' && cb <= 'z') cb -= 'a' - 'A';
+        if (ca != cb) return 0;
+    }
+    return *b == 0 || *b == '/';
+}
+
+void DirSnapshot_invalidate(const char *path) {
+    static char norm[DIR_SNAPSHOT_PATH_MAX];
+    if (snapshot_mutex == NULL || path == NULL) return;
+    xSemaphoreTake(snapshot_mutex, portMAX_DELAY);
+    // 路径过长时无法比较，全部失效
+    int all = DirSnapshot_normalize(norm, sizeof(norm), path) != 0;
+    for (int i = 0; i < DIR_SNAPSHOT_CACHE_SIZE && cache[i];) {
+        DirSnapshot *snap = cache[i];
+        if (all || DirSnapshot_is_ancestor(snap->path, norm) || DirSnapshot_is_ancestor(norm, snap->path)) {
+            snap->stale = 1;
+            DirSnapshot_remove_locked(snap);
+        } else {
+            i++;
+        }
+    }
+    xSemaphoreGive(snapshot_mutex);
+}
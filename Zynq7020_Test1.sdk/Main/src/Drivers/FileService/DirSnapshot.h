@@ -0,0 +1,77 @@
+//
+// Created by yaoji on 2022/5/9.
+//
+
+#ifndef ZYNQ7020_DIRSNAPSHOT_H
+#define ZYNQ7020_DIRSNAPSHOT_H
+
+#include "ff.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * 目录快照，后台任务分页读取目录项并转换为UTF-8，界面只读取需要显示的部分。
+ * 最近使用的快照会被缓存，经FileService创建、删除文件时对应的快照失效
+ */
+
+#define DIR_SNAPSHOT_CACHE_SIZE 4           //!< 缓存的目录数量
+#define DIR_SNAPSHOT_PAGE 32                //!< 每次发布的目录项数量
+#define DIR_SNAPSHOT_MAX_ENTRIES 60000      //!< 单个目录的最大项数，受lv_table行数限制
+
+typedef struct {
+    uint32_t name;      //!< 名称在names中的偏移
+    BYTE attr;          //!< FatFs文件属性
+} DirSnapshot_Entry;
+
+typedef struct DirSnapshot {
+    char *path;                     //!< 目录路径(GBK，"0:/a/b"的形式，根目录为"0:")
+    DirSnapshot_Entry *entries;
+    char *names;                    //!< UTF-8名称池
+    uint32_t names_len;
+    uint32_t names_cap;
+    uint32_t capacity;
+    volatile uint32_t count;        //!< 已读取的目录项数
+    volatile uint8_t complete;      //!< 读取完成
+    volatile uint8_t stale;         //!< 目录已被修改，需要重新打开
+    FRESULT result;                 //!< 读取结果，complete后有效
+    uint16_t refs;
+} DirSnapshot;
+
+/**
+ * 创建目录扫描任务
+ * @return XST_SUCCESS 或 XST_FAILURE
+ */
+int DirSnapshot_init();
+
+/**
+ * 打开目录快照，存在有效缓存时直接返回，否则创建新的快照并在后台读取
+ * @param dir UTF-8目录路径，可以带结尾分隔符
+ * @return 快照，使用完成后调用DirSnapshot_release，失败返回NULL
+ */
+DirSnapshot *DirSnapshot_open(const char *dir);
+
+/**
+ * 释放DirSnapshot_open返回的快照
+ * @param snap 快照
+ */
+void DirSnapshot_release(DirSnapshot *snap);
+
+/**
+ * 读取一个目录项
+ * @param snap 快照
+ * @param index 目录项序号，小于count
+ * @param name [out] UTF-8名称，可以为NULL
+ * @param size name缓冲区大小
+ * @param attr [out] 文件属性，可以为NULL
+ * @return 成功返回1，序号越界返回0
+ */
+int DirSnapshot_get(DirSnapshot *snap, uint32_t index, char *name, size_t size, BYTE *attr);
+
+/**
+ * 文件或目录被创建、删除后使其所在目录及上级目录的快照失效，
+ * 被删除的目录下的快照也一起失效
+ * @param path 被修改的路径(GBK)，可以不带卷号，与快照比较前统一为"0:/a/b"的形式
+ */
+void DirSnapshot_invalidate(const char *path);
+
+#endif //ZYNQ7020_DIRSNAPSHOT_H
@@ -0,0 +1,232 @@
+//
+// Created by yaoji on 2022/5/4.
+//
+
+#include "FileService.h"
+#include "queue.h"
+#include "xstatus.h"
+#include "Fatfs_init/Fatfs_Driver.h"
+#include "DirSnapshot.h"
+
+#define FILE_SERVICE_QUEUE_LEN      (16)
+#define FILE_SERVICE_STACK_SIZE     (1024)
+#define FILE_SERVICE_PRIORITY       (configMAX_PRIORITIES - 2)
+
+static QueueHandle_t service_queue;
+static TaskHandle_t service_task_handle;
+
+static void FileService_execute(FileService_Request *req) {
+    req->done = 0;
+    switch (req->op) {
+        case FS_OP_OPEN:
+            req->result = f_open(req->file, req->path, req->mode);
+            break;
+        case FS_OP_CLOSE:
+            req->result = f_close(req->file);
+            break;
+        case FS_OP_READ:
+            req->result = f_read(req->file, req->buf, req->len, &req->done);
+            break;
+        case FS_OP_PREAD:
+            req->result = f_lseek(req->file, req->offset);
+            if (req->result == FR_OK) req->result = f_read(req->file, req->buf, req->len, &req->done);
+            break;
+        case FS_OP_WRITE:
+            req->result = f_write(req->file, req->buf, req->len, &req->done);
+            break;
+        case FS_OP_WRITEV: {
+            const FileService_IoVec *iov = req->buf;
+            req->result = FR_OK;
+            for (UINT i = 0; i < req->len && req->result == FR_OK; i++) {
+                UINT bw = 0;
+                req->result = f_write(req->file, iov[i].buf, iov[i].len, &bw);
+                req->done += bw;
+                if (bw != iov[i].len) break;
+            }
+            break;
+        }
+        case FS_OP_LSEEK:
+            req->result = f_lseek(req->file, req->offset);
+            break;
+        case FS_OP_SYNC:
+            req->result = f_sync(req->file);
+            break;
+        case FS_OP_STAT:
+            req->result = f_stat(req->path, req->info);
+            break;
+        case FS_OP_OPENDIR:
+            req->result = f_opendir(req->dir, req->path);
+            break;
+        case FS_OP_READDIR:
+            req->result = f_readdir(req->dir, req->info);
+            break;
+        case FS_OP_CLOSEDIR:
+            req->result = f_closedir(req->dir);
+            break;
+        case FS_OP_MKDIR:
+            req->result = f_mkdir(req->path);
+            break;
+        case FS_OP_MKDIR_P:
+            req->result = Fatfs_mkdir_p(req->path);
+            break;
+        case FS_OP_UNLINK:
+            req->result = f_unlink(req->path);
+            break;
+        case FS_OP_RM_RF:
+            req->result = Fatfs_rm_rf(req->path);
+            break;
+        case FS_OP_GETFREE:
+            req->result = f_getfree(req->path, &req->clusters, &req->fs);
+            break;
+        default:
+            req->result = FR_INVALID_PARAMETER;
+    }
+
+    // 创建或删除了目录项，缓存的目录快照失效，rm -rf中途失败时也可能已删除了一部分
+    if (req->result == FR_OK || req->op == FS_OP_RM_RF) {
+        if ((req->op == FS_OP_OPEN && (req->mode & (FA_CREATE_NEW | FA_CREATE_ALWAYS | FA_OPEN_ALWAYS))) ||
+            req->op == FS_OP_MKDIR || req->op == FS_OP_MKDIR_P || req->op == FS_OP_UNLINK || req->op == FS_OP_RM_RF)
+            DirSnapshot_invalidate(req->path);
+    }
+}
+
+static void FileService_task(void *p) {
+    FileService_Request *req;
+    for (;;) {
+        if (xQueueReceive(service_queue, &req, portMAX_DELAY) != pdTRUE) continue;
+        FileService_execute(req);
+        // 回调中可能释放请求，先取出等待的任务
+        TaskHandle_t waiter = req->waiter;
+        if (req->callback) req->callback(req);
+        if (waiter) xTaskNotifyGive(waiter);
+    }
+}
+
+int FileService_init() {
+    if (service_task_handle) return XST_SUCCESS;
+    service_queue = xQueueCreate(FILE_SERVICE_QUEUE_LEN, sizeof(FileService_Request *));
+    if (service_queue == NULL) return XST_FAILURE;
+    if (xTaskCreate(FileService_task, "FileService", FILE_SERVICE_STACK_SIZE,
+                    NULL, FILE_SERVICE_PRIORITY, &service_task_handle) != pdPASS) {
+        vQueueDelete(service_queue);
+        service_queue = NULL;
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+BaseType_t FileService_post(FileService_Request *req, TickType_t timeout) {
+    if (req == NULL || service_queue == NULL) return pdFAIL;
+    req->waiter = NULL;
+    return xQueueSendToBack(service_queue, &req, timeout);
+}
+
+FRESULT FileService_call(FileService_Request *req) {
+    // 服务未启动、调度器未运行或在服务任务内部调用时直接执行，避免死锁
+    if (service_queue == NULL || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING ||
+        xTaskGetCurrentTaskHandle() == service_task_handle) {
+        FileService_execute(req);
+        return req->result;
+    }
+    req->callback = NULL;
+    req->waiter = xTaskGetCurrentTaskHandle();
+    xQueueSendToBack(service_queue, &req, portMAX_DELAY);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return req->result;
+}
+
+FRESULT FileService_open(FIL *fp, const char *path, BYTE mode) {
+    FileService_Request req = {.op = FS_OP_OPEN, .file = fp, .path = path, .mode = mode};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_close(FIL *fp) {
+    FileService_Request req = {.op = FS_OP_CLOSE, .file = fp};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_read(FIL *fp, void *buf, UINT btr, UINT *br) {
+    FileService_Request req = {.op = FS_OP_READ, .file = fp, .buf = buf, .len = btr};
+    FRESULT res = FileService_call(&req);
+    if (br) *br = req.done;
+    return res;
+}
+
+FRESULT FileService_pread(FIL *fp, FSIZE_t ofs, void *buf, UINT btr, UINT *br) {
+    FileService_Request req = {.op = FS_OP_PREAD, .file = fp, .offset = ofs, .buf = buf, .len = btr};
+    FRESULT res = FileService_call(&req);
+    if (br) *br = req.done;
+    return res;
+}
+
+FRESULT FileService_write(FIL *fp, const void *buf, UINT btw, UINT *bw) {
+    FileService_Request req = {.op = FS_OP_WRITE, .file = fp, .buf = (void *) buf, .len = btw};
+    FRESULT res = FileService_call(&req);
+    if (bw) *bw = req.done;
+    return res;
+}
+
+FRESULT FileService_writev(FIL *fp, const FileService_IoVec *iov, UINT iovcnt, UINT *bw) {
+    FileService_Request req = {.op = FS_OP_WRITEV, .file = fp, .buf = (void *) iov, .len = iovcnt};
+    FRESULT res = FileService_call(&req);
+    if (bw) *bw = req.done;
+    return res;
+}
+
+FRESULT FileService_lseek(FIL *fp, FSIZE_t ofs) {
+    FileService_Request req = {.op = FS_OP_LSEEK, .file = fp, .offset = ofs};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_sync(FIL *fp) {
+    FileService_Request req = {.op = FS_OP_SYNC, .file = fp};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_stat(const char *path, FILINFO *fno) {
+    FileService_Request req = {.op = FS_OP_STAT, .path = path, .info = fno};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_opendir(DIR *dp, const char *path) {
+    FileService_Request req = {.op = FS_OP_OPENDIR, .dir = dp, .path = path};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_readdir(DIR *dp, FILINFO *fno) {
+    FileService_Request req = {.op = FS_OP_READDIR, .dir = dp, .info = fno};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_closedir(DIR *dp) {
+    FileService_Request req = {.op = FS_OP_CLOSEDIR, .dir = dp};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_mkdir(const char *path) {
+    FileService_Request req = {.op = FS_OP_MKDIR, .path = path};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_mkdir_p(const char *path) {
+    FileService_Request req = {.op = FS_OP_MKDIR_P, .path = path};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_unlink(const char *path) {
+    FileService_Request req = {.op = FS_OP_UNLINK, .path = path};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_rm_rf(const char *path) {
+    FileService_Request req = {.op = FS_OP_RM_RF, .path = path};
+    return FileService_call(&req);
+}
+
+FRESULT FileService_getfree(const char *path, DWORD *nclst, FATFS **fatfs) {
+    FileService_Request req = {.op = FS_OP_GETFREE, .path = path};
+    FRESULT res = FileService_call(&req);
+    if (nclst) *nclst = req.clusters;
+    if (fatfs) *fatfs = req.fs;
+    return res;
+}
@@ -0,0 +1,130 @@
+//
+// Created by yaoji on 2022/5/4.
+//
+
+#ifndef ZYNQ7020_FILESERVICE_H
+#define ZYNQ7020_FILESERVICE_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "ff.h"
+
+/**
+ * 文件服务任务，所有FatFs访问在该任务中串行执行，调用者阻塞等待任务通知，
+ * 不需要关中断保护SD卡读写。
+ * FatFs未开启FF_FS_REENTRANT，文件服务启动后其他任务不能直接调用f_*
+ */
+
+typedef enum {
+    FS_OP_OPEN,
+    FS_OP_CLOSE,
+    FS_OP_READ,
+    FS_OP_PREAD,
+    FS_OP_WRITE,
+    FS_OP_WRITEV,
+    FS_OP_LSEEK,
+    FS_OP_SYNC,
+    FS_OP_STAT,
+    FS_OP_OPENDIR,
+    FS_OP_READDIR,
+    FS_OP_CLOSEDIR,
+    FS_OP_MKDIR,
+    FS_OP_MKDIR_P,
+    FS_OP_UNLINK,
+    FS_OP_RM_RF,
+    FS_OP_GETFREE,
+} FileService_Op;
+
+typedef struct {
+    const void *buf;
+    UINT len;
+} FileService_IoVec;
+
+typedef struct FileService_Request FileService_Request;
+
+typedef void (*FileService_Callback)(FileService_Request *req);
+
+struct FileService_Request {
+    FileService_Op op;
+    FIL *file;
+    DIR *dir;
+    const char *path;
+    BYTE mode;                      //!< f_open的打开方式
+    void *buf;                      //!< 读写缓冲区，FS_OP_WRITEV时为FileService_IoVec数组
+    UINT len;                       //!< 读写长度，FS_OP_WRITEV时为数组长度
+    FSIZE_t offset;                 //!< f_lseek / FS_OP_PREAD的位置
+    FILINFO *info;                  //!< f_stat / f_readdir的结果
+    DWORD clusters;                 //!< [out] f_getfree的空闲簇数
+    FATFS *fs;                      //!< [out] f_getfree的文件系统对象
+    UINT done;                      //!< [out] 实际读写长度
+    FRESULT result;                 //!< [out] 执行结果
+    FileService_Callback callback;  //!< 异步请求完成回调，在文件服务任务中执行
+    void *user_data;
+    TaskHandle_t waiter;            //!< 同步请求等待的任务，内部使用
+};
+
+/**
+ * 创建文件服务任务
+ * @return XST_SUCCESS 或 XST_FAILURE
+ */
+int FileService_init();
+
+/**
+ * 异步提交请求，请求结构体在回调执行前不能释放
+ * @param req 请求
+ * @param timeout 请求队列满时的等待时间
+ * @return
+ */
+BaseType_t FileService_post(FileService_Request *req, TickType_t timeout);
+
+/**
+ * 同步执行请求，在文件服务任务中调用或者服务未启动时直接执行
+ * @param req 请求
+ * @return 请求结果
+ */
+FRESULT FileService_call(FileService_Request *req);
+
+FRESULT FileService_open(FIL *fp, const char *path, BYTE mode);
+FRESULT FileService_close(FIL *fp);
+FRESULT FileService_read(FIL *fp, void *buf, UINT btr, UINT *br);
+
+/**
+ * 在一次请求中定位并读取，文件指针停在读取的末尾
+ * @param fp 文件
+ * @param ofs 读取位置
+ * @param br 实际读取长度
+ * @return 定位失败时返回f_lseek的结果
+ */
+FRESULT FileService_pread(FIL *fp, FSIZE_t ofs, void *buf, UINT btr, UINT *br);
+FRESULT FileService_write(FIL *fp, const void *buf, UINT btw, UINT *bw);
+
+/**
+ * 在一次请求中依次写入多段数据，减少与文件服务任务的切换
+ * @param fp 文件
+ * @param iov 数据段
+ * @param iovcnt 段数
+ * @param bw 实际写入的总长度
+ * @return 遇到错误或磁盘满时停止，返回f_write的结果
+ */
+FRESULT FileService_writev(FIL *fp, const FileService_IoVec *iov, UINT iovcnt, UINT *bw);
+FRESULT FileService_lseek(FIL *fp, FSIZE_t ofs);
+FRESULT FileService_sync(FIL *fp);
+FRESULT FileService_stat(const char *path, FILINFO *fno);
+FRESULT FileService_opendir(DIR *dp, const char *path);
+FRESULT FileService_readdir(DIR *dp, FILINFO *fno);
+FRESULT FileService_closedir(DIR *dp);
+FRESULT FileService_mkdir(const char *path);
+FRESULT FileService_mkdir_p(const char *path);
+FRESULT FileService_unlink(const char *path);
+
+/**
+ * 递归删除文件或目录
+ */
+FRESULT FileService_rm_rf(const char *path);
+
+/**
+ * 获取卷的空闲簇数，参数同f_getfree
+ */
+FRESULT FileService_getfree(const char *path, DWORD *nclst, FATFS **fatfs);
+
+#endif //ZYNQ7020_FILESERVICE_H
@@ -7,28 +7,396 @@
 
 #include "FreeRTOS_Mem/FreeRTOS_Mem.h"
 #include "FreeRTOS.h"
+#include "task.h"
 #include "stdlib.h"
+#include "string.h"
 #include "xil_cache.h"
+#include "xstatus.h"
+#include "src/misc/lv_tlsf.h"
 
-void *os_malloc(size_t __size) {
+#define OS_MEM_ALIGN 8
+#define OS_MEM_PAGES (OS_MEM_SMALL_ARENA / OS_MEM_PAGE_SIZE)
+
+static const uint16_t class_size[OS_MEM_CLASS_NUM] = {
+        8, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048,
+};
+
+typedef struct {
+    void *free_list;            //!< 空闲块单链表，块的首字存下一块地址
+    uint32_t pages;
+    volatile uint32_t used;
+    volatile uint32_t peak;
+} os_mem_class_t;
+
+static os_mem_class_t classes[OS_MEM_CLASS_NUM];
+
+/* 小块区，页号 -> 尺寸类 */
+static uint8_t *small_base;
+static uint32_t small_pages_used;
+static uint8_t page_class[OS_MEM_PAGES];
+static volatile size_t small_used;
+static volatile size_t small_peak;
+static volatile uint32_t small_fallback;
+
+/* 大块区 */
+static lv_tlsf_t tlsf;
+static lv_pool_t large_pools[OS_MEM_LARGE_POOLS];
+static size_t large_pool_size[OS_MEM_LARGE_POOLS];
+static int large_pool_num;
+static size_t large_used;
+static size_t large_peak;
+
+static volatile int initialized;
+
+/**
+ * 尺寸类：8~32按8字节递增，之后每个2的幂之间两档
+ * @param size 请求大小 0 ~ OS_MEM_SMALL_MAX
+ * @return 尺寸类
+ */
+static inline int os_mem_size_class(size_t size) {
+    if (size <= 32) return size ? (int) ((size - 1) >> 3) : 0;
+    uint32_t n = size - 1;
+    int log2 = 31 - __builtin_clz(n);
+    return 4 + (log2 - 5) * 2 + (int) ((n >> (log2 - 1)) & 1);
+}
+
+static inline void os_mem_update_peak(volatile uint32_t *peak, uint32_t value) {
+    uint32_t old = *peak;
+    while (value > old && !__atomic_compare_exchange_n(peak, &old, value, 1,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+/**
+ * 空闲链表的压入和弹出只屏蔽可调用FreeRTOS API的中断几条指令。
+ * 不用LDREX/STREX：异常返回不清除独占监视器，任务在LDREX之后被抢占，
+ * 恢复时可能沿用其他任务留下的独占状态，STREX在表头已被改过的情况下仍然成功(ABA)。
+ * 统计计数仍用原子操作，同样的情况只会少计一次，不影响链表
+ */
+static inline void os_mem_push(os_mem_class_t *cls, void *first, void *last) {
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    *(void **) last = cls->free_list;
+    cls->free_list = first;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+static inline void *os_mem_pop(os_mem_class_t *cls) {
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    void *blk = cls->free_list;
+    if (blk) cls->free_list = *(void **) blk;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    return blk;
+}
+
+/* newlib的malloc不是线程安全的，只在初始化和扩充TLSF时调用 */
+static void *os_mem_sys_alloc(size_t size) {
     vPortEnterCritical();
-    void *p = malloc(__size);
+    void *p = malloc(size);
     vPortExitCritical();
     return p;
 }
 
+static int os_mem_add_pool(size_t min_size) {
+    if (large_pool_num >= OS_MEM_LARGE_POOLS) return XST_FAILURE;
+    size_t size = OS_MEM_LARGE_CHUNK;
+    if (size < min_size) size = min_size;
+    if (size > LV_MEM_CUSTOM_TLSF_POOL_MAX) return XST_FAILURE;
+
+    void *mem = os_mem_sys_alloc(size);
+    if (mem == NULL) return XST_FAILURE;
+    lv_pool_t pool;
+    if (tlsf == NULL) {
+        tlsf = lv_tlsf_create_with_pool(mem, size);
+        pool = tlsf ? lv_tlsf_get_pool(tlsf) : NULL;
+    } else {
+        pool = lv_tlsf_add_pool(tlsf, mem, size);
+    }
+    if (pool == NULL) {
+        vPortEnterCritical();
+        free(mem);
+        vPortExitCritical();
+        return XST_FAILURE;
+    }
+    large_pools[large_pool_num] = pool;
+    large_pool_size[large_pool_num] = size;
+    large_pool_num++;
+    return XST_SUCCESS;
+}
+
+/* 调用者需挂起调度器 */
+static void os_mem_init_locked() {
+    if (initialized) return;
+    uint8_t *arena = os_mem_sys_alloc(OS_MEM_SMALL_ARENA + OS_MEM_PAGE_SIZE);
+    if (arena) small_base = (uint8_t *) (((uintptr_t) arena + OS_MEM_PAGE_SIZE - 1) & ~(OS_MEM_PAGE_SIZE - 1));
+    os_mem_add_pool(0);
+    initialized = 1;
+}
+
+static inline int os_mem_is_small(const void *p) {
+    return small_base != NULL && (const uint8_t *) p >= small_base &&
+           (const uint8_t *) p < small_base + OS_MEM_SMALL_ARENA;
+}
+
+static void *os_mem_large_alloc(size_t size) {
+    if (size == 0) size = 1;    // TLSF对0字节请求返回NULL
+    vTaskSuspendAll();
+    os_mem_init_locked();
+    void *p = tlsf ? lv_tlsf_memalign(tlsf, OS_MEM_ALIGN, size) : NULL;
+    if (p == NULL) {
+        size_t need = size + OS_MEM_ALIGN + lv_tlsf_size() + 4 * lv_tlsf_pool_overhead();
+        if (os_mem_add_pool(need) == XST_SUCCESS)
+            p = lv_tlsf_memalign(tlsf, OS_MEM_ALIGN, size);
+    }
+    if (p) {
+        large_used += lv_tlsf_block_size(p);
+        if (large_used > large_peak) large_peak = large_used;
+    }
+    xTaskResumeAll();
+    return p;
+}
+
+static void os_mem_large_free(void *p) {
+    vTaskSuspendAll();
+    large_used -= lv_tlsf_block_size(p);
+    lv_tlsf_free(tlsf, p);
+    xTaskResumeAll();
+}
+
+/**
+ * 空闲链表为空时从小块区划一页给尺寸类
+ * @return 分配到的块，小块区耗尽时返回NULL
+ */
+static void *os_mem_refill(int idx) {
+    os_mem_class_t *cls = &classes[idx];
+    vTaskSuspendAll();
+    os_mem_init_locked();
+    /* 挂起调度器期间可能已有其他任务补充过 */
+    void *blk = os_mem_pop(cls);
+    if (blk == NULL && small_base != NULL && small_pages_used < OS_MEM_PAGES) {
+        uint32_t page = small_pages_used++;
+        page_class[page] = idx;
+        cls->pages++;
+
+        uint8_t *start = small_base + page * OS_MEM_PAGE_SIZE;
+        uint32_t bsize = class_size[idx];
+        uint32_t count = OS_MEM_PAGE_SIZE / bsize;
+        for (uint32_t i = 1; i < count - 1; i++)
+            *(void **) (start + i * bsize) = start + (i + 1) * bsize;
+        /* 第一块直接返回，其余链入空闲链表 */
+        os_mem_push(cls, start + bsize, start + (count - 1) * bsize);
+        blk = start;
+    }
+    xTaskResumeAll();
+    return blk;
+}
+
+static void *os_mem_raw_alloc(size_t size) {
+    if (size > OS_MEM_SMALL_MAX) return os_mem_large_alloc(size);
+
+    int idx = os_mem_size_class(size);
+    os_mem_class_t *cls = &classes[idx];
+    void *p = os_mem_pop(cls);
+    if (p == NULL) p = os_mem_refill(idx);
+    if (p == NULL) {
+        __atomic_add_fetch(&small_fallback, 1, __ATOMIC_RELAXED);
+        return os_mem_large_alloc(size);
+    }
+
+    os_mem_update_peak(&cls->peak, __atomic_add_fetch(&cls->used, 1, __ATOMIC_RELAXED));
+    size_t total = __atomic_add_fetch(&small_used, class_size[idx], __ATOMIC_RELAXED);
+    if (total > small_peak) small_peak = total;    // 统计值，并发时可能略偏小
+    return p;
+}
+
+static void os_mem_raw_free(void *p) {
+    if (!os_mem_is_small(p)) {
+        os_mem_large_free(p);
+        return;
+    }
+    int idx = page_class[((uint8_t *) p - small_base) / OS_MEM_PAGE_SIZE];
+    os_mem_class_t *cls = &classes[idx];
+    os_mem_push(cls, p, p);
+    __atomic_sub_fetch(&cls->used, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&small_used, class_size[idx], __ATOMIC_RELAXED);
+}
+
+/**
+ * 判断realloc能否原地完成
+ * @param p 块地址
+ * @param size 新的请求长度
+ * @param capacity [out] 块的实际容量
+ * @return 原地可以容纳size时返回1
+ */
+static int os_mem_raw_fits(void *p, size_t size, size_t *capacity) {
+    if (os_mem_is_small(p)) {
+        *capacity = class_size[page_class[((uint8_t *) p - small_base) / OS_MEM_PAGE_SIZE]];
+        /* 仍落在同一尺寸类时原地返回 */
+        return size <= *capacity && class_size[os_mem_size_class(size)] == *capacity;
+    }
+    *capacity = lv_tlsf_block_size(p);
+    return size <= *capacity && size > *capacity / 2;
+}
+
+/* 每个块前的标签头，8字节保持块的对齐 */
+typedef struct {
+    uint32_t size;      //!< 请求长度
+    uint32_t tag;
+} os_mem_header_t;
+
+static os_mem_tag_stats_t tag_stats[OS_MEM_TAG_NUM];
+
+static const char *const tag_name[OS_MEM_TAG_NUM] = {
+        [OS_MEM_TAG_OTHER] = "其他",
+        [OS_MEM_TAG_LVGL] = "LVGL",
+        [OS_MEM_TAG_CJSON] = "cJSON",
+        [OS_MEM_TAG_FILE_DECODER] = "FileDecoder",
+        [OS_MEM_TAG_LWIP_APPS] = "lwIP应用",
+};
+
+static inline void os_mem_tag_add(uint32_t tag, size_t size) {
+    os_mem_tag_stats_t *t = &tag_stats[tag];
+    __atomic_add_fetch(&t->count, 1, __ATOMIC_RELAXED);
+    os_mem_update_peak(&t->peak, __atomic_add_fetch(&t->used, size, __ATOMIC_RELAXED));
+}
+
+static inline void os_mem_tag_sub(uint32_t tag, size_t size) {
+    os_mem_tag_stats_t *t = &tag_stats[tag];
+    __atomic_sub_fetch(&t->count, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&t->used, size, __ATOMIC_RELAXED);
+}
+
+void *os_malloc_tag(size_t __size, os_mem_tag_t tag) {
+    if (tag >= OS_MEM_TAG_NUM) tag = OS_MEM_TAG_OTHER;
+    os_mem_header_t *hdr = os_mem_raw_alloc(__size + sizeof(os_mem_header_t));
+    if (hdr == NULL) return NULL;
+    hdr->size = __size;
+    hdr->tag = tag;
+    os_mem_tag_add(tag, __size);
+    return hdr + 1;
+}
+
+void *os_malloc(size_t __size) {
+    return os_malloc_tag(__size, OS_MEM_TAG_OTHER);
+}
+
 void *os_realloc(void *__r, size_t __size) {
-    vPortEnterCritical();
-    void *p = realloc(__r, __size);
-    vPortExitCritical();
+    if (__r == NULL) return os_malloc(__size);
+    if (__size == 0) {
+        os_free(__r);
+        return NULL;
+    }
+
+    os_mem_header_t *hdr = (os_mem_header_t *) __r - 1;
+    uint32_t tag = hdr->tag;
+    size_t capacity;
+    if (os_mem_raw_fits(hdr, __size + sizeof(os_mem_header_t), &capacity)) {
+        os_mem_tag_sub(tag, hdr->size);
+        os_mem_tag_add(tag, __size);
+        hdr->size = __size;
+        return __r;
+    }
+
+    void *p = os_malloc_tag(__size, tag);
+    if (p == NULL) return NULL;
+    memcpy(p, __r, hdr->size < __size ? hdr->size : __size);
+    os_free(__r);
     return p;
 }
 
 void os_free(void *__r) {
     if (__r == NULL) return;
-    vPortEnterCritical();
-    free(__r);
-    vPortExitCritical();
+    os_mem_header_t *hdr = (os_mem_header_t *) __r - 1;
+    os_mem_tag_sub(hdr->tag, hdr->size);
+    os_mem_raw_free(hdr);
+}
+
+const char *os_mem_tag_name(os_mem_tag_t tag) {
+    return tag < OS_MEM_TAG_NUM ? tag_name[tag] : "";
+}
+
+void os_mem_get_tag_stats(os_mem_tag_t tag, os_mem_tag_stats_t *stats) {
+    if (tag >= OS_MEM_TAG_NUM) {
+        memset(stats, 0, sizeof(os_mem_tag_stats_t));
+        return;
+    }
+    *stats = tag_stats[tag];
+}
+
+void os_mem_reset_tag_peak(os_mem_tag_t tag) {
+    if (tag >= OS_MEM_TAG_NUM) return;
+    __atomic_store_n(&tag_stats[tag].peak, tag_stats[tag].used, __ATOMIC_RELAXED);
+}
+
+int os_mem_get_task_stacks(os_mem_task_stack_t *tasks, int max) {
+#if configUSE_TRACE_FACILITY
+    UBaseType_t num = uxTaskGetNumberOfTasks();
+    TaskStatus_t *status = os_mem_raw_alloc(num * sizeof(TaskStatus_t));
+    if (status == NULL) return 0;
+    num = uxTaskGetSystemState(status, num, NULL);
+    int n = 0;
+    for (UBaseType_t i = 0; i < num; i++) {
+        uint32_t free_min = status[i].usStackHighWaterMark * sizeof(StackType_t);
+        /* 按剩余栈从小到大插入，只保留最紧张的max个 */
+        int pos = n;
+        while (pos > 0 && tasks[pos - 1].free_min > free_min) pos--;
+        if (pos >= max) continue;
+        if (n < max) n++;
+        memmove(&tasks[pos + 1], &tasks[pos], (n - 1 - pos) * sizeof(os_mem_task_stack_t));
+        strncpy(tasks[pos].name, status[i].pcTaskName, sizeof(tasks[pos].name) - 1);
+        tasks[pos].name[sizeof(tasks[pos].name) - 1] = 0;
+        tasks[pos].priority = status[i].uxCurrentPriority;
+        tasks[pos].free_min = free_min;
+    }
+    os_mem_raw_free(status);
+    return n;
+#else
+    (void) tasks;
+    (void) max;
+    return 0;
+#endif
+}
+
+typedef struct {
+    size_t free_total;
+    size_t free_max;
+} os_mem_walk_t;
+
+static void os_mem_walker(void *ptr, size_t size, int used, void *user) {
+    (void) ptr;
+    os_mem_walk_t *walk = user;
+    if (used) return;
+    walk->free_total += size;
+    if (size > walk->free_max) walk->free_max = size;
+}
+
+void os_mem_get_stats(os_mem_stats_t *stats) {
+    os_mem_walk_t walk = {0};
+    memset(stats, 0, sizeof(os_mem_stats_t));
+
+    vTaskSuspendAll();
+    stats->small_reserved = small_pages_used * OS_MEM_PAGE_SIZE;
+    stats->small_used = small_used;
+    stats->small_peak = small_peak;
+    stats->small_fallback = small_fallback;
+    for (int i = 0; i < large_pool_num; i++) {
+        stats->large_total += large_pool_size[i];
+        lv_tlsf_walk_pool(large_pools[i], os_mem_walker, &walk);
+    }
+    stats->large_used = large_used;
+    stats->large_peak = large_peak;
+    xTaskResumeAll();
+
+    stats->large_free_max = walk.free_max;
+    if (walk.free_total)
+        stats->fragmentation = 100 - (uint32_t) ((uint64_t) walk.free_max * 100 / walk.free_total);
+}
+
+int os_mem_get_class_stats(int cls, os_mem_class_stats_t *stats) {
+    if (cls < 0 || cls >= OS_MEM_CLASS_NUM) return XST_FAILURE;
+    stats->block_size = class_size[cls];
+    stats->pages = classes[cls].pages;
+    stats->used = classes[cls].used;
+    stats->peak = classes[cls].peak;
+    return XST_SUCCESS;
 }
 
 void os_DCacheInvalidateRange(void *adr, uint32_t len) {
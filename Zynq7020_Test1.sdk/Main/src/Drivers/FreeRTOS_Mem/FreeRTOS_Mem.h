@@ -12,14 +12,126 @@
 #include <stdint.h>
 #include <stddef.h>
 
+/**
+ * 分级分配器：
+ * 不大于OS_MEM_SMALL_MAX的请求按尺寸类从小块区分配，每个尺寸类一条空闲链表，
+ * 链表操作只短暂屏蔽中断；
+ * 更大的请求以及小块区耗尽后的请求由TLSF分配，只挂起调度器不关中断
+ */
+
+#define OS_MEM_SMALL_MAX 2048                       //!< 小块区最大块
+#define OS_MEM_CLASS_NUM 16                         //!< 尺寸类数量
+#define OS_MEM_PAGE_SIZE (64 * 1024)                //!< 小块区按页划分给尺寸类
+#ifndef OS_MEM_SMALL_ARENA
+#define OS_MEM_SMALL_ARENA (16 * 1024 * 1024)       //!< 小块区容量(字节)
+#endif
+#ifndef OS_MEM_LARGE_CHUNK
+#define OS_MEM_LARGE_CHUNK (64 * 1024 * 1024)       //!< TLSF每次向newlib申请的池大小
+#endif
+#define OS_MEM_LARGE_POOLS 8                        //!< TLSF最多管理的池数量
+
+typedef struct {
+    size_t small_reserved;      //!< 小块区已划分给尺寸类的字节数
+    size_t small_used;          //!< 小块区使用中的字节数(按块大小计)
+    size_t small_peak;          //!< 小块区使用峰值
+    size_t large_total;         //!< TLSF池总字节数
+    size_t large_used;          //!< TLSF使用中的字节数
+    size_t large_peak;          //!< TLSF使用峰值
+    size_t large_free_max;      //!< TLSF最大空闲块
+    uint32_t fragmentation;     //!< TLSF外部碎片率(0~100)，1 - 最大空闲块 / 空闲总量
+    uint32_t small_fallback;    //!< 小块区耗尽后改由TLSF分配的次数
+} os_mem_stats_t;
+
+typedef struct {
+    uint32_t block_size;        //!< 块大小
+    uint32_t pages;             //!< 占用的页数
+    uint32_t used;              //!< 使用中的块数
+    uint32_t peak;              //!< 使用中块数的峰值
+} os_mem_class_stats_t;
+
+/**
+ * 分配标签，每块前有8字节的头记录长度和标签，用于按子系统统计
+ */
+typedef enum {
+    OS_MEM_TAG_OTHER,
+    OS_MEM_TAG_LVGL,
+    OS_MEM_TAG_CJSON,
+    OS_MEM_TAG_FILE_DECODER,
+    OS_MEM_TAG_LWIP_APPS,
+    OS_MEM_TAG_NUM,
+} os_mem_tag_t;
+
+typedef struct {
+    volatile uint32_t used;     //!< 当前使用字节数(按请求长度计)
+    volatile uint32_t peak;     //!< 使用峰值
+    volatile uint32_t count;    //!< 当前块数
+} os_mem_tag_stats_t;
+
+typedef struct {
+    char name[16];
+    uint32_t priority;
+    uint32_t free_min;          //!< 任务运行以来栈剩余的最小值(字节)
+} os_mem_task_stack_t;
+
 void *os_malloc(size_t __size);
 
+/**
+ * 带标签分配，释放和realloc仍使用os_free/os_realloc，realloc保留原标签
+ * @param __size 长度
+ * @param tag 标签
+ * @return 内存地址，失败返回NULL
+ */
+void *os_malloc_tag(size_t __size, os_mem_tag_t tag);
+
 void *os_realloc(void *__r, size_t __size);
 
 void *os_reallocarray(void *ptr, size_t nmemb, size_t size);
 
 void os_free(void *__r);
 
+/**
+ * 获取分配器统计，需要遍历TLSF池，不要在频繁调用的路径上使用
+ * @param stats [out] 统计数据
+ */
+void os_mem_get_stats(os_mem_stats_t *stats);
+
+/**
+ * 获取尺寸类统计
+ * @param cls 尺寸类 0 ~ OS_MEM_CLASS_NUM-1
+ * @param stats [out] 统计数据
+ * @return XST_SUCCESS 或 XST_FAILURE(cls越界)
+ */
+int os_mem_get_class_stats(int cls, os_mem_class_stats_t *stats);
+
+/**
+ * 获取标签名
+ * @param tag 标签
+ * @return 标签名(UTF-8)
+ */
+const char *os_mem_tag_name(os_mem_tag_t tag);
+
+/**
+ * 获取标签统计
+ * @param tag 标签
+ * @param stats [out] 统计数据
+ */
+void os_mem_get_tag_stats(os_mem_tag_t tag, os_mem_tag_stats_t *stats);
+
+/**
+ * 将标签的使用峰值重置为当前使用量，用于测量一段操作的峰值
+ * @param tag 标签
+ */
+void os_mem_reset_tag_peak(os_mem_tag_t tag);
+
+/**
+ * 获取任务栈高水位，按剩余栈从小到大排列
+ * 需要FreeRTOS开启configUSE_TRACE_FACILITY，否则返回0
+ * @param tasks [out] 任务栈信息
+ * @param max tasks数组长度
+ * @return 填入的任务数
+ */
+int os_mem_get_task_stacks(os_mem_task_stack_t *tasks, int max);
+
 void os_DCacheInvalidateRange(void *adr, uint32_t len);
 
 void os_DCacheFlushRange(void *adr, uint32_t len);
@@ -7,15 +7,19 @@
 
 #include "LVGL_Zynq_Init/zynq_lvgl_init.h"
 
+#include <string.h>
 #include "Fatfs_init/Fatfs_Driver.h"
+#include "Fatfs_init/Encoding.h"
 #include "FreeRTOS_Mem/FreeRTOS_Mem.h"
 #include "GT911_Driver/GT911_Driver.h"
 #include "VDMA_Driver/VDMA_Driver.h"
 #include "task.h"
 #include "xil_cache.h"
+#include "xtime_l.h"
 #include "check.h"
 #include "main.h"
 #include "zynq_lvgl_snapshot.h"
+#include "zynq_lvgl_remote.h"
 
 static lv_indev_drv_t touch_drv;
 static lv_indev_drv_t btn_drv;
@@ -27,32 +31,225 @@ static lv_disp_drv_t disp_drv;
 static lv_disp_draw_buf_t disp_draw_buf;
 static lv_disp_t *disp = NULL;
 
+/*
+ * 局部刷新：direct_mode下LVGL只把无效区域画进当前显存，两块显存交替显示。
+ * 开始绘制前把上一帧画过的区域从正在显示的显存拷过来，保证两块显存内容一致；
+ * 切换显存前只对画过和拷贝过的行刷新cache
+ */
+#define ZYNQ_ROW_WORDS ((VDMA_V_ACTIVE + 31) / 32)
+
+static lv_area_t sync_areas[LV_INV_BUF_SIZE];   //!< 上一帧重绘的区域
+static uint32_t sync_num;
+static uint32_t dirty_rows[ZYNQ_ROW_WORDS];     //!< 切换前需要刷新cache的行
+static volatile uint8_t flip_pending;           //!< 已切换显存，等待VDMA帧中断
+
 static void zynq_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
 static void zynq_wait_cb(lv_disp_drv_t *drv);
+static void zynq_render_start_cb(lv_disp_drv_t *drv);
 static void zynq_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px);
 static void zynq_lv_log_print(const char *buf);
 static void zynq_touch_read(lv_indev_drv_t *drv, lv_indev_data_t *data);
 static void zynq_btn_read(lv_indev_drv_t *indev_drv, lv_indev_data_t *data);
 
+/*
+ * 帧调度：刷新定时器的回调换成空函数，由LVGL任务在帧时刻调用_lv_disp_refr_timer，
+ * 数据定时器平时暂停，只在帧时刻就绪一次
+ */
+#define ZYNQ_COUNTS_PER_US (COUNTS_PER_SECOND / 1000000)
+
+static lv_timer_t *data_timers[ZYNQ_LVGL_DATA_TIMER_MAX];
+static volatile uint32_t target_fps = ZYNQ_LVGL_TARGET_FPS;
+static uint32_t flush_us;                       //!< 当前帧flush阶段的耗时
+static zynq_lvgl_frame_stats_t frame_stats;     //!< 上一个统计窗口的结果
+
+static struct {
+    uint64_t start_us;
+    uint32_t frames;
+    uint32_t skipped;
+    uint32_t timers_us;
+    uint32_t layout_us;
+    uint32_t draw_us;
+    uint32_t flush_us;
+    uint32_t frame_max_us;
+} stats_acc;
+
+#if ZYNQ_LVGL_STATS_LABEL
+static lv_obj_t *stats_label = NULL;
+#endif
+
+static inline uint64_t zynq_lvgl_now_us() {
+    XTime now;
+    XTime_GetTime(&now);
+    return now / ZYNQ_COUNTS_PER_US;
+}
+
+static void zynq_refr_timer_cb(lv_timer_t *timer) {
+    /* 刷新由zynq_lvgl_render_frame完成，这里只保留定时器周期给性能监视器计算帧率上限 */
+    LV_UNUSED(timer);
+}
+
+static void zynq_data_timers_run(bool run) {
+    for (uint32_t i = 0; i < ZYNQ_LVGL_DATA_TIMER_MAX; i++) {
+        if (data_timers[i] == NULL) continue;
+        if (run) {
+            lv_timer_resume(data_timers[i]);
+            lv_timer_ready(data_timers[i]);
+        } else {
+            lv_timer_pause(data_timers[i]);
+        }
+    }
+}
+
+/**
+ * 更新布局，有无效区域时绘制并切换显存
+ * @param timers_us 本帧定时器耗时
+ */
+static void zynq_lvgl_render_frame(uint32_t timers_us) {
+    uint64_t t0 = zynq_lvgl_now_us();
+    lv_obj_update_layout(disp->act_scr);
+    if (disp->prev_scr) lv_obj_update_layout(disp->prev_scr);
+    lv_obj_update_layout(disp->top_layer);
+    lv_obj_update_layout(disp->sys_layer);
+    uint64_t t1 = zynq_lvgl_now_us();
+    uint32_t layout_us = t1 - t0;
+
+    if (disp->inv_p == 0) {
+        stats_acc.skipped++;
+        return;
+    }
+
+    flush_us = 0;
+    _lv_disp_refr_timer(disp->refr_timer);
+    uint32_t refr_us = zynq_lvgl_now_us() - t1;
+    uint32_t draw_us = refr_us > flush_us ? refr_us - flush_us : 0;
+    uint32_t frame_us = timers_us + layout_us + refr_us;
+
+    stats_acc.frames++;
+    stats_acc.timers_us += timers_us;
+    stats_acc.layout_us += layout_us;
+    stats_acc.draw_us += draw_us;
+    stats_acc.flush_us += flush_us;
+    if (frame_us > stats_acc.frame_max_us) stats_acc.frame_max_us = frame_us;
+}
+
+/**
+ * 统计窗口结束时发布平均耗时
+ * @param now 当前时间
+ */
+static void zynq_lvgl_publish_stats(uint64_t now) {
+    uint32_t elapsed_us = now - stats_acc.start_us;
+    if (elapsed_us < ZYNQ_LVGL_STATS_PERIOD_MS * 1000) return;
+
+    uint32_t n = stats_acc.frames ? stats_acc.frames : 1;
+    taskENTER_CRITICAL();
+    frame_stats.target_fps = target_fps;
+    frame_stats.frames += stats_acc.frames;
+    frame_stats.skipped += stats_acc.skipped;
+    frame_stats.fps = (uint64_t) stats_acc.frames * 1000000 / elapsed_us;
+    frame_stats.timers_us = stats_acc.timers_us / n;
+    frame_stats.layout_us = stats_acc.layout_us / n;
+    frame_stats.draw_us = stats_acc.draw_us / n;
+    frame_stats.flush_us = stats_acc.flush_us / n;
+    frame_stats.frame_max_us = stats_acc.frame_max_us;
+    taskEXIT_CRITICAL();
+
+#if ZYNQ_LVGL_STATS_LABEL
+    /* 标签本身的重绘算进下一个窗口 */
+    lv_label_set_text_fmt(stats_label, "T %lu.%lu L %lu.%lu D %lu.%lu F %lu.%lu ms\n%lu/%lu FPS",
+                          frame_stats.timers_us / 1000, frame_stats.timers_us / 100 % 10,
+                          frame_stats.layout_us / 1000, frame_stats.layout_us / 100 % 10,
+                          frame_stats.draw_us / 1000, frame_stats.draw_us / 100 % 10,
+                          frame_stats.flush_us / 1000, frame_stats.flush_us / 100 % 10,
+                          frame_stats.fps, frame_stats.target_fps);
+#endif
+
+    lv_memset_00(&stats_acc, sizeof(stats_acc));
+    stats_acc.start_us = now;
+}
+
 #ifdef __USE_RTOS
 xSemaphoreHandle LVGL_Mutex = NULL;
 static TaskHandle_t rtos_TaskHandle;
 
 static void zynq_lv_timerTask(void *pvParameters) {
-    portTickType xLastExecutionTime = xTaskGetTickCount();
+    uint32_t fps = 0;
+    uint64_t frame_period_us = 0;
+    uint64_t next_frame_us = zynq_lvgl_now_us();
+    stats_acc.start_us = next_frame_us;
     for (;;) {
+        uint64_t now = zynq_lvgl_now_us();
+        bool frame = now >= next_frame_us;
+
         xSemaphoreTake(LVGL_Mutex, portMAX_DELAY);
-        lv_timer_handler();
+        if (fps != target_fps) {
+            fps = target_fps;
+            frame_period_us = 1000000 / fps;
+            lv_timer_set_period(disp->refr_timer, 1000 / fps);
+        }
+        if (frame) {
+            /* 落后超过一帧时不补帧 */
+            next_frame_us += frame_period_us;
+            if (next_frame_us <= now) next_frame_us = now + frame_period_us;
+            zynq_data_timers_run(true);
+        }
+        uint32_t next_timer_ms = lv_timer_handler();
+        if (frame) {
+            zynq_data_timers_run(false);
+            zynq_lvgl_render_frame(zynq_lvgl_now_us() - now);
+        }
+        now = zynq_lvgl_now_us();
+        zynq_lvgl_publish_stats(now);
         xSemaphoreGive(LVGL_Mutex);
+
         if (xSemaphoreTake(key_handle, 0) == pdTRUE) {
             zynq_lvgl_snapshot(disp_draw_buf.buf_act);
         }
-        vTaskDelayUntil(&xLastExecutionTime, pdMS_TO_TICKS(75));
+
+        /* 睡到下一帧时刻或下一个普通定时器，至少让出一个tick */
+        now = zynq_lvgl_now_us();
+        uint32_t wait_ms = next_frame_us > now ? (next_frame_us - now + 999) / 1000 : 0;
+        if (next_timer_ms < wait_ms) wait_ms = next_timer_ms;
+        TickType_t ticks = (wait_ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+        vTaskDelay(ticks ? ticks : 1);
     }
 }
 
 #endif
 
+lv_timer_t *zynq_lvgl_data_timer_create(lv_timer_cb_t cb, void *user_data) {
+    lv_timer_t *timer = lv_timer_create(cb, 1000 / ZYNQ_LVGL_TARGET_FPS, user_data);
+    LV_ASSERT_MALLOC(timer);
+    if (timer == NULL) return NULL;
+    lv_timer_pause(timer);
+    for (uint32_t i = 0; i < ZYNQ_LVGL_DATA_TIMER_MAX; i++) {
+        if (data_timers[i] == NULL) {
+            data_timers[i] = timer;
+            return timer;
+        }
+    }
+    /* 数据定时器已满，退化为普通定时器 */
+    LV_LOG_WARN("数据定时器数量超过ZYNQ_LVGL_DATA_TIMER_MAX");
+    lv_timer_resume(timer);
+    return timer;
+}
+
+void zynq_lvgl_data_timer_del(lv_timer_t *timer) {
+    for (uint32_t i = 0; i < ZYNQ_LVGL_DATA_TIMER_MAX; i++) {
+        if (data_timers[i] == timer) data_timers[i] = NULL;
+    }
+    lv_timer_del(timer);
+}
+
+void zynq_lvgl_set_target_fps(uint32_t fps) {
+    target_fps = LV_CLAMP(ZYNQ_LVGL_FPS_MIN, fps, ZYNQ_LVGL_FPS_MAX);
+}
+
+void zynq_lvgl_get_frame_stats(zynq_lvgl_frame_stats_t *stats) {
+    taskENTER_CRITICAL();
+    *stats = frame_stats;
+    taskEXIT_CRITICAL();
+}
+
 int zynq_lvgl_init(XIicPs *_iic, XGpioPs *_gpio) {
     int ret = XST_SUCCESS;
     LVGL_Mutex = xSemaphoreCreateMutex();
@@ -85,12 +282,25 @@ int zynq_lvgl_init(XIicPs *_iic, XGpioPs *_gpio) {
     disp_drv.offset_y = 0;
     disp_drv.draw_buf = &disp_draw_buf;
     disp_drv.direct_mode = TRUE;
-    disp_drv.full_refresh = TRUE;
+    disp_drv.full_refresh = FALSE;
+    disp_drv.render_start_cb = zynq_render_start_cb;
     disp_drv.wait_cb = zynq_wait_cb;
     disp_drv.flush_cb = zynq_flush_cb;
+    disp_drv.invalidate_cb = zynq_lvgl_remote_invalidate;
     //	disp_drv.monitor_cb = zynq_monitor_cb;
 
     disp = lv_disp_drv_register(&disp_drv);
+    lv_timer_set_cb(disp->refr_timer, zynq_refr_timer_cb);
+
+#if ZYNQ_LVGL_STATS_LABEL
+    stats_label = lv_label_create(lv_layer_sys());
+    lv_obj_set_style_bg_opa(stats_label, LV_OPA_50, 0);
+    lv_obj_set_style_bg_color(stats_label, lv_color_black(), 0);
+    lv_obj_set_style_text_color(stats_label, lv_color_white(), 0);
+    lv_obj_set_style_pad_all(stats_label, 3, 0);
+    lv_label_set_text(stats_label, "?");
+    lv_obj_align(stats_label, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+#endif
 
     gt911.GPIOInstancePtr = _gpio;
     gt911.I2CInstancePtr = _iic;
@@ -121,9 +331,79 @@ int zynq_lvgl_init(XIicPs *_iic, XGpioPs *_gpio) {
     return ret;
 }
 
+static void zynq_mark_rows(const lv_area_t *area) {
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) dirty_rows[y / 32] |= 1u << (y % 32);
+}
+
+/**
+ * 区域是否会被这一帧的某个区域完整重绘
+ */
+static bool zynq_area_is_redrawn(lv_disp_t *d, const lv_area_t *area) {
+    for (uint32_t i = 0; i < d->inv_p; i++) {
+        if (!d->inv_area_joined[i] && _lv_area_is_in(area, &d->inv_areas[i], 0)) return true;
+    }
+    return false;
+}
+
+static void zynq_render_start_cb(lv_disp_drv_t *drv) {
+    lv_disp_draw_buf_t *draw_buf = drv->draw_buf;
+    lv_disp_t *d = _lv_refr_get_disp_refreshing();
+    lv_color_t *back = draw_buf->buf_act;
+    lv_color_t *front = back == draw_buf->buf1 ? draw_buf->buf2 : draw_buf->buf1;
+
+    /* 上一帧切换完成之前这一块还在显示 */
+    while (draw_buf->flushing) zynq_wait_cb(drv);
+
+    uint64_t t0 = zynq_lvgl_now_us();
+    for (uint32_t i = 0; i < sync_num; i++) {
+        const lv_area_t *a = &sync_areas[i];
+        if (zynq_area_is_redrawn(d, a)) continue;
+        uint32_t len = lv_area_get_width(a) * sizeof(lv_color_t);
+        for (lv_coord_t y = a->y1; y <= a->y2; y++) {
+            uint32_t offset = y * VDMA_H_STRIDE + a->x1;
+            memcpy(back + offset, front + offset, len);
+        }
+        zynq_mark_rows(a);
+    }
+
+    sync_num = 0;
+    for (uint32_t i = 0; i < d->inv_p; i++) {
+        if (d->inv_area_joined[i]) continue;
+        sync_areas[sync_num++] = d->inv_areas[i];
+        zynq_mark_rows(&d->inv_areas[i]);
+    }
+    flush_us += zynq_lvgl_now_us() - t0;
+}
+
+/**
+ * 对标记的行刷新cache，连续的行合并为一次
+ */
+static void zynq_flush_rows(lv_color_t *gram) {
+    int32_t start = -1;
+    for (int32_t y = 0; y <= VDMA_V_ACTIVE; y++) {
+        bool dirty = y < VDMA_V_ACTIVE && (dirty_rows[y / 32] >> (y % 32) & 1);
+        if (dirty && start < 0) {
+            start = y;
+        } else if (!dirty && start >= 0) {
+            os_DCacheFlushRange(gram + start * VDMA_H_STRIDE, (y - start) * VDMA_H_STRIDE * sizeof(lv_color_t));
+            start = -1;
+        }
+    }
+    memset(dirty_rows, 0, sizeof(dirty_rows));
+}
+
 static void zynq_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p) {
-    os_DCacheFlushRange(color_p, VDMA_BUFFER_SIZE);
+    /* 所有区域都直接画在显存中，最后一个区域画完才切换 */
+    if (!lv_disp_flush_is_last(drv)) {
+        lv_disp_flush_ready(drv);
+        return;
+    }
+    uint64_t t0 = zynq_lvgl_now_us();
+    zynq_flush_rows(color_p);
+    flip_pending = 1;
     VDMA_SetBufferIndex((void *) color_p == (void *) GRAM0 ? 0 : 1);
+    zynq_lvgl_remote_flush(color_p);
+    flush_us += zynq_lvgl_now_us() - t0;
 }
 
 static void zynq_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px) {
@@ -135,14 +415,18 @@ static void zynq_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px) {
 
 void zynq_disp_flush_ready(void *unused) {
     LV_UNUSED(unused);
-    lv_disp_flush_ready(&disp_drv);
+    /* VDMA每帧都会中断，只在切换显存后通知LVGL */
+    if (flip_pending) {
+        flip_pending = 0;
+        lv_disp_flush_ready(&disp_drv);
+    }
 }
 
 static void zynq_lv_log_print(const char *buf) {
 #ifdef PRINT_ENCODE_GBK
-    char *gbk = UTF8_TO_GBK(buf);
+    char gbk[ENCODING_PATH_MAX];
+    Encoding_utf8_to_gbk(gbk, sizeof(gbk), buf);
     print(gbk);
-    os_free(gbk);
 #else
     print(buf);
 #endif
@@ -181,5 +465,7 @@ static void zynq_touch_read(lv_indev_drv_t *drv, lv_indev_data_t *data) {
 }
 
 void zynq_wait_cb(lv_disp_drv_t *drv) {
+    uint64_t t0 = zynq_lvgl_now_us();
     vTaskDelay(1);
+    flush_us += zynq_lvgl_now_us() - t0;
 }
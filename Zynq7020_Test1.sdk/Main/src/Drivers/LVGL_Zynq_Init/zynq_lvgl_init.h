@@ -18,9 +18,64 @@
 extern xSemaphoreHandle LVGL_Mutex;
 #endif
 
+/**
+ * 帧调度：
+ * LVGL任务按目标帧率划分帧时刻，每个帧时刻先运行一次数据定时器取新数据，
+ * 再更新布局，有无效区域才绘制并切换显存，其余时间只运行输入等普通定时器
+ */
+#define ZYNQ_LVGL_TARGET_FPS 30             //!< 默认目标帧率
+#define ZYNQ_LVGL_FPS_MIN 1
+#define ZYNQ_LVGL_FPS_MAX 60
+#define ZYNQ_LVGL_DATA_TIMER_MAX 8          //!< 数据定时器最大数量
+#define ZYNQ_LVGL_STATS_PERIOD_MS 1000      //!< 帧耗时统计窗口
+#ifndef ZYNQ_LVGL_STATS_LABEL
+#define ZYNQ_LVGL_STATS_LABEL 0             //!< 在系统层显示帧耗时，调试时在编译选项中定义为1
+#endif
+
+/**
+ * 最近一个统计窗口内每个渲染帧各阶段的平均耗时，单位us
+ */
+typedef struct {
+    uint32_t target_fps;
+    uint32_t fps;           //!< 窗口内实际渲染的帧率
+    uint32_t frames;        //!< 截至窗口结束的渲染帧总数
+    uint32_t skipped;       //!< 截至窗口结束，帧时刻没有变化而跳过渲染的总次数
+    uint32_t timers_us;     //!< 帧时刻的定时器，包括数据定时器和输入
+    uint32_t layout_us;     //!< 布局更新
+    uint32_t draw_us;       //!< 绘制
+    uint32_t flush_us;      //!< cache刷新、前后缓冲同步和等待VDMA切换
+    uint32_t frame_max_us;  //!< 窗口内最长的一帧
+} zynq_lvgl_frame_stats_t;
+
 int zynq_lvgl_init(XIicPs *_iic, XGpioPs *_gpio);
 
 void zynq_disp_flush_ready(void *);
 
+/**
+ * 创建数据定时器，只在帧时刻运行，每帧最多一次，代替周期1ms的轮询定时器
+ * @param cb 回调，没有新数据时不应使任何对象无效
+ * @param user_data 用户数据
+ * @return 定时器
+ */
+lv_timer_t *zynq_lvgl_data_timer_create(lv_timer_cb_t cb, void *user_data);
+
+/**
+ * 删除数据定时器
+ * @param timer 定时器
+ */
+void zynq_lvgl_data_timer_del(lv_timer_t *timer);
+
+/**
+ * 设置目标帧率，可在任意任务中调用，下一帧生效
+ * @param fps 帧率，限制在ZYNQ_LVGL_FPS_MIN到ZYNQ_LVGL_FPS_MAX之间
+ */
+void zynq_lvgl_set_target_fps(uint32_t fps);
+
+/**
+ * 获取帧耗时统计，可在任意任务中调用
+ * @param stats [out] 统计数据
+ */
+void zynq_lvgl_get_frame_stats(zynq_lvgl_frame_stats_t *stats);
+
 
 #endif /* SRC_LVGL_ZYNQ_INIT_ZYNQ_LVGL_INIT_H_ */
@@ -0,0 +1,194 @@
+//
+// Created by yaoji on 2022/5/14.
+//
+
+#include <string.h>
+#include "zynq_lvgl_remote.h"
+#include "zynq_lvgl_init.h"
+#include "RLE_encoder/rle_encoder.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "xstatus.h"
+#include "xtime_l.h"
+
+#define LVGL_REMOTE_QUEUE_LEN       (1)
+#define LVGL_REMOTE_STACK_SIZE      (512)
+#define LVGL_REMOTE_PRIORITY        (tskIDLE_PRIORITY + 2)
+
+#define LVGL_REMOTE_ALL_COLS ((uint32_t) (((uint64_t) 1 << LVGL_REMOTE_COLS) - 1))
+#define LVGL_REMOTE_BUF_SIZE (sizeof(zynq_lvgl_remote_header_t) + LVGL_REMOTE_COLS * LVGL_REMOTE_ROWS * \
+                             (sizeof(zynq_lvgl_remote_tile_t) + RLE_ENCODE_BOUND(LVGL_REMOTE_TILE * LVGL_REMOTE_TILE)))
+
+static QueueHandle_t remote_queue;
+static TaskHandle_t remote_task_handle;
+static zynq_lvgl_remote_sink_t remote_sink;
+static uint8_t *remote_buf;
+
+static volatile uint32_t sink_num;
+static volatile uint32_t keyframe_req;
+
+/* 以下只在持有LVGL_Mutex时访问，pending和pending_key在busy期间只由远程屏幕任务读取，busy由远程屏幕任务清零 */
+static uint32_t dirty[LVGL_REMOTE_ROWS];        //!< 上次交给任务后变化的图块
+static uint8_t dirty_key;
+static uint32_t pending[LVGL_REMOTE_ROWS];      //!< 任务正在压缩的图块
+static uint8_t pending_key;
+static uint32_t flush_count;
+static uint32_t pending_flush;                  //!< 交给任务时的flush_count
+static uint64_t pending_us;
+static uint64_t last_us;
+static uint32_t seq;
+static volatile uint8_t busy;
+
+static inline uint64_t zynq_lvgl_remote_now_us() {
+    XTime now;
+    XTime_GetTime(&now);
+    return now / (COUNTS_PER_SECOND / 1000000);
+}
+
+/**
+ * 压缩pending中的图块
+ * @param gram 显存
+ * @return 消息长度
+ */
+static uint32_t zynq_lvgl_remote_encode(const lv_color_t *gram) {
+    zynq_lvgl_remote_header_t *header = (zynq_lvgl_remote_header_t *) remote_buf;
+    uint8_t *p = remote_buf + sizeof(zynq_lvgl_remote_header_t);
+    uint16_t tile_num = 0;
+
+    for (uint32_t y = 0; y < LVGL_REMOTE_ROWS; y++) {
+        uint32_t h = LV_MIN(LVGL_REMOTE_TILE, VDMA_V_ACTIVE - y * LVGL_REMOTE_TILE);
+        for (uint32_t bits = pending[y]; bits; bits &= bits - 1) {
+            uint32_t x = __builtin_ctz(bits);
+            zynq_lvgl_remote_tile_t *tile = (zynq_lvgl_remote_tile_t *) p;
+            p += sizeof(zynq_lvgl_remote_tile_t);
+            tile->x = x;
+            tile->y = y;
+            tile->len = rle_encode(gram + (y * VDMA_H_ACTIVE + x) * LVGL_REMOTE_TILE, VDMA_H_ACTIVE,
+                                   LVGL_REMOTE_TILE, h, p);
+            p += tile->len;
+            tile_num++;
+        }
+    }
+    memset(header, 0, sizeof(zynq_lvgl_remote_header_t));
+    header->width = VDMA_H_ACTIVE;
+    header->height = VDMA_V_ACTIVE;
+    header->tile = LVGL_REMOTE_TILE;
+    header->format = LVGL_REMOTE_FORMAT_RLE24;
+    header->keyframe = pending_key;
+    header->tile_num = tile_num;
+    return p - remote_buf;
+}
+
+static void zynq_lvgl_remote_task(void *p) {
+    lv_color_t *gram;
+    for (;;) {
+        xQueueReceive(remote_queue, &gram, portMAX_DELAY);
+
+        /* 双缓冲，LVGL已经画完另一块显存后又开始画这一块时内容不再是交给任务时的画面。
+         * 绘制和flush在同一次持有LVGL_Mutex期间完成，压缩时不持有锁，
+         * 压缩前后各判断一次之后flush了几次，期间这块显存被重画过就丢弃结果 */
+        xSemaphoreTake(LVGL_Mutex, portMAX_DELAY);
+        int fresh = flush_count - pending_flush <= 1;
+        xSemaphoreGive(LVGL_Mutex);
+
+        uint32_t len = fresh ? zynq_lvgl_remote_encode(gram) : 0;
+
+        xSemaphoreTake(LVGL_Mutex, portMAX_DELAY);
+        if (flush_count - pending_flush > 1) {
+            len = 0;
+            for (int i = 0; i < LVGL_REMOTE_ROWS; i++) dirty[i] |= pending[i];
+            dirty_key |= pending_key;
+        }
+        xSemaphoreGive(LVGL_Mutex);
+
+        if (len) {
+            zynq_lvgl_remote_frame_t frame = {
+                    .seq = ++seq,
+                    .timestamp_us = pending_us,
+                    .data = remote_buf,
+                    .len = len,
+                    .keyframe = pending_key,
+            };
+            /* 接收者没有收下的帧无法补发，接收端只能等关键帧 */
+            if (remote_sink && remote_sink(&frame) == XST_SUCCESS) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            else zynq_lvgl_remote_keyframe();
+        }
+        busy = 0;
+    }
+}
+
+static int zynq_lvgl_remote_task_init() {
+    remote_buf = os_malloc_tag(LVGL_REMOTE_BUF_SIZE, OS_MEM_TAG_LVGL);
+    if (remote_buf == NULL) return XST_FAILURE;
+    remote_queue = xQueueCreate(LVGL_REMOTE_QUEUE_LEN, sizeof(lv_color_t *));
+    if (remote_queue == NULL ||
+        xTaskCreate(zynq_lvgl_remote_task, "remote screen", LVGL_REMOTE_STACK_SIZE,
+                    NULL, LVGL_REMOTE_PRIORITY, &remote_task_handle) != pdPASS) {
+        if (remote_queue) vQueueDelete(remote_queue);
+        remote_queue = NULL;
+        os_free(remote_buf);
+        remote_buf = NULL;
+        return XST_FAILURE;
+    }
+    return XST_SUCCESS;
+}
+
+void zynq_lvgl_remote_set_sink(zynq_lvgl_remote_sink_t sink) {
+    remote_sink = sink;
+}
+
+void zynq_lvgl_remote_subscribe(int subscribe) {
+    if (subscribe) {
+        __atomic_add_fetch(&sink_num, 1, __ATOMIC_RELAXED);
+        zynq_lvgl_remote_keyframe();
+    } else if (__atomic_load_n(&sink_num, __ATOMIC_RELAXED)) {
+        __atomic_sub_fetch(&sink_num, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void zynq_lvgl_remote_keyframe() {
+    __atomic_store_n(&keyframe_req, 1, __ATOMIC_RELEASE);
+}
+
+void zynq_lvgl_remote_release() {
+    if (remote_task_handle) xTaskNotifyGive(remote_task_handle);
+}
+
+void zynq_lvgl_remote_invalidate(lv_disp_drv_t *drv, const lv_area_t *area) {
+    LV_UNUSED(drv);
+    if (__atomic_load_n(&sink_num, __ATOMIC_RELAXED) == 0) return;
+
+    /* area已被裁剪到屏幕内 */
+    uint32_t x1 = area->x1 / LVGL_REMOTE_TILE, x2 = area->x2 / LVGL_REMOTE_TILE;
+    uint32_t cols = (uint32_t) ((((uint64_t) 1 << (x2 - x1 + 1)) - 1) << x1);
+    for (uint32_t y = area->y1 / LVGL_REMOTE_TILE; y <= area->y2 / LVGL_REMOTE_TILE; y++) dirty[y] |= cols;
+}
+
+void zynq_lvgl_remote_flush(lv_color_t *gram) {
+    flush_count++;
+    if (remote_sink == NULL || __atomic_load_n(&sink_num, __ATOMIC_RELAXED) == 0 || busy) return;
+
+    if (__atomic_exchange_n(&keyframe_req, 0, __ATOMIC_ACQUIRE)) {
+        for (int i = 0; i < LVGL_REMOTE_ROWS; i++) dirty[i] = LVGL_REMOTE_ALL_COLS;
+        dirty_key = 1;
+    }
+    uint64_t now = zynq_lvgl_remote_now_us();
+    if (now - last_us < 1000000 / LVGL_REMOTE_FPS) return;
+
+    uint32_t any = 0;
+    for (int i = 0; i < LVGL_REMOTE_ROWS; i++) any |= dirty[i];
+    if (any == 0) return;
+    if (remote_task_handle == NULL && zynq_lvgl_remote_task_init() != XST_SUCCESS) return;
+
+    memcpy(pending, dirty, sizeof(dirty));
+    memset(dirty, 0, sizeof(dirty));
+    pending_key = dirty_key;
+    dirty_key = 0;
+    pending_flush = flush_count;
+    pending_us = now;
+    last_us = now;
+    busy = 1;
+    xQueueSend(remote_queue, &gram, 0);
+}
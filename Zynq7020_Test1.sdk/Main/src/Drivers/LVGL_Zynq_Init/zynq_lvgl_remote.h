@@ -0,0 +1,101 @@
+//
+// Created by yaoji on 2022/5/14.
+//
+
+#ifndef ZYNQ7020_ZYNQ_LVGL_REMOTE_H
+#define ZYNQ7020_ZYNQ_LVGL_REMOTE_H
+
+#include <stdint.h>
+#include "lvgl.h"
+#include "VDMA_Driver/VDMA_Driver.h"
+
+/**
+ * 远程屏幕
+ * LVGL每次使区域无效时记录覆盖到的图块，按LVGL_REMOTE_FPS的频率把上次发出后变化过的图块
+ * 从刚刷新完的显存中用RLE(见rle_encoder.h)压缩，交给接收者推送。只有图块变化时才产生消息，
+ * 新的接收者或丢失了消息的接收者需要关键帧(全部图块)才能继续。
+ * 消息 [zynq_lvgl_remote_header_t][图块]...，每个图块 [zynq_lvgl_remote_tile_t][RLE数据]，小端。
+ * 图块按LVGL_REMOTE_TILE划分，最后一行图块高度为屏幕剩余的行数
+ */
+
+#define LVGL_REMOTE_TILE 32
+#define LVGL_REMOTE_COLS (VDMA_H_ACTIVE / LVGL_REMOTE_TILE)
+#define LVGL_REMOTE_ROWS ((VDMA_V_ACTIVE + LVGL_REMOTE_TILE - 1) / LVGL_REMOTE_TILE)
+#define LVGL_REMOTE_FPS 5                   //!< 最大推送帧率
+
+#if LVGL_REMOTE_COLS > 32 || VDMA_H_ACTIVE % LVGL_REMOTE_TILE
+#error "每行图块用一个uint32_t位图记录，屏幕宽度必须是图块的整数倍且不超过32块"
+#endif
+
+typedef enum {
+    LVGL_REMOTE_FORMAT_RLE24,               //!< rle_encoder.h
+} lvgl_remote_format;
+
+typedef struct __attribute__((packed)) {
+    uint16_t width;         //!< 屏幕宽度
+    uint16_t height;
+    uint8_t tile;           //!< 图块边长
+    uint8_t format;         //!< lvgl_remote_format
+    uint8_t keyframe;       //!< 1: 包含全部图块
+    uint8_t reserved;
+    uint16_t tile_num;      //!< 图块数
+    uint16_t reserved2;
+} zynq_lvgl_remote_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t x;              //!< 图块列号
+    uint8_t y;              //!< 图块行号
+    uint16_t len;           //!< RLE数据长度
+} zynq_lvgl_remote_tile_t;
+
+/**
+ * 交给接收者的一帧
+ */
+typedef struct {
+    uint32_t seq;
+    uint64_t timestamp_us;  //!< 显存刷新完成时间
+    const void *data;       //!< [zynq_lvgl_remote_header_t][图块]...
+    uint32_t len;
+    uint8_t keyframe;
+} zynq_lvgl_remote_frame_t;
+
+/**
+ * 帧的接收者，在远程屏幕任务中调用。
+ * 返回XST_SUCCESS表示接收者持有data，用完后必须调用zynq_lvgl_remote_release，在此之前不会产生下一帧
+ */
+typedef int (*zynq_lvgl_remote_sink_t)(const zynq_lvgl_remote_frame_t *frame);
+
+/**
+ * 设置帧的接收者，只支持一个
+ * @param sink 接收函数
+ */
+void zynq_lvgl_remote_set_sink(zynq_lvgl_remote_sink_t sink);
+
+/**
+ * 接收者的订阅数变化时调用，没有订阅时不记录无效区域，新订阅会触发关键帧，可以在任意任务中调用
+ * @param subscribe 1订阅 0取消
+ */
+void zynq_lvgl_remote_subscribe(int subscribe);
+
+/**
+ * 请求下一帧为关键帧，可以在任意任务中调用
+ */
+void zynq_lvgl_remote_keyframe();
+
+/**
+ * 接收者用完帧数据后调用
+ */
+void zynq_lvgl_remote_release();
+
+/**
+ * 作为disp_drv.invalidate_cb，记录无效区域
+ */
+void zynq_lvgl_remote_invalidate(lv_disp_drv_t *drv, const lv_area_t *area);
+
+/**
+ * 在flush_cb中调用，到了推送时间时把刚刷新完的显存交给远程屏幕任务压缩
+ * @param gram 刷新完成的显存
+ */
+void zynq_lvgl_remote_flush(lv_color_t *gram);
+
+#endif //ZYNQ7020_ZYNQ_LVGL_REMOTE_H
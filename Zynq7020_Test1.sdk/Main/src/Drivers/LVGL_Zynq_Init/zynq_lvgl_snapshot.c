@@ -11,6 +11,7 @@
 #include "VDMA_Driver/VDMA_Driver.h"
 #include "BMP_encoder/bmp_encoder.h"
 #include "DS1337_Driver/DS1337_Driver.h"
+#include "FileService/FileService.h"
 #include "ff.h"
 #include "zynq_lvgl_init.h"
 
@@ -34,9 +35,9 @@ static void zynq_lvgl_snapshot_task(void *p) {
 
             char filename[64] = {0};
             FILINFO file_info;
-            FRESULT res = f_stat("0:/ScreenShot", &file_info);
+            FRESULT res = FileService_stat("0:/ScreenShot", &file_info);
             if (res != FR_OK) {
-                if (res == FR_NO_FILE) res = f_mkdir("0:/ScreenShot");
+                if (res == FR_NO_FILE) res = FileService_mkdir("0:/ScreenShot");
                 if (res != FR_OK) vTaskDelete(NULL);
             }
             struct tm t;
@@ -48,7 +49,7 @@ static void zynq_lvgl_snapshot_task(void *p) {
             do {
                 sprintf(filename, "0:/ScreenShot/%04d-%02d-%02d_%02d-%02d-%02d_%d.bmp",
                         t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, index);
-                res = f_stat(filename, &file_info);
+                res = FileService_stat(filename, &file_info);
                 if (res == FR_OK) index++;
                 else if (res == FR_NO_FILE) break;
                 else {
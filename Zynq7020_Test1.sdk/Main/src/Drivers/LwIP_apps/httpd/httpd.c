@@ -0,0 +1,632 @@
+//
+// Created by yaoji on 2022/5/13.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "httpd.h"
+#include "websocket.h"
+#include "live_page.h"
+#include "lwip/tcp.h"
+#include "lwip/def.h"
+#include "lwip/tcpip.h"
+#include "LwIP_apps/udp_comm/udp_stream.h"
+#include "LVGL_Zynq_Init/zynq_lvgl_remote.h"
+#include "xil_printf.h"
+#include "xstatus.h"
+#include <cJSON.h>
+
+#define HTTPD_POLL_INTERVAL 2           //!< tcp_poll周期，单位为TCP粗定时器(500ms)
+#define HTTPD_REQ_TIMEOUT 10            //!< 请求头在几个poll周期内没有收完则关闭
+#define HTTPD_SCREEN_FRAG_MIN 1024      //!< 屏幕消息分片的最小负载，发送缓冲区将满时不产生过小的分片
+#define HTTPD_STREAM_MASK ((1 << (HTTPD_STREAM_SCREEN + 1)) - 1)
+
+typedef enum {
+    HTTPD_FREE,
+    HTTPD_REQUEST,                      //!< 接收请求头
+    HTTPD_RESPONSE,                     //!< 发送静态内容，发完后关闭
+    HTTPD_WEBSOCKET,
+    HTTPD_CLOSING,                      //!< tcp_close失败，在poll中重试
+} httpd_state;
+
+typedef struct {
+    struct tcp_pcb *pcb;
+    uint8_t state;
+    uint8_t streams;                    //!< 订阅的流，1<<udp_stream_id，1<<HTTPD_STREAM_SCREEN
+    uint8_t idle;                       //!< 请求头未收完的poll周期数
+    uint8_t screen_sync;                //!< 已收到关键帧，可以接收增量
+    uint8_t screen_pending;             //!< 持有当前屏幕消息的引用
+    uint8_t screen_idle;                //!< 屏幕消息没有进展的poll周期数
+    uint8_t screen_want_key;            //!< 因阻塞跳过了消息，发送缓冲区空出后再请求关键帧
+    uint32_t screen_sent;               //!< 当前屏幕消息已写入的负载长度，不为0时不能插入其它消息
+    uint16_t req_len;
+    const uint8_t *tx;                  //!< 还没有交给TCP的静态内容
+    uint32_t tx_left;
+    uint32_t interval_us;               //!< 最小推送间隔，0不限速
+    uint64_t last_us[UDP_STREAM_NUM];
+    uint32_t dropped;
+    ws_parser parser;
+    char req[HTTPD_REQ_MAX + 1];
+} httpd_conn;
+
+static httpd_conn conns[HTTPD_MAX_CONN];
+
+/* 正在推送的屏幕消息，引用归零后交还远程屏幕 */
+static zynq_lvgl_remote_frame_t screen_frame;
+static uint32_t screen_refs;
+
+static const char http_not_found[] = "404 Not Found";
+static const char http_bad_request[] = "400 Bad Request";
+
+static void httpd_screen_put() {
+    if (--screen_refs == 0) zynq_lvgl_remote_release();
+}
+
+/**
+ * 放弃当前屏幕消息，只能在还没有写入或连接关闭时调用
+ */
+static void httpd_screen_drop(httpd_conn *c) {
+    if (!c->screen_pending) return;
+    c->screen_pending = 0;
+    c->screen_sync = 0;
+    httpd_screen_put();
+}
+
+static void httpd_set_streams(httpd_conn *c, uint8_t streams) {
+    for (int i = 0; i < UDP_STREAM_NUM; i++) {
+        uint8_t bit = 1 << i;
+        if ((streams & bit) != (c->streams & bit)) udp_stream_sink_subscribe(i, (streams & bit) != 0);
+    }
+    uint8_t bit = 1 << HTTPD_STREAM_SCREEN;
+    if ((streams & bit) != (c->streams & bit)) {
+        /* 新订阅从关键帧开始 */
+        if (streams & bit) c->screen_sync = 0;
+        c->screen_want_key = 0;
+        zynq_lvgl_remote_subscribe((streams & bit) != 0);
+    }
+    c->streams = streams;
+}
+
+static void httpd_free(httpd_conn *c) {
+    httpd_set_streams(c, 0);
+    httpd_screen_drop(c);
+    c->pcb = NULL;
+    c->state = HTTPD_FREE;
+}
+
+/**
+ * 正常关闭，已交给TCP的数据会继续发送
+ */
+static void httpd_close(httpd_conn *c) {
+    struct tcp_pcb *pcb = c->pcb;
+    httpd_set_streams(c, 0);
+    httpd_screen_drop(c);
+    tcp_recv(pcb, NULL);
+    tcp_sent(pcb, NULL);
+    if (tcp_close(pcb) == ERR_OK) {
+        tcp_arg(pcb, NULL);
+        tcp_err(pcb, NULL);
+        tcp_poll(pcb, NULL, 0);
+        httpd_free(c);
+    } else {
+        c->state = HTTPD_CLOSING;
+    }
+}
+
+/**
+ * 立即断开，只能在接收回调之外或接收回调返回ERR_ABRT时调用
+ */
+static void httpd_abort(httpd_conn *c) {
+    struct tcp_pcb *pcb = c->pcb;
+    tcp_arg(pcb, NULL);
+    tcp_err(pcb, NULL);
+    httpd_free(c);
+    tcp_abort(pcb);
+}
+
+static void httpd_send_more(httpd_conn *c) {
+    while (c->tx_left) {
+        u16_t len = LWIP_MIN(c->tx_left, tcp_sndbuf(c->pcb));
+        if (len == 0) break;
+        /* 静态内容不需要拷贝 */
+        if (tcp_write(c->pcb, c->tx, len, 0) != ERR_OK) break;
+        c->tx += len;
+        c->tx_left -= len;
+    }
+    tcp_output(c->pcb);
+    if (c->tx_left == 0) httpd_close(c);
+}
+
+static void httpd_send_static(httpd_conn *c, const char *status, const char *type, const void *body, uint32_t len) {
+    char head[160];
+    int head_len = snprintf(head, sizeof(head),
+                            "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %lu\r\nConnection: close\r\n\r\n",
+                            status, type, (unsigned long) len);
+    if (tcp_write(c->pcb, head, head_len, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+        httpd_close(c);
+        return;
+    }
+    c->state = HTTPD_RESPONSE;
+    c->tx = body;
+    c->tx_left = len;
+    httpd_send_more(c);
+}
+
+static void httpd_send_error(httpd_conn *c, const char *status) {
+    httpd_send_static(c, status, "text/plain", status, strlen(status));
+}
+
+/**
+ * 在请求头中查找字段
+ * @param req 以空行结尾的请求头
+ * @param name 字段名
+ * @param len [out] 值的长度
+ * @return 值，没有该字段返回NULL
+ */
+static const char *httpd_header(const char *req, const char *name, uint32_t *len) {
+    size_t name_len = strlen(name);
+    const char *line = strstr(req, "\r\n");
+    while (line && line[2] != '\r') {
+        line += 2;
+        if (lwip_strnicmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            const char *value = line + name_len + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            const char *end = strstr(value, "\r\n");
+            while (end > value && (end[-1] == ' ' || end[-1] == '\t')) end--;
+            *len = end - value;
+            return value;
+        }
+        line = strstr(line, "\r\n");
+    }
+    return NULL;
+}
+
+static int httpd_contains_token(const char *value, uint32_t len, const char *token) {
+    size_t token_len = strlen(token);
+    for (uint32_t i = 0; i + token_len <= len; i++)
+        if (lwip_strnicmp(value + i, token, token_len) == 0) return 1;
+    return 0;
+}
+
+static err_t httpd_ws_send(httpd_conn *c, ws_opcode opcode, const void *payload, uint32_t len) {
+    uint8_t frame[WS_HEADER_MAX + WS_CONTROL_MAX];
+    uint32_t header_len = ws_frame_header(frame, opcode, len);
+    memcpy(frame + header_len, payload, len);
+    err_t err = tcp_write(c->pcb, frame, header_len + len, TCP_WRITE_FLAG_COPY);
+    tcp_output(c->pcb);
+    return err;
+}
+
+static void httpd_ws_close(httpd_conn *c, uint16_t code) {
+    uint8_t payload[2] = {code >> 8, code};
+    httpd_ws_send(c, WS_OP_CLOSE, payload, sizeof(payload));
+    httpd_close(c);
+}
+
+/**
+ * 处理订阅消息 {"streams": 位掩码, "fps": 每秒最大帧数}
+ */
+static void httpd_ws_command(httpd_conn *c, const char *text, uint32_t len) {
+    cJSON *json = cJSON_ParseWithLength(text, len);
+    if (json == NULL) return;
+    cJSON *streams = cJSON_GetObjectItem(json, "streams");
+    cJSON *fps = cJSON_GetObjectItem(json, "fps");
+    if (cJSON_IsNumber(fps)) c->interval_us = fps->valueint > 0 ? 1000000 / fps->valueint : 0;
+    if (cJSON_IsNumber(streams)) httpd_set_streams(c, streams->valueint & HTTPD_STREAM_MASK);
+    cJSON_Delete(json);
+}
+
+/**
+ * 处理客户端发来的数据
+ * @return 连接已关闭返回0
+ */
+static int httpd_ws_recv(httpd_conn *c, const uint8_t *data, uint32_t len) {
+    while (len) {
+        uint32_t used;
+        ws_parse_result res = ws_parser_feed(&c->parser, data, len, &used);
+        data += used;
+        len -= used;
+        if (res == WS_PARSE_MORE) break;
+        if (res == WS_PARSE_ERROR) {
+            httpd_ws_close(c, c->parser.close_code);
+            return 0;
+        }
+
+        ws_parser *p = &c->parser;
+        switch (p->opcode) {
+            case WS_OP_TEXT:
+                if (!p->fin) {
+                    httpd_ws_close(c, WS_CLOSE_UNSUPPORTED);
+                    return 0;
+                }
+                httpd_ws_command(c, (const char *) p->payload, p->payload_len);
+                break;
+            case WS_OP_PING:
+                httpd_ws_send(c, WS_OP_PONG, p->payload, p->payload_len);
+                break;
+            case WS_OP_CLOSE:
+                /* 回复对方的关闭码 */
+                httpd_ws_send(c, WS_OP_CLOSE, p->payload, LWIP_MIN(p->payload_len, 2));
+                httpd_close(c);
+                return 0;
+            case WS_OP_PONG:
+                break;
+            default:
+                /* 不接收二进制消息和分片 */
+                httpd_ws_close(c, WS_CLOSE_UNSUPPORTED);
+                return 0;
+        }
+    }
+    return 1;
+}
+
+static void httpd_ws_upgrade(httpd_conn *c, const char *key, uint32_t key_len) {
+    char accept[WS_ACCEPT_KEY_LEN + 1];
+    char resp[160];
+    ws_accept_key(key, key_len, accept);
+    int resp_len = snprintf(resp, sizeof(resp),
+                            "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                            "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n", accept);
+    if (tcp_write(c->pcb, resp, resp_len, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+        httpd_close(c);
+        return;
+    }
+    tcp_output(c->pcb);
+    /* 推送的帧都是整帧写入后立即发送，不需要等待合并 */
+    tcp_nagle_disable(c->pcb);
+    ws_parser_reset(&c->parser);
+    c->state = HTTPD_WEBSOCKET;
+    c->streams = 0;
+    c->screen_sync = 0;
+    c->screen_pending = 0;
+    c->screen_sent = 0;
+    c->screen_want_key = 0;
+    c->interval_us = 0;
+    c->dropped = 0;
+    memset(c->last_us, 0, sizeof(c->last_us));
+    xil_printf("httpd: websocket %d connected\r\n", (int) (c - conns));
+}
+
+/**
+ * 请求头收完后处理请求
+ * @param header_len 请求头长度(含空行)
+ * @return 连接已关闭返回0
+ */
+static int httpd_handle_request(httpd_conn *c, uint32_t header_len) {
+    char *req = c->req;
+    if (strncmp(req, "GET ", 4) != 0) {
+        httpd_send_error(c, http_bad_request);
+        return 0;
+    }
+    char *path = req + 4;
+    size_t path_len = strcspn(path, " ?\r");
+
+    if ((path_len == 1 && path[0] == '/') || (path_len == 11 && strncmp(path, "/index.html", 11) == 0)) {
+        httpd_send_static(c, "200 OK", "text/html; charset=utf-8", live_page_html, live_page_html_len);
+        return 0;
+    }
+    if (path_len != 3 || strncmp(path, "/ws", 3) != 0) {
+        httpd_send_error(c, http_not_found);
+        return 0;
+    }
+
+    uint32_t upgrade_len, key_len;
+    const char *upgrade = httpd_header(req, "Upgrade", &upgrade_len);
+    const char *key = httpd_header(req, "Sec-WebSocket-Key", &key_len);
+    if (upgrade == NULL || !httpd_contains_token(upgrade, upgrade_len, "websocket") || key == NULL) {
+        httpd_send_error(c, http_bad_request);
+        return 0;
+    }
+    httpd_ws_upgrade(c, key, key_len);
+    if (c->state != HTTPD_WEBSOCKET) return 0;
+
+    /* 客户端可能紧接着握手发送了数据 */
+    return httpd_ws_recv(c, (const uint8_t *) req + header_len, c->req_len - header_len);
+}
+
+/**
+ * 积累请求头
+ * @return 连接已关闭返回0
+ */
+static int httpd_request_recv(httpd_conn *c, const uint8_t *data, uint32_t len) {
+    if (c->req_len + len > HTTPD_REQ_MAX) {
+        httpd_send_error(c, http_bad_request);
+        return 0;
+    }
+    memcpy(c->req + c->req_len, data, len);
+    c->req_len += len;
+    c->req[c->req_len] = '\0';
+
+    char *end = strstr(c->req, "\r\n\r\n");
+    if (end == NULL) return 1;
+    return httpd_handle_request(c, end + 4 - c->req);
+}
+
+static err_t httpd_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err) {
+    httpd_conn *c = arg;
+    if (p == NULL) {
+        /* 对方关闭 */
+        httpd_close(c);
+        return ERR_OK;
+    }
+    if (err != ERR_OK) {
+        pbuf_free(p);
+        return err;
+    }
+    tcp_recved(pcb, p->tot_len);
+
+    for (struct pbuf *q = p; q != NULL; q = q->next) {
+        int open;
+        if (c->state == HTTPD_REQUEST) {
+            c->idle = 0;
+            open = httpd_request_recv(c, q->payload, q->len);
+        } else if (c->state == HTTPD_WEBSOCKET) {
+            open = httpd_ws_recv(c, q->payload, q->len);
+        } else {
+            /* 响应发送期间忽略对方的数据 */
+            open = 1;
+        }
+        if (!open || c->state == HTTPD_FREE || c->state == HTTPD_CLOSING) break;
+    }
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+/**
+ * 按发送缓冲区的空间继续写入屏幕消息，每次写入一个完整的分片
+ * @return 连接已断开返回0
+ */
+static int httpd_screen_send_more(httpd_conn *c) {
+    uint32_t total = sizeof(httpd_ws_frame_header_t) + screen_frame.len;
+    while (c->screen_sent < total) {
+        uint32_t left = total - c->screen_sent;
+        uint32_t room = tcp_sndbuf(c->pcb);
+        if (room < WS_HEADER_MAX + LWIP_MIN(left, HTTPD_SCREEN_FRAG_MIN)) break;
+        /* 发送缓冲区空出一半才开始，已经积压的连接跳过这一帧，而不是写了一半后阻塞被断开 */
+        if (c->screen_sent == 0 && room < LWIP_MIN(WS_HEADER_MAX + total, TCP_SND_BUF / 2)) break;
+        uint32_t len = LWIP_MIN(left, room - WS_HEADER_MAX);
+        if (tcp_sndqueuelen(c->pcb) + len / tcp_mss(c->pcb) + 4 > TCP_SND_QUEUELEN) break;
+
+        uint8_t head[WS_HEADER_MAX + sizeof(httpd_ws_frame_header_t)];
+        uint32_t head_len = ws_fragment_header(head, c->screen_sent ? WS_OP_CONTINUATION : WS_OP_BINARY,
+                                               len == left, len);
+        const uint8_t *data = screen_frame.data;
+        uint32_t data_len = len;
+        if (c->screen_sent == 0) {
+            httpd_ws_frame_header_t header = {
+                    .stream = HTTPD_STREAM_SCREEN,
+                    .seq = screen_frame.seq,
+                    .timestamp_us = screen_frame.timestamp_us,
+                    .dropped = c->dropped,
+            };
+            memcpy(head + head_len, &header, sizeof(header));
+            head_len += sizeof(header);
+            data_len -= sizeof(header);
+        } else {
+            data += c->screen_sent - sizeof(httpd_ws_frame_header_t);
+        }
+
+        /* 消息在远程屏幕中只保留到所有连接写完，数据拷贝进发送缓冲区 */
+        err_t err = tcp_write(c->pcb, head, head_len, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+        if (err == ERR_OK) err = tcp_write(c->pcb, data, data_len, TCP_WRITE_FLAG_COPY);
+        if (err != ERR_OK) {
+            /* 分片写了一半，只能断开 */
+            httpd_abort(c);
+            return 0;
+        }
+        c->screen_sent += len;
+        c->screen_idle = 0;
+    }
+    tcp_output(c->pcb);
+    if (c->screen_sent == total) {
+        c->screen_pending = 0;
+        c->screen_sent = 0;
+        httpd_screen_put();
+    }
+    return 1;
+}
+
+/**
+ * 阻塞过的连接在发送缓冲区空出一半后才请求关键帧，持续阻塞的连接不会反复拖慢其它连接
+ */
+static void httpd_screen_check_resume(httpd_conn *c) {
+    if (c->screen_want_key && tcp_sndbuf(c->pcb) >= TCP_SND_BUF / 2) {
+        c->screen_want_key = 0;
+        zynq_lvgl_remote_keyframe();
+    }
+}
+
+static err_t httpd_sent(void *arg, struct tcp_pcb *pcb, u16_t len) {
+    httpd_conn *c = arg;
+    LWIP_UNUSED_ARG(pcb);
+    LWIP_UNUSED_ARG(len);
+    if (c->state == HTTPD_RESPONSE) {
+        httpd_send_more(c);
+    } else if (c->state == HTTPD_WEBSOCKET) {
+        if (c->screen_pending && !httpd_screen_send_more(c)) return ERR_ABRT;
+        httpd_screen_check_resume(c);
+    }
+    return ERR_OK;
+}
+
+static err_t httpd_poll(void *arg, struct tcp_pcb *pcb) {
+    httpd_conn *c = arg;
+    if (c == NULL) {
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
+    switch (c->state) {
+        case HTTPD_REQUEST:
+            if (++c->idle >= HTTPD_REQ_TIMEOUT) {
+                httpd_abort(c);
+                return ERR_ABRT;
+            }
+            break;
+        case HTTPD_RESPONSE:
+            httpd_send_more(c);
+            break;
+        case HTTPD_CLOSING:
+            httpd_close(c);
+            break;
+        case HTTPD_WEBSOCKET:
+            httpd_screen_check_resume(c);
+            if (!c->screen_pending) break;
+            if (!httpd_screen_send_more(c)) return ERR_ABRT;
+            if (c->screen_pending && ++c->screen_idle >= HTTPD_SCREEN_TIMEOUT) {
+                if (c->screen_sent) {
+                    httpd_abort(c);
+                    return ERR_ABRT;
+                }
+                /* 还没开始写入，跳过这一帧，之后的增量需要从关键帧开始 */
+                c->dropped++;
+                c->screen_want_key = 1;
+                httpd_screen_drop(c);
+            }
+            break;
+        default:
+            break;
+    }
+    return ERR_OK;
+}
+
+static void httpd_err(void *arg, err_t err) {
+    httpd_conn *c = arg;
+    LWIP_UNUSED_ARG(err);
+    /* pcb已被协议栈释放 */
+    if (c) httpd_free(c);
+}
+
+static err_t httpd_accept(void *arg, struct tcp_pcb *pcb, err_t err) {
+    LWIP_UNUSED_ARG(arg);
+    if (err != ERR_OK || pcb == NULL) return ERR_VAL;
+
+    httpd_conn *c = NULL;
+    for (int i = 0; i < HTTPD_MAX_CONN; i++) {
+        if (conns[i].state == HTTPD_FREE) {
+            c = &conns[i];
+            break;
+        }
+    }
+    if (c == NULL) {
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
+
+    c->pcb = pcb;
+    c->state = HTTPD_REQUEST;
+    c->streams = 0;
+    c->idle = 0;
+    c->req_len = 0;
+    tcp_arg(pcb, c);
+    tcp_recv(pcb, httpd_recv);
+    tcp_sent(pcb, httpd_sent);
+    tcp_err(pcb, httpd_err);
+    tcp_poll(pcb, httpd_poll, HTTPD_POLL_INTERVAL);
+    return ERR_OK;
+}
+
+/**
+ * 把一帧写入订阅了该流的连接，在协议栈线程中执行
+ */
+static void httpd_stream_sink(udp_stream_id stream, const udp_stream_frame_t *frame) {
+    for (int i = 0; i < HTTPD_MAX_CONN; i++) {
+        httpd_conn *c = &conns[i];
+        if (c->state != HTTPD_WEBSOCKET || !(c->streams & (1 << stream))) continue;
+        if (frame->timestamp_us - c->last_us[stream] < c->interval_us) continue;
+        /* 屏幕消息写了一部分，分片之间不能插入其它消息 */
+        if (c->screen_sent) {
+            c->dropped++;
+            continue;
+        }
+
+        /* 整帧放不进发送缓冲区时跳过，慢的客户端看到的帧率降低，不会积压 */
+        uint32_t msg_len = sizeof(httpd_ws_frame_header_t) + frame->len;
+        uint32_t total = WS_HEADER_MAX + msg_len;
+        if (tcp_sndbuf(c->pcb) < total ||
+            tcp_sndqueuelen(c->pcb) + total / tcp_mss(c->pcb) + 4 > TCP_SND_QUEUELEN) {
+            c->dropped++;
+            continue;
+        }
+
+        uint8_t head[WS_HEADER_MAX + sizeof(httpd_ws_frame_header_t)];
+        uint32_t head_len = ws_frame_header(head, WS_OP_BINARY, msg_len);
+        httpd_ws_frame_header_t header = {
+                .stream = stream,
+                .format = frame->format,
+                .seq = frame->seq,
+                .timestamp_us = frame->timestamp_us,
+                .sample_rate = frame->sample_rate,
+                .dropped = c->dropped,
+        };
+        memcpy(head + head_len, &header, sizeof(header));
+        head_len += sizeof(header);
+
+        /* 返回后采集缓冲区会被覆盖，数据拷贝进发送缓冲区 */
+        err_t err = tcp_write(c->pcb, head, head_len, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+        const uint8_t *data = frame->data;
+        for (uint32_t left = frame->len; err == ERR_OK && left;) {
+            u16_t len = LWIP_MIN(left, 0x8000);
+            left -= len;
+            err = tcp_write(c->pcb, data, len, TCP_WRITE_FLAG_COPY | (left ? TCP_WRITE_FLAG_MORE : 0));
+            data += len;
+        }
+        if (err != ERR_OK) {
+            /* 已写入部分消息，后面的消息无法对齐，只能断开 */
+            httpd_abort(c);
+            continue;
+        }
+        c->last_us[stream] = frame->timestamp_us;
+        tcp_output(c->pcb);
+    }
+}
+
+/**
+ * 把屏幕消息交给订阅了屏幕的连接，在协议栈线程中执行
+ */
+static void httpd_screen_publish(void *ctx) {
+    LWIP_UNUSED_ARG(ctx);
+    /* 发送期间的引用，防止第一个连接写完就交还 */
+    screen_refs = 1;
+    for (int i = 0; i < HTTPD_MAX_CONN; i++) {
+        httpd_conn *c = &conns[i];
+        if (c->state != HTTPD_WEBSOCKET || !(c->streams & (1 << HTTPD_STREAM_SCREEN))) continue;
+        /* 丢失过消息的连接只能从关键帧继续 */
+        if (!c->screen_sync && !screen_frame.keyframe) continue;
+        c->screen_sync = 1;
+        c->screen_pending = 1;
+        c->screen_sent = 0;
+        c->screen_idle = 0;
+        screen_refs++;
+        httpd_screen_send_more(c);
+    }
+    httpd_screen_put();
+}
+
+static int httpd_screen_sink(const zynq_lvgl_remote_frame_t *frame) {
+    screen_frame = *frame;
+    return tcpip_callback_with_block(httpd_screen_publish, NULL, 1) == ERR_OK ? XST_SUCCESS : XST_FAILURE;
+}
+
+void httpd_start() {
+    struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+    if (pcb == NULL) {
+        xil_printf("httpd [init] error: no memory\r\n");
+        return;
+    }
+    err_t err = tcp_bind(pcb, IP_ANY_TYPE, HTTPD_PORT);
+    if (err != ERR_OK) {
+        xil_printf("httpd [init] error %d\r\n", err);
+        tcp_close(pcb);
+        return;
+    }
+    struct tcp_pcb *listen_pcb = tcp_listen(pcb);
+    if (listen_pcb == NULL) {
+        xil_printf("httpd [init] error: listen\r\n");
+        tcp_close(pcb);
+        return;
+    }
+    tcp_accept(listen_pcb, httpd_accept);
+    udp_stream_set_sink(httpd_stream_sink);
+    zynq_lvgl_remote_set_sink(httpd_screen_sink);
+    xil_printf("httpd [init] success\r\n");
+}
@@ -0,0 +1,46 @@
+//
+// Created by yaoji on 2022/5/13.
+//
+
+#ifndef ZYNQ7020_HTTPD_H
+#define ZYNQ7020_HTTPD_H
+
+#include <stdint.h>
+#include "LwIP_apps/udp_comm/udp_stream.h"
+
+/**
+ * 实时查看网页
+ * GET / 返回网页，GET /ws 升级为WebSocket，推送udp_stream的波形和频谱。
+ * 客户端发送文本消息 {"streams": 位掩码(1<<udp_stream_id), "fps": 每秒最大帧数，0不限} 订阅。
+ * 推送为二进制消息 [httpd_ws_frame_header_t][数据]，小端，数据与udp_stream相同。
+ * 帧在协议栈线程中直接从采集缓冲区拷贝进TCP发送缓冲区，不占用采集缓冲区等待对方确认；
+ * 某个客户端发送缓冲区放不下整帧时该客户端跳过这一帧，不影响其它客户端和UDP推送。
+ * 订阅位1<<HTTPD_STREAM_SCREEN为远程屏幕(zynq_lvgl_remote.h)，消息为
+ * [httpd_ws_frame_header_t][zynq_lvgl_remote_header_t][图块]...，帧率由远程屏幕决定，不受fps限制。
+ * 屏幕增量不能跳过，按发送缓冲区的空间分片逐步写入，所有连接都写完后才压缩下一帧；
+ * 写入期间该连接跳过波形和频谱。超过HTTPD_SCREEN_TIMEOUT没有进展时，还没开始写入的跳过这一帧，
+ * 发送缓冲区空出后再请求关键帧，已经开始写入的断开
+ */
+
+#define HTTPD_PORT 80
+#define HTTPD_MAX_CONN 4                //!< 同时连接数，包括WebSocket
+#define HTTPD_REQ_MAX 1024              //!< 请求头最大长度
+#define HTTPD_STREAM_SCREEN UDP_STREAM_NUM  //!< 远程屏幕的流编号
+#define HTTPD_SCREEN_TIMEOUT 2          //!< 屏幕消息在几个poll周期内没有进展视为阻塞
+
+typedef struct __attribute__((packed)) {
+    uint8_t stream;         //!< udp_stream_id或HTTPD_STREAM_SCREEN
+    uint8_t format;         //!< udp_stream_format，屏幕为0
+    uint16_t reserved;
+    uint32_t seq;           //!< 帧序号，不连续说明中间的帧被跳过
+    uint64_t timestamp_us;  //!< 采集完成时间
+    uint32_t sample_rate;   //!< 采样率，频谱为0
+    uint32_t dropped;       //!< 该连接因发送缓冲区满累计跳过的帧数
+} httpd_ws_frame_header_t;
+
+/**
+ * 启动HTTP服务器，在网络初始化完成后调用
+ */
+void httpd_start();
+
+#endif //ZYNQ7020_HTTPD_H
@@ -0,0 +1,109 @@
+//
+// Created by yaoji on 2022/5/13.
+//
+
+#include "live_page.h"
+
+const char live_page_html[] =
+        "<!DOCTYPE html>\n"
+        "<html>\n"
+        "<head>\n"
+        "<meta charset=\"utf-8\">\n"
+        "<title>Zynq7020 Live</title>\n"
+        "<style>\n"
+        "body{margin:0;background:#202020;color:#ddd;font:14px sans-serif}\n"
+        "header{padding:6px 10px;background:#303030}\n"
+        "canvas{display:block;width:100%;height:40vh;background:#000;margin-top:4px}\n"
+        "label{margin-right:12px}\n"
+        "#c2{height:auto;max-width:1024px;display:none}\n"
+        "</style>\n"
+        "</head>\n"
+        "<body>\n"
+        "<header>\n"
+        "<label><input type=\"checkbox\" id=\"s0\" checked>示波器</label>\n"
+        "<label><input type=\"checkbox\" id=\"s1\" checked>频谱</label>\n"
+        "<label><input type=\"checkbox\" id=\"s2\">屏幕</label>\n"
+        "<label>帧率 <select id=\"fps\"><option>5</option><option>10</option><option selected>20</option><option value=\"0\">不限</option></select></label>\n"
+        "<span id=\"st\">连接中</span>\n"
+        "</header>\n"
+        "<canvas id=\"c0\"></canvas>\n"
+        "<canvas id=\"c1\"></canvas>\n"
+        "<canvas id=\"c2\"></canvas>\n"
+        "<script>\n"
+        "var HDR = 24, ws, cnt = [0, 0, 0], drop = 0, gap = 0, seq = [0, 0], img, sync = 0;\n"
+        "var range = [[-5000, 5000], [-120, 0]];\n"
+        "function $(id) { return document.getElementById(id); }\n"
+        "function sub() {\n"
+        "  if (!ws || ws.readyState != 1) return;\n"
+        "  var s2 = $('s2').checked;\n"
+        "  $('c2').style.display = s2 ? 'block' : 'none';\n"
+        "  /* 取消订阅后再订阅，服务器从关键帧开始发送 */\n"
+        "  if (!s2) sync = 0;\n"
+        "  ws.send(JSON.stringify({streams: ($('s0').checked ? 1 : 0) | ($('s1').checked ? 2 : 0) | (s2 ? 4 : 0), fps: +$('fps').value}));\n"
+        "}\n"
+        "/* 远程屏幕: 图块RLE，c<128后跟c+1个像素，否则1个像素重复c-126次，像素为B G R */\n"
+        "function screen(buf) {\n"
+        "  var v = new DataView(buf, HDR), W = v.getUint16(0, true), H = v.getUint16(2, true), T = v.getUint8(4);\n"
+        "  var c = $('c2'), g = c.getContext('2d');\n"
+        "  if (!img || img.width != W || img.height != H) { c.width = W; c.height = H; img = g.createImageData(W, H); sync = 0; }\n"
+        "  if (v.getUint8(6)) sync = 1;\n"
+        "  if (!sync) return;\n"
+        "  var b = new Uint8Array(buf), px = img.data, o = HDR + 12, n = v.getUint16(8, true);\n"
+        "  for (var t = 0; t < n; t++) {\n"
+        "    var tx = b[o] * T, ty = b[o + 1] * T, end = o + 4 + (b[o + 2] | b[o + 3] << 8), x = 0, d = (ty * W + tx) * 4;\n"
+        "    for (o += 4; o < end;) {\n"
+        "      var k = b[o++], run = k >= 128, m = run ? k - 126 : k + 1;\n"
+        "      for (var i = 0; i < m; i++) {\n"
+        "        var s = run ? o : o + i * 3;\n"
+        "        px[d] = b[s + 2]; px[d + 1] = b[s + 1]; px[d + 2] = b[s]; px[d + 3] = 255;\n"
+        "        d += 4;\n"
+        "        if (++x == T) { x = 0; d += (W - T) * 4; }\n"
+        "      }\n"
+        "      o += run ? 3 : m * 3;\n"
+        "    }\n"
+        "  }\n"
+        "  g.putImageData(img, 0, 0);\n"
+        "}\n"
+        "function draw(id, d, n) {\n"
+        "  var c = $('c' + id), w = c.width = c.clientWidth, h = c.height = c.clientHeight, g = c.getContext('2d');\n"
+        "  var lo = range[id][0], k = h / (range[id][1] - lo);\n"
+        "  g.strokeStyle = '#333';\n"
+        "  for (var i = 1; i < 8; i++) { g.beginPath(); g.moveTo(0, i * h / 8); g.lineTo(w, i * h / 8); g.stroke(); }\n"
+        "  g.strokeStyle = id ? '#fc0' : '#0f0';\n"
+        "  g.beginPath();\n"
+        "  for (var x = 0; x < w; x++) {\n"
+        "    var a = Math.floor(x * n / w), b = Math.max(a + 1, Math.floor((x + 1) * n / w)), mn = d[a], mx = d[a];\n"
+        "    for (var j = a + 1; j < b; j++) { if (d[j] < mn) mn = d[j]; if (d[j] > mx) mx = d[j]; }\n"
+        "    g.moveTo(x + .5, h - (mn - lo) * k); g.lineTo(x + .5, h - (mx - lo) * k - 1);\n"
+        "  }\n"
+        "  g.stroke();\n"
+        "}\n"
+        "function connect() {\n"
+        "  ws = new WebSocket('ws://' + location.host + '/ws');\n"
+        "  ws.binaryType = 'arraybuffer';\n"
+        "  ws.onopen = sub;\n"
+        "  ws.onclose = function () { $('st').textContent = '已断开'; sync = 0; setTimeout(connect, 1000); };\n"
+        "  ws.onmessage = function (e) {\n"
+        "    var v = new DataView(e.data), s = v.getUint8(0), f = v.getUint8(1), q = v.getUint32(4, true);\n"
+        "    if (s == 2) { cnt[2]++; screen(e.data); return; }\n"
+        "    if (s > 2) return;\n"
+        "    if (seq[s] && q != seq[s] + 1) gap += q - seq[s] - 1;\n"
+        "    seq[s] = q; cnt[s]++; drop = v.getUint32(20, true);\n"
+        "    var n = (e.data.byteLength - HDR) / (f ? 4 : 2);\n"
+        "    var d = f ? new Float32Array(e.data, HDR, n) : new Int16Array(e.data, HDR, n);\n"
+        "    /* 频谱只显示单边 */\n"
+        "    draw(s, d, s ? n / 2 : n);\n"
+        "  };\n"
+        "}\n"
+        "setInterval(function () {\n"
+        "  if (ws && ws.readyState == 1)\n"
+        "    $('st').textContent = '示波器 ' + cnt[0] + ' fps, 频谱 ' + cnt[1] + ' fps, 屏幕 ' + cnt[2] + ' fps, 未推送 ' + gap + ', 缓冲区满跳过 ' + drop;\n"
+        "  cnt = [0, 0, 0];\n"
+        "}, 1000);\n"
+        "$('s0').onchange = $('s1').onchange = $('s2').onchange = $('fps').onchange = sub;\n"
+        "connect();\n"
+        "</script>\n"
+        "</body>\n"
+        "</html>\n";
+
+const uint32_t live_page_html_len = sizeof(live_page_html) - 1;
@@ -0,0 +1,16 @@
+//
+// Created by yaoji on 2022/5/13.
+//
+
+#ifndef ZYNQ7020_LIVE_PAGE_H
+#define ZYNQ7020_LIVE_PAGE_H
+
+#include <stdint.h>
+
+/**
+ * 实时查看网页，源码为UTF-8
+ */
+extern const char live_page_html[];
+extern const uint32_t live_page_html_len;
+
+#endif //ZYNQ7020_LIVE_PAGE_H
@@ -0,0 +1,215 @@
+//
+// Created by yaoji on 2022/5/13.
+//
+
+#include <string.h>
+#include "websocket.h"
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+typedef struct {
+    uint32_t h[5];
+    uint8_t block[64];
+    uint32_t block_len;
+    uint64_t total;
+} ws_sha1_ctx;
+
+static inline uint32_t rol32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static void ws_sha1_block(ws_sha1_ctx *ctx, const uint8_t *block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++)
+        w[i] = (uint32_t) block[i * 4] << 24 | (uint32_t) block[i * 4 + 1] << 16 |
+               (uint32_t) block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    for (int i = 16; i < 80; i++)
+        w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = ctx->h[0], b = ctx->h[1], c = ctx->h[2], d = ctx->h[3], e = ctx->h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = rol32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol32(b, 30);
+        b = a;
+        a = t;
+    }
+    ctx->h[0] += a;
+    ctx->h[1] += b;
+    ctx->h[2] += c;
+    ctx->h[3] += d;
+    ctx->h[4] += e;
+}
+
+static void ws_sha1_update(ws_sha1_ctx *ctx, const uint8_t *data, uint32_t len) {
+    ctx->total += len;
+    while (len) {
+        uint32_t n = 64 - ctx->block_len;
+        if (n > len) n = len;
+        memcpy(ctx->block + ctx->block_len, data, n);
+        ctx->block_len += n;
+        data += n;
+        len -= n;
+        if (ctx->block_len == 64) {
+            ws_sha1_block(ctx, ctx->block);
+            ctx->block_len = 0;
+        }
+    }
+}
+
+static void ws_sha1_final(ws_sha1_ctx *ctx, uint8_t *digest) {
+    uint64_t bits = ctx->total * 8;
+    uint8_t pad = 0x80;
+    ws_sha1_update(ctx, &pad, 1);
+    pad = 0;
+    while (ctx->block_len != 56) ws_sha1_update(ctx, &pad, 1);
+    uint8_t len_be[8];
+    for (int i = 0; i < 8; i++) len_be[i] = bits >> (56 - i * 8);
+    ws_sha1_update(ctx, len_be, 8);
+    for (int i = 0; i < 20; i++) digest[i] = ctx->h[i / 4] >> (24 - (i % 4) * 8);
+}
+
+void ws_accept_key(const char *key, uint32_t key_len, char *accept) {
+    static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    ws_sha1_ctx ctx = {.h = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0}};
+    uint8_t digest[21];
+
+    ws_sha1_update(&ctx, (const uint8_t *) key, key_len);
+    ws_sha1_update(&ctx, (const uint8_t *) WS_GUID, sizeof(WS_GUID) - 1);
+    ws_sha1_final(&ctx, digest);
+
+    /* 20字节摘要编码为28个字符，最后一组只有2字节，补一个'=' */
+    digest[20] = 0;
+    for (int i = 0; i < 7; i++) {
+        uint32_t v = (uint32_t) digest[i * 3] << 16 | (uint32_t) digest[i * 3 + 1] << 8 | digest[i * 3 + 2];
+        accept[i * 4] = base64[(v >> 18) & 0x3f];
+        accept[i * 4 + 1] = base64[(v >> 12) & 0x3f];
+        accept[i * 4 + 2] = base64[(v >> 6) & 0x3f];
+        accept[i * 4 + 3] = base64[v & 0x3f];
+    }
+    accept[WS_ACCEPT_KEY_LEN - 1] = '=';
+    accept[WS_ACCEPT_KEY_LEN] = '\0';
+}
+
+uint32_t ws_frame_header(uint8_t *buf, ws_opcode opcode, uint32_t len) {
+    return ws_fragment_header(buf, opcode, 1, len);
+}
+
+uint32_t ws_fragment_header(uint8_t *buf, ws_opcode opcode, int fin, uint32_t len) {
+    buf[0] = (fin ? 0x80 : 0) | opcode;
+    if (len < 126) {
+        buf[1] = len;
+        return 2;
+    }
+    if (len <= 0xffff) {
+        buf[1] = 126;
+        buf[2] = len >> 8;
+        buf[3] = len;
+        return 4;
+    }
+    buf[1] = 127;
+    memset(&buf[2], 0, 4);
+    buf[6] = len >> 24;
+    buf[7] = len >> 16;
+    buf[8] = len >> 8;
+    buf[9] = len;
+    return 10;
+}
+
+void ws_parser_reset(ws_parser *parser) {
+    parser->header_len = 0;
+    parser->header_need = 2;
+    parser->received = 0;
+    parser->close_code = 0;
+}
+
+/**
+ * 帧头前两字节到齐后确定帧头总长度
+ */
+static ws_parse_result ws_parse_header_start(ws_parser *parser) {
+    uint8_t b0 = parser->header[0], b1 = parser->header[1];
+    parser->fin = b0 >> 7;
+    parser->opcode = b0 & 0x0f;
+    /* 没有协商扩展，RSV必须为0；客户端发出的帧必须带掩码 */
+    if ((b0 & 0x70) || !(b1 & 0x80)) {
+        parser->close_code = WS_CLOSE_PROTOCOL_ERROR;
+        return WS_PARSE_ERROR;
+    }
+    uint8_t len7 = b1 & 0x7f;
+    /* 控制帧不能分片，负载不超过125 */
+    if ((parser->opcode & 0x08) && (!parser->fin || len7 > 125)) {
+        parser->close_code = WS_CLOSE_PROTOCOL_ERROR;
+        return WS_PARSE_ERROR;
+    }
+    parser->header_need = (len7 == 126 ? 4 : len7 == 127 ? 10 : 2) + 4;
+    return WS_PARSE_MORE;
+}
+
+/**
+ * 帧头到齐后取出负载长度
+ */
+static ws_parse_result ws_parse_header_end(ws_parser *parser) {
+    uint8_t len7 = parser->header[1] & 0x7f;
+    uint32_t len = len7;
+    if (len7 == 126) {
+        len = (uint32_t) parser->header[2] << 8 | parser->header[3];
+    } else if (len7 == 127) {
+        len = WS_CONTROL_MAX + 1;
+        if (!parser->header[2] && !parser->header[3] && !parser->header[4] && !parser->header[5] &&
+            !parser->header[6] && !parser->header[7] && !parser->header[8])
+            len = parser->header[9];
+    }
+    if (len > WS_CONTROL_MAX) {
+        parser->close_code = WS_CLOSE_TOO_BIG;
+        return WS_PARSE_ERROR;
+    }
+    parser->payload_len = len;
+    return WS_PARSE_MORE;
+}
+
+ws_parse_result ws_parser_feed(ws_parser *parser, const uint8_t *data, uint32_t len, uint32_t *used) {
+    uint32_t pos = 0;
+    /* 上次返回了完整的帧，开始下一帧 */
+    if (parser->header_need == 0) ws_parser_reset(parser);
+
+    while (parser->header_len < parser->header_need) {
+        if (pos == len) {
+            *used = pos;
+            return WS_PARSE_MORE;
+        }
+        parser->header[parser->header_len++] = data[pos++];
+        ws_parse_result res = WS_PARSE_MORE;
+        if (parser->header_len == 2) res = ws_parse_header_start(parser);
+        if (res != WS_PARSE_ERROR && parser->header_len == parser->header_need)
+            res = ws_parse_header_end(parser);
+        if (res == WS_PARSE_ERROR) {
+            *used = pos;
+            return res;
+        }
+    }
+
+    const uint8_t *mask = &parser->header[parser->header_need - 4];
+    while (parser->received < parser->payload_len && pos < len) {
+        parser->payload[parser->received] = data[pos++] ^ mask[parser->received & 3];
+        parser->received++;
+    }
+    *used = pos;
+    if (parser->received < parser->payload_len) return WS_PARSE_MORE;
+    parser->header_need = 0;
+    return WS_PARSE_FRAME;
+}
@@ -0,0 +1,93 @@
+//
+// Created by yaoji on 2022/5/13.
+//
+
+#ifndef ZYNQ7020_WEBSOCKET_H
+#define ZYNQ7020_WEBSOCKET_H
+
+#include <stdint.h>
+
+/**
+ * WebSocket(RFC 6455)协议处理，不依赖协议栈，可以在PC上单独测试
+ */
+
+#define WS_ACCEPT_KEY_LEN 28            //!< Sec-WebSocket-Accept长度，不含结尾0
+#define WS_HEADER_MAX 10                //!< 服务器发出的帧头最大长度(不带掩码)
+#define WS_CONTROL_MAX 125              //!< 接收的帧最大负载，客户端只发送控制命令
+
+typedef enum {
+    WS_OP_CONTINUATION = 0x0,
+    WS_OP_TEXT = 0x1,
+    WS_OP_BINARY = 0x2,
+    WS_OP_CLOSE = 0x8,
+    WS_OP_PING = 0x9,
+    WS_OP_PONG = 0xA,
+} ws_opcode;
+
+typedef enum {
+    WS_CLOSE_NORMAL = 1000,
+    WS_CLOSE_PROTOCOL_ERROR = 1002,
+    WS_CLOSE_UNSUPPORTED = 1003,
+    WS_CLOSE_TOO_BIG = 1009,
+} ws_close_code;
+
+typedef enum {
+    WS_PARSE_MORE,                      //!< 数据已用完，帧不完整
+    WS_PARSE_FRAME,                     //!< 收到一个完整的帧
+    WS_PARSE_ERROR,                     //!< 格式错误或帧过长，应关闭连接
+} ws_parse_result;
+
+typedef struct {
+    uint8_t header[14];
+    uint8_t header_len;
+    uint8_t header_need;
+    uint8_t fin;
+    uint8_t opcode;
+    uint8_t payload_len;
+    uint8_t received;
+    uint8_t payload[WS_CONTROL_MAX];
+    uint16_t close_code;                //!< WS_PARSE_ERROR时建议的关闭码
+} ws_parser;
+
+/**
+ * 计算握手回复的Sec-WebSocket-Accept
+ * @param key 客户端的Sec-WebSocket-Key
+ * @param key_len key长度
+ * @param accept [out] WS_ACCEPT_KEY_LEN + 1字节
+ */
+void ws_accept_key(const char *key, uint32_t key_len, char *accept);
+
+/**
+ * 生成服务器发出的帧头，FIN置位，不带掩码
+ * @param buf [out] 至少WS_HEADER_MAX字节
+ * @param opcode 帧类型
+ * @param len 负载长度
+ * @return 帧头长度
+ */
+uint32_t ws_frame_header(uint8_t *buf, ws_opcode opcode, uint32_t len);
+
+/**
+ * 生成分片的帧头，第一片为消息类型，后续为WS_OP_CONTINUATION，最后一片fin为1。
+ * 分片之间可以插入控制帧，不能插入其它消息
+ * @param buf [out] 至少WS_HEADER_MAX字节
+ * @param opcode 帧类型
+ * @param fin 1: 消息的最后一片
+ * @param len 本片负载长度
+ * @return 帧头长度
+ */
+uint32_t ws_fragment_header(uint8_t *buf, ws_opcode opcode, int fin, uint32_t len);
+
+void ws_parser_reset(ws_parser *parser);
+
+/**
+ * 解析客户端发来的数据，返回WS_PARSE_FRAME时parser中为去掉掩码的完整帧，
+ * 处理完后继续用剩余数据调用
+ * @param parser 解析器
+ * @param data 数据
+ * @param len 数据长度
+ * @param used [out] 本次消耗的字节数
+ * @return ws_parse_result
+ */
+ws_parse_result ws_parser_feed(ws_parser *parser, const uint8_t *data, uint32_t len, uint32_t *used);
+
+#endif //ZYNQ7020_WEBSOCKET_H
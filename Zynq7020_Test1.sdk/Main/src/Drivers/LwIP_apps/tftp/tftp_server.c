@@ -47,22 +47,29 @@
  * This is simple TFTP server for the lwIP raw API.
  */
 
-#include "lwip/apps/tftp_server.h"
+#include "tftp_server_ext.h"
 
 #if LWIP_UDP
 
 #include "lwip/udp.h"
 #include "lwip/timeouts.h"
+#include "lwip/tcpip.h"
 #include "lwip/debug.h"
 
-#define TFTP_MAX_PAYLOAD_SIZE 512
 #define TFTP_HEADER_LENGTH    4
+#define TFTP_OPTIONS_MAX_LEN  128
+#define TFTP_OACK_MAX_LEN     64
 
 #define TFTP_RRQ   1
 #define TFTP_WRQ   2
 #define TFTP_DATA  3
 #define TFTP_ACK   4
 #define TFTP_ERROR 5
+#define TFTP_OACK  6
+
+#define TFTP_OPT_BLKSIZE    0x01
+#define TFTP_OPT_WINDOWSIZE 0x02
+#define TFTP_OPT_TSIZE      0x04
 
 enum tftp_error {
     TFTP_ERROR_FILE_NOT_FOUND = 1,
@@ -74,45 +81,93 @@ enum tftp_error {
     TFTP_ERROR_NO_SUCH_USER = 7
 };
 
+enum tftp_session_state {
+    TFTP_SESSION_FREE,
+    TFTP_SESSION_START,         /* 读请求等后端给出文件大小后回复OACK */
+    TFTP_SESSION_XFER,
+    TFTP_SESSION_FLUSH,         /* 写请求已收到最后一块，等后端写完再确认 */
+    TFTP_SESSION_DALLY,         /* 写请求已完成，最后的ACK丢失时对方会重发最后一个窗口 */
+};
+
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
 
+/* 每个会话使用单独的端口(RFC 1350 TID) */
 struct tftp_state {
-    const struct tftp_context *ctx;
     void *handle;
-    struct pbuf *last_data;
+    struct pbuf *oack;                          /* 等待确认的OACK，超时重发 */
+    struct pbuf *window[TFTP_MAX_WINDOWSIZE];   /* 读: 已发送未确认的数据块 */
+    struct pbuf *pending;                       /* 写: 后端暂时不能接收的数据块 */
     struct udp_pcb *upcb;
     ip_addr_t addr;
     u16_t port;
-    int timer;
     int last_pkt;
-    u16_t blknum;
+    u16_t blknum;                               /* 读: window[0]的块号，写: 期望的下一个块号 */
+    u16_t blksize;
+    u32_t tsize;                                /* 写: 对方声明的文件大小 */
+    u8_t windowsize;
+    u8_t win_count;                             /* 读: window中的块数，写: 上次ACK后收到的块数 */
+    u8_t options;                               /* 接受的选项 TFTP_OPT_* */
+    u8_t state;
+    u8_t eof;                                   /* 读: 最后一块已读出 */
+    u8_t gap_acked;                             /* 本定时周期已处理过丢块(写: 确认乱序的块，读: 按重复ACK重发) */
     u8_t retries;
     u8_t mode_write;
 };
 
-static struct tftp_state tftp_state;
+static const struct tftp_ext_context *tftp_ctx;
+static struct tftp_ext_context tftp_ctx_base;
+static struct udp_pcb *tftp_pcb;
+static struct tftp_state sessions[TFTP_MAX_SESSIONS];
+static int tftp_timer;
+static u8_t tftp_timer_running;
 
 static void tftp_tmr(void *arg);
+static void session_recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16_t port);
 
-static void close_handle(void) {
-    tftp_state.port = 0;
-    ip_addr_set_any(0, &tftp_state.addr);
+/* 只有传输取得进展时才重置超时，重复的报文不能推迟重发 */
+static void progress(struct tftp_state *s) {
+    s->last_pkt = tftp_timer;
+    s->retries = 0;
+}
 
-    if (tftp_state.last_data != NULL) {
-        pbuf_free(tftp_state.last_data);
-        tftp_state.last_data = NULL;
+static void release_buffers(struct tftp_state *s) {
+    if (s->oack != NULL) {
+        pbuf_free(s->oack);
+        s->oack = NULL;
     }
+    for (int i = 0; i < s->win_count && !s->mode_write; i++) {
+        pbuf_free(s->window[i]);
+    }
+    s->win_count = 0;
+    if (s->pending != NULL) {
+        pbuf_free(s->pending);
+        s->pending = NULL;
+    }
+}
 
-    sys_untimeout(tftp_tmr, NULL);
-
-    if (tftp_state.handle) {
-        tftp_state.ctx->close(tftp_state.handle);
-        tftp_state.handle = NULL;
+static void close_file(struct tftp_state *s) {
+    if (s->handle) {
+        tftp_ctx->base.close(s->handle);
+        s->handle = NULL;
         LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, ("tftp: closing\n"));
     }
 }
 
-static void send_error(const ip_addr_t *addr, u16_t port, enum tftp_error code, const char *str) {
+static void close_handle(struct tftp_state *s) {
+    release_buffers(s);
+    close_file(s);
+    if (s->upcb != NULL) {
+        udp_remove(s->upcb);
+        s->upcb = NULL;
+    }
+    s->port = 0;
+    ip_addr_set_any(0, &s->addr);
+    s->state = TFTP_SESSION_FREE;
+}
+
+static void send_error(struct udp_pcb *upcb, const ip_addr_t *addr, u16_t port, enum tftp_error code, const char *str) {
     int str_length = strlen(str);
     struct pbuf *p;
     u16_t *payload;
@@ -127,11 +182,16 @@ static void send_error(const ip_addr_t *addr, u16_t port, enum tftp_error code,
     payload[1] = lwip_htons(code);
     MEMCPY(&payload[2], str, str_length + 1);
 
-    udp_sendto(tftp_state.upcb, p, addr, port);
+    udp_sendto(upcb, p, addr, port);
     pbuf_free(p);
 }
 
-static void send_ack(u16_t blknum) {
+static void session_error(struct tftp_state *s, enum tftp_error code, const char *str) {
+    send_error(s->upcb, &s->addr, s->port, code, str);
+    close_handle(s);
+}
+
+static void send_ack(struct tftp_state *s, u16_t blknum) {
     struct pbuf *p;
     u16_t *payload;
 
@@ -143,72 +203,413 @@ static void send_ack(u16_t blknum) {
 
     payload[0] = PP_HTONS(TFTP_ACK);
     payload[1] = lwip_htons(blknum);
-    udp_sendto(tftp_state.upcb, p, &tftp_state.addr, tftp_state.port);
+    udp_sendto(s->upcb, p, &s->addr, s->port);
     pbuf_free(p);
 }
 
-static void resend_data(void) {
-    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, tftp_state.last_data->len, PBUF_RAM);
+/* 发送保存的报文的副本，原报文留作重发 */
+static void resend_pbuf(struct tftp_state *s, struct pbuf *q) {
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, q->len, PBUF_RAM);
     if (p == NULL) {
         return;
     }
 
-    if (pbuf_copy(p, tftp_state.last_data) != ERR_OK) {
+    if (pbuf_copy(p, q) != ERR_OK) {
         pbuf_free(p);
         return;
     }
 
-    udp_sendto(tftp_state.upcb, p, &tftp_state.addr, tftp_state.port);
+    udp_sendto(s->upcb, p, &s->addr, s->port);
     pbuf_free(p);
 }
 
-static void send_data(void) {
+static void resend_window(struct tftp_state *s) {
+    for (int i = 0; i < s->win_count; i++) {
+        resend_pbuf(s, s->window[i]);
+    }
+}
+
+static u16_t oack_append(char *buf, u16_t pos, const char *name, u32_t value) {
+    int len = snprintf(buf + pos, TFTP_OACK_MAX_LEN - pos, "%s%c%lu",
+                       name, 0, (unsigned long) value);
+    if (len < 0 || pos + len + 1 > TFTP_OACK_MAX_LEN) return pos;
+    return (u16_t) (pos + len + 1);
+}
+
+/**
+ * 解析请求中的选项，记录接受的选项和取值，OACK在start_transfer中生成
+ */
+static void parse_options(struct tftp_state *s, struct pbuf *p, u16_t offset) {
+    char opts[TFTP_OPTIONS_MAX_LEN + 1];
+    u16_t len = 0;
+
+    if (offset < p->tot_len) {
+        len = pbuf_copy_partial(p, opts, TFTP_OPTIONS_MAX_LEN, offset);
+    }
+    opts[len] = 0;
+
+    char *name = opts, *end = opts + len;
+    while (name < end) {
+        char *value = name + strlen(name) + 1;
+        if (value >= end) break;
+        long v = strtol(value, NULL, 10);
+
+        if (lwip_stricmp(name, "blksize") == 0 && v >= 8) {
+            s->blksize = (u16_t) LWIP_MIN(v, TFTP_MAX_BLKSIZE);
+            s->options |= TFTP_OPT_BLKSIZE;
+        } else if (lwip_stricmp(name, "windowsize") == 0 && v >= 1) {
+            s->windowsize = (u8_t) LWIP_MIN(v, TFTP_MAX_WINDOWSIZE);
+            s->options |= TFTP_OPT_WINDOWSIZE;
+        } else if (lwip_stricmp(name, "tsize") == 0 && v >= 0) {
+            /* 写请求回显对方的文件大小，读请求回复实际大小 */
+            if (s->mode_write || tftp_ctx->size != NULL) {
+                s->tsize = (u32_t) v;
+                s->options |= TFTP_OPT_TSIZE;
+            }
+        }
+        /* 不认识的选项忽略，不出现在OACK中 */
+        name = value + strlen(value) + 1;
+    }
+}
+
+static void send_oack(struct tftp_state *s, const char *options, u16_t len) {
+    s->oack = pbuf_alloc(PBUF_TRANSPORT, (u16_t) (2 + len), PBUF_RAM);
+    if (s->oack == NULL) {
+        return;
+    }
+
+    u16_t *payload = (u16_t *) s->oack->payload;
+    payload[0] = PP_HTONS(TFTP_OACK);
+    MEMCPY(&payload[1], options, len);
+    resend_pbuf(s, s->oack);
+}
+
+static void oack_confirmed(struct tftp_state *s) {
+    if (s->oack != NULL) {
+        pbuf_free(s->oack);
+        s->oack = NULL;
+    }
+}
+
+static struct pbuf *read_block(struct tftp_state *s, u16_t blknum) {
     u16_t *payload;
     int ret;
 
-    if (tftp_state.last_data != NULL) {
-        pbuf_free(tftp_state.last_data);
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, (u16_t) (TFTP_HEADER_LENGTH + s->blksize), PBUF_RAM);
+    if (p == NULL) {
+        return NULL;
     }
 
-    tftp_state.last_data = pbuf_alloc(PBUF_TRANSPORT, TFTP_HEADER_LENGTH + TFTP_MAX_PAYLOAD_SIZE, PBUF_RAM);
-    if (tftp_state.last_data == NULL) {
+    payload = (u16_t *) p->payload;
+    payload[0] = PP_HTONS(TFTP_DATA);
+    payload[1] = lwip_htons(blknum);
+
+    ret = tftp_ctx->base.read(s->handle, &payload[2], s->blksize);
+    if (ret == TFTP_IO_PENDING) {
+        /* 后端预读的数据不够，就绪后由tftp_io_ready继续 */
+        pbuf_free(p);
+        return NULL;
+    }
+    if (ret < 0) {
+        pbuf_free(p);
+        session_error(s, TFTP_ERROR_ACCESS_VIOLATION, "Error occured while reading the file.");
+        return NULL;
+    }
+
+    /* 不足一块的数据块(可能为空)是最后一块 */
+    s->eof = ret < s->blksize;
+    pbuf_realloc(p, (u16_t) (TFTP_HEADER_LENGTH + ret));
+    return p;
+}
+
+/* 读出并发送数据块直到窗口填满 */
+static void fill_window(struct tftp_state *s) {
+    while (s->state == TFTP_SESSION_XFER && !s->eof && s->win_count < s->windowsize) {
+        struct pbuf *p = read_block(s, (u16_t) (s->blknum + s->win_count));
+        if (p == NULL) {
+            return;
+        }
+        s->window[s->win_count++] = p;
+        resend_pbuf(s, p);
+    }
+}
+
+/**
+ * 回复请求，有接受的选项时回复OACK，读请求等对方ACK 0后再发数据，写请求等对方直接发数据块1
+ */
+static void start_transfer(struct tftp_state *s) {
+    char oack[TFTP_OACK_MAX_LEN];
+    u16_t oack_len = 0;
+
+    if ((s->options & TFTP_OPT_TSIZE) && !s->mode_write) {
+        int size = tftp_ctx->size(s->handle);
+        if (size == TFTP_IO_PENDING) {
+            s->state = TFTP_SESSION_START;
+            return;
+        }
+        if (size < 0) {
+            session_error(s, TFTP_ERROR_FILE_NOT_FOUND, "Unable to open requested file.");
+            return;
+        }
+        s->tsize = (u32_t) size;
+    }
+    s->state = TFTP_SESSION_XFER;
+
+    if (s->options & TFTP_OPT_BLKSIZE) {
+        oack_len = oack_append(oack, oack_len, "blksize", s->blksize);
+    }
+    if (s->options & TFTP_OPT_WINDOWSIZE) {
+        oack_len = oack_append(oack, oack_len, "windowsize", s->windowsize);
+    }
+    if (s->options & TFTP_OPT_TSIZE) {
+        oack_len = oack_append(oack, oack_len, "tsize", s->tsize);
+    }
+
+    if (oack_len) {
+        send_oack(s, oack, oack_len);
+    } else if (s->mode_write) {
+        send_ack(s, 0);
+    } else {
+        fill_window(s);
+    }
+}
+
+static void recv_ack(struct tftp_state *s, u16_t blknum) {
+    /* 确认到窗口中的第几块，过期的ACK忽略 */
+    u16_t acked = (u16_t) (blknum - s->blknum + 1);
+    if (acked == 0 || acked > s->win_count) {
+        if (s->oack != NULL && blknum == 0) {
+            progress(s);
+            oack_confirmed(s);
+            fill_window(s);
+        } else if (acked == 0 && s->win_count && !s->gap_acked) {
+            /* 对方超时重发了上一个ACK，说明整个窗口丢失，不等定时器直接重发。
+             * 每个定时周期只重发一次，避免重复的ACK引起成倍的重传 */
+            resend_window(s);
+            s->gap_acked = 1;
+        }
         return;
     }
 
-    payload = (u16_t *) tftp_state.last_data->payload;
-    payload[0] = PP_HTONS(TFTP_DATA);
-    payload[1] = lwip_htons(tftp_state.blknum);
+    progress(s);
+    for (int i = 0; i < acked; i++) {
+        pbuf_free(s->window[i]);
+    }
+    s->win_count -= acked;
+    memmove(s->window, s->window + acked, s->win_count * sizeof(struct pbuf *));
+    s->blknum += acked;
 
-    ret = tftp_state.ctx->read(tftp_state.handle, &payload[2], TFTP_MAX_PAYLOAD_SIZE);
+    if (s->win_count == 0 && s->eof) {
+        close_handle(s);
+        return;
+    }
+
+    /* 对方确认了窗口中间的块，说明后面的块丢失，从确认的下一块重发 */
+    resend_window(s);
+    fill_window(s);
+}
+
+/* 最后一块已交给后端，等后端写完再确认，失败时对方能收到错误 */
+static void finish_write(struct tftp_state *s) {
+    int ret = tftp_ctx->flush != NULL ? tftp_ctx->flush(s->handle) : 0;
+    if (ret == TFTP_IO_PENDING) {
+        s->state = TFTP_SESSION_FLUSH;
+        return;
+    }
     if (ret < 0) {
-        send_error(&tftp_state.addr, tftp_state.port, TFTP_ERROR_ACCESS_VIOLATION,
-                   "Error occured while reading the file.");
-        close_handle();
+        session_error(s, TFTP_ERROR_DISK_FULL, "error writing file");
         return;
     }
 
-    pbuf_realloc(tftp_state.last_data, (u16_t) (TFTP_HEADER_LENGTH + ret));
-    resend_data();
+    send_ack(s, (u16_t) (s->blknum - 1));
+    release_buffers(s);
+    close_file(s);
+    s->state = TFTP_SESSION_DALLY;
+    progress(s);
 }
 
-static void recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16_t port) {
+/**
+ * 把按序到达的数据块交给后端
+ * @return 0 后端暂时不能接收，p已保存为pending
+ */
+static int write_block(struct tftp_state *s, struct pbuf *p) {
+    int ret = tftp_ctx->base.write(s->handle, p);
+    if (ret == TFTP_IO_PENDING) {
+        if (s->pending != p) {
+            pbuf_ref(p);
+            s->pending = p;
+        }
+        return 0;
+    }
+    if (s->pending == p) {
+        s->pending = NULL;
+        pbuf_free(p);
+    }
+    if (ret < 0) {
+        session_error(s, TFTP_ERROR_ACCESS_VIOLATION, "error writing file");
+        return -1;
+    }
+    return 1;
+}
+
+static void recv_data(struct tftp_state *s, struct pbuf *p, u16_t blknum) {
+    if (s->state == TFTP_SESSION_DALLY) {
+        /* 最后的ACK丢失，对方重发了最后一个窗口 */
+        if ((u16_t) (s->blknum - 1 - blknum) < TFTP_MAX_WINDOWSIZE) {
+            send_ack(s, (u16_t) (s->blknum - 1));
+        }
+        return;
+    }
+
+    if (blknum != s->blknum || s->pending != NULL || s->state != TFTP_SESSION_XFER) {
+        /* 重复或乱序的块，确认最后一个按序收到的块，每个定时周期只确认一次。
+         * 后端忙时丢弃后面的块，写入pending后再确认 */
+        if (!s->gap_acked && s->pending == NULL && s->state == TFTP_SESSION_XFER) {
+            send_ack(s, (u16_t) (s->blknum - 1));
+            s->gap_acked = 1;
+            s->win_count = 0;
+        }
+        return;
+    }
+    progress(s);
+    oack_confirmed(s);
+
+    pbuf_header(p, -TFTP_HEADER_LENGTH);
+    int ret = write_block(s, p);
+    if (ret < 0) {
+        return;
+    }
+
+    s->blknum++;
+    if (ret == 0) {
+        return;
+    }
+
+    u8_t last = p->tot_len < s->blksize;
+    if (last) {
+        finish_write(s);
+    } else if (++s->win_count >= s->windowsize) {
+        send_ack(s, blknum);
+        s->win_count = 0;
+    }
+}
+
+/* 后端就绪或定时器触发时继续被挂起的读写 */
+static void session_poll(struct tftp_state *s) {
+    switch (s->state) {
+        case TFTP_SESSION_START:
+            start_transfer(s);
+            break;
+        case TFTP_SESSION_XFER:
+            if (s->mode_write && s->pending != NULL) {
+                struct pbuf *p = s->pending;
+                u8_t last = p->tot_len < s->blksize;
+                if (write_block(s, p) <= 0) {
+                    break;
+                }
+                /* 写入期间对方发来的块都被丢弃了，确认后从下一块继续 */
+                if (last) {
+                    finish_write(s);
+                } else {
+                    send_ack(s, (u16_t) (s->blknum - 1));
+                    s->win_count = 0;
+                }
+            } else if (!s->mode_write && s->oack == NULL) {
+                fill_window(s);
+            }
+            break;
+        case TFTP_SESSION_FLUSH:
+            finish_write(s);
+            break;
+        default:
+            break;
+    }
+}
+
+static void session_recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16_t port) {
+    struct tftp_state *s = arg;
     u16_t *sbuf = (u16_t *) p->payload;
-    int opcode;
 
-    LWIP_UNUSED_ARG(arg);
-    LWIP_UNUSED_ARG(upcb);
+    if (port != s->port || !ip_addr_cmp(&s->addr, addr)) {
+        send_error(upcb, addr, port, TFTP_ERROR_UNKNOWN_TRFR_ID, "Unknown transfer ID");
+        pbuf_free(p);
+        return;
+    }
 
-    if (((tftp_state.port != 0) && (port != tftp_state.port)) ||
-        (!ip_addr_isany_val(tftp_state.addr) && !ip_addr_cmp(&tftp_state.addr, addr))) {
-        send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Only one connection at a time is supported");
+    if (p->len < TFTP_HEADER_LENGTH) {
         pbuf_free(p);
         return;
     }
 
-    opcode = sbuf[0];
+    switch (sbuf[0]) {
+        case PP_HTONS(TFTP_DATA):
+            if (s->mode_write != 1) {
+                session_error(s, TFTP_ERROR_ACCESS_VIOLATION, "Not a write connection");
+                break;
+            }
+            recv_data(s, p, lwip_ntohs(sbuf[1]));
+            break;
+
+        case PP_HTONS(TFTP_ACK):
+            if (s->mode_write != 0) {
+                session_error(s, TFTP_ERROR_ACCESS_VIOLATION, "Not a read connection");
+                break;
+            }
+            if (s->state == TFTP_SESSION_XFER) {
+                recv_ack(s, lwip_ntohs(sbuf[1]));
+            }
+            break;
+
+        case PP_HTONS(TFTP_ERROR):
+            /* 对方拒绝OACK或中止传输 */
+            LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, ("tftp: error from peer\n"));
+            close_handle(s);
+            break;
+
+        default:
+            session_error(s, TFTP_ERROR_ILLEGAL_OPERATION, "Unknown operation");
+            break;
+    }
+
+    pbuf_free(p);
+}
+
+static struct tftp_state *find_session(const ip_addr_t *addr, u16_t port) {
+    for (int i = 0; i < TFTP_MAX_SESSIONS; i++) {
+        struct tftp_state *s = &sessions[i];
+        if (s->state != TFTP_SESSION_FREE && s->port == port && ip_addr_cmp(&s->addr, addr)) {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/* 空闲的会话，没有时回收最早完成的写请求 */
+static struct tftp_state *alloc_session(void) {
+    struct tftp_state *dally = NULL;
+    for (int i = 0; i < TFTP_MAX_SESSIONS; i++) {
+        struct tftp_state *s = &sessions[i];
+        if (s->state == TFTP_SESSION_FREE) {
+            return s;
+        }
+        if (s->state == TFTP_SESSION_DALLY && (dally == NULL || s->last_pkt < dally->last_pkt)) {
+            dally = s;
+        }
+    }
+    if (dally != NULL) {
+        close_handle(dally);
+    }
+    return dally;
+}
 
-    tftp_state.last_pkt = tftp_state.timer;
-    tftp_state.retries = 0;
+static void recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16_t port) {
+    u16_t *sbuf = (u16_t *) p->payload;
+    int opcode;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(upcb);
+
+    opcode = p->len >= 2 ? sbuf[0] : 0;
 
     switch (opcode) {
         case PP_HTONS(TFTP_RRQ): /* fall through */
@@ -218,18 +619,30 @@ static void recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_
             char mode[TFTP_MAX_MODE_LEN] = {0};
             u16_t filename_end_offset = 0;
             u16_t mode_end_offset = 0;
+            struct tftp_state *s;
 
-            if (tftp_state.handle != NULL) {
-                send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Only one connection at a time is supported");
+            s = find_session(addr, port);
+            if (s != NULL && s->state == TFTP_SESSION_DALLY) {
+                /* 同一端口发起了新的请求，上一次写请求已经完成 */
+                close_handle(s);
+                s = NULL;
+            }
+            if (s != NULL) {
+                /* 同一客户端重发的请求，说明第一个回复丢失 */
+                if (s->oack != NULL) {
+                    resend_pbuf(s, s->oack);
+                } else if (s->state == TFTP_SESSION_XFER && s->blknum == 1 && s->mode_write) {
+                    send_ack(s, 0);
+                } else if (s->state == TFTP_SESSION_XFER && s->blknum == 1) {
+                    resend_window(s);
+                }
                 break;
             }
 
-            sys_timeout(TFTP_TIMER_MSECS, tftp_tmr, NULL);
-
             /* find \0 in pbuf -> end of filename string */
             filename_end_offset = pbuf_memfind(p, &tftp_null, sizeof(tftp_null), 2);
             if ((u16_t) (filename_end_offset - 2) > sizeof(filename)) {
-                send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Filename too long/not NULL terminated");
+                send_error(upcb, addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Filename too long/not NULL terminated");
                 break;
             }
             pbuf_copy_partial(p, filename, filename_end_offset - 2, 2);
@@ -237,107 +650,68 @@ static void recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_
             /* find \0 in pbuf -> end of mode string */
             mode_end_offset = pbuf_memfind(p, &tftp_null, sizeof(tftp_null), filename_end_offset + 1);
             if ((u16_t) (mode_end_offset - filename_end_offset) > sizeof(mode)) {
-                send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Mode too long/not NULL terminated");
+                send_error(upcb, addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Mode too long/not NULL terminated");
                 break;
             }
             pbuf_copy_partial(p, mode, mode_end_offset - filename_end_offset, filename_end_offset + 1);
 
-            tftp_state.handle = tftp_state.ctx->open(filename, mode, opcode == PP_HTONS(TFTP_WRQ));
-            tftp_state.blknum = 1;
-
-            if (!tftp_state.handle) {
-                send_error(addr, port, TFTP_ERROR_FILE_NOT_FOUND, "Unable to open requested file.");
-                break;
-            }
-
-            LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE,
-                        ("tftp: %s request from ", (opcode == PP_HTONS(TFTP_WRQ)) ? "write" : "read"));
-            ip_addr_debug_print(TFTP_DEBUG | LWIP_DBG_STATE, addr);
-            LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, (" for '%s' mode '%s'\n", filename, mode));
-
-            ip_addr_copy(tftp_state.addr, *addr);
-            tftp_state.port = port;
-
-            if (opcode == PP_HTONS(TFTP_WRQ)) {
-                tftp_state.mode_write = 1;
-                send_ack(0);
-            } else {
-                tftp_state.mode_write = 0;
-                send_data();
-            }
-
-            break;
-        }
-
-        case PP_HTONS(TFTP_DATA): {
-            int ret;
-            u16_t blknum;
-
-            if (tftp_state.handle == NULL) {
-                send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "No connection");
+            s = alloc_session();
+            if (s == NULL) {
+                send_error(upcb, addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Too many connections");
                 break;
             }
 
-            if (tftp_state.mode_write != 1) {
-                send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Not a write connection");
+            s->upcb = udp_new_ip_type(IPADDR_TYPE_ANY);
+            if (s->upcb == NULL || udp_bind(s->upcb, IP_ANY_TYPE, 0) != ERR_OK) {
+                if (s->upcb != NULL) {
+                    udp_remove(s->upcb);
+                    s->upcb = NULL;
+                }
+                send_error(upcb, addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Out of memory");
                 break;
             }
-
-            blknum = lwip_ntohs(sbuf[1]);
-            pbuf_header(p, -TFTP_HEADER_LENGTH);
-
-            ret = tftp_state.ctx->write(tftp_state.handle, p);
-            if (ret < 0) {
-                send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "error writing file");
-                close_handle();
-            } else {
-                send_ack(blknum);
+            udp_recv(s->upcb, session_recv, s);
+
+            memset(s->window, 0, sizeof(s->window));
+            s->oack = NULL;
+            s->pending = NULL;
+            s->blknum = 1;
+            s->blksize = TFTP_DEFAULT_BLKSIZE;
+            s->windowsize = 1;
+            s->win_count = 0;
+            s->options = 0;
+            s->tsize = 0;
+            s->eof = 0;
+            s->gap_acked = 0;
+            s->mode_write = opcode == PP_HTONS(TFTP_WRQ);
+            s->state = TFTP_SESSION_XFER;
+            ip_addr_copy(s->addr, *addr);
+            s->port = port;
+            progress(s);
+
+            if (!tftp_timer_running) {
+                tftp_timer_running = 1;
+                sys_timeout(TFTP_TIMER_MSECS, tftp_tmr, NULL);
             }
 
-            if (p->tot_len < TFTP_MAX_PAYLOAD_SIZE) {
-                close_handle();
-            }
-            break;
-        }
-
-        case PP_HTONS(TFTP_ACK): {
-            u16_t blknum;
-            int lastpkt;
-
-            if (tftp_state.handle == NULL) {
-                send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "No connection");
+            s->handle = tftp_ctx->base.open(filename, mode, s->mode_write);
+            if (!s->handle) {
+                session_error(s, TFTP_ERROR_FILE_NOT_FOUND, "Unable to open requested file.");
                 break;
             }
 
-            if (tftp_state.mode_write != 0) {
-                send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Not a read connection");
-                break;
-            }
-
-            blknum = lwip_ntohs(sbuf[1]);
-            if (blknum != tftp_state.blknum) {
-                send_error(addr, port, TFTP_ERROR_UNKNOWN_TRFR_ID, "Wrong block number");
-                break;
-            }
-
-            lastpkt = 0;
-
-            if (tftp_state.last_data != NULL) {
-                lastpkt = tftp_state.last_data->tot_len != (TFTP_MAX_PAYLOAD_SIZE + TFTP_HEADER_LENGTH);
-            }
-
-            if (!lastpkt) {
-                tftp_state.blknum++;
-                send_data();
-            } else {
-                close_handle();
-            }
+            LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE,
+                        ("tftp: %s request from ", s->mode_write ? "write" : "read"));
+            ip_addr_debug_print(TFTP_DEBUG | LWIP_DBG_STATE, addr);
+            LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, (" for '%s' mode '%s'\n", filename, mode));
 
+            parse_options(s, p, (u16_t) (mode_end_offset + 1));
+            start_transfer(s);
             break;
         }
 
         default:
-            send_error(addr, port, TFTP_ERROR_ILLEGAL_OPERATION, "Unknown operation");
+            send_error(upcb, addr, port, TFTP_ERROR_UNKNOWN_TRFR_ID, "Unknown transfer ID");
             break;
     }
 
@@ -346,32 +720,67 @@ static void recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_
 
 static void tftp_tmr(void *arg) {
     LWIP_UNUSED_ARG(arg);
+    u8_t active = 0;
 
-    tftp_state.timer++;
+    tftp_timer++;
 
-    if (tftp_state.handle == NULL) {
-        return;
+    for (int i = 0; i < TFTP_MAX_SESSIONS; i++) {
+        struct tftp_state *s = &sessions[i];
+        if (s->state == TFTP_SESSION_FREE) {
+            continue;
+        }
+        s->gap_acked = 0;
+
+        /* 后端的通知可能因为消息队列满而丢失，每个周期轮询一次 */
+        session_poll(s);
+        if (s->state == TFTP_SESSION_FREE) {
+            continue;
+        }
+
+        if ((tftp_timer - s->last_pkt) > (TFTP_TIMEOUT_MSECS / TFTP_TIMER_MSECS)) {
+            u8_t pending = s->state == TFTP_SESSION_XFER &&
+                           (s->oack != NULL || (!s->mode_write && s->win_count));
+            if (pending && (s->retries < TFTP_MAX_RETRIES)) {
+                LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, ("tftp: timeout, retrying\n"));
+                if (s->oack != NULL) {
+                    resend_pbuf(s, s->oack);
+                } else {
+                    resend_window(s);
+                }
+                s->retries++;
+                s->last_pkt = tftp_timer;
+            } else {
+                LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, ("tftp: timeout\n"));
+                close_handle(s);
+                continue;
+            }
+        }
+        active = 1;
     }
 
-    sys_timeout(TFTP_TIMER_MSECS, tftp_tmr, NULL);
+    if (active) {
+        sys_timeout(TFTP_TIMER_MSECS, tftp_tmr, NULL);
+    } else {
+        tftp_timer_running = 0;
+    }
+}
 
-    if ((tftp_state.timer - tftp_state.last_pkt) > (TFTP_TIMEOUT_MSECS / TFTP_TIMER_MSECS)) {
-        if ((tftp_state.last_data != NULL) && (tftp_state.retries < TFTP_MAX_RETRIES)) {
-            LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, ("tftp: timeout, retrying\n"));
-            resend_data();
-            tftp_state.retries++;
-        } else {
-            LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, ("tftp: timeout\n"));
-            close_handle();
+static void tftp_io_ready_cb(void *handle) {
+    for (int i = 0; i < TFTP_MAX_SESSIONS; i++) {
+        struct tftp_state *s = &sessions[i];
+        if (s->state != TFTP_SESSION_FREE && s->handle == handle) {
+            session_poll(s);
+            return;
         }
     }
 }
 
-/** @ingroup tftp
- * Initialize TFTP server.
- * @param ctx TFTP callback struct
- */
-err_t tftp_init(const struct tftp_context *ctx) {
+void tftp_io_ready(void *handle) {
+    /* 失败时由定时器轮询 */
+    tcpip_callback_with_block(tftp_io_ready_cb, handle, 0);
+}
+
+err_t tftp_init_ext(const struct tftp_ext_context *ctx) {
     err_t ret;
 
     struct udp_pcb *pcb = udp_new_ip_type(IPADDR_TYPE_ANY);
@@ -385,16 +794,26 @@ err_t tftp_init(const struct tftp_context *ctx) {
         return ret;
     }
 
-    tftp_state.handle = NULL;
-    tftp_state.port = 0;
-    tftp_state.ctx = ctx;
-    tftp_state.timer = 0;
-    tftp_state.last_data = NULL;
-    tftp_state.upcb = pcb;
+    memset(sessions, 0, sizeof(sessions));
+    tftp_ctx = ctx;
+    tftp_timer = 0;
+    tftp_timer_running = 0;
+    tftp_pcb = pcb;
 
     udp_recv(pcb, recv, NULL);
 
     return ERR_OK;
 }
 
+/** @ingroup tftp
+ * Initialize TFTP server.
+ * @param ctx TFTP callback struct
+ */
+err_t tftp_init(const struct tftp_context *ctx) {
+    tftp_ctx_base.base = *ctx;
+    tftp_ctx_base.size = NULL;
+    tftp_ctx_base.flush = NULL;
+    return tftp_init_ext(&tftp_ctx_base);
+}
+
 #endif /* LWIP_UDP */
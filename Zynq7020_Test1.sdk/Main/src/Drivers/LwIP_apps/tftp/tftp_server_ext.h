@@ -0,0 +1,45 @@
+//
+// Created by yaoji on 2022/5/12.
+//
+
+#ifndef ZYNQ7020_TFTP_SERVER_EXT_H
+#define ZYNQ7020_TFTP_SERVER_EXT_H
+
+#include "lwip/apps/tftp_server.h"
+
+/**
+ * tftp_server.c在lwIP TFTP服务器基础上的扩展
+ * 支持blksize(RFC 2348)、tsize(RFC 2349)、windowsize(RFC 7440)选项协商，
+ * 最多TFTP_MAX_SESSIONS个传输同时进行，每个传输使用单独的端口。
+ * 回调都在协议栈线程中执行，read/write/size可以返回TFTP_IO_PENDING表示后端还没有就绪，
+ * 后端就绪后调用tftp_io_ready，服务器重新调用该回调
+ */
+
+#define TFTP_DEFAULT_BLKSIZE 512
+#define TFTP_MAX_BLKSIZE 1468           //!< 以太网MTU内不分片的最大块长度
+#define TFTP_MAX_WINDOWSIZE 8           //!< 读请求最多缓存的未确认数据块，每块占用一个PBUF_RAM
+#define TFTP_MAX_SESSIONS 4             //!< 同时进行的传输数，每个占用一个udp_pcb
+#define TFTP_IO_PENDING (-2)
+
+struct tftp_ext_context {
+    struct tftp_context base;
+    /** 读请求tsize选项的文件大小，失败返回-1，为NULL时读请求不回复tsize */
+    int (*size)(void *handle);
+    /** 写请求收到最后一块后调用，数据写入存储后返回0，失败返回-1，可以为NULL */
+    int (*flush)(void *handle);
+};
+
+/**
+ * 初始化TFTP服务器
+ * @param ctx 回调
+ * @return ERR_OK
+ */
+err_t tftp_init_ext(const struct tftp_ext_context *ctx);
+
+/**
+ * 后端数据就绪或有空闲缓冲区后通知服务器，可以在任意任务中调用
+ * @param handle open返回的句柄
+ */
+void tftp_io_ready(void *handle);
+
+#endif //ZYNQ7020_TFTP_SERVER_EXT_H
@@ -4,28 +4,84 @@
 
 #include "tftp_user.h"
 #include "xil_printf.h"
+#include "xstatus.h"
 #include "FreeRTOS_Mem/FreeRTOS_Mem.h"
 #include "Fatfs_init/Fatfs_Driver.h"
+#include "Fatfs_init/Encoding.h"
+#include "FileService/FileService.h"
+#include "DiskCache/DiskCache.h"
+#include "DMA_Driver/DMA_Mem.h"
 #include "utils/str_tool.h"
-#include <lwip/apps/tftp_server.h>
+#include "tftp_server_ext.h"
+#include "lwip/def.h"
+#include <stdbool.h>
 #include <ff.h>
 #include <cJSON.h>
 
+/**
+ * 文件读写交给文件服务任务异步执行，协议栈线程只访问每个会话的环形缓冲区。
+ * 缓冲区在文件打开后按卷的簇大小从DMA_Mem分配，由TFTP_FS_RING_CHUNKS个块组成，
+ * 每块为一簇(限制在TFTP_FS_CHUNK_MIN~TFTP_FS_CHUNK_MAX之间)。
+ * 收到的pbuf链只拷贝一次，直接拼进块中；每次读写整块，文件偏移和缓冲区都按簇对齐，
+ * FatFs不经过扇区窗口，簇不小于DISK_CACHE_BYPASS个扇区时DiskCache也不缓存，由ADMA2直接读写缓冲区。
+ * 同一个文件同时只有一个请求在文件服务中，由busy保证
+ */
+
+#define TFTP_FS_CHUNK_MIN   (DISK_CACHE_BYPASS * DISK_CACHE_SECTOR_SIZE)    //!< 小于该长度的读写会经过磁盘缓存
+#define TFTP_FS_CHUNK_MAX   (128 * 1024)
+#define TFTP_FS_RING_CHUNKS 2               //!< 一块在文件服务中读写时协议栈使用另一块，总长大于一个传输窗口
+#define TFTP_FS_OP_NONE     ((FileService_Op) -1)
+
+typedef enum {
+    TFTP_FS_STAGE_MKDIR,
+    TFTP_FS_STAGE_OPEN,
+    TFTP_FS_STAGE_IO,
+    TFTP_FS_STAGE_CLOSE,
+} tftp_fs_stage;
+
+typedef struct {
+    FIL file;
+    FileService_Request req;
+    char *dir;                          //!< 写请求需要创建的目录
+    char path[TFTP_MAX_FILENAME_LEN + 1];
+    DMA_Mem_Buf ring;                   //!< 只用DMA_Mem的缓存行对齐，缓存由SD驱动在DMA前后维护
+    uint32_t chunk;                     //!< 每次提交给文件服务的读写长度，2的幂
+    uint32_t ring_size;
+    /* 读: 文件服务写head，协议栈读tail；写: 协议栈写head，文件服务读tail */
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t busy;             //!< 有请求在文件服务中
+    volatile uint8_t stage;
+    volatile uint8_t eof;
+    volatile uint8_t error;
+    volatile uint8_t flushing;          //!< 写请求收到最后一块，剩余数据不足一块也写入
+    volatile uint8_t synced;
+    volatile uint8_t closing;
+    uint8_t write;
+} tftp_fs_file;
+
 static void *tftp_fs_open(const char *fname, const char *mode, u8_t write);
 static void tftp_fs_close(void *handle);
 static int tftp_fs_read(void *handle, void *buf, int bytes);
 static int tftp_fs_write(void *handle, struct pbuf *p);
+static int tftp_fs_size(void *handle);
+static int tftp_fs_flush(void *handle);
+static void tftp_fs_kick(tftp_fs_file *f, bool in_service);
 
-static struct tftp_context context = {
-        .open = tftp_fs_open,
-        .close = tftp_fs_close,
-        .read = tftp_fs_read,
-        .write = tftp_fs_write,
+static struct tftp_ext_context context = {
+        .base = {
+                .open = tftp_fs_open,
+                .close = tftp_fs_close,
+                .read = tftp_fs_read,
+                .write = tftp_fs_write,
+        },
+        .size = tftp_fs_size,
+        .flush = tftp_fs_flush,
 };
 
 void tftp_start() {
     if (Fatfs_GetMountStatus(SD_INDEX) == FR_OK) {
-        err_t err = tftp_init(&context);
+        err_t err = tftp_init_ext(&context);
         if (err) {
             xil_printf("tftp [init] error %d\r\n", err);
         } else {
@@ -34,61 +90,261 @@ void tftp_start() {
     } else xil_printf("tftp [init] no SD card, skip\r\n");
 }
 
+/**
+ * 下一个需要提交给文件服务的操作，没有副作用，用于判断是否需要提交
+ */
+static FileService_Op tftp_fs_next_op(tftp_fs_file *f) {
+    switch (f->stage) {
+        case TFTP_FS_STAGE_MKDIR:
+            return FS_OP_MKDIR_P;
+        case TFTP_FS_STAGE_OPEN:
+            return FS_OP_OPEN;
+        case TFTP_FS_STAGE_IO:
+            break;
+        default:
+            return TFTP_FS_OP_NONE;
+    }
+
+    uint32_t used = __atomic_load_n(&f->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&f->tail, __ATOMIC_ACQUIRE);
+    if (f->write) {
+        if (!f->error && used && (used >= f->chunk || f->flushing || f->closing)) return FS_OP_WRITE;
+        if (!f->error && f->flushing && !f->synced) return FS_OP_SYNC;
+    } else {
+        if (!f->closing && !f->error && !f->eof && f->ring_size - used >= f->chunk) return FS_OP_READ;
+    }
+    return f->closing ? FS_OP_CLOSE : TFTP_FS_OP_NONE;
+}
+
+static void tftp_fs_done(FileService_Request *req);
+
+static void tftp_fs_submit(tftp_fs_file *f, FileService_Op op, bool in_service) {
+    FileService_Request *req = &f->req;
+    memset(req, 0, sizeof(*req));
+    req->op = op;
+    req->file = &f->file;
+    req->callback = tftp_fs_done;
+    req->user_data = f;
+
+    uint8_t *ring = f->ring.addr;
+    uint32_t head = f->head, tail = f->tail;
+    switch (op) {
+        case FS_OP_MKDIR_P:
+            req->path = f->dir;
+            break;
+        case FS_OP_OPEN:
+            req->path = f->path;
+            req->mode = f->write ? FA_WRITE | FA_CREATE_ALWAYS : FA_READ;
+            break;
+        case FS_OP_READ:
+            /* 文件结束前每次读满一块，head总在块边界上 */
+            req->buf = ring + (head & (f->ring_size - 1));
+            req->len = f->chunk;
+            break;
+        case FS_OP_WRITE:
+            /* 只有最后一次写入不足一块，tail在此之前总在块边界上，不会跨过缓冲区末尾 */
+            req->buf = ring + (tail & (f->ring_size - 1));
+            req->len = LWIP_MIN(head - tail, f->chunk - (tail & (f->chunk - 1)));
+            break;
+        case FS_OP_CLOSE:
+            f->stage = TFTP_FS_STAGE_CLOSE;
+            break;
+        default:
+            break;
+    }
+
+    if (FileService_post(req, 0) == pdTRUE) return;
+    if (op != FS_OP_CLOSE) {
+        /* 队列满，服务器轮询时再次提交 */
+        __atomic_store_n(&f->busy, 0, __ATOMIC_SEQ_CST);
+        return;
+    }
+    /* 关闭之后服务器不再轮询，必须提交成功 */
+    if (in_service) {
+        FileService_call(req);
+        tftp_fs_done(req);
+    } else {
+        FileService_post(req, portMAX_DELAY);
+    }
+}
+
+/**
+ * 没有请求在文件服务中时提交下一个操作，协议栈线程和文件服务任务都会调用
+ */
+static void tftp_fs_kick(tftp_fs_file *f, bool in_service) {
+    /* 释放busy后重新检查，避免对方在busy期间更新的状态被漏掉 */
+    while (tftp_fs_next_op(f) != TFTP_FS_OP_NONE) {
+        uint32_t idle = 0;
+        if (!__atomic_compare_exchange_n(&f->busy, &idle, 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            return;
+        FileService_Op op = tftp_fs_next_op(f);
+        if (op != TFTP_FS_OP_NONE) {
+            tftp_fs_submit(f, op, in_service);
+            return;
+        }
+        __atomic_store_n(&f->busy, 0, __ATOMIC_SEQ_CST);
+    }
+}
+
+/**
+ * 文件打开后按所在卷的簇大小分配缓冲区
+ * @return XST_SUCCESS 或 XST_FAILURE
+ */
+static int tftp_fs_alloc_ring(tftp_fs_file *f) {
+    uint32_t cluster = (uint32_t) f->file.obj.fs->csize * FF_MAX_SS;
+    f->chunk = LWIP_MIN(LWIP_MAX(cluster, TFTP_FS_CHUNK_MIN), TFTP_FS_CHUNK_MAX);
+    f->ring_size = f->chunk * TFTP_FS_RING_CHUNKS;
+    return DMA_Mem_alloc(&f->ring, f->ring_size, DMA_MEM_BIDIRECTIONAL);
+}
+
+/**
+ * 文件服务任务中执行的完成回调
+ */
+static void tftp_fs_done(FileService_Request *req) {
+    tftp_fs_file *f = req->user_data;
+    switch (req->op) {
+        case FS_OP_MKDIR_P:
+            os_free(f->dir);
+            f->dir = NULL;
+            f->stage = TFTP_FS_STAGE_OPEN;
+            break;
+        case FS_OP_OPEN:
+            if (req->result != FR_OK) {
+                xil_printf("tftp: [open] error: return %d\r\n", req->result);
+                f->error = 1;
+            } else if (tftp_fs_alloc_ring(f) != XST_SUCCESS) {
+                xil_printf("tftp: [open] no memory for %d bytes buffer\r\n", (int) f->ring_size);
+                f->error = 1;
+            } else {
+                xil_printf("tftp: [open] success handle=%p chunk=%d\r\n", f, (int) f->chunk);
+            }
+            __atomic_store_n(&f->stage, TFTP_FS_STAGE_IO, __ATOMIC_RELEASE);
+            break;
+        case FS_OP_READ:
+            if (req->result != FR_OK) {
+                f->error = 1;
+                break;
+            }
+            __atomic_add_fetch(&f->head, req->done, __ATOMIC_RELEASE);
+            if (req->done < req->len) __atomic_store_n(&f->eof, 1, __ATOMIC_RELEASE);
+            break;
+        case FS_OP_WRITE:
+            if (req->result != FR_OK || req->done != req->len) {
+                xil_printf("tftp: [write] error: return %d\r\n", req->result);
+                f->error = 1;
+            }
+            __atomic_add_fetch(&f->tail, req->done, __ATOMIC_RELEASE);
+            break;
+        case FS_OP_SYNC:
+            if (req->result != FR_OK) f->error = 1;
+            f->synced = 1;
+            break;
+        case FS_OP_CLOSE:
+            xil_printf("tftp: [close] %p\r\n", f);
+            if (f->dir) os_free(f->dir);
+            DMA_Mem_free(&f->ring);
+            os_free(f);
+            return;
+        default:
+            break;
+    }
+
+    __atomic_store_n(&f->busy, 0, __ATOMIC_SEQ_CST);
+    tftp_fs_kick(f, true);
+    tftp_io_ready(f);
+}
+
 static void *tftp_fs_open(const char *fname, const char *mode, u8_t write) {
     LWIP_UNUSED_ARG(mode);
-    vPortEnterCritical();
-    FIL *file_ptr = os_malloc(sizeof(FIL));
-    if (file_ptr == NULL) return NULL;
-    else memset(file_ptr, 0, sizeof(FILE));
-    char *utf8 = GBK_TO_UTF8(fname);
+    tftp_fs_file *f = os_malloc_tag(sizeof(tftp_fs_file), OS_MEM_TAG_LWIP_APPS);
+    if (f == NULL) return NULL;
+    memset(f, 0, sizeof(tftp_fs_file));
+
+    char utf8[ENCODING_PATH_MAX];
+    Encoding_gbk_to_utf8(utf8, sizeof(utf8), fname);
     xil_printf("tftp: [open] filename=%s, mode=%s, %c\r\n", utf8, mode, write ? 'w' : 'r');
-    os_free(utf8);
 
+    strncpy(f->path, fname, TFTP_MAX_FILENAME_LEN);
+    f->write = write;
+    f->stage = TFTP_FS_STAGE_OPEN;
     if (write) {
-        char *path = Fatfs_GetFileDir(fname);
-        Fatfs_mkdir_p(path);
-        os_free(path);
+        f->dir = Fatfs_GetFileDir(fname);
+        if (f->dir) f->stage = TFTP_FS_STAGE_MKDIR;
     }
-
-    FRESULT ret = f_open(file_ptr, fname, write ? FA_WRITE | FA_CREATE_ALWAYS : FA_READ);
-    if (ret == FR_OK) {
-        xil_printf("tftp: [open] success handle=%p\r\n", file_ptr);
-        vPortExitCritical();
-        return file_ptr;
-    }
-    xil_printf("tftp: [open] error: return %d\r\n", ret);
-    os_free(file_ptr);
-    vPortExitCritical();
-    return NULL;
+    tftp_fs_kick(f, false);
+    return f;
 }
 
 static void tftp_fs_close(void *handle) {
-    vPortEnterCritical();
-    f_close(handle);
-    vPortExitCritical();
-    xil_printf("tftp: [close] %p\r\n", handle);
-    os_free(handle);
+    tftp_fs_file *f = handle;
+    f->closing = 1;
+    tftp_fs_kick(f, false);
 }
 
 static int tftp_fs_read(void *handle, void *buf, int bytes) {
-    UINT read_bytes = 0;
-    vPortEnterCritical();
-    f_read(handle, buf, bytes, &read_bytes);
-    vPortExitCritical();
-    return read_bytes;
+    tftp_fs_file *f = handle;
+    if (f->error) return -1;
+
+    /* 先读eof再读head，eof之前写入的数据都可见 */
+    bool eof = __atomic_load_n(&f->eof, __ATOMIC_ACQUIRE);
+    uint32_t tail = f->tail;
+    uint32_t used = __atomic_load_n(&f->head, __ATOMIC_ACQUIRE) - tail;
+    if (used < (uint32_t) bytes && !eof) {
+        tftp_fs_kick(f, false);
+        return TFTP_IO_PENDING;
+    }
+
+    uint8_t *ring = f->ring.addr;
+    uint32_t len = LWIP_MIN(used, (uint32_t) bytes);
+    uint32_t pos = tail & (f->ring_size - 1);
+    uint32_t first = LWIP_MIN(len, f->ring_size - pos);
+    memcpy(buf, ring + pos, first);
+    memcpy((uint8_t *) buf + first, ring, len - first);
+    __atomic_store_n(&f->tail, tail + len, __ATOMIC_RELEASE);
+    tftp_fs_kick(f, false);
+    return (int) len;
 }
 
 static int tftp_fs_write(void *handle, struct pbuf *p) {
-    int sum_bytes = 0;
-    vPortEnterCritical();
-    while (p) {
-        UINT write_bytes = 0;
-        FRESULT ret = f_write(handle, p->payload, p->len, &write_bytes);
-        if (ret == FR_OK) {
-            p = p->next;
-            sum_bytes += write_bytes;
-        } else return -1;
+    tftp_fs_file *f = handle;
+    if (f->error) return -1;
+
+    /* 文件打开之前没有缓冲区 */
+    if (__atomic_load_n(&f->stage, __ATOMIC_ACQUIRE) < TFTP_FS_STAGE_IO) {
+        tftp_fs_kick(f, false);
+        return TFTP_IO_PENDING;
+    }
+    uint32_t head = f->head;
+    uint32_t space = f->ring_size - (head - __atomic_load_n(&f->tail, __ATOMIC_ACQUIRE));
+    if (space < p->tot_len) {
+        tftp_fs_kick(f, false);
+        return TFTP_IO_PENDING;
+    }
+
+    /* pbuf链逐段直接拷进块中，跨过缓冲区末尾时分两次 */
+    uint8_t *ring = f->ring.addr;
+    uint32_t pos = head & (f->ring_size - 1);
+    uint32_t first = LWIP_MIN(p->tot_len, f->ring_size - pos);
+    pbuf_copy_partial(p, ring + pos, first, 0);
+    pbuf_copy_partial(p, ring, p->tot_len - first, first);
+    __atomic_store_n(&f->head, head + p->tot_len, __ATOMIC_RELEASE);
+    tftp_fs_kick(f, false);
+    return p->tot_len;
+}
+
+static int tftp_fs_size(void *handle) {
+    tftp_fs_file *f = handle;
+    if (f->error) return -1;
+    if (f->stage < TFTP_FS_STAGE_IO) return TFTP_IO_PENDING;
+    return (int) f_size(&f->file);
+}
+
+static int tftp_fs_flush(void *handle) {
+    tftp_fs_file *f = handle;
+    f->flushing = 1;
+    if (f->error) return -1;
+    if (!f->synced) {
+        tftp_fs_kick(f, false);
+        return TFTP_IO_PENDING;
     }
-    vPortExitCritical();
-    return sum_bytes;
+    return 0;
 }
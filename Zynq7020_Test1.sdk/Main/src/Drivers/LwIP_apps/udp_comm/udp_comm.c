@@ -4,22 +4,40 @@
 
 #include <string.h>
 #include "udp_comm.h"
-#include "utils/Array.h"
+#include "lwip/sys.h"
+#include "lwip/timeouts.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "xstatus.h"
+#include "xtime_l.h"
 
 #define UDP_COMM_PORT 70
 #define UDP_COMM_RET_HEAD (0xff)
+#define UDP_COMM_COUNTS_PER_US (COUNTS_PER_SECOND / 1000000)
+#define UDP_COMM_DRAIN_MS 10    //!< 有未释放的接管数据时，协议栈线程检查pending_free的间隔
 
-typedef struct {
-    NodeBase parent;
-    uint8_t message_id;
-    struct pbuf *(*fun)(struct pbuf *);
-} MsgProcessor;
+#if LWIP_SUPPORT_CUSTOM_PBUF
+typedef struct udp_comm_custom_pbuf {
+    struct pbuf_custom pc;
+    void *data;
+    void (*free_fn)(void *);
+    struct udp_comm_custom_pbuf *next;
+} udp_comm_custom_pbuf;
+
+/* 网卡驱动可能在中断中释放已发送的pbuf，接管的数据先挂到链表，在协议栈线程中释放 */
+static udp_comm_custom_pbuf *pending_free;
+static uint32_t take_outstanding;   //!< 已接管尚未释放的数据数，只在协议栈线程中访问
+static uint8_t drain_scheduled;
+#endif
 
 static struct udp_pcb *udpPcb;
 static void udp_comm_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
                           const ip_addr_t *addr, u16_t port);
 
-Array processorList;
+/* 按消息ID直接索引，UDP_COMM_RET_HEAD保留，始终为NULL */
+static udp_comm_processor_t processors[256];
+static udp_comm_stats_t processor_stats[256];
+static const ip_addr_t *remote_addr;
+static u16_t remote_port;
 
 void udp_comm_start() {
     udpPcb = udp_new_ip_type(IPADDR_TYPE_ANY);
@@ -27,18 +45,24 @@ void udp_comm_start() {
     udp_recv(udpPcb, udp_comm_recv, NULL);
 }
 
-void udp_comm_RegMegProcessor(uint8_t message_id, struct pbuf *(*fun)(struct pbuf *)) {
-    if (message_id == 0xff) return; //保留id
-    MsgProcessor processor = {
-            .fun = fun,
-            .message_id = message_id,
-            .parent.destructor = NULL,
-    };
-    Array_push(&processorList, &processor, sizeof(MsgProcessor));
+void udp_comm_RegMegProcessor(uint8_t message_id, udp_comm_processor_t fun) {
+    if (message_id == UDP_COMM_RET_HEAD) return; //保留id
+    processors[message_id] = fun;
+}
+
+struct pbuf *udp_comm_alloc_resp(uint8_t id, uint16_t len, void **data) {
+    struct pbuf *ret_buf = pbuf_alloc(PBUF_TRANSPORT, len + UDP_COMM_HEAD_LEN, PBUF_RAM);
+    if (ret_buf == NULL) return NULL;
+    uint8_t *p = ret_buf->payload;
+    p[0] = UDP_COMM_ACK;
+    p[1] = id;
+    if (data) *data = p + UDP_COMM_HEAD_LEN;
+    return ret_buf;
 }
 
 struct pbuf *send_err(uint8_t err_id, uint8_t id) {
-    struct pbuf *ret_buf = pbuf_alloc(PBUF_TRANSPORT, 2, PBUF_RAM);
+    struct pbuf *ret_buf = pbuf_alloc(PBUF_TRANSPORT, UDP_COMM_HEAD_LEN, PBUF_RAM);
+    if (ret_buf == NULL) return NULL;
     uint8_t *data = ret_buf->payload;
     data[0] = err_id;
     data[1] = id;
@@ -46,33 +70,145 @@ struct pbuf *send_err(uint8_t err_id, uint8_t id) {
 }
 
 struct pbuf *send_data(uint8_t id, const void *data, int len) {
-    struct pbuf *ret_buf = pbuf_alloc(PBUF_TRANSPORT, len + 2, PBUF_RAM);
+    void *payload;
+    struct pbuf *ret_buf = udp_comm_alloc_resp(id, len, &payload);
     if (ret_buf == NULL) return send_err(UDP_COMM_ERR, id);
-    uint8_t *p = ret_buf->payload;
-    p[0] = UDP_COMM_ACK;
-    p[1] = id;
-    memcpy(p + 2, data, len);
+    memcpy(payload, data, len);
     return ret_buf;
 }
 
+int udp_comm_resp_append_ref(struct pbuf *resp, const void *data, uint16_t len) {
+    if (resp == NULL) return XST_FAILURE;
+    struct pbuf *ref = pbuf_alloc(PBUF_RAW, len, PBUF_REF);
+    if (ref == NULL) return XST_FAILURE;
+    ref->payload = (void *) data;
+    pbuf_cat(resp, ref);
+    return XST_SUCCESS;
+}
+
+struct pbuf *send_data_ref(uint8_t id, const void *data, uint16_t len) {
+    struct pbuf *ret_buf = udp_comm_alloc_resp(id, 0, NULL);
+    if (udp_comm_resp_append_ref(ret_buf, data, len) != XST_SUCCESS) {
+        if (ret_buf) pbuf_free(ret_buf);
+        return send_err(UDP_COMM_ERR, id);
+    }
+    return ret_buf;
+}
+
+#if LWIP_SUPPORT_CUSTOM_PBUF
+static void udp_comm_custom_free(struct pbuf *p) {
+    udp_comm_custom_pbuf *cp = (udp_comm_custom_pbuf *) p;
+    SYS_ARCH_DECL_PROTECT(lev);
+    SYS_ARCH_PROTECT(lev);
+    cp->next = pending_free;
+    pending_free = cp;
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+static void udp_comm_free_pending() {
+    SYS_ARCH_DECL_PROTECT(lev);
+    SYS_ARCH_PROTECT(lev);
+    udp_comm_custom_pbuf *cp = pending_free;
+    pending_free = NULL;
+    SYS_ARCH_UNPROTECT(lev);
+    while (cp) {
+        udp_comm_custom_pbuf *next = cp->next;
+        cp->free_fn(cp->data);
+        os_free(cp);
+        take_outstanding--;
+        cp = next;
+    }
+}
+
+static void udp_comm_schedule_drain();
+
+static void udp_comm_drain_timeout(void *arg) {
+    drain_scheduled = 0;
+    udp_comm_free_pending();
+    if (take_outstanding) udp_comm_schedule_drain();
+}
+
+/**
+ * 不依赖下一个数据报到达，由协议栈定时器释放，直到接管的数据全部释放
+ */
+static void udp_comm_schedule_drain() {
+    if (drain_scheduled) return;
+    drain_scheduled = 1;
+    sys_timeout(UDP_COMM_DRAIN_MS, udp_comm_drain_timeout, NULL);
+}
+#endif
+
+struct pbuf *send_data_take(uint8_t id, void *data, uint16_t len, void (*free_fn)(void *)) {
+#if LWIP_SUPPORT_CUSTOM_PBUF
+    struct pbuf *ret_buf = udp_comm_alloc_resp(id, 0, NULL);
+    udp_comm_custom_pbuf *cp = os_malloc(sizeof(udp_comm_custom_pbuf));
+    if (ret_buf == NULL || cp == NULL) goto err;
+    cp->pc.custom_free_function = udp_comm_custom_free;
+    cp->data = data;
+    cp->free_fn = free_fn;
+    struct pbuf *q = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &cp->pc, data, len);
+    if (q == NULL) goto err;
+    pbuf_cat(ret_buf, q);
+    take_outstanding++;
+    udp_comm_schedule_drain();
+    return ret_buf;
+
+    err:
+    if (ret_buf) pbuf_free(ret_buf);
+    os_free(cp);
+    free_fn(data);
+    return send_err(UDP_COMM_ERR, id);
+#else
+    struct pbuf *ret_buf = send_data(id, data, len);
+    free_fn(data);
+    return ret_buf;
+#endif
+}
+
+void udp_comm_get_remote(ip_addr_t *addr, u16_t *port) {
+    ip_addr_copy(*addr, *remote_addr);
+    *port = remote_port;
+}
+
+err_t udp_comm_sendto(struct pbuf *p, const ip_addr_t *addr, u16_t port) {
+    return udp_sendto(udpPcb, p, addr, port);
+}
+
+void udp_comm_get_stats(uint8_t message_id, udp_comm_stats_t *stats) {
+    SYS_ARCH_DECL_PROTECT(lev);
+    SYS_ARCH_PROTECT(lev);
+    *stats = processor_stats[message_id];
+    SYS_ARCH_UNPROTECT(lev);
+}
+
 static void udp_comm_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port) {
-    uint8_t message_id = ((uint8_t *) p->payload)[0];
-    for (int i = 0; i < processorList.len; i++) {
-        MsgProcessor *processor = Array_get(&processorList, i);
-        if (processor != NULL && processor->message_id == message_id) {
-            if (processor->fun) {
-                struct pbuf *tx_buf = processor->fun(p);
-                if (tx_buf) {
-                    udp_sendto(pcb, tx_buf, addr, port);
-                    pbuf_free(tx_buf);
-                }
-                goto ret;
-            }
-        }
+    XTime start, end;
+    XTime_GetTime(&start);
+#if LWIP_SUPPORT_CUSTOM_PBUF
+    udp_comm_free_pending();
+#endif
+
+    uint8_t message_id = p->len ? ((uint8_t *) p->payload)[0] : UDP_COMM_RET_HEAD;
+    udp_comm_processor_t fun = processors[message_id];
+    remote_addr = addr;
+    remote_port = port;
+    struct pbuf *tx_buf = fun ? fun(p) : send_err(UDP_COMM_NO_MSG_ID, UDP_COMM_RET_HEAD);
+    if (tx_buf) {
+        udp_sendto(pcb, tx_buf, addr, port);
+        pbuf_free(tx_buf);
     }
-    struct pbuf *ret_ubf = send_err(UDP_COMM_NO_MSG_ID, 0xff);
-    udp_sendto(pcb, ret_ubf, addr, port);
-    pbuf_free(ret_ubf);
-    ret:
     pbuf_free(p);
-}
\ No newline at end of file
+
+    if (fun) {
+        XTime_GetTime(&end);
+        uint32_t us = (end - start) / UDP_COMM_COUNTS_PER_US;
+        udp_comm_stats_t *stats = &processor_stats[message_id];
+        SYS_ARCH_DECL_PROTECT(lev);
+        SYS_ARCH_PROTECT(lev);
+        stats->count++;
+        stats->last_us = us;
+        stats->total_us += us;
+        if (us > stats->max_us) stats->max_us = us;
+        SYS_ARCH_UNPROTECT(lev);
+    }
+}
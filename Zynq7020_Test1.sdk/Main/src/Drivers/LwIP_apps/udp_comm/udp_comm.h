@@ -7,15 +7,99 @@
 
 #include <lwip/udp.h>
 
-enum {
+typedef enum {
     UDP_COMM_ACK = 1,
     UDP_COMM_ERR = 2,
     UDP_COMM_NO_MSG_ID = 3,
 } UDP_COMM_CMD_CODE;
 
+#define UDP_COMM_HEAD_LEN 2     //!< [状态][ID]
+
+/**
+ * 消息处理函数，返回的pbuf由udp_comm发送后释放，返回NULL不回复
+ */
+typedef struct pbuf *(*udp_comm_processor_t)(struct pbuf *);
+
+/**
+ * 每个消息ID的处理耗时统计，从收到数据报到回复发送完成，单位us
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} udp_comm_stats_t;
+
 void udp_comm_start();
-void udp_comm_RegMegProcessor(uint8_t message_id, struct pbuf *(*fun)(struct pbuf *));
+void udp_comm_RegMegProcessor(uint8_t message_id, udp_comm_processor_t fun);
 struct pbuf *send_err(uint8_t err_id, uint8_t id);
+
+/**
+ * 拷贝data构造回复
+ */
 struct pbuf *send_data(uint8_t id, const void *data, int len);
 
+/**
+ * 分配指定长度的回复，头部已填好，处理函数直接向*data写入负载，
+ * 失败返回NULL，适用于长度已知的回复
+ * @param id 消息ID
+ * @param len 负载长度
+ * @param data [out] 负载地址
+ * @return 回复pbuf
+ */
+struct pbuf *udp_comm_alloc_resp(uint8_t id, uint16_t len, void **data);
+
+/**
+ * 零拷贝回复，负载以PBUF_REF引用data，
+ * 网卡发送完成前(可能晚于处理函数返回)data不得释放或修改，适用于静态数据和采集缓冲区
+ * @param id 消息ID
+ * @param data 负载
+ * @param len 负载长度
+ * @return 回复pbuf
+ */
+struct pbuf *send_data_ref(uint8_t id, const void *data, uint16_t len);
+
+/**
+ * 零拷贝回复，由pbuf接管data，协议栈释放pbuf后由协议栈线程的定时器调用free_fn释放data，
+ * 适用于cJSON_Print等已经分配好的结果，只能在消息处理函数中调用
+ * @param id 消息ID
+ * @param data 负载
+ * @param len 负载长度
+ * @param free_fn 释放函数
+ * @return 回复pbuf，失败时返回错误回复，data已被释放
+ */
+struct pbuf *send_data_take(uint8_t id, void *data, uint16_t len, void (*free_fn)(void *));
+
+/**
+ * 向回复追加一段PBUF_REF引用的数据，生命周期要求同send_data_ref
+ * @param resp 回复pbuf
+ * @param data 数据
+ * @param len 长度
+ * @return XST_SUCCESS 或 XST_FAILURE
+ */
+int udp_comm_resp_append_ref(struct pbuf *resp, const void *data, uint16_t len);
+
+/**
+ * 获取当前消息的来源，只能在消息处理函数中调用
+ * @param addr [out] 地址
+ * @param port [out] 端口
+ */
+void udp_comm_get_remote(ip_addr_t *addr, u16_t *port);
+
+/**
+ * 从通信端口主动发送数据报，只能在协议栈线程中调用
+ * @param p 数据
+ * @param addr 地址
+ * @param port 端口
+ * @return lwIP错误码
+ */
+err_t udp_comm_sendto(struct pbuf *p, const ip_addr_t *addr, u16_t port);
+
+/**
+ * 获取消息处理耗时统计
+ * @param message_id 消息ID
+ * @param stats [out] 统计数据
+ */
+void udp_comm_get_stats(uint8_t message_id, udp_comm_stats_t *stats);
+
 #endif //ZYNQ7020_UDP_COMM_H
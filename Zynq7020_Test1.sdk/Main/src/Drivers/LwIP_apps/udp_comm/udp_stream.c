@@ -0,0 +1,250 @@
+//
+// Created by yaoji on 2022/5/11.
+//
+
+#include <string.h>
+#include "udp_stream.h"
+#include "lwip/sys.h"
+#include "lwip/tcpip.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "xstatus.h"
+#include "xtime_l.h"
+
+#if !LWIP_SUPPORT_CUSTOM_PBUF
+#error "udp_stream需要LWIP_SUPPORT_CUSTOM_PBUF"
+#endif
+
+typedef struct {
+    ip_addr_t addr;
+    u16_t port;
+    uint32_t interval_us;       //!< 最小推送间隔，0不限速
+    uint64_t last_us;           //!< 上次推送的帧时间
+    TickType_t expire;
+} udp_stream_sub;
+
+typedef struct {
+    udp_stream_sub subs[UDP_STREAM_SUB_MAX];
+    volatile uint32_t sub_num;
+    volatile uint32_t sink_num;     //!< sink中的订阅数
+    uint32_t seq;
+    /* 正在发送的帧，只在busy归零后被下一帧覆盖 */
+    const uint8_t *data;
+    uint32_t len;
+    uint8_t format;
+    uint32_t sample_rate;
+    uint64_t timestamp_us;
+    volatile uint32_t *busy;
+    udp_stream_stats_t stats;
+} udp_stream_t;
+
+/**
+ * 分片负载的引用，网卡发送完成释放pbuf时减少帧的引用计数，可能在中断中调用
+ */
+typedef struct udp_stream_ref {
+    struct pbuf_custom pc;
+    volatile uint32_t *busy;
+    struct udp_stream_ref *next;
+} udp_stream_ref;
+
+static udp_stream_t streams[UDP_STREAM_NUM];
+static const uint32_t frame_max[UDP_STREAM_NUM] = {
+        [UDP_STREAM_ADC] = UDP_STREAM_ADC_FRAME_MAX,
+        [UDP_STREAM_FFT] = UDP_STREAM_FFT_FRAME_MAX,
+};
+static udp_stream_ref ref_pool[UDP_STREAM_PBUF_NUM];
+static udp_stream_ref *ref_free_list;
+static udp_stream_sink_t stream_sink;
+
+static inline void udp_stream_release(volatile uint32_t *busy) {
+    __atomic_sub_fetch(busy, 1, __ATOMIC_RELEASE);
+}
+
+static void udp_stream_ref_free(struct pbuf *p) {
+    udp_stream_ref *ref = (udp_stream_ref *) p;
+    udp_stream_release(ref->busy);
+    SYS_ARCH_DECL_PROTECT(lev);
+    SYS_ARCH_PROTECT(lev);
+    ref->next = ref_free_list;
+    ref_free_list = ref;
+    SYS_ARCH_UNPROTECT(lev);
+}
+
+static udp_stream_ref *udp_stream_ref_alloc() {
+    SYS_ARCH_DECL_PROTECT(lev);
+    SYS_ARCH_PROTECT(lev);
+    udp_stream_ref *ref = ref_free_list;
+    if (ref) ref_free_list = ref->next;
+    SYS_ARCH_UNPROTECT(lev);
+    return ref;
+}
+
+static void udp_stream_send_frame(udp_stream_t *s, uint8_t msg_id, const udp_stream_sub *sub) {
+    udp_stream_header_t header = {
+            .seq = s->seq,
+            .timestamp_us = s->timestamp_us,
+            .frame_len = s->len,
+            .frag_count = (s->len + UDP_STREAM_FRAG_PAYLOAD - 1) / UDP_STREAM_FRAG_PAYLOAD,
+            .sample_rate = s->sample_rate,
+            .format = s->format,
+    };
+    for (uint32_t offset = 0; offset < s->len; offset += UDP_STREAM_FRAG_PAYLOAD) {
+        uint16_t len = LWIP_MIN(s->len - offset, UDP_STREAM_FRAG_PAYLOAD);
+        void *payload;
+        /* 分配失败时放弃该帧剩余分片，上位机按frag_count丢弃不完整的帧 */
+        struct pbuf *head = udp_comm_alloc_resp(msg_id, sizeof(header), &payload);
+        udp_stream_ref *ref = head ? udp_stream_ref_alloc() : NULL;
+        if (ref == NULL) {
+            if (head) pbuf_free(head);
+            s->stats.frag_drops += header.frag_count - header.frag_index;
+            return;
+        }
+        header.offset = offset;
+        memcpy(payload, &header, sizeof(header));
+        header.frag_index++;
+
+        ref->pc.custom_free_function = udp_stream_ref_free;
+        ref->busy = s->busy;
+        __atomic_add_fetch(s->busy, 1, __ATOMIC_RELAXED);
+        struct pbuf *q = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &ref->pc,
+                                             (void *) (s->data + offset), len);
+        pbuf_cat(head, q);
+        udp_comm_sendto(head, &sub->addr, sub->port);
+        pbuf_free(head);
+    }
+}
+
+/**
+ * 在协议栈线程中把帧发给各订阅者
+ */
+static void udp_stream_send(void *ctx) {
+    udp_stream_t *s = ctx;
+    uint8_t msg_id = UDP_STREAM_MSG_BASE + (s - streams);
+    TickType_t tick = xTaskGetTickCount();
+    for (uint32_t i = 0; i < s->sub_num;) {
+        udp_stream_sub *sub = &s->subs[i];
+        if ((int32_t) (tick - sub->expire) >= 0) {
+            s->subs[i] = s->subs[--s->sub_num];
+            continue;
+        }
+        if (s->timestamp_us - sub->last_us >= sub->interval_us) {
+            sub->last_us = s->timestamp_us;
+            udp_stream_send_frame(s, msg_id, sub);
+        }
+        i++;
+    }
+    if (stream_sink && s->sink_num) {
+        udp_stream_frame_t frame = {
+                .seq = s->seq,
+                .timestamp_us = s->timestamp_us,
+                .data = s->data,
+                .len = s->len,
+                .sample_rate = s->sample_rate,
+                .format = s->format,
+        };
+        stream_sink(s - streams, &frame);
+    }
+    /* 释放推送时持有的引用 */
+    udp_stream_release(s->busy);
+}
+
+int udp_stream_publish(udp_stream_id stream, const void *data, uint32_t len,
+                       udp_stream_format format, uint32_t sample_rate, volatile uint32_t *busy) {
+    udp_stream_t *s = &streams[stream];
+    if (len > frame_max[stream]) return XST_FAILURE;
+    if (s->sub_num == 0 && s->sink_num == 0) return XST_FAILURE;
+    if (s->busy && __atomic_load_n(s->busy, __ATOMIC_ACQUIRE)) {
+        s->stats.busy_drops++;
+        return XST_FAILURE;
+    }
+
+    XTime now;
+    XTime_GetTime(&now);
+    s->data = data;
+    s->len = len;
+    s->format = format;
+    s->sample_rate = sample_rate;
+    s->timestamp_us = now / (COUNTS_PER_SECOND / 1000000);
+    s->seq++;
+    s->busy = busy;
+    __atomic_store_n(busy, 1, __ATOMIC_RELAXED);
+    if (tcpip_callback_with_block(udp_stream_send, s, 0) != ERR_OK) {
+        __atomic_store_n(busy, 0, __ATOMIC_RELEASE);
+        s->stats.busy_drops++;
+        return XST_FAILURE;
+    }
+    s->stats.frames++;
+    return XST_SUCCESS;
+}
+
+static struct pbuf *udp_stream_subscribe(struct pbuf *p) {
+    uint8_t *data = p->payload;
+    if (p->len < 3 || data[1] >= UDP_STREAM_NUM) return send_err(UDP_COMM_ERR, UDP_STREAM_MSG_SUBSCRIBE);
+
+    ip_addr_t addr;
+    u16_t port;
+    udp_comm_get_remote(&addr, &port);
+    udp_stream_t *s = &streams[data[1]];
+    udp_stream_sub *sub = NULL;
+    for (uint32_t i = 0; i < s->sub_num; i++) {
+        if (ip_addr_cmp(&s->subs[i].addr, &addr) && s->subs[i].port == port) {
+            sub = &s->subs[i];
+            break;
+        }
+    }
+    if (sub == NULL) {
+        if (s->sub_num >= UDP_STREAM_SUB_MAX) return send_err(UDP_COMM_ERR, UDP_STREAM_MSG_SUBSCRIBE);
+        sub = &s->subs[s->sub_num];
+        ip_addr_copy(sub->addr, addr);
+        sub->port = port;
+        sub->last_us = 0;
+        s->sub_num++;
+    }
+    sub->interval_us = data[2] ? 1000000 / data[2] : 0;
+    sub->expire = xTaskGetTickCount() + pdMS_TO_TICKS(UDP_STREAM_TTL_MS);
+    return send_data(UDP_STREAM_MSG_SUBSCRIBE, &data[1], 1);
+}
+
+static struct pbuf *udp_stream_unsubscribe(struct pbuf *p) {
+    uint8_t *data = p->payload;
+    if (p->len < 2 || data[1] >= UDP_STREAM_NUM) return send_err(UDP_COMM_ERR, UDP_STREAM_MSG_UNSUBSCRIBE);
+
+    ip_addr_t addr;
+    u16_t port;
+    udp_comm_get_remote(&addr, &port);
+    udp_stream_t *s = &streams[data[1]];
+    for (uint32_t i = 0; i < s->sub_num; i++) {
+        if (ip_addr_cmp(&s->subs[i].addr, &addr) && s->subs[i].port == port) {
+            s->subs[i] = s->subs[--s->sub_num];
+            break;
+        }
+    }
+    return send_data(UDP_STREAM_MSG_UNSUBSCRIBE, &data[1], 1);
+}
+
+void udp_stream_init() {
+    for (int i = 0; i < UDP_STREAM_PBUF_NUM; i++) {
+        ref_pool[i].next = ref_free_list;
+        ref_free_list = &ref_pool[i];
+    }
+    udp_comm_RegMegProcessor(UDP_STREAM_MSG_SUBSCRIBE, udp_stream_subscribe);
+    udp_comm_RegMegProcessor(UDP_STREAM_MSG_UNSUBSCRIBE, udp_stream_unsubscribe);
+}
+
+void udp_stream_set_sink(udp_stream_sink_t sink) {
+    stream_sink = sink;
+}
+
+void udp_stream_sink_subscribe(udp_stream_id stream, int subscribe) {
+    if (stream >= UDP_STREAM_NUM) return;
+    if (subscribe) streams[stream].sink_num++;
+    else if (streams[stream].sink_num) streams[stream].sink_num--;
+}
+
+void udp_stream_get_stats(udp_stream_id stream, udp_stream_stats_t *stats) {
+    if (stream >= UDP_STREAM_NUM) {
+        memset(stats, 0, sizeof(udp_stream_stats_t));
+        return;
+    }
+    *stats = streams[stream].stats;
+}
@@ -0,0 +1,118 @@
+//
+// Created by yaoji on 2022/5/11.
+//
+
+#ifndef ZYNQ7020_UDP_STREAM_H
+#define ZYNQ7020_UDP_STREAM_H
+
+#include <stdint.h>
+#include "udp_comm.h"
+
+/**
+ * 波形推送
+ * 上位机发送订阅消息后，每采集一帧就推送给订阅者，超过UDP_STREAM_FRAG_PAYLOAD的帧分片发送。
+ * 订阅 [4][stream][max_fps]，取消订阅 [5][stream]，回复 [ACK][ID][stream]。
+ * 订阅在UDP_STREAM_TTL_MS内不续订自动失效。
+ * 推送 [ACK][UDP_STREAM_MSG_BASE + stream][udp_stream_header_t][数据]，小端。
+ * 负载以PBUF_REF直接引用生产者的缓冲区，每个流同一时刻只有一帧在发送，
+ * 上一帧未发送完成时新帧不推送，推送和丢弃的帧数、分片数由udp_stream_get_stats给出
+ */
+
+#define UDP_STREAM_MSG_SUBSCRIBE 4
+#define UDP_STREAM_MSG_UNSUBSCRIBE 5
+#define UDP_STREAM_MSG_BASE 0x10
+#define UDP_STREAM_SUB_MAX 4                //!< 每个流的最大订阅者数
+#define UDP_STREAM_TTL_MS 10000
+#define UDP_STREAM_FRAG_PAYLOAD 1408        //!< 每个分片的负载长度，分片总长不超过以太网MTU
+#define UDP_STREAM_ADC_FRAME_MAX (4096 * 2)     //!< 示波器一帧的最大长度，更长的帧不推送
+#define UDP_STREAM_FFT_FRAME_MAX (8192 * 4)     //!< 频谱一帧的最大长度
+#define UDP_STREAM_FRAG_NUM(len) (((len) + UDP_STREAM_FRAG_PAYLOAD - 1) / UDP_STREAM_FRAG_PAYLOAD)
+/* 所有流共用的分片引用数量，按每个流的最大帧同时发给全部订阅者计算，正常情况下不会不足 */
+#define UDP_STREAM_PBUF_NUM ((UDP_STREAM_FRAG_NUM(UDP_STREAM_ADC_FRAME_MAX) + \
+                              UDP_STREAM_FRAG_NUM(UDP_STREAM_FFT_FRAME_MAX)) * UDP_STREAM_SUB_MAX)
+
+typedef enum {
+    UDP_STREAM_ADC,         //!< 示波器采集，int16 mV
+    UDP_STREAM_FFT,         //!< 频谱，float dB
+    UDP_STREAM_NUM,
+} udp_stream_id;
+
+typedef enum {
+    UDP_STREAM_FORMAT_INT16,
+    UDP_STREAM_FORMAT_FLOAT,
+} udp_stream_format;
+
+typedef struct __attribute__((packed)) {
+    uint32_t seq;           //!< 帧序号
+    uint64_t timestamp_us;  //!< 采集完成时间
+    uint32_t frame_len;     //!< 整帧长度
+    uint32_t offset;        //!< 本分片在帧内的偏移
+    uint16_t frag_index;
+    uint16_t frag_count;
+    uint32_t sample_rate;   //!< 采样率，频谱为0
+    uint8_t format;         //!< udp_stream_format
+    uint8_t reserved[3];
+} udp_stream_header_t;
+
+typedef struct {
+    uint32_t frames;            //!< 推送的帧数
+    uint32_t busy_drops;        //!< 上一帧未发送完成或协议栈队列已满而未推送的帧数
+    uint32_t frag_drops;        //!< pbuf或分片引用不足而未发送的分片数(按订阅者计)
+} udp_stream_stats_t;
+
+/**
+ * 交给其它推送方式(WebSocket等)的一帧
+ */
+typedef struct {
+    uint32_t seq;
+    uint64_t timestamp_us;
+    const void *data;
+    uint32_t len;
+    uint32_t sample_rate;
+    uint8_t format;         //!< udp_stream_format
+} udp_stream_frame_t;
+
+/**
+ * 帧的其它接收者，在协议栈线程中调用，返回后data可能被生产者覆盖，需要的数据必须在返回前拷贝
+ */
+typedef void (*udp_stream_sink_t)(udp_stream_id stream, const udp_stream_frame_t *frame);
+
+/**
+ * 注册订阅消息，在udp_comm_controller_init中调用
+ */
+void udp_stream_init();
+
+/**
+ * 设置帧的其它接收者，只支持一个
+ * @param sink 接收函数
+ */
+void udp_stream_set_sink(udp_stream_sink_t sink);
+
+/**
+ * 接收者的订阅数变化时调用，流没有任何订阅时不推送
+ * @param stream 流
+ * @param subscribe 1订阅 0取消
+ */
+void udp_stream_sink_subscribe(udp_stream_id stream, int subscribe);
+
+/**
+ * 推送一帧，生产者在*busy归零前不得修改data
+ * @param stream 流
+ * @param data 数据
+ * @param len 长度
+ * @param format 数据格式
+ * @param sample_rate 采样率
+ * @param busy 发送引用计数，推送成功后不为0，发送完成后归零
+ * @return XST_SUCCESS，或XST_FAILURE(无订阅者/上一帧未发送完成/超过流的最大帧长)
+ */
+int udp_stream_publish(udp_stream_id stream, const void *data, uint32_t len,
+                       udp_stream_format format, uint32_t sample_rate, volatile uint32_t *busy);
+
+/**
+ * 获取流的推送统计
+ * @param stream 流
+ * @param stats [out] 统计数据
+ */
+void udp_stream_get_stats(udp_stream_id stream, udp_stream_stats_t *stats);
+
+#endif //ZYNQ7020_UDP_STREAM_H
@@ -10,6 +10,7 @@
 #include "xparameters.h"
 #include "LwIP_apps/sntp/sntp_user.h"
 #include "LwIP_apps/tftp/tftp_user.h"
+#include "LwIP_apps/httpd/httpd.h"
 #include "xil_printf.h"
 #include "netif/xemacpsif.h"
 #include "LwIP_apps/udp_comm/udp_comm.h"
@@ -23,6 +24,13 @@ err_t dhcp_start(struct netif *netif);
 
 #define THREAD_STACKSIZE 2048
 
+/*
+ * 协议栈参数在Main_bsp/system.mss的lwip202中配置：IP/TCP/UDP校验和由GEM计算和检查，
+ * 接收描述符和tcpip_mbox按TFTP窗口和实时流的突发配置，TCP只有httpd使用，tcp_pcb按连接数配置。
+ * 没有启用校验和卸载时仍能工作，只在初始化时提示一次
+ */
+#define CHECKSUM_OFFLOAD (!CHECKSUM_GEN_UDP && !CHECKSUM_CHECK_UDP)
+
 struct netif server_netif;
 
 static int complete_nw_thread;
@@ -111,6 +119,7 @@ static void network_init_thread(void *p) {
 #endif
     /* initialize lwIP before calling sys_thread_new */
     lwip_init();
+    if (!CHECKSUM_OFFLOAD) xil_printf("warning: checksum offload disabled, CPU computes UDP checksums\r\n");
 
     /* any thread using lwIP should be created using sys_thread_new */
     sys_thread_new("nw_thread", network_thread, NULL, THREAD_STACKSIZE, DEFAULT_THREAD_PRIO);
@@ -142,6 +151,7 @@ static void network_init_thread(void *p) {
 #endif /* LWIP_IPV6 */
     sntp_start();
     tftp_start();
+    httpd_start();
     udp_comm_start();
     vTaskDelete(NULL);
     return;
@@ -3,15 +3,81 @@
 //
 
 #include <string.h>
+#include <strings.h>
 #include <stdlib.h>
 #include "FileDecoder.h"
 #include "math.h"
 #include "Fatfs_init/Fatfs_Driver.h"
+#include "Fatfs_init/Encoding.h"
+#include "FileService/FileService.h"
 #include "cJSON.h"
 #include "FreeRTOS_Mem/FreeRTOS_Mem.h"
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #define GOTO_RET(STATUS) { status = (STATUS); goto ret; }
 
+#define WAV_FORMAT_PCM          (0x0001)
+#define WAV_FORMAT_IEEE_FLOAT   (0x0003)
+#define WAV_FORMAT_EXTENSIBLE   (0xFFFE)
+#define WAV_READ_BLOCK_SIZE     (4096)
+
+typedef struct {
+    char id[4];
+    uint32_t size;
+}__attribute__((packed)) wav_chunk_t;
+
+typedef struct {
+    uint16_t audio_format;
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint32_t byte_rate;
+    uint16_t block_align;
+    uint16_t bits_per_sample;
+    uint16_t ext_size;
+    uint16_t valid_bits;
+    uint32_t channel_mask;
+    uint16_t sub_format;            //!< EXTENSIBLE格式GUID的前两个字节即实际格式
+    uint8_t sub_format_guid[14];
+}__attribute__((packed)) wav_fmt_t;
+
+#define FD_TEXT_BLOCK_SIZE  (512)
+#define FD_TOKEN_LEN_MAX    (40)
+#define FD_COE_LEN_MAX      (FD_FILE_SIZE_MAX / sizeof(int32_t))
+
+/**
+ * 解码器的数据源，file为NULL时从内存缓冲区读取
+ */
+typedef struct {
+    FIL *file;
+    const uint8_t *mem;
+    FSIZE_t size;
+    FSIZE_t pos;
+} FDReader;
+
+typedef enum {
+    FDToken_eof,
+    FDToken_word,
+    FDToken_equ,
+    FDToken_comma,
+    FDToken_semi,
+    FDToken_at,
+    FDToken_error,
+} FDToken;
+
+typedef struct {
+    FDReader *reader;
+    UINT pos;
+    UINT len;
+    int back;                               //!< 回退的字符，-1为空
+    FDStatus status;
+    int token_len;
+    char token[FD_TOKEN_LEN_MAX + 1];
+    char buf[FD_TEXT_BLOCK_SIZE];
+} FDTokenizer;
+
 const char *FileDecoder_status_string(FDStatus status) {
     static const char *str[] = {
             "ok",
@@ -27,6 +93,8 @@ const char *FileDecoder_status_string(FDStatus status) {
             "coe format error",
             "coe width error",
             "array file",
+            "wav format error",
+            "wav channel error",
     };
     return status < FDStatus_end ? str[status] : NULL;
 }
@@ -37,6 +105,8 @@ const char *FileDecoder_type_string(FDType type) {
             "bin",
             "json",
             "coe",
+            "wav",
+            "mem",
             "unknown",
     };
     return type < FDType_end ? str[type] : NULL;
@@ -65,32 +135,6 @@ static double FileDecoder_parse_number(const char *str, int len) {
 }
 
 
-static uint64_t FileDecoder_parse_number_16(const char *str, int len) {
-    uint64_t number = 0;
-    for (int i = 0; i < len; i++) {
-        if (str[i] == ' ') continue;
-        if (str[i] >= '0' && str[i] <= '9') {
-            number = (number << 4) | ((str[i] - '0') & 0x0f);
-        } else if (str[i] >= 'A' && str[i] <= 'F') {
-            number = (number << 4) | ((str[i] - 'A' + 0x0a) & 0x0f);
-        } else if (str[i] >= 'a' && str[i] <= 'f') {
-            number = (number << 4) | ((str[i] - 'a' + 0x0a) & 0x0f);
-        } else return 0;
-    }
-    return number;
-}
-
-static uint64_t FileDecoder_parse_number_2(const char *str, int len) {
-    uint64_t number = 0;
-    for (int i = 0; i < len; i++) {
-        if (str[i] == ' ') continue;
-        if (str[i] == '0' || str[i] == '1')
-            number = (number << 1) | (str[i] - '0');
-        else return 0;
-    }
-    return number;
-}
-
 FDType FileDecoder_get_file_type(const char *filename) {
     if (filename == NULL) return FDType_unknown;
     size_t len = strlen(filename);
@@ -120,98 +164,156 @@ FDType FileDecoder_get_file_type(const char *filename) {
         return FDType_json;
     if (strcmp(suffix, "coe") == 0)
         return FDType_coe;
+    if (strcmp(suffix, "wav") == 0)
+        return FDType_wav;
+    if (strcmp(suffix, "mem") == 0)
+        return FDType_mem;
     return FDType_unknown;
 }
 
 
-static FDStatus FileDecoder_decode_bin(const char *filename, int8_t **p, size_t *len) {
-    if (p == NULL || filename == NULL || len == NULL)
-        return FDStatus_null;
+static FDStatus FDReader_open(FDReader *r, FIL *file, const char *filename) {
+    if (FileService_open(file, filename, FA_READ) != FR_OK) return FDStatus_invalid_path;
+    r->file = file;
+    r->mem = NULL;
+    r->size = f_size(file);
+    r->pos = 0;
+    return FDStatus_ok;
+}
 
-    int8_t *buf = NULL;
+static void FDReader_init_mem(FDReader *r, const void *buf, size_t size) {
+    r->file = NULL;
+    r->mem = buf;
+    r->size = size;
+    r->pos = 0;
+}
 
-    FIL file;
-    if (f_open(&file, filename, FA_READ) != FR_OK) return FDStatus_invalid_path;
+static void FDReader_close(FDReader *r) {
+    if (r->file) FileService_close(r->file);
+}
+
+static FRESULT FDReader_read(FDReader *r, void *buf, UINT len, UINT *br) {
+    if (r->file) return FileService_read(r->file, buf, len, br);
+    FSIZE_t remain = r->size - r->pos;
+    *br = len < remain ? len : (UINT) remain;
+    memcpy(buf, r->mem + r->pos, *br);
+    r->pos += *br;
+    return FR_OK;
+}
 
-    if (f_size(&file) > FD_FILE_SIZE_MAX) {
-        f_close(&file);
+static FRESULT FDReader_seek(FDReader *r, FSIZE_t pos) {
+    if (r->file) return FileService_lseek(r->file, pos);
+    r->pos = pos < r->size ? pos : r->size;
+    return FR_OK;
+}
+
+static FSIZE_t FDReader_tell(FDReader *r) {
+    return r->file ? f_tell(r->file) : r->pos;
+}
+
+static FSIZE_t FDReader_size(FDReader *r) {
+    return r->size;
+}
+
+static int FDReader_eof(FDReader *r) {
+    return FDReader_tell(r) >= r->size;
+}
+
+static FDStatus FileDecoder_decode_bin(FDReader *r, int8_t **p, size_t *len) {
+    if (p == NULL || r == NULL || len == NULL)
+        return FDStatus_null;
+
+    if (FDReader_size(r) > FD_FILE_SIZE_MAX)
         return FDStatus_file_too_lager_error;
-    }
+    if (FDReader_size(r) == 0)
+        return FDStatus_invalid_file;
 
-    long size = f_size(&file);
-    buf = os_malloc(size);
+    UINT size = FDReader_size(r);
+    int8_t *buf = os_malloc_tag(size, OS_MEM_TAG_FILE_DECODER);
     if (buf == NULL) return FDStatus_out_of_memory;
 
     UINT read_size;
-    if (f_read(&file, buf, size, &read_size) == FR_OK && size == read_size) {
-        f_close(&file);
+    if (FDReader_read(r, buf, size, &read_size) == FR_OK && size == read_size) {
         *len = size;
         *p = buf;
         return FDStatus_ok;
     } else {
         os_free(buf);
-        f_close(&file);
         return FDStatus_file_read_error;
     }
 }
 
-static FDStatus FileDecoder_decode_csv(const char *filename, int8_t **p, size_t *len) {
+static FDStatus FileDecoder_decode_csv(FDReader *r, int8_t **p, size_t *len) {
     FDStatus status = FDStatus_ok;
-    FIL file;
     size_t buf_len = 128, buf_used_len = 0;
 
-    if (f_open(&file, filename, FA_READ) != FR_OK) return FDStatus_invalid_path;
-
-    int8_t *buf = os_malloc(128);
+    int8_t *buf = os_malloc_tag(128, OS_MEM_TAG_FILE_DECODER);
     if (buf == NULL) GOTO_RET(FDStatus_out_of_memory)
 
     char text_buf[128];
     UINT read_len;
-    if (f_read(&file, text_buf, 128, &read_len) != FR_OK) GOTO_RET(FDStatus_file_read_error)
+    if (FDReader_read(r, text_buf, 128, &read_len) != FR_OK) GOTO_RET(FDStatus_file_read_error)
     while (read_len > 0) {
         int start = 0;
         int i;
         for (i = 0; i < read_len; i++) {
-            if (text_buf[i] == ',' || text_buf[i] == '\n' || (read_len < 128 && i == read_len - 1)) {
+            int delimiter = text_buf[i] == ',' || text_buf[i] == '\n';
+            if (delimiter || (read_len < 128 && i == read_len - 1)) {
                 if (buf_used_len == buf_len) {
-                    buf = realloc(buf, buf_len + 128);
-                    if (buf == NULL) GOTO_RET(FDStatus_out_of_memory)
-                    buf_len += 128;
+                    int8_t *new_buf = os_realloc(buf, buf_len * 2);
+                    if (new_buf == NULL) GOTO_RET(FDStatus_out_of_memory)
+                    buf = new_buf;
+                    buf_len *= 2;
                 }
-                buf[buf_used_len++] = (int8_t) FileDecoder_parse_number(text_buf + start, i - start);
+                // 文件末尾没有分隔符时最后一个字符也属于数字
+                int end = delimiter ? i : i + 1;
+                buf[buf_used_len++] = (int8_t) FileDecoder_parse_number(text_buf + start, end - start);
                 start = i + 1;
             }
         }
         if (read_len < 128) break;
+        // 整块数据中没有分隔符，不是有效的csv文件
+        if (start == 0) GOTO_RET(FDStatus_invalid_file)
         if (start < 128)
-            f_lseek(&file, f_tell(&file) + start - 128);
-        if (f_read(&file, text_buf, 128, &read_len) != FR_OK) GOTO_RET(FDStatus_file_read_error)
+            FDReader_seek(r, FDReader_tell(r) + start - 128);
+        if (FDReader_read(r, text_buf, 128, &read_len) != FR_OK) GOTO_RET(FDStatus_file_read_error)
     }
-    buf = realloc(buf, buf_used_len);
-    *p = buf;
+    if (buf_used_len == 0) GOTO_RET(FDStatus_invalid_file)
+    int8_t *shrink = os_realloc(buf, buf_used_len);
+    *p = shrink ? shrink : buf;
     *len = buf_used_len;
-    f_close(&file);
     return status;
 
     ret:
     os_free(buf);
-    f_close(&file);
     return status;
 }
 
-static FDStatus FileDecoder_decode_json(const char *filename, int8_t **p, size_t *len, const char *field) {
-    FDStatus status;
-    int8_t *buf = NULL;
+/**
+ * 解析json，内存数据源直接解析，文件数据源先读入内存
+ */
+static FDStatus FileDecoder_load_json(FDReader *r, cJSON **json) {
+    if (FDReader_size(r) == 0) return FDStatus_json_parse_error;
+    if (r->file == NULL) {
+        *json = cJSON_ParseWithLength((const char *) r->mem, r->size);
+        return *json ? FDStatus_ok : FDStatus_json_parse_error;
+    }
+
     size_t file_size;
     char *file;
-    status = FileDecoder_decode_bin(filename, (int8_t **) &file, &file_size);
+    FDStatus status = FileDecoder_decode_bin(r, (int8_t **) &file, &file_size);
     if (status != FDStatus_ok) return status;
+    *json = cJSON_ParseWithLength(file, file_size);
+    os_free(file);
+    return *json ? FDStatus_ok : FDStatus_json_parse_error;
+}
 
-    cJSON *json = cJSON_ParseWithLength(file, file_size);
-    if (json == NULL) {
-        os_free(file);
-        return FDStatus_json_parse_error;
-    }
+static FDStatus FileDecoder_decode_json(FDReader *r, int8_t **p, size_t *len, const char *field) {
+    FDStatus status;
+    int8_t *buf = NULL;
+    cJSON *json;
+    status = FileDecoder_load_json(r, &json);
+    if (status != FDStatus_ok) return status;
 
     cJSON *array = NULL;
     if (cJSON_IsArray(json)) array = json;
@@ -225,103 +327,618 @@ static FDStatus FileDecoder_decode_json(const char *filename, int8_t **p, size_t
     int size = cJSON_GetArraySize(array);
     if (size == 0) GOTO_RET(FDStatus_json_format_error)
 
-    buf = os_malloc(size);
+    buf = os_malloc_tag(size, OS_MEM_TAG_FILE_DECODER);
     if (buf == NULL) GOTO_RET(FDStatus_out_of_memory)
 
-    for (int i = 0; i < size; i++) {
-        cJSON *item = cJSON_GetArrayItem(array, i);
-        if (cJSON_IsNumber(item))
-            buf[i] = (int8_t) cJSON_GetNumberValue(item);
-        else GOTO_RET(FDStatus_out_of_memory)
+    int i = 0;
+    cJSON *item;
+    cJSON_ArrayForEach(item, array) {
+        if (!cJSON_IsNumber(item)) {
+            os_free(buf);
+            GOTO_RET(FDStatus_json_format_error)
+        }
+        buf[i++] = (int8_t) cJSON_GetNumberValue(item);
     }
     *len = size;
     *p = buf;
 
     ret:
-    cJSON_free(json);
-    os_free(file);
+    cJSON_Delete(json);
     return status;
 }
 
-static FDStatus FileDecoder_decode_coe(const char *filename, int16_t **p, size_t *len) {
-    FIL file;
-    if (f_open(&file, filename, FA_READ) != FR_OK) return FDStatus_invalid_path;
+static void FileDecoder_tokenizer_init(FDTokenizer *t, FDReader *reader) {
+    t->reader = reader;
+    t->pos = 0;
+    t->len = 0;
+    t->back = -1;
+    t->status = FDStatus_ok;
+    t->token_len = 0;
+}
+
+static int FileDecoder_tokenizer_getc(FDTokenizer *t) {
+    if (t->back >= 0) {
+        int c = t->back;
+        t->back = -1;
+        return c;
+    }
+    if (t->pos == t->len) {
+        if (FDReader_read(t->reader, t->buf, sizeof(t->buf), &t->len) != FR_OK) {
+            t->status = FDStatus_file_read_error;
+            t->len = 0;
+        }
+        t->pos = 0;
+        if (t->len == 0) return -1;
+    }
+    return (unsigned char) t->buf[t->pos++];
+}
+
+static void FileDecoder_tokenizer_skip_line(FDTokenizer *t) {
+    int c;
+    do {
+        c = FileDecoder_tokenizer_getc(t);
+    } while (c != '\n' && c != -1);
+}
+
+/**
+ * 读取下一个记号，跳过空白和 // # 注释
+ * @param t
+ * @return 记号类型，FDToken_word的内容保存在t->token中
+ */
+static FDToken FileDecoder_tokenizer_next(FDTokenizer *t) {
+    int c;
+    while (1) {
+        c = FileDecoder_tokenizer_getc(t);
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+        if (c == '#') {
+            FileDecoder_tokenizer_skip_line(t);
+            continue;
+        }
+        if (c == '/') {
+            int next = FileDecoder_tokenizer_getc(t);
+            if (next == '/') {
+                FileDecoder_tokenizer_skip_line(t);
+                continue;
+            }
+            t->back = next;
+        }
+        break;
+    }
+    if (t->status != FDStatus_ok) return FDToken_error;
+
+    switch (c) {
+        case -1:
+            return FDToken_eof;
+        case '=':
+            return FDToken_equ;
+        case ',':
+            return FDToken_comma;
+        case ';':
+            return FDToken_semi;
+        case '@':
+            return FDToken_at;
+        default:
+            break;
+    }
+
+    t->token_len = 0;
+    while (c != -1 && c != ' ' && c != '\t' && c != '\r' && c != '\n' &&
+           c != '=' && c != ',' && c != ';' && c != '@' && c != '#') {
+        if (t->token_len == FD_TOKEN_LEN_MAX) {
+            t->status = FDStatus_coe_format_error;
+            return FDToken_error;
+        }
+        t->token[t->token_len++] = (char) c;
+        c = FileDecoder_tokenizer_getc(t);
+    }
+    t->token[t->token_len] = '\0';
+    if (c != -1) t->back = c;
+    return FDToken_word;
+}
+
+static int FileDecoder_token_is(const FDTokenizer *t, const char *key) {
+    return strcasecmp(t->token, key) == 0;
+}
+
+static int FileDecoder_digit_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return 99;
+}
+
+/**
+ * 按数的位数推断位宽，用于没有coefficient_width字段的文件，10进制数返回0，需要按数值推断
+ */
+static int FileDecoder_coe_digits_width(int len, int radix) {
+    int width = radix == 2 ? len : radix == 8 ? len * 3 : radix == 16 ? len * 4 : 0;
+    return width > 32 ? 32 : width;
+}
+
+/**
+ * 按数值推断补码所需的位宽，以8位为单位
+ */
+static int FileDecoder_coe_value_width(int32_t value) {
+    int width = 8;
+    while (width < 32 && (value < -((int32_t) 1 << (width - 1)) || value >= ((int32_t) 1 << (width - 1))))
+        width += 8;
+    return width;
+}
+
+static void FileDecoder_coe_sign_extend(int32_t *data, size_t len, int width) {
+    if (width >= 32) return;
+    uint32_t mask = ((uint32_t) 1 << width) - 1;
+    uint32_t sign = (uint32_t) 1 << (width - 1);
+    for (size_t i = 0; i < len; i++)
+        data[i] = (int32_t) ((((uint32_t) data[i] & mask) ^ sign) - sign);
+}
+
+/**
+ * 解析一个系数并按位宽符号扩展
+ * @param str 数字字符串
+ * @param len 字符串长度
+ * @param radix 基数，2/8/10/16
+ * @param width 位宽，1-32
+ * @param out [out] 结果
+ * @return
+ */
+static FDStatus FileDecoder_coe_parse_value(const char *str, int len, int radix, int width, int32_t *out) {
+    int i = 0, neg = 0;
+    if (radix == 10 && (str[0] == '-' || str[0] == '+')) {
+        neg = str[0] == '-';
+        i++;
+    }
+    if (i == len) return FDStatus_coe_format_error;
+
+    uint64_t value = 0;
+    for (; i < len; i++) {
+        int digit = FileDecoder_digit_value(str[i]);
+        if (digit >= radix) return FDStatus_coe_format_error;
+        value = value * radix + digit;
+        if (value >> 32) return FDStatus_coe_format_error;
+    }
+
+    uint64_t range = (uint64_t) 1 << width;
+    if (neg) {
+        if (value > range / 2) return FDStatus_coe_format_error;
+        *out = (int32_t) -(int64_t) value;
+        return FDStatus_ok;
+    }
+    // 10进制是有符号数，正数不能超过位宽的最大值，其他进制按补码写法允许到2^width-1
+    if (value >= (radix == 10 ? range / 2 : range)) return FDStatus_coe_format_error;
+    // 补码表示，最高位为符号位
+    uint32_t sign = (uint32_t) 1 << (width - 1);
+    *out = (int32_t) (((uint32_t) value ^ sign) - sign);
+    return FDStatus_ok;
+}
+
+static FDStatus FileDecoder_coe_reserve(int32_t **data, size_t *capacity, size_t need) {
+    if (need <= *capacity) return FDStatus_ok;
+    if (need > FD_COE_LEN_MAX) return FDStatus_file_too_lager_error;
+    size_t new_capacity = *capacity ? *capacity : 256;
+    while (new_capacity < need) new_capacity *= 2;
+    int32_t *p = *data ? os_realloc(*data, new_capacity * sizeof(int32_t))
+                       : os_malloc_tag(new_capacity * sizeof(int32_t), OS_MEM_TAG_FILE_DECODER);
+    if (p == NULL) return FDStatus_out_of_memory;
+    *data = p;
+    *capacity = new_capacity;
+    return FDStatus_ok;
+}
+
+static FDStatus FileDecoder_coe_expect(FDTokenizer *t, FDToken token) {
+    FDToken next = FileDecoder_tokenizer_next(t);
+    if (next == FDToken_error) return t->status;
+    return next == token ? FDStatus_ok : FDStatus_coe_format_error;
+}
+
+/**
+ * 解析xilinx coe文件，支持FIR系数格式(radix/coefficient_width/coefdata)
+ * 和存储器初始化格式(memory_initialization_radix/memory_initialization_vector)，
+ * 行首的';'为注释
+ */
+static FDStatus FileDecoder_parse_coe(FDTokenizer *t, int32_t **p, size_t *len, int *width) {
     FDStatus status = FDStatus_ok;
+    int32_t *data = NULL;
+    size_t capacity = 0, used = 0;
+    int radix = 0, coefficient_width = 0, inferred_width = 0, in_vector = 0;
+
+    while (1) {
+        FDToken token = FileDecoder_tokenizer_next(t);
+        if (token == FDToken_error) GOTO_RET(t->status)
+        if (token == FDToken_eof) break;
+
+        if (in_vector) {
+            if (token == FDToken_comma) continue;
+            if (token == FDToken_semi) {
+                in_vector = 0;
+                continue;
+            }
+            if (token != FDToken_word) GOTO_RET(FDStatus_coe_format_error)
+            status = FileDecoder_coe_reserve(&data, &capacity, used + 1);
+            if (status != FDStatus_ok) GOTO_RET(status)
+            if (coefficient_width) {
+                status = FileDecoder_coe_parse_value(t->token, t->token_len, radix, coefficient_width, &data[used]);
+            } else {
+                // 未指定位宽时先按32位无符号读取，结束后按推断的位宽统一符号扩展
+                status = FileDecoder_coe_parse_value(t->token, t->token_len, radix, 32, &data[used]);
+                int w = radix == 10 ? FileDecoder_coe_value_width(data[used])
+                                    : FileDecoder_coe_digits_width(t->token_len, radix);
+                if (w > inferred_width) inferred_width = w;
+            }
+            if (status != FDStatus_ok) GOTO_RET(status)
+            used++;
+            continue;
+        }
 
-    int radix = 0;
-    int coefficient_width = 0;
-    int16_t *data = os_malloc(sizeof(int16_t) * 64);
-    if (data == NULL) GOTO_RET(FDStatus_out_of_memory)
-    int data_start = 0;
-    int data_len = 64, data_used_len = 0;
+        if (token == FDToken_semi) {
+            FileDecoder_tokenizer_skip_line(t);
+            continue;
+        }
+        if (token != FDToken_word) GOTO_RET(FDStatus_coe_format_error)
+
+        if (FileDecoder_token_is(t, "radix") || FileDecoder_token_is(t, "memory_initialization_radix")) {
+            status = FileDecoder_coe_expect(t, FDToken_equ);
+            if (status != FDStatus_ok) GOTO_RET(status)
+            status = FileDecoder_coe_expect(t, FDToken_word);
+            if (status != FDStatus_ok) GOTO_RET(status)
+            radix = atoi(t->token);
+            if (radix != 2 && radix != 8 && radix != 10 && radix != 16) GOTO_RET(FDStatus_coe_format_error)
+        } else if (FileDecoder_token_is(t, "coefficient_width")) {
+            status = FileDecoder_coe_expect(t, FDToken_equ);
+            if (status != FDStatus_ok) GOTO_RET(status)
+            status = FileDecoder_coe_expect(t, FDToken_word);
+            if (status != FDStatus_ok) GOTO_RET(status)
+            // 已按推断位宽读取的系数无法再按新位宽检查
+            if (used) GOTO_RET(FDStatus_coe_format_error)
+            coefficient_width = atoi(t->token);
+            if (coefficient_width < 1 || coefficient_width > 32) GOTO_RET(FDStatus_coe_width_error)
+        } else if (FileDecoder_token_is(t, "coefdata") || FileDecoder_token_is(t, "memory_initialization_vector")) {
+            status = FileDecoder_coe_expect(t, FDToken_equ);
+            if (status != FDStatus_ok) GOTO_RET(status)
+            if (radix == 0) GOTO_RET(FDStatus_coe_format_error)
+            in_vector = 1;
+            continue;
+        } else {
+            // 其他字段(如Number_Of_Coefficients)不需要，跳过到';'
+            do {
+                token = FileDecoder_tokenizer_next(t);
+                if (token == FDToken_error) GOTO_RET(t->status)
+            } while (token != FDToken_semi && token != FDToken_eof);
+            continue;
+        }
+        status = FileDecoder_coe_expect(t, FDToken_semi);
+        if (status != FDStatus_ok) GOTO_RET(status)
+    }
+
+    if (used == 0) GOTO_RET(FDStatus_coe_format_error)
+    if (coefficient_width == 0) {
+        coefficient_width = inferred_width;
+        if (radix != 10) FileDecoder_coe_sign_extend(data, used, coefficient_width);
+    }
+    *p = data;
+    *len = used;
+    if (width) *width = coefficient_width;
+    return FDStatus_ok;
+
+    ret:
+    os_free(data);
+    return status;
+}
+
+/**
+ * 解析verilog $readmemh格式的mem文件，'@'指定16进制地址，未写入的地址补0，位宽按最长的数推断
+ */
+static FDStatus FileDecoder_parse_mem(FDTokenizer *t, int32_t **p, size_t *len, int *width) {
+    FDStatus status = FDStatus_ok;
+    int32_t *data = NULL;
+    size_t capacity = 0, used = 0, addr = 0;
+    int mem_width = 0;
 
-    char text_buf[512];
     while (1) {
-        char *line = f_gets(text_buf, 512, &file);
-        if (line == NULL) break;
-        int line_len = 0;
-        while (line_len < 512 && line[line_len] != '\n' && line[line_len] != ';') line_len++;
-        while (line[0] == ' ' || line[0] == '\t') {
-            line++;
-            line_len--;
+        FDToken token = FileDecoder_tokenizer_next(t);
+        if (token == FDToken_error) GOTO_RET(t->status)
+        if (token == FDToken_eof) break;
+
+        if (token == FDToken_at) {
+            status = FileDecoder_coe_expect(t, FDToken_word);
+            if (status != FDStatus_ok) GOTO_RET(status)
+            int32_t new_addr;
+            status = FileDecoder_coe_parse_value(t->token, t->token_len, 16, 32, &new_addr);
+            if (status != FDStatus_ok) GOTO_RET(status)
+            addr = (uint32_t) new_addr;
+            continue;
         }
-        if (line_len == 0) continue;
-
-        if (radix == 0 || coefficient_width == 0 || data_start == 0) {
-            if (line[0] == 'R' || line[0] == 'r' || line[0] == 'C' || line[0] == 'c') {
-                int equ = 0;
-                while (equ < line_len && line[equ] != '=') equ++;
-                if (line[equ] != '=') GOTO_RET(FDStatus_coe_format_error)
-                int flied_end = equ - 1;
-                while (equ >= 0 && line[flied_end] == ' ')flied_end--;
-
-                char xxx[100] = "";
-                memcpy(xxx, line, flied_end + 1);
-
-                for (int i = 0; i <= flied_end; i++)
-                    if (xxx[i] <= 'Z') xxx[i] += 'a' - 'A';
-
-                if (strcmp(xxx, "radix") == 0) {
-                    radix = (int) FileDecoder_parse_number(line + equ + 1, line_len - equ - 1);
-                    if (radix != 2 && radix != 10 && radix != 16) GOTO_RET(FDStatus_coe_format_error)
-                } else if (strcmp(xxx, "coefficient_width") == 0) {
-                    coefficient_width = (int) FileDecoder_parse_number(line + equ + 1, line_len - equ - 1);
-                    if (coefficient_width != 16) GOTO_RET(FDStatus_coe_width_error)
-                } else if (strcmp(xxx, "coefdata") == 0) {
-                    line += equ + 1;
-                    line_len -= equ + 1;
-                    while (*line == ' ') {
-                        line++;
-                        line_len--;
-                    }
-                    data_start = 1;
-                }
+        if (token != FDToken_word) GOTO_RET(FDStatus_coe_format_error)
+
+        int w = FileDecoder_coe_digits_width(t->token_len, 16);
+        if (w > mem_width) mem_width = w;
+        status = FileDecoder_coe_reserve(&data, &capacity, addr + 1);
+        if (status != FDStatus_ok) GOTO_RET(status)
+        if (addr > used)
+            memset(&data[used], 0, (addr - used) * sizeof(int32_t));
+        status = FileDecoder_coe_parse_value(t->token, t->token_len, 16, 32, &data[addr++]);
+        if (status != FDStatus_ok) GOTO_RET(status)
+        if (addr > used) used = addr;
+    }
+
+    if (used == 0) GOTO_RET(FDStatus_coe_format_error)
+    FileDecoder_coe_sign_extend(data, used, mem_width);
+    *p = data;
+    *len = used;
+    if (width) *width = mem_width;
+    return FDStatus_ok;
+
+    ret:
+    os_free(data);
+    return status;
+}
+
+static FDStatus FileDecoder_decode_coe(FDReader *r, FDType type, int32_t **p, size_t *len, int *width) {
+    FDStatus status;
+    FDTokenizer *t = os_malloc_tag(sizeof(FDTokenizer), OS_MEM_TAG_FILE_DECODER);
+    if (t == NULL) return FDStatus_out_of_memory;
+
+    FileDecoder_tokenizer_init(t, r);
+    if (type == FDType_mem)
+        status = FileDecoder_parse_mem(t, p, len, width);
+    else
+        status = FileDecoder_parse_coe(t, p, len, width);
+    os_free(t);
+
+    if (status == FDStatus_ok) {
+        // 释放多余的容量
+        int32_t *shrink = os_realloc(*p, *len * sizeof(int32_t));
+        if (shrink) *p = shrink;
+    }
+    return status;
+}
+
+/**
+ * 系数转换为int16_t，用于兼容FileDecoder_open的接口，原地转换
+ */
+static FDStatus FileDecoder_coe_to_int16(int32_t *data, size_t len, int width, int16_t **p) {
+    if (width > 16) {
+        os_free(data);
+        return FDStatus_coe_width_error;
+    }
+    int16_t *data16 = (int16_t *) data;
+    for (size_t i = 0; i < len; i++)
+        data16[i] = (int16_t) data[i];
+    int16_t *shrink = os_realloc(data16, len * sizeof(int16_t));
+    *p = shrink ? shrink : data16;
+    return FDStatus_ok;
+}
+
+/**
+ * 定位wav文件的fmt块与data块，返回时文件指针位于data块数据起始处
+ * @param r [in] 数据源
+ * @param fmt [out] fmt块内容，EXTENSIBLE格式会被替换为实际格式
+ * @param data_size [out] data块长度
+ * @return
+ */
+static FDStatus FileDecoder_wav_locate(FDReader *r, wav_fmt_t *fmt, uint32_t *data_size) {
+    uint8_t riff[12];
+    UINT br;
+    if (FDReader_read(r, riff, sizeof(riff), &br) != FR_OK) return FDStatus_file_read_error;
+    if (br != sizeof(riff) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+        return FDStatus_wav_format_error;
+
+    int fmt_found = 0;
+    wav_chunk_t chunk;
+    while (1) {
+        if (FDReader_read(r, &chunk, sizeof(chunk), &br) != FR_OK) return FDStatus_file_read_error;
+        if (br != sizeof(chunk)) return FDStatus_wav_format_error;
+        FSIZE_t chunk_start = FDReader_tell(r);
+
+        if (memcmp(chunk.id, "fmt ", 4) == 0) {
+            UINT fmt_len = chunk.size < sizeof(wav_fmt_t) ? chunk.size : sizeof(wav_fmt_t);
+            if (fmt_len < 16) return FDStatus_wav_format_error;
+            memset(fmt, 0, sizeof(wav_fmt_t));
+            if (FDReader_read(r, fmt, fmt_len, &br) != FR_OK || br != fmt_len) return FDStatus_file_read_error;
+            if (fmt->audio_format == WAV_FORMAT_EXTENSIBLE) {
+                if (fmt_len < sizeof(wav_fmt_t)) return FDStatus_wav_format_error;
+                fmt->audio_format = fmt->sub_format;
+            }
+            fmt_found = 1;
+        } else if (memcmp(chunk.id, "data", 4) == 0) {
+            if (!fmt_found) return FDStatus_wav_format_error;
+            // 流式录音软件可能不回填data块长度，以文件实际长度为准
+            FSIZE_t remain = FDReader_size(r) - chunk_start;
+            *data_size = chunk.size > remain ? remain : chunk.size;
+            return FDStatus_ok;
+        }
+
+        // 奇数长度的块后有一字节填充
+        if (FDReader_seek(r, chunk_start + chunk.size + (chunk.size & 1)) != FR_OK) return FDStatus_file_read_error;
+        if (FDReader_eof(r)) return FDStatus_wav_format_error;
+    }
+}
+
+static FDStatus FileDecoder_wav_check_fmt(const wav_fmt_t *fmt) {
+    if (fmt->channels == 0 || fmt->bits_per_sample == 0 || fmt->bits_per_sample % 8 != 0)
+        return FDStatus_wav_format_error;
+    if (fmt->audio_format == WAV_FORMAT_PCM) {
+        if (fmt->bits_per_sample > 32) return FDStatus_wav_format_error;
+    } else if (fmt->audio_format == WAV_FORMAT_IEEE_FLOAT) {
+        if (fmt->bits_per_sample != 32 && fmt->bits_per_sample != 64) return FDStatus_wav_format_error;
+    } else return FDStatus_wav_format_error;
+    if (fmt->block_align != fmt->channels * fmt->bits_per_sample / 8)
+        return FDStatus_wav_format_error;
+    return FDStatus_ok;
+}
+
+/**
+ * 从字段名末尾的数字解析声道号，如"声道2"返回1，没有数字时默认第一个声道
+ * @param field
+ * @return 从0开始的声道号
+ */
+static int FileDecoder_wav_parse_channel(const char *field) {
+    if (field == NULL) return 0;
+    size_t len = strlen(field);
+    size_t i = len;
+    while (i > 0 && field[i - 1] >= '0' && field[i - 1] <= '9') i--;
+    if (i == len) return 0;
+    int channel = atoi(field + i);
+    return channel > 0 ? channel - 1 : 0;
+}
+
+static int8_t FileDecoder_wav_float_to_int8(double f) {
+    if (isnan(f)) return 0;
+    f *= 127;
+    if (f >= 127) return 127;
+    if (f <= -128) return -128;
+    return (int8_t) f;
+}
+
+/**
+ * 将一段wav采样转换为DAC使用的int8格式，整数PCM只取每个采样的最高字节
+ * @param src [in] 原始数据，按帧排列
+ * @param dst [out] 转换结果
+ * @param n 帧数
+ * @param fmt wav格式
+ * @param channel 选择的声道
+ */
+static void FileDecoder_wav_convert(const uint8_t *src, int8_t *dst, size_t n, const wav_fmt_t *fmt, int channel) {
+    const uint16_t stride = fmt->block_align;
+    const uint16_t bytes = fmt->bits_per_sample / 8;
+    size_t i = 0;
+
+    if (fmt->audio_format == WAV_FORMAT_PCM) {
+        // 8位PCM为无符号数，其他位宽为有符号数
+        const uint8_t sign = bytes == 1 ? 0x80 : 0x00;
+        const uint16_t msb = channel * bytes + bytes - 1;
+#if defined(__ARM_NEON)
+        const uint8x16_t v_sign = vdupq_n_u8(sign);
+        if (stride == 1) {
+            for (; i + 16 <= n; i += 16)
+                vst1q_s8(dst + i, vreinterpretq_s8_u8(veorq_u8(vld1q_u8(src + i), v_sign)));
+        } else if (stride == 2) {
+            // 8位双声道 / 16位单声道
+            for (; i + 16 <= n; i += 16) {
+                uint8x16x2_t v = vld2q_u8(src + i * 2);
+                vst1q_s8(dst + i, vreinterpretq_s8_u8(veorq_u8(v.val[msb], v_sign)));
+            }
+        } else if (stride == 3) {
+            // 24位单声道
+            for (; i + 16 <= n; i += 16) {
+                uint8x16x3_t v = vld3q_u8(src + i * 3);
+                vst1q_s8(dst + i, vreinterpretq_s8_u8(veorq_u8(v.val[msb], v_sign)));
+            }
+        } else if (stride == 4) {
+            // 16位双声道 / 32位单声道
+            for (; i + 16 <= n; i += 16) {
+                uint8x16x4_t v = vld4q_u8(src + i * 4);
+                vst1q_s8(dst + i, vreinterpretq_s8_u8(veorq_u8(v.val[msb], v_sign)));
             }
         }
-        if (data_start) {
-            while (line_len > 0) {
-                int number_end = 0;
-                while (number_end <= line_len && line[number_end] != ',' && line[number_end] != ';') number_end++;
-                if (data_used_len == data_len) {
-                    data_len += 64;
-                    data = realloc(data, sizeof(int16_t) * data_len);
-                    if (data == NULL) GOTO_RET(FDStatus_out_of_memory)
+#endif
+        const uint8_t *s = src + msb;
+        for (; i < n; i++)
+            dst[i] = (int8_t) (s[i * stride] ^ sign);
+    } else if (bytes == 4) {
+        const uint8_t *s = src + channel * 4;
+#if defined(__ARM_NEON)
+        if (stride == 4 || stride == 8) {
+            for (; i + 8 <= n; i += 8) {
+                float32x4_t lo, hi;
+                if (stride == 4) {
+                    lo = vld1q_f32((const float *) (src + i * 4));
+                    hi = vld1q_f32((const float *) (src + i * 4 + 16));
+                } else {
+                    lo = vld2q_f32((const float *) (src + i * 8)).val[channel];
+                    hi = vld2q_f32((const float *) (src + i * 8 + 32)).val[channel];
                 }
-                if (radix == 16)
-                    data[data_used_len++] = (int16_t) FileDecoder_parse_number_16(line, number_end);
-                else if (radix == 10)
-                    data[data_used_len++] = (int16_t) FileDecoder_parse_number(line, number_end);
-                else data[data_used_len++] = (int16_t) FileDecoder_parse_number_2(line, number_end);
-                line += number_end + 1;
-                line_len -= number_end + 1;
+                // 饱和窄化完成限幅，NaN转换结果为0
+                int16x8_t v = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(lo, 127.0f))),
+                                           vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(hi, 127.0f))));
+                vst1_s8(dst + i, vqmovn_s16(v));
             }
         }
+#endif
+        for (; i < n; i++) {
+            float f;
+            memcpy(&f, s + i * stride, sizeof(f));
+            dst[i] = FileDecoder_wav_float_to_int8(f);
+        }
+    } else {
+        const uint8_t *s = src + channel * 8;
+        for (; i < n; i++) {
+            double f;
+            memcpy(&f, s + i * stride, sizeof(f));
+            dst[i] = FileDecoder_wav_float_to_int8(f);
+        }
+    }
+}
+
+static FDStatus FileDecoder_decode_wav(FDReader *r, int8_t **p, size_t *len, const char *field) {
+    FDStatus status;
+    int8_t *data = NULL;
+    uint8_t *block = NULL;
+
+    wav_fmt_t fmt;
+    uint32_t data_size;
+    status = FileDecoder_wav_locate(r, &fmt, &data_size);
+    if (status != FDStatus_ok) GOTO_RET(status)
+    status = FileDecoder_wav_check_fmt(&fmt);
+    if (status != FDStatus_ok) GOTO_RET(status)
+
+    int channel = FileDecoder_wav_parse_channel(field);
+    if (channel >= fmt.channels) GOTO_RET(FDStatus_wav_channel_error)
+
+    size_t frames = data_size / fmt.block_align;
+    if (frames == 0) GOTO_RET(FDStatus_wav_format_error)
+    if (frames > FD_FILE_SIZE_MAX) GOTO_RET(FDStatus_file_too_lager_error)
+
+    // 每次读取整数个帧，边读边转换，不需要缓存整个文件
+    UINT block_frames = WAV_READ_BLOCK_SIZE / fmt.block_align;
+    if (block_frames == 0) block_frames = 1;
+
+    data = os_malloc_tag(frames, OS_MEM_TAG_FILE_DECODER);
+    block = os_malloc_tag(block_frames * fmt.block_align, OS_MEM_TAG_FILE_DECODER);
+    if (data == NULL || block == NULL) GOTO_RET(FDStatus_out_of_memory)
+
+    size_t done = 0;
+    while (done < frames) {
+        UINT n = frames - done < block_frames ? frames - done : block_frames;
+        UINT br;
+        if (FDReader_read(r, block, n * fmt.block_align, &br) != FR_OK || br != n * fmt.block_align)
+            GOTO_RET(FDStatus_file_read_error)
+        FileDecoder_wav_convert(block, data + done, n, &fmt, channel);
+        done += n;
     }
     *p = data;
-    *len = data_used_len;
+    *len = frames;
+    data = NULL;
 
     ret:
-    f_close(&file);
+    os_free(block);
+    os_free(data);
+    return status;
+}
+
+FDStatus FileDecoder_get_wav_info(const char *filename, FDWavInfo *info) {
+    if (filename == NULL || info == NULL)
+        return FDStatus_null;
+    FIL file;
+    FDReader reader;
+    char filename_GBK[ENCODING_PATH_MAX];
+    if (Encoding_utf8_to_gbk(filename_GBK, sizeof(filename_GBK), filename) < 0)
+        return FDStatus_invalid_path;
+    FDStatus status = FDReader_open(&reader, &file, filename_GBK);
+    if (status != FDStatus_ok) return status;
+
+    wav_fmt_t fmt;
+    uint32_t data_size;
+    status = FileDecoder_wav_locate(&reader, &fmt, &data_size);
+    if (status == FDStatus_ok) status = FileDecoder_wav_check_fmt(&fmt);
+    if (status == FDStatus_ok) {
+        info->format = fmt.audio_format;
+        info->channels = fmt.channels;
+        info->sample_rate = fmt.sample_rate;
+        info->bits_per_sample = fmt.bits_per_sample;
+        info->frames = data_size / fmt.block_align;
+    }
+    FDReader_close(&reader);
     return status;
 }
 
@@ -330,65 +947,144 @@ FDStatus FileDecoder_get_json_field(const char *filename, char ***p, size_t *len
         return FDStatus_null;
     FDStatus status;
     char **buf = NULL;
+    int size = 0;
 
-
-    size_t file_size;
-    char *file;
-    char *filename_GBK = UTF8_TO_GBK(filename);
-    status = FileDecoder_decode_bin(filename_GBK, (int8_t **) &file, &file_size);
-    os_free(filename_GBK);
+    FIL file;
+    FDReader reader;
+    cJSON *json;
+    char filename_GBK[ENCODING_PATH_MAX];
+    if (Encoding_utf8_to_gbk(filename_GBK, sizeof(filename_GBK), filename) < 0)
+        return FDStatus_invalid_path;
+    status = FDReader_open(&reader, &file, filename_GBK);
+    if (status != FDStatus_ok) return status;
+    status = FileDecoder_load_json(&reader, &json);
+    FDReader_close(&reader);
     if (status != FDStatus_ok) return status;
 
-    cJSON *json = cJSON_ParseWithLength(file, file_size);
-    if (json == NULL) {
-        os_free(file);
-        return FDStatus_json_parse_error;
-    }
     if (cJSON_IsArray(json)) GOTO_RET(FDStatus_array_file)
 
-    int size = 0;
     cJSON *obj = json->child;
     while (obj) {
         if (cJSON_IsArray(obj)) {
-            buf = realloc(buf, ++size * sizeof(const char *));
-            if (buf == NULL) GOTO_RET(FDStatus_out_of_memory)
-            buf[size - 1] = os_malloc(strlen(obj->string));
-            strcpy(buf[size - 1], obj->string);
+            char **new_buf = buf ? os_realloc(buf, (size + 1) * sizeof(char *))
+                                 : os_malloc_tag(sizeof(char *), OS_MEM_TAG_FILE_DECODER);
+            if (new_buf == NULL) GOTO_RET(FDStatus_out_of_memory)
+            buf = new_buf;
+            buf[size] = os_malloc_tag(strlen(obj->string) + 1, OS_MEM_TAG_FILE_DECODER);
+            if (buf[size] == NULL) GOTO_RET(FDStatus_out_of_memory)
+            strcpy(buf[size++], obj->string);
         }
         obj = obj->next;
     }
     *len = size;
-    *p = (const char **) buf;
+    *p = buf;
     ret:
-    cJSON_free(json);
-    os_free(file);
+    if (status != FDStatus_ok && buf) {
+        for (int i = 0; i < size; i++) os_free(buf[i]);
+        os_free(buf);
+    }
+    cJSON_Delete(json);
     return status;
 }
 
-FDStatus FileDecoder_open(const char *filename, const char *field, FDType *type, int8_t **p, size_t *len) {
-    if (p == NULL || filename == NULL || len == NULL)
-        return FDStatus_null;
+/**
+ * 按类型从数据源解码
+ */
+static FDStatus FileDecoder_decode(FDReader *r, FDType file_type, const char *field, int8_t **p, size_t *len) {
     FDStatus status;
-    char *filename_GBK = UTF8_TO_GBK(filename);
-    FDType file_type = FileDecoder_get_file_type(filename_GBK);
     switch (file_type) {
         case FDType_csv:
-            status = FileDecoder_decode_csv(filename_GBK, p, len);
+            status = FileDecoder_decode_csv(r, p, len);
             break;
         case FDType_bin:
-            status = FileDecoder_decode_bin(filename_GBK, p, len);
+            status = FileDecoder_decode_bin(r, p, len);
             break;
         case FDType_json:
-            status = FileDecoder_decode_json(filename_GBK, p, len, field);
+            status = FileDecoder_decode_json(r, p, len, field);
             break;
         case FDType_coe:
-            status = FileDecoder_decode_coe(filename_GBK, (int16_t **) p, len);
+        case FDType_mem: {
+            int32_t *data;
+            int width;
+            status = FileDecoder_decode_coe(r, file_type, &data, len, &width);
+            if (status == FDStatus_ok)
+                status = FileDecoder_coe_to_int16(data, *len, width, (int16_t **) p);
+            break;
+        }
+        case FDType_wav:
+            status = FileDecoder_decode_wav(r, p, len, field);
             break;
         case FDType_unknown:
         default:
             status = FDStatus_invalid_file;
     }
-    os_free(filename_GBK);
+    return status;
+}
+
+FDStatus FileDecoder_open(const char *filename, const char *field, FDType *type, int8_t **p, size_t *len) {
+    if (p == NULL || filename == NULL || len == NULL)
+        return FDStatus_null;
+    FDStatus status;
+    FIL file;
+    FDReader reader;
+    char filename_GBK[ENCODING_PATH_MAX];
+    if (Encoding_utf8_to_gbk(filename_GBK, sizeof(filename_GBK), filename) < 0)
+        return FDStatus_invalid_path;
+    FDType file_type = FileDecoder_get_file_type(filename_GBK);
+    if (file_type == FDType_unknown) {
+        status = FDStatus_invalid_file;
+    } else {
+        status = FDReader_open(&reader, &file, filename_GBK);
+        if (status == FDStatus_ok) {
+            status = FileDecoder_decode(&reader, file_type, field, p, len);
+            FDReader_close(&reader);
+        }
+    }
+    if (type) *type = file_type;
+    return status;
+}
+
+FDStatus FileDecoder_open_buffer(const char *filename, const void *buf, size_t size, const char *field,
+                                 FDType *type, int8_t **p, size_t *len) {
+    if (p == NULL || filename == NULL || buf == NULL || len == NULL)
+        return FDStatus_null;
+    FDReader reader;
+    FDReader_init_mem(&reader, buf, size);
+    FDType file_type = FileDecoder_get_file_type(filename);
     if (type) *type = file_type;
+    return FileDecoder_decode(&reader, file_type, field, p, len);
+}
+
+FDStatus FileDecoder_open_coe(const char *filename, int32_t **p, size_t *len, int *width) {
+    if (p == NULL || filename == NULL || len == NULL)
+        return FDStatus_null;
+    FDStatus status;
+    FIL file;
+    FDReader reader;
+    char filename_GBK[ENCODING_PATH_MAX];
+    if (Encoding_utf8_to_gbk(filename_GBK, sizeof(filename_GBK), filename) < 0)
+        return FDStatus_invalid_path;
+    FDType file_type = FileDecoder_get_file_type(filename_GBK);
+    if (file_type == FDType_coe || file_type == FDType_mem) {
+        status = FDReader_open(&reader, &file, filename_GBK);
+        if (status == FDStatus_ok) {
+            status = FileDecoder_decode_coe(&reader, file_type, p, len, width);
+            FDReader_close(&reader);
+        }
+    } else {
+        status = FDStatus_invalid_file;
+    }
     return status;
 }
+
+FDStatus FileDecoder_open_coe_buffer(const char *filename, const void *buf, size_t size,
+                                     int32_t **p, size_t *len, int *width) {
+    if (p == NULL || filename == NULL || buf == NULL || len == NULL)
+        return FDStatus_null;
+    FDType file_type = FileDecoder_get_file_type(filename);
+    if (file_type != FDType_coe && file_type != FDType_mem)
+        return FDStatus_invalid_file;
+    FDReader reader;
+    FDReader_init_mem(&reader, buf, size);
+    return FileDecoder_decode_coe(&reader, file_type, p, len, width);
+}
\ No newline at end of file
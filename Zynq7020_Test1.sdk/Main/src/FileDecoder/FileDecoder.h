@@ -24,6 +24,8 @@ typedef enum FDStatus {
     FDStatus_coe_format_error,
     FDStatus_coe_width_error,
     FDStatus_array_file,
+    FDStatus_wav_format_error,
+    FDStatus_wav_channel_error,
     FDStatus_end,
 } FDStatus;
 
@@ -32,10 +34,20 @@ typedef enum FDType {
     FDType_bin,
     FDType_json,
     FDType_coe,
+    FDType_wav,
+    FDType_mem,
     FDType_unknown,
     FDType_end,
 } FDType;
 
+typedef struct FDWavInfo {
+    uint16_t format;            //!< 1:PCM 3:IEEE浮点
+    uint16_t channels;          //!< 声道数
+    uint32_t sample_rate;       //!< 采样率
+    uint16_t bits_per_sample;   //!< 采样位宽
+    uint32_t frames;            //!< 每个声道的采样点数
+} FDWavInfo;
+
 /**
  *
  * @param status
@@ -66,14 +78,54 @@ FDType FileDecoder_get_file_type(const char *filename);
  */
 FDStatus FileDecoder_get_json_field(const char *filename, char ***p, size_t *len);
 
+/**
+ * 读取wav文件格式信息
+ * @param filename [in] 文件路径
+ * @param info [out] 格式信息
+ * @return
+ */
+FDStatus FileDecoder_get_wav_info(const char *filename, FDWavInfo *info);
+
 /**
  * 自动判断类型并读取文件
  * @param filename [in] 文件路径
- * @param field [in] 选择字段，仅json文件有效
+ * @param field [in] 选择字段，json文件为字段名，wav文件为声道名(如"声道1")，末尾数字为声道号
  * @param type [out] 返回文件类型
- * @param p [out] 返回数据指针，需要释放，coe文件指针类型需要转换为int16_t
- * @param len [out] 返回数组的长度，coe文件为int16_t的长度
+ * @param p [out] 返回数据指针，需要释放，coe/mem文件指针类型需要转换为int16_t
+ * @param len [out] 返回数组的长度，coe/mem文件为int16_t的长度
+ * @return coe/mem文件位宽大于16时返回FDStatus_coe_width_error，需要使用FileDecoder_open_coe
  */
 FDStatus FileDecoder_open(const char *filename, const char *field, FDType *type, int8_t **p, size_t *len);
 
+/**
+ * 读取coe或mem系数文件，支持1-32位宽和2/8/10/16进制，系数按位宽符号扩展
+ * 没有coefficient_width字段时按数的最大位数(10进制按数值)推断位宽
+ * @param filename [in] 文件路径
+ * @param p [out] 系数数组，需要释放
+ * @param len [out] 系数个数
+ * @param width [out] 系数位宽，可以为NULL
+ * @return
+ */
+FDStatus FileDecoder_open_coe(const char *filename, int32_t **p, size_t *len, int *width);
+
+/**
+ * 从内存缓冲区解码，不访问文件系统，可用于网络接收的数据和离线测试
+ * @param filename [in] 文件名，仅用于按后缀判断类型
+ * @param buf [in] 文件内容
+ * @param size [in] 文件长度
+ * @param field [in] 同FileDecoder_open
+ * @param type [out] 返回文件类型
+ * @param p [out] 同FileDecoder_open
+ * @param len [out] 同FileDecoder_open
+ * @return
+ */
+FDStatus FileDecoder_open_buffer(const char *filename, const void *buf, size_t size, const char *field,
+                                 FDType *type, int8_t **p, size_t *len);
+
+/**
+ * 从内存缓冲区读取coe或mem系数文件，参数同FileDecoder_open_coe
+ */
+FDStatus FileDecoder_open_coe_buffer(const char *filename, const void *buf, size_t size,
+                                     int32_t **p, size_t *len, int *width);
+
 #endif //ZYNQ7020_FILEDECODER_H
@@ -6,6 +6,7 @@
 #include <arm_math.h>
 #include "LVGL_Utils/FileSelectBox.h"
 #include "Fatfs_init/Fatfs_Driver.h"
+#include "FileService/FileService.h"
 #include "FileDecoder/FileDecoder.h"
 #include "AmplitudeResponse/AmplitudeResponse.h"
 #include "LVGL_Utils/MessageBox.h"
@@ -100,12 +101,12 @@ void DigitalFilter_create(lv_obj_t *parent) {
 
     char *buf = UTF8_TO_GBK("0:/数字滤波器");
     DIR dir;
-    FRESULT res = f_opendir(&dir, buf);
+    FRESULT res = FileService_opendir(&dir, buf);
     if (res == FR_OK) {
         lv_file_select_box_set_dir(file_table, "0:/数字滤波器/");
-        f_closedir(&dir);
+        FileService_closedir(&dir);
     } else if (res == FR_NO_PATH) {
-        res = f_mkdir(buf);
+        res = FileService_mkdir(buf);
         if (res != FR_OK) {
             LV_LOG_ERROR("创建文件夹 \"0:/数字滤波器\" 失败");
         } else {
@@ -123,7 +124,7 @@ static void file_table_path_change_cb(lv_obj_t *obj, const char *path) {
 static void file_table_click_cb(lv_obj_t *obj, const char *path, const char *filename) {
     LV_UNUSED(obj);
     FDType type = FileDecoder_get_file_type(filename);
-    if (type == FDType_coe) {
+    if (type == FDType_coe || type == FDType_mem) {
         size_t len;
         int16_t *data;
         FDStatus status = FileDecoder_open(path, NULL, NULL, (int8_t **) &data, &len);
@@ -139,7 +140,7 @@ static void file_table_click_cb(lv_obj_t *obj, const char *path, const char *fil
             memset(coe_data, 0, sizeof(coe_data));
             for (int i = 0; i < 64 && i < len; i++)
                 coe_data[i] = data[i] * (10000.0 / INT16_MAX);
-            memcpy(coe_raw_data, data, sizeof(int16_t) * len);
+            memcpy(coe_raw_data, data, sizeof(int16_t) * (len < 65 ? len : 65));
             coe_len = len;
             lv_chart_refresh(amp_chart);
             lv_chart_hide_series(amp_chart, amp_series, false);
@@ -168,9 +169,14 @@ void reload_btn_cb(lv_event_t *event) {
                 return;
             }
         }
+        if (xSemaphoreTake(FIR_Mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+            MessageBox_info("错误", "关闭", "滤波器正在被远程重载");
+            return;
+        }
         int ret = FIR_reload_coe(coe_raw_data);
+        if (ret == XST_SUCCESS) SPU_SetFirShift(fraction_bit);
+        xSemaphoreGive(FIR_Mutex);
         if (ret == XST_SUCCESS) {
-            SPU_SetFirShift(fraction_bit);
             LV_LOG_USER("FIR: file='%s', fraction_bit=%d", lv_label_get_text(path_label), fraction_bit);
             MessageBox_info("完成", "关闭", "滤波器系数重载完成");
         } else {
@@ -0,0 +1,480 @@
+//
+// Created by yaoji on 2022/5/14.
+//
+
+#include "Chart_trace_plugin.h"
+#include <string.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define TRACE_MAX_SERIES 4          //!< 单个图表最多接管的数据系列数
+
+typedef struct {
+    lv_coord_t x_ofs, y_ofs;        //!< 第0个点所在列与y轴最大值所在行，相对图表左上角
+    lv_coord_t w, h;                //!< 缩放后的数据区尺寸
+    lv_coord_t ymin, ymax;
+    uint16_t point_cnt;
+    uint16_t start_point;           //!< 循环数据的起点，不参与余辉缓冲的失效判断
+} trace_map_t;
+
+typedef struct {
+    lv_chart_series_t *ser;
+    lv_coord_t *y_points;           //!< 与ser一起识别系列，删除的系列的地址可能被新系列复用
+    uint8_t *buf;                   //!< 余辉亮度，覆盖整个图表对象区域
+    trace_map_t map;                //!< 余辉缓冲对应的坐标映射，映射改变时清空
+} trace_layer_t;
+
+typedef struct {
+    lv_opa_t persistence;
+    bool drawn;                     //!< 本轮绘制已输出波形
+    uint8_t hidden_num;
+    lv_chart_series_t *hidden[TRACE_MAX_SERIES];    //!< 绘制期间临时隐藏、由插件绘制的系列
+    lv_coord_t layer_w, layer_h;
+    trace_layer_t layer[TRACE_MAX_SERIES];
+} trace_data_t;
+
+static void trace_get_map(lv_obj_t *obj, const lv_chart_series_t *ser, trace_map_t *map) {
+    lv_chart_t *chart = (lv_chart_t *) obj;
+    lv_coord_t border_width = lv_obj_get_style_border_width(obj, LV_PART_MAIN);
+    lv_coord_t pad_left = lv_obj_get_style_pad_left(obj, LV_PART_MAIN) + border_width;
+    lv_coord_t pad_top = lv_obj_get_style_pad_top(obj, LV_PART_MAIN) + border_width;
+    map->w = ((int32_t) lv_obj_get_content_width(obj) * chart->zoom_x) >> 8;
+    map->h = ((int32_t) lv_obj_get_content_height(obj) * chart->zoom_y) >> 8;
+    map->x_ofs = pad_left - lv_obj_get_scroll_left(obj);
+    map->y_ofs = pad_top - lv_obj_get_scroll_top(obj);
+    map->ymin = chart->ymin[ser->y_axis_sec];
+    map->ymax = chart->ymax[ser->y_axis_sec];
+    map->point_cnt = chart->point_cnt;
+    map->start_point = chart->update_mode == LV_CHART_UPDATE_MODE_SHIFT ? ser->start_point : 0;
+}
+
+static bool trace_map_equal(const trace_map_t *a, const trace_map_t *b) {
+    return a->x_ofs == b->x_ofs && a->y_ofs == b->y_ofs && a->w == b->w && a->h == b->h &&
+           a->ymin == b->ymin && a->ymax == b->ymax && a->point_cnt == b->point_cnt;
+}
+
+/**
+ * 在已有的最小/最大值上合并y[0..n)
+ */
+static void trace_minmax(const lv_coord_t *y, uint32_t n, lv_coord_t *vmin, lv_coord_t *vmax) {
+    lv_coord_t lo = *vmin, hi = *vmax;
+    uint32_t i = 0;
+#if defined(__ARM_NEON) && !LV_USE_LARGE_COORD
+    if (n >= 8) {
+        int16x8_t mn = vld1q_s16(y), mx = mn;
+        for (i = 8; i + 8 <= n; i += 8) {
+            int16x8_t v = vld1q_s16(y + i);
+            mn = vminq_s16(mn, v);
+            mx = vmaxq_s16(mx, v);
+        }
+        int16x4_t mn4 = vmin_s16(vget_low_s16(mn), vget_high_s16(mn));
+        int16x4_t mx4 = vmax_s16(vget_low_s16(mx), vget_high_s16(mx));
+        mn4 = vpmin_s16(mn4, mn4);
+        mx4 = vpmax_s16(mx4, mx4);
+        mn4 = vpmin_s16(mn4, mn4);
+        mx4 = vpmax_s16(mx4, mx4);
+        lo = LV_MIN(lo, vget_lane_s16(mn4, 0));
+        hi = LV_MAX(hi, vget_lane_s16(mx4, 0));
+    }
+#endif
+    for (; i < n; i++) {
+        lo = LV_MIN(lo, y[i]);
+        hi = LV_MAX(hi, y[i]);
+    }
+    *vmin = lo;
+    *vmax = hi;
+}
+
+static inline lv_coord_t trace_point(const trace_map_t *m, const lv_coord_t *y, uint32_t i) {
+    i += m->start_point;
+    return y[i >= m->point_cnt ? i - m->point_cnt : i];
+}
+
+/**
+ * 数据点序号p(16位定点)处的线性插值
+ */
+static lv_coord_t trace_interp(const trace_map_t *m, const lv_coord_t *y, int64_t p) {
+    uint32_t i = p >> 16;
+    uint32_t f = p & 0xFFFF;
+    lv_coord_t v0 = trace_point(m, y, i);
+    if (f == 0 || v0 == LV_CHART_POINT_NONE) return v0;
+    lv_coord_t v1 = trace_point(m, y, i + 1);
+    if (v1 == LV_CHART_POINT_NONE) return v1;
+    return v0 + (lv_coord_t) (((int64_t) (v1 - v0) * f) >> 16);
+}
+
+/**
+ * 数据值到行坐标，k为h / (ymax - ymin)的16位定点值
+ */
+static inline lv_coord_t trace_value_to_y(const trace_map_t *m, int64_t k, lv_coord_t v) {
+    return m->h - (lv_coord_t) (((int64_t) (v - m->ymin) * k) >> 16) + m->y_ofs;
+}
+
+/**
+ * 计算像素列[rx, rx + num)上波形的竖直范围，即折线在列内经过的所有y值，
+ * 由列左右边界处的插值与列内的数据点共同决定，相邻列共享边界值因而连续
+ * @param m 坐标映射
+ * @param y 数据
+ * @param rx 起始列，相对图表左边界
+ * @param num 列数
+ * @param width 线宽
+ * @param top 输出每列的上端，相对图表上边界
+ * @param bottom 输出每列的下端，top > bottom表示该列没有波形
+ */
+static void trace_spans(const trace_map_t *m, const lv_coord_t *y, lv_coord_t rx, lv_coord_t num,
+                        lv_coord_t width, lv_coord_t *top, lv_coord_t *bottom) {
+    uint32_t last = m->point_cnt - 1;
+    int64_t p_end = (int64_t) last << 16;
+    int32_t range = m->ymax - m->ymin;
+    int64_t k = range ? ((int64_t) m->h << 16) / range : 0;
+    lv_coord_t up = (width - 1) / 2;
+    lv_coord_t down = width - 1 - up;
+
+    /* 列边界c在数据点序号上的位置p = c * last / w，16位定点，Cortex-A9没有除法指令，逐列累加商和余数 */
+    int32_t c = LV_MAX(rx - m->x_ofs, 0);
+    int64_t p = m->w ? p_end * c / m->w : 0;
+    int32_t rem = m->w ? p_end * c % m->w : 0;
+    int64_t step = m->w ? p_end / m->w : 0;
+    int32_t step_rem = m->w ? p_end % m->w : 0;
+
+    for (lv_coord_t i = 0; i < num; i++) {
+        top[i] = 1;
+        bottom[i] = 0;
+        if (rx + i - m->x_ofs != c || c > m->w || m->w == 0) continue;
+
+        int64_t p0 = p;
+        p += step;
+        rem += step_rem;
+        if (rem >= m->w) {
+            rem -= m->w;
+            p++;
+        }
+        c++;
+        int64_t p1 = LV_MIN(p, p_end);
+
+        lv_coord_t v0 = trace_interp(m, y, p0);
+        lv_coord_t v1 = trace_interp(m, y, p1);
+        if (v0 == LV_CHART_POINT_NONE || v1 == LV_CHART_POINT_NONE) continue;
+        lv_coord_t vmin = LV_MIN(v0, v1);
+        lv_coord_t vmax = LV_MAX(v0, v1);
+
+        /* 严格位于两边界之间的数据点，循环数据最多分两段 */
+        uint32_t a = (p0 >> 16) + 1;
+        uint32_t b = (p1 + 0xFFFF) >> 16;
+        if (a < b) {
+            uint32_t s = a + m->start_point;
+            if (s >= m->point_cnt) s -= m->point_cnt;
+            uint32_t first = LV_MIN(b - a, m->point_cnt - s);
+            trace_minmax(y + s, first, &vmin, &vmax);
+            if (b - a > first) trace_minmax(y, b - a - first, &vmin, &vmax);
+            if (vmax == LV_CHART_POINT_NONE) continue;
+        }
+        top[i] = trace_value_to_y(m, k, vmax) - up;
+        bottom[i] = trace_value_to_y(m, k, vmin) + down;
+    }
+}
+
+/**
+ * 可直接写帧缓冲时返回mask左上角在缓冲中的地址，有遮罩或颜色格式不符时返回NULL
+ */
+static lv_color_t *trace_get_fb(const lv_area_t *mask, lv_coord_t *stride) {
+#if LV_COLOR_DEPTH == 32
+    lv_disp_t *disp = _lv_refr_get_disp_refreshing();
+    lv_disp_draw_buf_t *draw_buf = lv_disp_get_draw_buf(disp);
+    if (disp->driver->set_px_cb || lv_draw_mask_is_any(mask)) return NULL;
+    if (disp->driver->gpu_wait_cb) disp->driver->gpu_wait_cb(disp->driver);
+    *stride = lv_area_get_width(&draw_buf->area);
+    return (lv_color_t *) draw_buf->buf_act + (mask->y1 - draw_buf->area.y1) * *stride + (mask->x1 - draw_buf->area.x1);
+#else
+    LV_UNUSED(mask);
+    LV_UNUSED(stride);
+    return NULL;
+#endif
+}
+
+/**
+ * 把mask内各列的竖直线段画到帧缓冲
+ * @param mask 绘制区域，绝对坐标
+ * @param top mask各列线段上端，绝对坐标
+ * @param bottom mask各列线段下端，绝对坐标
+ */
+static void trace_fill_spans(const lv_area_t *mask, const lv_coord_t *top, const lv_coord_t *bottom,
+                             lv_color_t color, lv_opa_t opa) {
+    lv_coord_t cols = lv_area_get_width(mask);
+    lv_coord_t stride;
+    lv_color_t *fb = trace_get_fb(mask, &stride);
+    if (fb == NULL) {
+        /* 有圆角等遮罩时交给lv_draw_rect处理 */
+        lv_draw_rect_dsc_t rect_dsc;
+        lv_draw_rect_dsc_init(&rect_dsc);
+        rect_dsc.bg_color = color;
+        rect_dsc.bg_opa = opa;
+        for (lv_coord_t i = 0; i < cols; i++) {
+            lv_area_t a = {mask->x1 + i, top[i], mask->x1 + i, bottom[i]};
+            if (a.y1 <= a.y2) lv_draw_rect(&a, mask, &rect_dsc);
+        }
+        return;
+    }
+
+    for (lv_coord_t i = 0; i < cols; i++) {
+        lv_coord_t y1 = LV_MAX(top[i], mask->y1);
+        lv_coord_t y2 = LV_MIN(bottom[i], mask->y2);
+        if (y1 > y2) continue;
+        lv_color_t *p = fb + (y1 - mask->y1) * stride + i;
+        if (opa >= LV_OPA_MAX) {
+            for (lv_coord_t y = y1; y <= y2; y++, p += stride) *p = color;
+        } else {
+            for (lv_coord_t y = y1; y <= y2; y++, p += stride) *p = lv_color_mix(color, *p, opa);
+        }
+    }
+}
+
+#if LV_COLOR_DEPTH == 32
+/**
+ * c * a + bg * (255 - a)，按四舍五入除以255
+ */
+static inline uint8_t trace_mix(uint8_t c, uint8_t bg, uint8_t a) {
+    uint32_t x = c * a + bg * (255 - a);
+    return (x + 128 + ((x + 128) >> 8)) >> 8;
+}
+
+#if defined(__ARM_NEON)
+static inline uint8x8_t trace_mix_u8(uint8x8_t c, uint8x8_t bg, uint8x8_t a) {
+    uint16x8_t x = vmlal_u8(vmull_u8(c, a), bg, vmvn_u8(a));
+    return vraddhn_u16(x, vrshrq_n_u16(x, 8));
+}
+#endif
+
+/**
+ * 按余辉亮度把波形颜色混合到一行像素上
+ */
+static void trace_blend_row(lv_color_t *dst, const uint8_t *alpha, uint32_t n, lv_color_t color) {
+    uint32_t i = 0;
+#if defined(__ARM_NEON)
+    const uint8x8_t c_b = vdup_n_u8(color.ch.blue);
+    const uint8x8_t c_g = vdup_n_u8(color.ch.green);
+    const uint8x8_t c_r = vdup_n_u8(color.ch.red);
+    for (; i + 8 <= n; i += 8) {
+        uint8x8_t a = vld1_u8(alpha + i);
+        // 余辉区域大部分为空，整组为0时跳过
+        if (vget_lane_u64(vreinterpret_u64_u8(a), 0) == 0) continue;
+        uint8x8x4_t px = vld4_u8((uint8_t *) (dst + i));
+        px.val[0] = trace_mix_u8(c_b, px.val[0], a);
+        px.val[1] = trace_mix_u8(c_g, px.val[1], a);
+        px.val[2] = trace_mix_u8(c_r, px.val[2], a);
+        vst4_u8((uint8_t *) (dst + i), px);
+    }
+#endif
+    for (; i < n; i++) {
+        uint8_t a = alpha[i];
+        if (a == 0) continue;
+        dst[i].ch.blue = trace_mix(color.ch.blue, dst[i].ch.blue, a);
+        dst[i].ch.green = trace_mix(color.ch.green, dst[i].ch.green, a);
+        dst[i].ch.red = trace_mix(color.ch.red, dst[i].ch.red, a);
+    }
+}
+#endif
+
+/**
+ * 余辉衰减，buf = buf * k / 256
+ */
+static void trace_decay(uint8_t *buf, uint32_t n, uint8_t k) {
+    uint32_t i = 0;
+#if defined(__ARM_NEON)
+    const uint8x8_t vk = vdup_n_u8(k);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t v = vld1q_u8(buf + i);
+        vst1q_u8(buf + i, vcombine_u8(vshrn_n_u16(vmull_u8(vget_low_u8(v), vk), 8),
+                                      vshrn_n_u16(vmull_u8(vget_high_u8(v), vk), 8)));
+    }
+#endif
+    for (; i < n; i++) buf[i] = (buf[i] * k) >> 8;
+}
+
+static void trace_free_layer(trace_layer_t *layer) {
+    lv_mem_free(layer->buf);
+    layer->buf = NULL;
+    layer->ser = NULL;
+    layer->y_points = NULL;
+}
+
+/**
+ * 释放已被lv_chart_remove_series删除的系列的余辉缓冲
+ */
+static void trace_release_layers(lv_obj_t *obj, trace_data_t *data) {
+    lv_chart_t *chart = (lv_chart_t *) obj;
+    for (int i = 0; i < TRACE_MAX_SERIES; i++) {
+        trace_layer_t *layer = &data->layer[i];
+        if (layer->ser == NULL) continue;
+        bool live = false;
+        lv_chart_series_t *ser;
+        _LV_LL_READ(&chart->series_ll, ser) {
+            if (ser == layer->ser && ser->y_points == layer->y_points) {
+                live = true;
+                break;
+            }
+        }
+        if (!live) trace_free_layer(layer);
+    }
+}
+
+/**
+ * 取得系列对应的余辉缓冲，图表尺寸改变时重新分配
+ * @return 分配失败或系列过多时返回NULL
+ */
+static trace_layer_t *trace_get_layer(lv_obj_t *obj, trace_data_t *data, lv_chart_series_t *ser) {
+    lv_coord_t w = lv_obj_get_width(obj);
+    lv_coord_t h = lv_obj_get_height(obj);
+    if (data->layer_w != w || data->layer_h != h) {
+        for (int i = 0; i < TRACE_MAX_SERIES; i++) trace_free_layer(&data->layer[i]);
+        data->layer_w = w;
+        data->layer_h = h;
+    }
+    trace_release_layers(obj, data);
+
+    trace_layer_t *layer = NULL;
+    for (int i = 0; i < TRACE_MAX_SERIES; i++) {
+        if (data->layer[i].ser == ser) return data->layer[i].buf ? &data->layer[i] : NULL;
+        if (layer == NULL && data->layer[i].ser == NULL) layer = &data->layer[i];
+    }
+    if (layer == NULL) return NULL;
+
+    layer->ser = ser;
+    layer->y_points = ser->y_points;
+    layer->buf = lv_mem_alloc((size_t) w * h);
+    if (layer->buf == NULL) return NULL;
+    memset(layer->buf, 0, (size_t) w * h);
+    layer->map.point_cnt = 0;       // 首次使用时按当前数据建立
+    return layer;
+}
+
+/**
+ * 把系列当前的波形累积到余辉缓冲
+ * @param decay 是否先衰减历史波形，坐标映射改变时总是清空
+ */
+static void trace_layer_update(lv_obj_t *obj, trace_data_t *data, trace_layer_t *layer, lv_opa_t opa, bool decay) {
+    trace_map_t map;
+    trace_get_map(obj, layer->ser, &map);
+    uint32_t size = (uint32_t) data->layer_w * data->layer_h;
+    if (!trace_map_equal(&map, &layer->map)) {
+        memset(layer->buf, 0, size);
+    } else if (decay) {
+        trace_decay(layer->buf, size, data->persistence);
+    }
+    layer->map = map;
+    if (map.point_cnt < 2) return;
+
+    lv_coord_t *top = lv_mem_buf_get(data->layer_w * 2 * sizeof(lv_coord_t));
+    lv_coord_t *bottom = top + data->layer_w;
+    trace_spans(&map, layer->ser->y_points, 0, data->layer_w, LV_MAX(lv_obj_get_style_line_width(obj, LV_PART_ITEMS), 1),
+                top, bottom);
+    for (lv_coord_t x = 0; x < data->layer_w; x++) {
+        lv_coord_t y1 = LV_MAX(top[x], 0);
+        lv_coord_t y2 = LV_MIN(bottom[x], data->layer_h - 1);
+        if (y1 > y2) continue;
+        uint8_t *p = layer->buf + y1 * data->layer_w + x;
+        for (lv_coord_t y = y1; y <= y2; y++, p += data->layer_w) *p = LV_MAX(*p, opa);
+    }
+    lv_mem_buf_release(top);
+}
+
+static void trace_draw(lv_obj_t *obj, trace_data_t *data, const lv_area_t *clip_area) {
+    data->drawn = true;
+    lv_area_t mask;
+    if (!_lv_area_intersect(&mask, &obj->coords, clip_area)) return;
+
+    lv_draw_line_dsc_t line_dsc;
+    lv_draw_line_dsc_init(&line_dsc);
+    lv_obj_init_draw_line_dsc(obj, LV_PART_ITEMS, &line_dsc);
+    if (line_dsc.opa <= LV_OPA_MIN) return;
+    lv_coord_t width = LV_MAX(line_dsc.width, 1);
+
+    lv_coord_t cols = lv_area_get_width(&mask);
+    lv_coord_t *top = lv_mem_buf_get(cols * 2 * sizeof(lv_coord_t));
+    lv_coord_t *bottom = top + cols;
+    for (int i = 0; i < data->hidden_num; i++) {
+        lv_chart_series_t *ser = data->hidden[i];
+#if LV_COLOR_DEPTH == 32
+        trace_layer_t *layer = data->persistence ? trace_get_layer(obj, data, ser) : NULL;
+        lv_coord_t stride;
+        lv_color_t *fb = layer ? trace_get_fb(&mask, &stride) : NULL;
+        if (fb) {
+            trace_map_t map;
+            trace_get_map(obj, ser, &map);
+            /* 缩放或滚动后按当前数据重建余辉 */
+            if (!trace_map_equal(&map, &layer->map))
+                trace_layer_update(obj, data, layer, lv_obj_get_style_line_opa(obj, LV_PART_ITEMS), false);
+            const uint8_t *alpha = layer->buf + (mask.y1 - obj->coords.y1) * data->layer_w + (mask.x1 - obj->coords.x1);
+            for (lv_coord_t y = mask.y1; y <= mask.y2; y++, fb += stride, alpha += data->layer_w)
+                trace_blend_row(fb, alpha, cols, ser->color);
+            continue;
+        }
+#endif
+        trace_map_t map;
+        trace_get_map(obj, ser, &map);
+        trace_spans(&map, ser->y_points, mask.x1 - obj->coords.x1, cols, width, top, bottom);
+        for (lv_coord_t x = 0; x < cols; x++) {
+            top[x] += obj->coords.y1;
+            bottom[x] += obj->coords.y1;
+        }
+        trace_fill_spans(&mask, top, bottom, ser->color, line_dsc.opa);
+    }
+    lv_mem_buf_release(top);
+}
+
+static void chart_trace_event_cb(lv_event_t *e) {
+    lv_obj_t *obj = lv_event_get_target(e);
+    lv_chart_t *chart = (lv_chart_t *) obj;
+    trace_data_t *data = lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_chart_series_t *ser;
+    if (code == LV_EVENT_DRAW_MAIN_BEGIN) {
+        /* 临时隐藏系列，让lv_chart跳过逐段绘制 */
+        data->drawn = false;
+        data->hidden_num = 0;
+        if (chart->type != LV_CHART_TYPE_LINE || chart->point_cnt < 2) return;
+        _LV_LL_READ_BACK(&chart->series_ll, ser) {
+            if (ser->hidden || data->hidden_num == TRACE_MAX_SERIES) continue;
+            ser->hidden = 1;
+            data->hidden[data->hidden_num++] = ser;
+        }
+    } else if (code == LV_EVENT_DRAW_PART_BEGIN) {
+        /* lv_chart在数据系列之后绘制游标，在第一个游标之前补画波形 */
+        lv_obj_draw_part_dsc_t *dsc = lv_event_get_param(e);
+        if (!data->drawn && dsc->class_p == &lv_chart_class && dsc->type == LV_CHART_DRAW_PART_CURSOR)
+            trace_draw(obj, data, dsc->clip_area);
+    } else if (code == LV_EVENT_DRAW_MAIN) {
+        if (!data->drawn) trace_draw(obj, data, lv_event_get_param(e));
+    } else if (code == LV_EVENT_DRAW_MAIN_END) {
+        for (int i = 0; i < data->hidden_num; i++)
+            data->hidden[i]->hidden = 0;
+        data->hidden_num = 0;
+    } else if (code == LV_EVENT_REFRESH) {
+        if (data->persistence == LV_OPA_TRANSP || chart->type != LV_CHART_TYPE_LINE) return;
+        lv_opa_t opa = lv_obj_get_style_line_opa(obj, LV_PART_ITEMS);
+        _LV_LL_READ_BACK(&chart->series_ll, ser) {
+            if (ser->hidden) continue;
+            trace_layer_t *layer = trace_get_layer(obj, data, ser);
+            if (layer) trace_layer_update(obj, data, layer, opa, true);
+        }
+    } else if (code == LV_EVENT_DELETE) {
+        for (int i = 0; i < TRACE_MAX_SERIES; i++)
+            lv_mem_free(data->layer[i].buf);
+        lv_mem_free(data);
+    }
+}
+
+void lv_chart_install_trace_plugin(lv_obj_t *obj, lv_opa_t persistence) {
+    trace_data_t *data = lv_mem_alloc(sizeof(trace_data_t));
+    LV_ASSERT_MALLOC(data);
+    memset(data, 0, sizeof(trace_data_t));
+    data->persistence = persistence;
+    lv_obj_add_event_cb(obj, chart_trace_event_cb, LV_EVENT_ALL, data);
+}
+
+void lv_chart_trace_refresh(lv_obj_t *obj) {
+    lv_event_send(obj, LV_EVENT_REFRESH, NULL);
+    lv_chart_refresh(obj);
+}
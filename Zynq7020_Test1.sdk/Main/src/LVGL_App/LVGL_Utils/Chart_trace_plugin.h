@@ -0,0 +1,27 @@
+//
+// Created by yaoji on 2022/5/14.
+//
+
+#ifndef ZYNQ7020_LV_CHART_TRACE_PLUGIN_H
+#define ZYNQ7020_LV_CHART_TRACE_PLUGIN_H
+
+#include "lvgl.h"
+
+/**
+ * 安装波形快速绘制插件，接管LINE类型图表中可见数据系列的绘制：
+ * 按像素列求落入该列的数据点的最小/最大值，以竖直线段直接写入32位帧缓冲，
+ * 代替逐段抗锯齿的lv_draw_line，绘制范围裁剪到图表当前的缩放/滚动窗口，
+ * 游标仍绘制在波形之上
+ * @param obj 图表对象
+ * @param persistence 余辉系数，LV_OPA_TRANSP关闭余辉，
+ *                    否则每次lv_chart_trace_refresh时历史波形亮度乘以persistence/256
+ */
+void lv_chart_install_trace_plugin(lv_obj_t *obj, lv_opa_t persistence);
+
+/**
+ * 数据更新后代替lv_chart_refresh调用，开启余辉时把新波形累积到余辉缓冲
+ * @param obj 图表对象
+ */
+void lv_chart_trace_refresh(lv_obj_t *obj);
+
+#endif //ZYNQ7020_LV_CHART_TRACE_PLUGIN_H
@@ -5,24 +5,39 @@
 #include "FileSelectBox.h"
 #include "Fatfs_init/Fatfs_Driver.h"
 #include "MessageBox.h"
+#include "FileService/FileService.h"
+#include "FileService/DirSnapshot.h"
 #include "utils/str_tool.h"
 
 #define FILE_SELECT_BACK_CTRL LV_TABLE_CELL_CTRL_CUSTOM_2
 #define FILE_SELECT_DIR_CTRL LV_TABLE_CELL_CTRL_CUSTOM_1
+#define FILE_SELECT_REFRESH_PERIOD 50   // 检查后台读取进度的周期(ms)
+#define FILE_SELECT_WINDOW_MARGIN 8     // 可见区域上下额外填充的行数
 
 typedef struct {
     char *current_dir;
     char *selected_file;
-    const char *delete_filename;
+    char *delete_filename;
     uint32_t path_len;
     lv_file_sel_click_cb_t click_callback;
     lv_file_sel_path_change_cb_t path_change_callback;
+    DirSnapshot *snap;
+    lv_timer_t *timer;
+    uint32_t shown;         // 表格中的目录项行数
+    uint16_t offset;        // 第一行为"返回上一级"时为1
+    uint16_t bound_start;   // 已填充文字的行范围 [bound_start, bound_end)
+    uint16_t bound_end;
+    bool error_reported;
 } FileSelectBox_UserData;
 
 static void file_table_click_event(lv_event_t *event);
 static void file_table_delete_event(lv_event_t *event);
+static void file_table_scroll_event(lv_event_t *event);
 static void lv_file_table_long_pressed_event(lv_event_t *event);
+static void file_table_timer_cb(lv_timer_t *timer);
 static void scan_file(lv_obj_t *obj, const char *dir);
+static void file_table_sync(lv_obj_t *obj);
+static int file_table_get_entry(lv_obj_t *obj, uint16_t row, char *name, size_t size, bool *is_dir);
 
 lv_obj_t *lv_file_select_box_create(lv_obj_t *parent) {
     FileSelectBox_UserData *userData = lv_mem_alloc(sizeof(FileSelectBox_UserData));
@@ -35,7 +50,9 @@ lv_obj_t *lv_file_select_box_create(lv_obj_t *parent) {
     lv_obj_set_user_data(file_table, userData);
     lv_obj_add_event_cb(file_table, file_table_click_event, LV_EVENT_VALUE_CHANGED, NULL);
     lv_obj_add_event_cb(file_table, file_table_delete_event, LV_EVENT_DELETE, NULL);
+    lv_obj_add_event_cb(file_table, file_table_scroll_event, LV_EVENT_SCROLL, NULL);
     lv_obj_add_event_cb(file_table, lv_file_table_long_pressed_event, LV_EVENT_LONG_PRESSED, NULL);
+    userData->timer = lv_timer_create(file_table_timer_cb, FILE_SELECT_REFRESH_PERIOD, file_table);
     lv_file_select_box_set_dir(file_table, "0:/");
     return file_table;
 }
@@ -44,10 +61,7 @@ static void delete_file_callback(uint16_t index, void *userdata) {
     lv_obj_t *table = userdata;
     FileSelectBox_UserData *fs_data = table->user_data;
 
-    if (index) {
-        fs_data->delete_filename = NULL;
-        return;
-    }
+    if (index) goto end;
 
     char *path = str_malloc_cat(fs_data->current_dir, fs_data->delete_filename, 0);
     if (path == NULL) goto err;
@@ -55,42 +69,45 @@ static void delete_file_callback(uint16_t index, void *userdata) {
     if (path[path_len - 1] == '/' || path[path_len - 1] == '\\') path[path_len - 1] = 0;
 
     char *gbk = UTF8_TO_GBK(path);
-    if (Fatfs_rm_rf(gbk) != FR_OK) goto err;
-    os_free(gbk);
-
     os_free(path);
+    if (gbk == NULL) goto err;
+    FRESULT res = FileService_rm_rf(gbk);
+    os_free(gbk);
+    if (res != FR_OK) goto err;
 
     MessageBox_info("删除文件", "关闭", "'%s'删除成功", fs_data->delete_filename);
-    fs_data->delete_filename = NULL;
     scan_file(userdata, fs_data->current_dir);
-    return;
+    goto end;
     err:
     MessageBox_info("删除文件", "关闭", "'%s'删除失败", fs_data->delete_filename);
+    end:
+    lv_mem_free(fs_data->delete_filename);
     fs_data->delete_filename = NULL;
 }
 
 static void lv_file_table_long_pressed_event(lv_event_t *event) {
     lv_obj_t *target = lv_event_get_target(event);
+    FileSelectBox_UserData *fs_data = target->user_data;
     uint16_t row, col;
     lv_table_get_selected_cell(target, &row, &col);
 
-    if (row >= lv_table_get_row_cnt(target) ||
-        col >= lv_table_get_col_cnt(target))
-        return;
-
-    if (lv_table_has_cell_ctrl(target, row, col, FILE_SELECT_BACK_CTRL))
+    if (row >= lv_table_get_row_cnt(target) || col != 0 || row < fs_data->offset || fs_data->delete_filename)
         return;
 
-    const char *filename = lv_table_get_cell_value(target, row, col);
-    FileSelectBox_UserData *fs_data = target->user_data;
-    fs_data->delete_filename = filename;
+    char name[FF_MAX_LFN * 3 + 2];
+    bool is_dir;
+    if (!file_table_get_entry(target, row, name, sizeof(name), &is_dir)) return;
+    fs_data->delete_filename = lv_mem_alloc(strlen(name) + 1);
+    LV_ASSERT_MALLOC(fs_data->delete_filename)
+    if (fs_data->delete_filename == NULL) return;
+    strcpy(fs_data->delete_filename, name);
 
-    if (lv_table_has_cell_ctrl(target, row, col, FILE_SELECT_DIR_CTRL)) {
+    if (is_dir) {
         MessageBox_question("删除文件", "是", "否", delete_file_callback,
-                            target, "是否删除文件夹'%s'?", filename);
+                            target, "是否删除文件夹'%s'?", name);
     } else {
         MessageBox_question("删除文件", "是", "否", delete_file_callback,
-                            target, "是否删除文件'%s'?", filename);
+                            target, "是否删除文件'%s'?", name);
     }
 }
 
@@ -111,7 +128,9 @@ void lv_file_select_box_set_dir(lv_obj_t *obj, const char *dir) {
     if (userData == NULL) return;
     int str_len = strlen(dir) + 1;
     if (userData->current_dir == NULL || userData->path_len < str_len) {
+        userData->path_len = str_len;
         userData->current_dir = lv_mem_realloc(userData->current_dir, str_len);
+        LV_ASSERT_MALLOC(userData->current_dir)
     }
     strcpy(userData->current_dir, dir);
     scan_file(obj, userData->current_dir);
@@ -135,30 +154,36 @@ static void file_table_click_event(lv_event_t *event) {
     if (row >= lv_table_get_row_cnt(file_table) || col != 0)
         return;
 
-    const char *filename = lv_table_get_cell_value(file_table, row, 0);
-    if (lv_table_has_cell_ctrl(file_table, row, 0, FILE_SELECT_DIR_CTRL)) {
-        /* 点击了一个文件夹，判断是返回上一级还是进入子文件夹 */
-        if (lv_table_has_cell_ctrl(file_table, row, 0, FILE_SELECT_BACK_CTRL)) {
-            /* 返回上一级，清除最后一个分隔符及之后的字符 */
-            size_t len = strlen(userData->current_dir);
-            userData->current_dir[len - 1] = '\0';
-            for (size_t i = len - 2; i > 0; i--) {
-                if (userData->current_dir[i] == '/') break;
-                userData->current_dir[i] = '\0';
-            }
-        } else {
-            /* 进入子文件夹，拼接路径名 */
-            size_t new_len = strlen(userData->current_dir) + strlen(filename) + 1;
-            /* 如果内存不足，重新分配，并刷新path_label指针 */
-            if (userData->path_len < new_len) {
-                userData->path_len = new_len;
-                userData->current_dir = lv_mem_realloc(userData->current_dir, userData->path_len);
-                LV_ASSERT_MALLOC(userData->current_dir)
-            }
-            strcat(userData->current_dir, filename);
-            if (userData->path_change_callback)
-                userData->path_change_callback(file_table, userData->current_dir);
+    if (row < userData->offset) {
+        /* 返回上一级，清除最后一个分隔符及之后的字符 */
+        size_t len = strlen(userData->current_dir);
+        userData->current_dir[len - 1] = '\0';
+        for (size_t i = len - 2; i > 0; i--) {
+            if (userData->current_dir[i] == '/') break;
+            userData->current_dir[i] = '\0';
         }
+        if (userData->path_change_callback)
+            userData->path_change_callback(file_table, userData->current_dir);
+        scan_file(file_table, userData->current_dir);
+        lv_mem_free(userData->selected_file);
+        userData->selected_file = NULL;
+        return;
+    }
+
+    char filename[FF_MAX_LFN * 3 + 2];
+    bool is_dir;
+    if (!file_table_get_entry(file_table, row, filename, sizeof(filename), &is_dir)) return;
+    if (is_dir) {
+        /* 进入子文件夹，拼接路径名 */
+        size_t new_len = strlen(userData->current_dir) + strlen(filename) + 1;
+        if (userData->path_len < new_len) {
+            userData->path_len = new_len;
+            userData->current_dir = lv_mem_realloc(userData->current_dir, userData->path_len);
+            LV_ASSERT_MALLOC(userData->current_dir)
+        }
+        strcat(userData->current_dir, filename);
+        if (userData->path_change_callback)
+            userData->path_change_callback(file_table, userData->current_dir);
         /* 重新扫描文件夹 */
         scan_file(file_table, userData->current_dir);
         lv_mem_free(userData->selected_file);
@@ -175,65 +200,148 @@ static void file_table_click_event(lv_event_t *event) {
     }
 }
 
-static void scan_file(lv_obj_t *obj, const char *dir) {
-    char *buf = UTF8_TO_GBK(dir);
-    buf[strlen(buf) - 1] = 0;
+/**
+ * 读取表格行对应的目录项，文件夹名称末尾加上分隔符
+ */
+static int file_table_get_entry(lv_obj_t *obj, uint16_t row, char *name, size_t size, bool *is_dir) {
+    FileSelectBox_UserData *userData = lv_obj_get_user_data(obj);
+    BYTE attr;
+    if (userData->snap == NULL || row < userData->offset ||
+        !DirSnapshot_get(userData->snap, row - userData->offset, name, size - 1, &attr))
+        return 0;
+    *is_dir = attr & AM_DIR;
+    if (*is_dir) strcat(name, "/");
+    return 1;
+}
 
-    int index = 0;
-    /* 不是根目录第一项加上一级 */
-    if (buf[2] != 0) {
-        lv_table_set_cell_value(obj, 0, 0, "返回上一级");
-        lv_table_add_cell_ctrl(obj, 0, 0,
-                               FILE_SELECT_DIR_CTRL | FILE_SELECT_BACK_CTRL);
-        index = 1;
+/**
+ * 直接释放单元格文字，目录项行高固定，不需要lv_table重新计算行高
+ */
+static void file_table_clear_row(lv_table_t *table, uint16_t row) {
+    lv_mem_free(table->cell_data[row]);
+    table->cell_data[row] = NULL;
+}
+
+/**
+ * 直接写入单元格文字，避免lv_table_set_cell_value每次从该行起重新计算所有行高，
+ * 单元格数据第一个字节为控制字
+ */
+static void file_table_fill_row(lv_obj_t *obj, uint16_t row) {
+    lv_table_t *table = (lv_table_t *) obj;
+    char name[FF_MAX_LFN * 3 + 2];
+    bool is_dir;
+    if (!file_table_get_entry(obj, row, name, sizeof(name), &is_dir)) return;
+    size_t len = strlen(name);
+    char *cell = lv_mem_realloc(table->cell_data[row], len + 2);
+    LV_ASSERT_MALLOC(cell)
+    if (cell == NULL) return;
+    cell[0] = LV_TABLE_CELL_CTRL_TEXT_CROP | (is_dir ? FILE_SELECT_DIR_CTRL : 0);
+    memcpy(cell + 1, name, len + 1);
+    table->cell_data[row] = cell;
+}
+
+/**
+ * 表格行数与目录项数一致，只有可见区域附近的行填充文字
+ */
+static void file_table_bind_window(lv_obj_t *obj) {
+    lv_table_t *table = (lv_table_t *) obj;
+    FileSelectBox_UserData *userData = lv_obj_get_user_data(obj);
+    if (table->row_cnt == 0) return;
+
+    lv_coord_t row_h = table->row_h[table->row_cnt - 1];
+    if (row_h <= 0) row_h = 1;
+    int32_t scroll_y = lv_obj_get_scroll_y(obj);
+    int32_t first = scroll_y / row_h - FILE_SELECT_WINDOW_MARGIN;
+    int32_t last = (scroll_y + lv_obj_get_height(obj)) / row_h + FILE_SELECT_WINDOW_MARGIN + 1;
+    int32_t end = userData->offset + userData->shown;
+    if (first < userData->offset) first = userData->offset;
+    if (last > end) last = end;
+    if (first > last) first = last;
+
+    for (int32_t row = userData->bound_start; row < userData->bound_end; row++) {
+        if (row < first || row >= last) file_table_clear_row(table, row);
+    }
+    for (int32_t row = first; row < last; row++) {
+        if (row < userData->bound_start || row >= userData->bound_end) file_table_fill_row(obj, row);
     }
+    userData->bound_start = first;
+    userData->bound_end = last;
+    lv_obj_invalidate(obj);
+}
 
-    DIR root_dir;
-    FILINFO file_info;
-    FRESULT res = f_opendir(&root_dir, buf);
-    if (res != FR_OK) {
-        LV_LOG_ERROR("open dir %s error, return %d", buf, res);
-        lv_mem_free(buf);
-        return;
+/**
+ * 将后台已经读取的目录项同步到表格
+ */
+static void file_table_sync(lv_obj_t *obj) {
+    FileSelectBox_UserData *userData = lv_obj_get_user_data(obj);
+    uint32_t count = userData->snap ? userData->snap->count : 0;
+    if (count != userData->shown) {
+        userData->shown = count;
+        lv_table_set_row_cnt(obj, userData->offset + count);
     }
+    file_table_bind_window(obj);
+}
 
-    while (f_readdir(&root_dir, &file_info) == FR_OK) {
-        if (file_info.fname[0] == 0) break;
-        /* 跳过系统文件和隐藏文件 */
-        if (file_info.fattrib & (AM_HID | AM_SYS)) continue;
-
-        char *utf8 = GBK_TO_UTF8(file_info.fname);
-        lv_table_clear_cell_ctrl(obj, index, 0,
-                                 FILE_SELECT_DIR_CTRL | FILE_SELECT_BACK_CTRL);
-        if (file_info.fattrib & AM_DIR) {
-            lv_table_add_cell_ctrl(obj, index, 0, FILE_SELECT_DIR_CTRL);
-            lv_table_set_cell_value_fmt(obj, index, 0, "%s/", utf8);
-        } else {
-            lv_table_set_cell_value(obj, index, 0, utf8);
-        }
-        lv_mem_free(utf8);
-        index++;
+static void scan_file(lv_obj_t *obj, const char *dir) {
+    FileSelectBox_UserData *userData = lv_obj_get_user_data(obj);
+
+    DirSnapshot_release(userData->snap);
+    userData->snap = DirSnapshot_open(dir);
+    userData->error_reported = false;
+    if (userData->snap == NULL) LV_LOG_ERROR("open dir %s error", dir);
+
+    /* 清空表格，超出行数的单元格由lv_table释放 */
+    lv_table_t *table = (lv_table_t *) obj;
+    for (uint16_t row = userData->bound_start; row < userData->bound_end && row < table->row_cnt; row++)
+        file_table_clear_row(table, row);
+    userData->bound_start = userData->bound_end = 0;
+    userData->shown = 0;
+
+    /* 不是根目录第一项加上一级 */
+    userData->offset = strlen(dir) > 3 ? 1 : 0;
+    lv_table_set_row_cnt(obj, userData->offset);
+    if (userData->offset) {
+        lv_table_set_cell_value(obj, 0, 0, "返回上一级");
+        lv_table_add_cell_ctrl(obj, 0, 0, FILE_SELECT_DIR_CTRL | FILE_SELECT_BACK_CTRL);
     }
 
-    lv_table_set_row_cnt(obj, index);
+    lv_obj_scroll_to_y(obj, 0, LV_ANIM_OFF);
+    file_table_sync(obj);
+}
 
-    res = f_closedir(&root_dir);
-    if (res != FR_OK) {
-        LV_LOG_ERROR("close dir %s error, return %d", buf, res);
-        lv_mem_free(buf);
+static void file_table_timer_cb(lv_timer_t *timer) {
+    lv_obj_t *obj = timer->user_data;
+    FileSelectBox_UserData *userData = lv_obj_get_user_data(obj);
+    DirSnapshot *snap = userData->snap;
+    if (snap == NULL) return;
+
+    if (snap->stale) {
+        /* 目录内容被修改，重新读取并保持滚动位置 */
+        lv_coord_t scroll_y = lv_obj_get_scroll_y(obj);
+        scan_file(obj, userData->current_dir);
+        lv_obj_scroll_to_y(obj, scroll_y, LV_ANIM_OFF);
         return;
     }
-    lv_mem_free(buf);
+    if (snap->count != userData->shown) file_table_sync(obj);
+    if (snap->complete && snap->result != FR_OK && !userData->error_reported) {
+        LV_LOG_ERROR("read dir %s error, return %d", userData->current_dir, snap->result);
+        userData->error_reported = true;
+    }
+}
 
-    lv_obj_scroll_to_y(obj, 0, LV_ANIM_OFF);
+static void file_table_scroll_event(lv_event_t *event) {
+    file_table_bind_window(lv_event_get_target(event));
 }
 
 static void file_table_delete_event(lv_event_t *event) {
     lv_obj_t *target = lv_event_get_target(event);
     if (target != NULL) {
         FileSelectBox_UserData *userData = lv_obj_get_user_data(target);
+        lv_timer_del(userData->timer);
+        DirSnapshot_release(userData->snap);
         lv_mem_free(userData->current_dir);
         lv_mem_free(userData->selected_file);
+        lv_mem_free(userData->delete_filename);
         lv_mem_free(userData);
     }
 }
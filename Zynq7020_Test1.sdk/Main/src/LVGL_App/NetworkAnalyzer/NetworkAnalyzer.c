@@ -5,6 +5,7 @@
 #include <math.h>
 #include "NetworkAnalyzer.h"
 #include "LVGL_Utils/Chart_zoom_plugin.h"
+#include "LVGL_Utils/Chart_trace_plugin.h"
 #include "Controller/ADC_Controller.h"
 #include "Controller/DDS_Controller.h"
 #include "FreeRTOS.h"
@@ -54,8 +55,9 @@ void NetworkAnalyzer_create(lv_obj_t *parent) {
     lv_chart_set_point_count(chart, MAX_POINTS);
     lv_chart_set_div_line_count(chart, 12 + 1, 15 + 1);
 
-    /* 安装缩放插件 */
+    /* 安装缩放插件与波形快速绘制插件 */
     lv_chart_install_zoom_plugin(chart);
+    lv_chart_install_trace_plugin(chart, LV_OPA_TRANSP);
 
     start_btn = lv_btn_create(tile1);
     start_btn_text = lv_label_create(start_btn);
@@ -133,7 +135,7 @@ void NetworkAnalyzer_create(lv_obj_t *parent) {
     lv_obj_add_event_cb(voltage_slider, voltage_slider_value_change_cb, LV_EVENT_VALUE_CHANGED, voltage_slider_label);
     lv_event_send(voltage_slider, LV_EVENT_VALUE_CHANGED, NULL);
 
-    lv_timer_create(timer_cb, 10, parent);
+    zynq_lvgl_data_timer_create(timer_cb, parent);
 }
 
 static void scan_task(void *param) {
@@ -216,7 +218,7 @@ void timer_cb(lv_timer_t *timer) {
 
     if (!lv_obj_has_flag(start_btn, LV_OBJ_FLAG_CLICKABLE)) {
         lv_label_set_text_fmt(start_btn_text, "%d%%", plan);
-        lv_chart_refresh(chart);
+        lv_chart_trace_refresh(chart);
     }
 }
 
@@ -7,6 +7,12 @@
 #include "LVGL_Utils/slider.h"
 #include "math.h"
 #include "LVGL_Utils/Chart_zoom_plugin.h"
+#include "LVGL_Utils/Chart_trace_plugin.h"
+#include "LVGL_Utils/MessageBox.h"
+#include "LVGL_Zynq_Init/zynq_lvgl_init.h"
+#include "Oscilloscope_export.h"
+
+#define OSC_TRACE_PERSISTENCE LV_OPA_50   //!< 波形余辉系数
 
 static lv_obj_t *chart;
 static lv_chart_cursor_t *cursor_ver;
@@ -37,6 +43,7 @@ static void trigger_level_slider_cb(lv_event_t *e);
 static void measure_checkbox_cb(lv_event_t *e);
 static void trigger_position_slider_cb(lv_event_t *e);
 static void scroll_btn_cb(lv_event_t *e);
+static void save_btn_cb(lv_event_t *e);
 
 void Oscilloscope_create(lv_obj_t *parent) {
     lv_obj_t *tv = lv_tileview_create(parent);
@@ -53,11 +60,12 @@ void Oscilloscope_create(lv_obj_t *parent) {
     lv_obj_set_style_size(chart, 0, LV_PART_INDICATOR);
     series = lv_chart_add_series(chart, lv_palette_main(LV_PALETTE_RED), LV_CHART_AXIS_PRIMARY_Y);
     lv_chart_set_ext_y_array(chart, series, ADC_Data);
-    lv_chart_set_point_count(chart, 4096);
+    lv_chart_set_point_count(chart, ADC_DATA_LEN);
     lv_chart_set_range(chart, LV_CHART_AXIS_PRIMARY_Y, -5000, 5000);
     cursor_hor = lv_chart_add_cursor(chart, lv_palette_main(LV_PALETTE_BLUE), LV_DIR_HOR);
     cursor_ver = lv_chart_add_cursor(chart, lv_palette_main(LV_PALETTE_YELLOW), LV_DIR_VER);
     lv_chart_install_zoom_plugin(chart);
+    lv_chart_install_trace_plugin(chart, OSC_TRACE_PERSISTENCE);
     /**
      * x轴缩放控件组
      */
@@ -93,6 +101,15 @@ void Oscilloscope_create(lv_obj_t *parent) {
     lv_obj_align_to(scroll_btn, tile1, LV_ALIGN_BOTTOM_MID, 0, -10);
     lv_obj_add_event_cb(scroll_btn, scroll_btn_cb, LV_EVENT_CLICKED, tv);
 
+    /**
+     * 保存波形按钮
+     */
+    lv_obj_t *save_btn = lv_btn_create(tile1);
+    lv_obj_t *save_label = lv_label_create(save_btn);
+    lv_label_set_text_static(save_label, "保存波形");
+    lv_obj_align_to(save_btn, scroll_btn, LV_ALIGN_OUT_TOP_MID, 0, -10);
+    lv_obj_add_event_cb(save_btn, save_btn_cb, LV_EVENT_CLICKED, NULL);
+
     /**
      * 调整触发方式控件组
      */
@@ -161,7 +178,7 @@ void Oscilloscope_create(lv_obj_t *parent) {
     /**
      * 其他
      */
-    lv_timer_create(adc_timer_cb, 1, chart);
+    zynq_lvgl_data_timer_create(adc_timer_cb, chart);
 }
 
 /**
@@ -176,6 +193,8 @@ static void adc_timer_cb(lv_timer_t *timer) {
     LV_UNUSED(timer);
     bool triggered;
     if (ADC_get_data(&triggered) == XST_SUCCESS) {
+        /* ADC_Data每次采集后指向新的缓冲区 */
+        lv_chart_set_ext_y_array(chart, series, ADC_Data);
         int16_t trigger_level = ADC_get_trigger_level();
         float self_height = lv_obj_get_self_height(chart);
         lv_coord_t offset = (lv_obj_get_height(chart) - lv_chart_get_window_height(chart)) / 2;
@@ -255,7 +274,7 @@ static void adc_timer_cb(lv_timer_t *timer) {
         lv_label_set_text(measure_text_label, buf);
         lv_mem_free(buf2);
         lv_mem_free(buf);
-        lv_chart_refresh(chart);
+        lv_chart_trace_refresh(chart);
     }
     xSemaphoreGive(ADC_Mutex);
 }
@@ -291,4 +310,13 @@ static void trigger_position_slider_cb(lv_event_t *e) {
 static void scroll_btn_cb(lv_event_t *e) {
     lv_obj_t *tv = lv_event_get_user_data(e);
     lv_obj_set_tile_id(tv, 0, 1, LV_ANIM_ON);
+}
+
+static void save_btn_cb(lv_event_t *e) {
+    LV_UNUSED(e);
+    if (xSemaphoreTake(ADC_Mutex, pdMS_TO_TICKS(100)) != pdTRUE) return;
+    BaseType_t res = Oscilloscope_export_wav(ADC_Data, ADC_DATA_LEN, ADC_SAMPLE_RATE);
+    xSemaphoreGive(ADC_Mutex);
+    if (res != pdPASS)
+        MessageBox_info("保存波形", "OK", "上一次保存尚未完成");
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+//
+// Created by yaoji on 2022/5/2.
+//
+
+#include "Oscilloscope_export.h"
+#include "LVGL_Utils/MessageBox.h"
+#include "lvgl.h"
+#include "task.h"
+#include "queue.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "WAV_encoder/wav_encoder.h"
+#include "DS1337_Driver/DS1337_Driver.h"
+#include "LVGL_Zynq_Init/zynq_lvgl_init.h"
+#include "FileService/FileService.h"
+#include "ff.h"
+
+#define EXPORT_FULL_SCALE_MV (5000)
+/*
+ * 栈用量：任务帧(FILINFO约290B、文件名、struct tm)约0.5KB，
+ * 加上最深的调用链MessageBox(LVGL建对象+格式化)约1.5KB或wav_save(FIL约0.6KB+FileService)约1KB，
+ * 峰值约2KB，取两倍余量
+ */
+#define EXPORT_STACK_SIZE (1024)
+
+typedef struct {
+    uint32_t sample_rate;
+    uint32_t len;
+    int16_t data[];
+} wav_export_t;
+
+static QueueHandle_t export_queue;
+static TaskHandle_t export_task_handle;
+
+static void Oscilloscope_export_task(void *p) {
+    wav_export_t *wav;
+
+    for (;;) {
+        if (xQueuePeek(export_queue, &wav, portMAX_DELAY) == pdTRUE) {
+            char filename[64] = {0};
+            FILINFO file_info;
+            int save_res = XST_FAILURE;
+
+            xSemaphoreTake(LVGL_Mutex, portMAX_DELAY);
+            lv_obj_t *messagebox = MessageBox_wait("请稍等", "正在保存波形");
+            xSemaphoreGive(LVGL_Mutex);
+
+            FRESULT res = FileService_stat("0:/Waveform", &file_info);
+            if (res == FR_NO_FILE) res = FileService_mkdir("0:/Waveform");
+            if (res == FR_OK) {
+                struct tm t;
+                int index = 0;
+                DS1337_GetTime(NULL, &t);
+                do {
+                    sprintf(filename, "0:/Waveform/%04d-%02d-%02d_%02d-%02d-%02d_%d.wav",
+                            t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, index);
+                    res = FileService_stat(filename, &file_info);
+                    if (res == FR_OK) index++;
+                } while (res == FR_OK);
+                if (res == FR_NO_FILE)
+                    save_res = wav_save(filename, wav->sample_rate, 1, wav->data, wav->len);
+            }
+
+            xSemaphoreTake(LVGL_Mutex, portMAX_DELAY);
+            lv_msgbox_close(messagebox);
+            if (save_res == XST_SUCCESS) {
+                MessageBox_info("保存波形", "OK", "波形保存至 %s", filename);
+                LV_LOG_INFO("save waveform %s", filename);
+            } else {
+                MessageBox_info("保存波形", "OK", "波形保存失败");
+                LV_LOG_ERROR("save waveform error");
+            }
+            xSemaphoreGive(LVGL_Mutex);
+
+            xQueueReceive(export_queue, &wav, portMAX_DELAY);
+            os_free(wav);
+        }
+    }
+}
+
+BaseType_t Oscilloscope_export_wav(const int16_t *data, uint32_t len, uint32_t sample_rate) {
+    if (export_task_handle == NULL) {
+        export_queue = xQueueCreate(1, sizeof(wav_export_t *));
+        configASSERT(export_queue);
+        configASSERT(xTaskCreate(Oscilloscope_export_task, "wav export", EXPORT_STACK_SIZE,
+                                 NULL, uxTaskPriorityGet(NULL), &export_task_handle));
+    }
+    if (uxQueueSpacesAvailable(export_queue) == 0) return pdFAIL;
+
+    wav_export_t *wav = os_malloc(sizeof(wav_export_t) + len * sizeof(int16_t));
+    if (wav == NULL) return pdFAIL;
+    wav->sample_rate = sample_rate;
+    wav->len = len;
+    // mV转换为16位满量程
+    for (uint32_t i = 0; i < len; i++) {
+        int32_t v = data[i] * INT16_MAX / EXPORT_FULL_SCALE_MV;
+        wav->data[i] = v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v;
+    }
+    if (xQueueSendToBack(export_queue, &wav, 0) != pdTRUE) {
+        os_free(wav);
+        return pdFAIL;
+    }
+    return pdPASS;
+}
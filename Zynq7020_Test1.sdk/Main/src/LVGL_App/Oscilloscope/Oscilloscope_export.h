@@ -0,0 +1,21 @@
+//
+// Created by yaoji on 2022/5/2.
+//
+
+#ifndef ZYNQ7020_OSCILLOSCOPE_EXPORT_H
+#define ZYNQ7020_OSCILLOSCOPE_EXPORT_H
+
+#include "FreeRTOS.h"
+#include "portmacro.h"
+#include <stdint.h>
+
+/**
+ * 复制一帧波形并交给后台任务保存为wav文件，保存至 0:/Waveform
+ * @param data 波形数据，单位mV，满量程±5000mV
+ * @param len 采样点数
+ * @param sample_rate 采样率
+ * @return 上一次保存未完成时返回pdFAIL
+ */
+BaseType_t Oscilloscope_export_wav(const int16_t *data, uint32_t len, uint32_t sample_rate);
+
+#endif //ZYNQ7020_OSCILLOSCOPE_EXPORT_H
@@ -1,6 +1,10 @@
 #include "Setup.h"
 
 #include "Fatfs_init/Fatfs_Driver.h"
+#include "DiskCache/DiskCache.h"
+#include "DiskCache/DiskBench.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "DMA_Driver/DMA_Mem.h"
 #include "DS1337_Driver/DS1337_Driver.h"
 #include "LVGL_Utils/MessageBox.h"
 #include "SystemConfig/SystemConfig.h"
@@ -22,6 +26,9 @@ static lv_style_t style_title, style_sec_title, style_content;
 
 static lv_obj_t *sd_info;
 static lv_obj_t *emmc_info;
+static lv_obj_t *cache_info;
+static lv_obj_t *mem_info;
+static lv_obj_t *stack_info;
 static lv_obj_t *time_info;
 static lv_obj_t *net_info;
 static lv_obj_t *sensor_info;
@@ -32,6 +39,8 @@ static void calibration_time_btn_cb(lv_event_t *e);
 static void wait_timer_cb(lv_timer_t *timer);
 static void flash_MsgBox_event_cb(uint16_t index, void *userdata);
 static void flash_btn_event_cb(lv_event_t *e);
+static void bench_btn_event_cb(lv_event_t *e);
+static void bench_wait_timer_cb(lv_timer_t *timer);
 
 static void signal_dropdown_cb(lv_event_t *event);
 
@@ -127,6 +136,11 @@ void Setup_create(lv_obj_t *parent) {
     lv_label_set_text_static(fs_title, "文件系统信息");
     lv_obj_align_to(fs_title, fw_info, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 20);
 
+    lv_obj_t *bench_btn = lv_btn_create(parent);
+    lv_label_set_text_static(lv_label_create(bench_btn), "存储测速");
+    lv_obj_add_event_cb(bench_btn, bench_btn_event_cb, LV_EVENT_CLICKED, NULL);
+    lv_obj_align_to(bench_btn, fs_title, LV_ALIGN_OUT_RIGHT_MID, 30, 0);
+
     lv_obj_t *sd_title = lv_label_create(parent);
     lv_label_set_text_static(sd_title, "SD Card:");
     lv_obj_add_style(sd_title, &style_sec_title, 0);
@@ -146,10 +160,42 @@ void Setup_create(lv_obj_t *parent) {
     lv_obj_add_style(emmc_info, &style_content, 0);
     lv_obj_align_to(emmc_info, emmc_title, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 10);
 
+    lv_obj_t *cache_title = lv_label_create(parent);
+    lv_label_set_text_fmt(cache_title, "磁盘缓存(%dKB, %d路组相联):", DISK_CACHE_SIZE / 1024, DISK_CACHE_WAYS);
+    lv_obj_add_style(cache_title, &style_sec_title, 0);
+    lv_obj_align_to(cache_title, emmc_info, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 10);
+
+    cache_info = lv_label_create(parent);
+    lv_label_set_text_static(cache_info, "\n");
+    lv_obj_add_style(cache_info, &style_content, 0);
+    lv_obj_align_to(cache_info, cache_title, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 10);
+
+    lv_obj_t *mem_title = lv_label_create(parent);
+    lv_label_set_text_static(mem_title, "内存使用");
+    lv_obj_add_style(mem_title, &style_title, 0);
+    lv_obj_align_to(mem_title, cache_info, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 20);
+
+    mem_info = lv_label_create(parent);
+    lv_label_set_text_static(mem_info, "\n\n\n\n\n\n\n\n");
+    lv_obj_add_style(mem_info, &style_content, 0);
+    lv_obj_align_to(mem_info, mem_title, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 10);
+
+    lv_obj_t *stack_title = lv_label_create(parent);
+    lv_label_set_text_static(stack_title, "任务栈剩余最小值:");
+    lv_obj_add_style(stack_title, &style_sec_title, 0);
+    lv_obj_align_to(stack_title, mem_info, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 10);
+
+    stack_info = lv_label_create(parent);
+    lv_label_set_text_static(stack_info, "\n\n");
+    lv_obj_set_width(stack_info, lv_pct(90));
+    lv_label_set_long_mode(stack_info, LV_LABEL_LONG_WRAP);
+    lv_obj_add_style(stack_info, &style_content, 0);
+    lv_obj_align_to(stack_info, stack_title, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 10);
+
     lv_obj_t *time_title = lv_label_create(parent);
     lv_label_set_text_static(time_title, "时间设置");
     lv_obj_add_style(time_title, &style_title, 0);
-    lv_obj_align_to(time_title, emmc_info, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 20);
+    lv_obj_align_to(time_title, stack_info, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 20);
 
     time_info = lv_label_create(parent);
     lv_obj_align_to(time_info, time_title, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 10);
@@ -230,11 +276,74 @@ static void flash_btn_event_cb(lv_event_t *e) {
     }
 }
 
+static void bench_wait_timer_cb(lv_timer_t *timer) {
+    if (!DiskBench_isfinished()) return;
+    lv_msgbox_close(timer->user_data);
+    lv_timer_del(timer);
+    char text[2][96];
+    for (int i = 0; i < 2; i++) {
+        const DiskBench_Result *result = DiskBench_get_result(i);
+        if (result->result == FR_OK) {
+            lv_snprintf(text[i], sizeof(text[i]), "顺序写 %.1fMB/s, 顺序读 %.1fMB/s\n随机写 %.2fMB/s, 随机读 %.2fMB/s",
+                        result->seq_write, result->seq_read, result->rand_write, result->rand_read);
+        } else {
+            lv_snprintf(text[i], sizeof(text[i]), "测试失败, 代码%d", result->result);
+        }
+    }
+    MessageBox_info("存储测速", "关闭", "SD卡:\n%s\nEMMC:\n%s", text[0], text[1]);
+}
+
+static void bench_btn_event_cb(lv_event_t *e) {
+    LV_UNUSED(e);
+    if (DiskBench_start() != XST_SUCCESS) {
+        MessageBox_info("错误", "关闭", "创建存储测速任务失败");
+        return;
+    }
+    lv_obj_t *messagebox = MessageBox_wait("请稍等", "正在测试存储读写速度 . . .");
+    lv_timer_create(bench_wait_timer_cb, 500, messagebox);
+}
+
 static void calibration_time_btn_cb(lv_event_t *e) {
     LV_UNUSED(e);
     sntp_start();
 }
 
+static void refresh_mem_info() {
+    char buf[512];
+    int len = 0;
+    for (int i = 0; i < OS_MEM_TAG_NUM; i++) {
+        os_mem_tag_stats_t tag;
+        os_mem_get_tag_stats(i, &tag);
+        len += lv_snprintf(buf + len, sizeof(buf) - len, "%s: 当前 %uKB, 峰值 %uKB, %u块\n",
+                           os_mem_tag_name(i), (unsigned) tag.used / 1024, (unsigned) tag.peak / 1024,
+                           (unsigned) tag.count);
+    }
+    os_mem_stats_t mem;
+    os_mem_get_stats(&mem);
+    DMA_Mem_Stats dma;
+    DMA_Mem_get_stats(&dma);
+    lv_snprintf(buf + len, sizeof(buf) - len,
+                "小块区: 已划分 %uKB, 使用 %uKB, 峰值 %uKB\n"
+                "大块区: 总计 %uMB, 使用 %uKB, 峰值 %uKB, 最大空闲块 %uKB, 碎片率 %u%%\n"
+                "DMA: 总计 %uKB, 使用 %uKB, 峰值 %uKB",
+                (unsigned) mem.small_reserved / 1024, (unsigned) mem.small_used / 1024,
+                (unsigned) mem.small_peak / 1024,
+                (unsigned) mem.large_total / (1024 * 1024), (unsigned) mem.large_used / 1024,
+                (unsigned) mem.large_peak / 1024, (unsigned) mem.large_free_max / 1024,
+                (unsigned) mem.fragmentation,
+                DMA_MEM_SIZE / 1024, (unsigned) dma.used / 1024, (unsigned) dma.peak / 1024);
+    lv_label_set_text(mem_info, buf);
+
+    os_mem_task_stack_t stacks[16];
+    int task_num = os_mem_get_task_stacks(stacks, 16);
+    len = 0;
+    buf[0] = 0;
+    for (int i = 0; i < task_num && len < (int) sizeof(buf); i++) {
+        len += lv_snprintf(buf + len, sizeof(buf) - len, "%s %uB  ", stacks[i].name, (unsigned) stacks[i].free_min);
+    }
+    lv_label_set_text(stack_info, task_num ? buf : "未开启configUSE_TRACE_FACILITY");
+}
+
 static void refresh_timer_cb(lv_timer_t *timer) {
     if (!lv_obj_is_visible(timer->user_data))
         return;
@@ -257,6 +366,21 @@ static void refresh_timer_cb(lv_timer_t *timer) {
         lv_label_set_text_fmt(emmc_info, "EMMC未挂载, 代码%d", Fatfs_GetMountStatus(1));
     }
 
+    DiskCache_Stats sd_stats, emmc_stats;
+    uint32_t sd_dirty = DiskCache_get_stats(SD_INDEX, &sd_stats);
+    uint32_t emmc_dirty = DiskCache_get_stats(EMMC_INDEX, &emmc_stats);
+    lv_label_set_text_fmt(cache_info,
+                          "SD: 命中率 %d%%, 命中 %u, 未命中 %u, 预读 %u, 回写 %u, 脏扇区 %u\n"
+                          "EMMC: 命中率 %d%%, 命中 %u, 未命中 %u, 预读 %u, 回写 %u, 脏扇区 %u",
+                          (int) DiskCache_hit_rate(&sd_stats), (unsigned) sd_stats.read_hits,
+                          (unsigned) sd_stats.read_misses, (unsigned) sd_stats.prefetched,
+                          (unsigned) sd_stats.writebacks, (unsigned) sd_dirty,
+                          (int) DiskCache_hit_rate(&emmc_stats), (unsigned) emmc_stats.read_hits,
+                          (unsigned) emmc_stats.read_misses, (unsigned) emmc_stats.prefetched,
+                          (unsigned) emmc_stats.writebacks, (unsigned) emmc_dirty);
+
+    refresh_mem_info();
+
     int speed = network_linkSpeed();
     if (speed > 0) {
         char ip_str[3][IP4ADDR_STRLEN_MAX];
@@ -4,6 +4,7 @@
 
 #include "SignalGenerator_fromFile.h"
 #include "Fatfs_init/Fatfs_Driver.h"
+#include "FileService/FileService.h"
 #include "FileDecoder/FileDecoder.h"
 #include "LVGL_Utils/MessageBox.h"
 #include "Controller/DDS_Controller.h"
@@ -60,12 +61,12 @@ void fromFile_create(lv_obj_t *parent) {
 
     char *buf = UTF8_TO_GBK("0:/信号发生器");
     DIR dir;
-    FRESULT res = f_opendir(&dir, buf);
+    FRESULT res = FileService_opendir(&dir, buf);
     if (res == FR_OK) {
         lv_file_select_box_set_dir(file_table, "0:/信号发生器/");
-        f_closedir(&dir);
+        FileService_closedir(&dir);
     } else if (res == FR_NO_PATH) {
-        res = f_mkdir(buf);
+        res = FileService_mkdir(buf);
         if (res != FR_OK) {
             LV_LOG_ERROR("创建文件夹 \"0:/信号发生器\" 失败");
         } else {
@@ -107,6 +108,22 @@ static void file_table_click_cb(lv_obj_t *obj, const char *path, const char *fil
         } else {
             LV_LOG_ERROR("%s", FileDecoder_status_string(status));
         }
+    } else if (type == FDType_wav) {
+        FDWavInfo info;
+        FDStatus status = FileDecoder_get_wav_info(path, &info);
+        if (status == FDStatus_ok) {
+            char channel_name[16];
+            for (int i = 0; i < info.channels; i++) {
+                sprintf(channel_name, "声道%d", i + 1);
+                lv_dropdown_add_option(field_list_dropdown, channel_name, LV_DROPDOWN_POS_LAST);
+            }
+            if (info.channels > 1) lv_obj_clear_state(field_list_dropdown, LV_STATE_DISABLED);
+            lv_obj_clear_state(start_btn, LV_STATE_DISABLED);
+            LV_LOG_USER("wav %dHz %dbit %d声道 %d点", info.sample_rate, info.bits_per_sample, info.channels, info.frames);
+        } else {
+            lv_obj_add_state(start_btn, LV_STATE_DISABLED);
+            LV_LOG_ERROR("%s", FileDecoder_status_string(status));
+        }
     } else {
         lv_obj_clear_state(start_btn, LV_STATE_DISABLED);
         lv_dropdown_set_text(field_list_dropdown, FileDecoder_type_string(type));
@@ -9,6 +9,8 @@
 #include "xaxidma.h"
 #include "check.h"
 #include "LVGL_Utils/Chart_zoom_plugin.h"
+#include "LVGL_Utils/Chart_trace_plugin.h"
+#include "LVGL_Zynq_Init/zynq_lvgl_init.h"
 #include <arm_math.h>
 
 static lv_obj_t *chart;
@@ -33,8 +35,9 @@ void SpectrumAnalyzer_create(lv_obj_t *parent) {
     lv_chart_set_point_count(chart, 4096);
     lv_chart_set_div_line_count(chart, 12 + 1, 15 + 1);
 
-    /* 安装缩放插件 */
+    /* 安装缩放插件与波形快速绘制插件 */
     lv_chart_install_zoom_plugin(chart);
+    lv_chart_install_trace_plugin(chart, LV_OPA_TRANSP);
 
     /**
      * 水平缩放
@@ -60,7 +63,7 @@ void SpectrumAnalyzer_create(lv_obj_t *parent) {
     lv_obj_add_event_cb(zoom_x_slider, chart_change_event_cb, LV_EVENT_VALUE_CHANGED, NULL);
     lv_event_send(zoom_x_slider, LV_EVENT_VALUE_CHANGED, NULL);
 
-    lv_timer_create(fft_timer_cb, 1, parent);
+    zynq_lvgl_data_timer_create(fft_timer_cb, parent);
 }
 
 static inline float inRange(float _min, float _v, float _max) {
@@ -75,7 +78,7 @@ static void fft_timer_cb(lv_timer_t *timer) {
         for (int i = 0; i < 4096; i++) {
             data[i] = inRange(-120.0, FFT_OriginalData[i], 0.0) * 100;
         }
-        lv_chart_refresh(chart);
+        lv_chart_trace_refresh(chart);
     }
 }
 
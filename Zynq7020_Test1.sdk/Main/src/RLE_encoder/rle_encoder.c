@@ -0,0 +1,61 @@
+//
+// Created by yaoji on 2022/5/14.
+//
+
+#include <stddef.h>
+#include "rle_encoder.h"
+
+#define RLE_RGB_MASK 0x00ffffff
+
+typedef struct {
+    uint8_t *p;
+    uint8_t *literal;               //!< 正在追加的不重复像素段的控制字节，NULL表示没有
+} rle_writer;
+
+static inline void rle_put_pixel(rle_writer *w, uint32_t px) {
+    w->p[0] = px;
+    w->p[1] = px >> 8;
+    w->p[2] = px >> 16;
+    w->p += 3;
+}
+
+/**
+ * 输出n个相同的像素
+ */
+static inline void rle_emit(rle_writer *w, uint32_t px, uint32_t n) {
+    if (n >= 2) {
+        *w->p++ = n + 126;
+        rle_put_pixel(w, px);
+        w->literal = NULL;
+        return;
+    }
+    if (w->literal && *w->literal < RLE_LITERAL_MAX - 1) {
+        (*w->literal)++;
+    } else {
+        w->literal = w->p++;
+        *w->literal = 0;
+    }
+    rle_put_pixel(w, px);
+}
+
+uint32_t rle_encode(const lv_color_t *src, uint32_t stride, uint32_t w, uint32_t h, uint8_t *out) {
+    rle_writer writer = {.p = out, .literal = NULL};
+    uint32_t run_px = src[0].full & RLE_RGB_MASK;
+    uint32_t run_n = 0;
+
+    for (uint32_t y = 0; y < h; y++) {
+        const lv_color_t *line = src + y * stride;
+        for (uint32_t x = 0; x < w; x++) {
+            uint32_t px = line[x].full & RLE_RGB_MASK;
+            if (px == run_px && run_n < RLE_RUN_MAX) {
+                run_n++;
+                continue;
+            }
+            rle_emit(&writer, run_px, run_n);
+            run_px = px;
+            run_n = 1;
+        }
+    }
+    if (run_n) rle_emit(&writer, run_px, run_n);
+    return writer.p - out;
+}
@@ -0,0 +1,38 @@
+//
+// Created by yaoji on 2022/5/14.
+//
+
+#ifndef ZYNQ7020_RLE_ENCODER_H
+#define ZYNQ7020_RLE_ENCODER_H
+
+#include <stdint.h>
+#include "src/misc/lv_color.h"
+
+/**
+ * 以像素为单位的行程编码，按行扫描，行与行之间的行程连续
+ * 控制字节c < 128: 后跟c+1个不同的像素
+ * 控制字节c >= 128: 后跟1个像素，重复c-126次(2~129)
+ * 像素为3字节 B G R，忽略alpha
+ */
+
+#define RLE_LITERAL_MAX 128
+#define RLE_RUN_MAX 129
+
+/**
+ * 编码结果的最大长度，全部为不重复像素时
+ * @param px 像素数
+ */
+#define RLE_ENCODE_BOUND(px) ((px) * 3 + ((px) + RLE_LITERAL_MAX - 1) / RLE_LITERAL_MAX)
+
+/**
+ * 编码图像中的一个矩形区域
+ * @param src 区域左上角像素
+ * @param stride 图像一行的像素数
+ * @param w 区域宽度
+ * @param h 区域高度
+ * @param out [out] 至少RLE_ENCODE_BOUND(w * h)字节
+ * @return 编码长度
+ */
+uint32_t rle_encode(const lv_color_t *src, uint32_t stride, uint32_t w, uint32_t h, uint8_t *out);
+
+#endif //ZYNQ7020_RLE_ENCODER_H
@@ -1,6 +1,7 @@
 #include "SystemConfig.h"
 
 #include "Fatfs_init/Fatfs_Driver.h"
+#include "FileService/FileService.h"
 #include "Flash_Driver/qspi_g128_flash.h"
 #include "FreeRTOS.h"
 #include "FreeRTOS_Mem/FreeRTOS_Mem.h"
@@ -36,7 +37,7 @@ static void ProgramFLASH_task(void *param) {
     FRESULT res;
     FIL bin_file;
     int start_time = getTime_millis();
-    res = f_open(&bin_file, path, FA_READ);
+    res = FileService_open(&bin_file, path, FA_READ);
     if (res != FR_OK) {
         xil_printf("open file %s failed res=%d\r\n", param, res);
     }
@@ -51,7 +52,7 @@ static void ProgramFLASH_task(void *param) {
         goto end;
     }
     UINT rdsize;
-    f_read(&bin_file, buf1, size, &rdsize);
+    FileService_read(&bin_file, buf1, size, &rdsize);
     if (rdsize != size) {
         xil_printf("error ");
     }
@@ -65,7 +66,7 @@ static void ProgramFLASH_task(void *param) {
     os_free(buf1);
     os_free(buf2);
     os_free(buf3);
-    f_close(&bin_file);
+    FileService_close(&bin_file);
     vTaskDelete(NULL);
 }
 
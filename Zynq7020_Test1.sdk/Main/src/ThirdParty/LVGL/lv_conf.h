@@ -61,9 +61,12 @@
 
 #else       /*LV_MEM_CUSTOM*/
 #  define LV_MEM_CUSTOM_INCLUDE <FreeRTOS_Mem/FreeRTOS_Mem.h>   /*Header for the dynamic memory function*/
-#  define LV_MEM_CUSTOM_ALLOC   os_malloc
+#  define LV_MEM_CUSTOM_ALLOC(size) os_malloc_tag(size, OS_MEM_TAG_LVGL)
 #  define LV_MEM_CUSTOM_FREE    os_free
 #  define LV_MEM_CUSTOM_REALLOC os_realloc
+/*Build lv_tlsf even with a custom allocator, os_malloc uses it for large blocks*/
+#  define LV_MEM_CUSTOM_TLSF 1
+#  define LV_MEM_CUSTOM_TLSF_POOL_MAX (256U * 1024U * 1024U)   /*Largest single TLSF pool [bytes]*/
 #endif     /*LV_MEM_CUSTOM*/
 
 /*Number of the intermediate memory buffer used during rendering and other internal processing mechanisms.
@@ -346,6 +349,10 @@ e.g. "stm32f769xx.h" or "stm32f429xx.h"*/
 #define  LV_FONT_MSYHL_46     0
 #define  LV_FONT_MSYHL_48     0
 
+/*Glyph cache of the MSYHL fonts [bytes]. Only the offset tables stay in RAM,
+ *glyphs are read from the font files on first use and the least recently used ones are dropped*/
+#define LV_USER_FONT_CACHE_SIZE (512U * 1024U)
+
 /*Demonstrate special features*/
 #define LV_FONT_MONTSERRAT_12_SUBPX      0
 #define LV_FONT_MONTSERRAT_28_COMPRESSED 0  /*bpp = 3*/
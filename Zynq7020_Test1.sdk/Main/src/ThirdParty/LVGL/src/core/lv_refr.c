@@ -123,6 +123,8 @@ void _lv_inv_area(lv_disp_t *disp, const lv_area_t *area_p) {
     suc = _lv_area_intersect(&com_area, area_p, &scr_area);
     if (suc == false) return; /*Out of the screen*/
 
+    if (disp->driver->invalidate_cb) disp->driver->invalidate_cb(disp->driver, &com_area);
+
     /*If there were at least 1 invalid area in full refresh mode, redraw the whole screen*/
     if (disp->driver->full_refresh) {
         disp->inv_areas[0] = scr_area;
@@ -205,6 +207,10 @@ void _lv_disp_refr_timer(lv_timer_t *tmr) {
 
     lv_refr_join_area();
 
+    if (disp_refr->inv_p != 0 && disp_refr->driver->render_start_cb) {
+        disp_refr->driver->render_start_cb(disp_refr->driver);
+    }
+
     lv_refr_areas();
 
     /*If refresh happened ...*/
@@ -251,11 +257,18 @@ void _lv_disp_refr_timer(lv_timer_t *tmr) {
     static uint32_t perf_last_time = 0;
     static uint32_t elaps_sum = 0;
     static uint32_t frame_cnt = 0;
+    static uint32_t px_sum = 0;
+    static uint32_t refr_cnt = 0;
     if (lv_tick_elaps(perf_last_time) < 300) {
         if (px_num > 5000) {
             elaps_sum += elaps;
             frame_cnt++;
         }
+        /*Share of the screen redrawn per refresh, 100% with full_refresh*/
+        if (px_num) {
+            px_sum += px_num;
+            refr_cnt++;
+        }
     } else {
         perf_last_time = lv_tick_get();
         uint32_t fps_limit = 1000 / disp_refr->refr_timer->period;
@@ -271,7 +284,11 @@ void _lv_disp_refr_timer(lv_timer_t *tmr) {
         fps_sum_all += fps;
         fps_sum_cnt++;
         unsigned int cpu = 100 - lv_timer_get_idle();
-        lv_label_set_text_fmt(perf_label, "%u FPS\n%u%% CPU", fps, cpu);
+        uint32_t scr_px = lv_disp_get_hor_res(disp_refr) * lv_disp_get_ver_res(disp_refr);
+        unsigned int area = refr_cnt ? (uint64_t) px_sum * 100 / ((uint64_t) refr_cnt * scr_px) : 0;
+        px_sum = 0;
+        refr_cnt = 0;
+        lv_label_set_text_fmt(perf_label, "%u FPS\n%u%% CPU\n%u%% area", fps, cpu, area);
     }
 #endif
 
@@ -921,8 +938,9 @@ static void draw_buf_flush(void) {
 
     draw_buf->flushing = 1;
 
-    if (disp_refr->driver->draw_buf->last_area && disp_refr->driver->draw_buf->last_part) draw_buf->flushing_last = 1;
-    else draw_buf->flushing_last = 0;
+    /*flush_cb or an interrupt may clear `flushing_last` with lv_disp_flush_ready()*/
+    bool last = disp_refr->driver->draw_buf->last_area && disp_refr->driver->draw_buf->last_part;
+    draw_buf->flushing_last = last;
 
     if (disp->driver->flush_cb) {
         /*Rotate the buffer to the display's native orientation if necessary*/
@@ -932,7 +950,8 @@ static void draw_buf_flush(void) {
             call_flush_cb(disp->driver, &draw_buf->area, color_p);
         }
     }
-    if (draw_buf->buf1 && draw_buf->buf2) {
+    /*In direct mode every area is drawn to the same buffer, swap only after the last one*/
+    if (draw_buf->buf1 && draw_buf->buf2 && (!disp->driver->direct_mode || last)) {
         if (draw_buf->buf_act == draw_buf->buf1)
             draw_buf->buf_act = draw_buf->buf2;
         else
@@ -10,6 +10,7 @@
 
 #if LV_USE_FS_FATFS != '\0'
 #include "ff.h"
+#include "FileService/FileService.h"   /*FatFs is not reentrant, access it through the file service task*/
 
 /*********************
  *      DEFINES
@@ -107,7 +108,7 @@ static void * fs_open(lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
     FIL * f = lv_mem_alloc(sizeof(FIL));
     if(f == NULL) return NULL;
 
-    FRESULT res = f_open(f, path, flags);
+    FRESULT res = FileService_open(f, path, flags);
     if(res == FR_OK) {
         return f;
     } else {
@@ -126,7 +127,7 @@ static void * fs_open(lv_fs_drv_t * drv, const char * path, lv_fs_mode_t mode)
 static lv_fs_res_t fs_close(lv_fs_drv_t * drv, void * file_p)
 {
     LV_UNUSED(drv);
-    f_close(file_p);
+    FileService_close(file_p);
     lv_mem_free(file_p);
     return LV_FS_RES_OK;
 }
@@ -144,7 +145,7 @@ static lv_fs_res_t fs_close(lv_fs_drv_t * drv, void * file_p)
 static lv_fs_res_t fs_read(lv_fs_drv_t * drv, void * file_p, void * buf, uint32_t btr, uint32_t * br)
 {
     LV_UNUSED(drv);
-    FRESULT res = f_read(file_p, buf, btr, (UINT *)br);
+    FRESULT res = FileService_read(file_p, buf, btr, (UINT *)br);
     if(res == FR_OK) return LV_FS_RES_OK;
     else return LV_FS_RES_UNKNOWN;
 }
@@ -161,7 +162,7 @@ static lv_fs_res_t fs_read(lv_fs_drv_t * drv, void * file_p, void * buf, uint32_
 static lv_fs_res_t fs_write(lv_fs_drv_t * drv, void * file_p, const void * buf, uint32_t btw, uint32_t * bw)
 {
     LV_UNUSED(drv);
-    FRESULT res = f_write(file_p, buf, btw, (UINT *)bw);
+    FRESULT res = FileService_write(file_p, buf, btw, (UINT *)bw);
     if(res == FR_OK) return LV_FS_RES_OK;
     else return LV_FS_RES_UNKNOWN;
 }
@@ -180,13 +181,13 @@ static lv_fs_res_t fs_seek(lv_fs_drv_t * drv, void * file_p, uint32_t pos, lv_fs
     LV_UNUSED(drv);
     switch (whence) {
     case LV_FS_SEEK_SET:
-        f_lseek((FIL *)file_p, pos);
+        FileService_lseek((FIL *)file_p, pos);
         break;
     case LV_FS_SEEK_CUR:
-        f_lseek((FIL *)file_p, f_tell((FIL *)file_p) + pos);
+        FileService_lseek((FIL *)file_p, f_tell((FIL *)file_p) + pos);
         break;
     case LV_FS_SEEK_END:
-        f_lseek((FIL *)file_p, f_size((FIL *)file_p) + pos);
+        FileService_lseek((FIL *)file_p, f_size((FIL *)file_p) + pos);
         break;
     default:
         break;
@@ -221,7 +222,7 @@ static void * fs_dir_open(lv_fs_drv_t * drv, const char * path)
     DIR * d = lv_mem_alloc(sizeof(DIR));
     if(d == NULL) return NULL;
 
-    FRESULT res = f_opendir(d, path);
+    FRESULT res = FileService_opendir(d, path);
     if(res != FR_OK) {
         lv_mem_free(d);
         d = NULL;
@@ -245,7 +246,7 @@ static lv_fs_res_t fs_dir_read(lv_fs_drv_t * drv, void * dir_p, char * fn)
     fn[0] = '\0';
 
     do {
-        res = f_readdir(dir_p, &fno);
+        res = FileService_readdir(dir_p, &fno);
         if(res != FR_OK) return LV_FS_RES_UNKNOWN;
 
         if(fno.fattrib & AM_DIR) {
@@ -268,7 +269,7 @@ static lv_fs_res_t fs_dir_read(lv_fs_drv_t * drv, void * dir_p, char * fn)
 static lv_fs_res_t fs_dir_close(lv_fs_drv_t * drv, void * dir_p)
 {
     LV_UNUSED(drv);
-    f_closedir(dir_p);
+    FileService_closedir(dir_p);
     lv_mem_free(dir_p);
     return LV_FS_RES_OK;
 }
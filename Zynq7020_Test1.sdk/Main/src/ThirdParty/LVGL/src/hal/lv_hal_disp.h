@@ -107,6 +107,14 @@ typedef struct _lv_disp_drv_t {
      * E.g. round `y` to, 8, 16 ..) on a monochrome display*/
     void (*rounder_cb)(struct _lv_disp_drv_t *disp_drv, lv_area_t *area);
 
+    /** OPTIONAL: Called with every invalidated area (already clipped to the screen) before it is merged.
+     * With `full_refresh` the areas are still reported, e.g. to track which parts of the screen changed*/
+    void (*invalidate_cb)(struct _lv_disp_drv_t *disp_drv, const lv_area_t *area);
+
+    /** OPTIONAL: Called when the invalidated areas are joined, right before they are rendered (as in v8.3).
+     * In `direct_mode` with two buffers the areas of the previous refresh can be copied to the new buffer here*/
+    void (*render_start_cb)(struct _lv_disp_drv_t *disp_drv);
+
     /** OPTIONAL: Set a pixel in a buffer according to the special requirements of the display
      * Can be used for color format not supported in LittelvGL. E.g. 2 bit -> 4 gray scales
      * @note Much slower then drawing with supported color formats.*/
@@ -3,6 +3,10 @@
 
 #include "src/font/lv_font.h"
 
+#ifndef LV_USER_FONT_CACHE_SIZE
+#define LV_USER_FONT_CACHE_SIZE (512U * 1024U)     //!< 字形缓存预算，单位字节
+#endif
+
 typedef struct {
     uint16_t min;
     uint16_t max;
@@ -25,7 +29,8 @@ typedef struct {
 
 typedef struct {
     x_header_t head;
-    uint8_t *data;
+    uint32_t *table;        //!< 偏移表，0表示没有该字形
+    void *fp;               //!< 打开的字体文件，字形按需读取
     lv_font_t *font_obj;
     uint16_t min;
     uint16_t max;
@@ -35,6 +40,27 @@ typedef struct {
     const char *filename;
 } x_file_t;
 
+typedef struct {
+    uint32_t budget;        //!< 缓存预算
+    uint32_t used;          //!< 缓存的字形占用
+    uint32_t table_size;    //!< 常驻的偏移表大小
+    uint32_t glyphs;        //!< 缓存的字形数量
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t evictions;
+} lv_user_font_cache_stats_t;
+
+/**
+ * 加载字体，只读入文件头后的偏移表，字形在第一次使用时从文件读取并放入LRU缓存
+ * @param dir 字体文件所在目录
+ * @return 0成功
+ */
 int lv_user_font_load(const char *dir);
 
+/**
+ * 获取字形缓存统计
+ * @param stats [out] 统计数据
+ */
+void lv_user_font_get_cache_stats(lv_user_font_cache_stats_t *stats);
+
 #endif
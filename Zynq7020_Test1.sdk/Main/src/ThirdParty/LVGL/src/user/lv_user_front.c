@@ -2,7 +2,9 @@
 #include "src/misc/lv_mem.h"
 #include "src/misc/lv_fs.h"
 #include "src/misc/lv_log.h"
+#include "src/hal/lv_hal_tick.h"
 #include "ff.h"
+#include "FileService/FileService.h"
 
 const lv_font_t *defualt_font = &lv_font_montserrat_16;
 
@@ -345,57 +347,159 @@ static x_file_t font_files[] = {
 #endif
 };
 
-static inline uint8_t *lv_user_font_getdata(const lv_font_t *font, int offset, int size) {
-    if (((x_file_t *)(font->user_data))->data == NULL) return NULL;
-    return ((x_file_t *)(font->user_data))->data + offset;
+/*
+ * 字形缓存：字形描述和位图一起缓存，按哈希查找，超出预算时淘汰最久未使用的字形。
+ * LVGL先取字形描述再取位图，中间不会查找其他字形，所以返回的位图在绘制期间不会被淘汰
+ */
+#define GLYPH_HASH_SIZE 1024
+
+typedef struct _glyph_entry_t {
+    struct _glyph_entry_t *prev;        //!< LRU链表，表头最近使用
+    struct _glyph_entry_t *next;
+    struct _glyph_entry_t *hash_next;
+    const x_file_t *file;
+    uint32_t unicode;
+    uint32_t size;                      //!< 计入预算的大小
+    glyph_dsc_t dsc;
+    uint8_t bitmap[];
+} glyph_entry_t;
+
+static glyph_entry_t *glyph_hash[GLYPH_HASH_SIZE];
+static glyph_entry_t *lru_head;
+static glyph_entry_t *lru_tail;
+static lv_user_font_cache_stats_t cache_stats = {.budget = LV_USER_FONT_CACHE_SIZE};
+
+static inline uint32_t glyph_hash_index(const x_file_t *file, uint32_t unicode) {
+    return (unicode + (file - font_files) * 0x9E37) & (GLYPH_HASH_SIZE - 1);
 }
 
-static const uint8_t *lv_user_font_get_bitmap(const lv_font_t *font, uint32_t unicode_letter) {
-    x_header_t *__g_xbf_hd = &((x_file_t *)(font->user_data))->head;
-    if (unicode_letter > __g_xbf_hd->max || unicode_letter < __g_xbf_hd->min) {
+static void glyph_lru_unlink(glyph_entry_t *e) {
+    if (e->prev) e->prev->next = e->next;
+    else lru_head = e->next;
+    if (e->next) e->next->prev = e->prev;
+    else lru_tail = e->prev;
+}
+
+static void glyph_lru_push(glyph_entry_t *e) {
+    e->prev = NULL;
+    e->next = lru_head;
+    if (lru_head) lru_head->prev = e;
+    else lru_tail = e;
+    lru_head = e;
+}
+
+static void glyph_cache_evict(void) {
+    glyph_entry_t *e = lru_tail;
+    glyph_lru_unlink(e);
+    glyph_entry_t **pp = &glyph_hash[glyph_hash_index(e->file, e->unicode)];
+    while (*pp != e) pp = &(*pp)->hash_next;
+    *pp = e->hash_next;
+    cache_stats.used -= e->size;
+    cache_stats.glyphs--;
+    cache_stats.evictions++;
+    lv_mem_free(e);
+}
+
+/**
+ * 从文件读取字形
+ * @param file 字体
+ * @param unicode 字符
+ * @param pos 字形在文件中的偏移
+ * @return 缓存项，失败返回NULL
+ */
+static glyph_entry_t *glyph_cache_load(const x_file_t *file, uint32_t unicode, uint32_t pos) {
+    FIL *fp = file->fp;
+    glyph_dsc_t dsc;
+    UINT br;
+    if (FileService_pread(fp, pos, &dsc, sizeof(dsc), &br) != FR_OK || br != sizeof(dsc)) {
+        LV_LOG_ERROR("Failed to read glyph 0x%04x from %s", unicode, file->filename);
+        return NULL;
+    }
+
+    uint32_t bitmap_size = (dsc.box_w * dsc.box_h * file->head.bpp + 7) / 8;
+    uint32_t size = sizeof(glyph_entry_t) + bitmap_size;
+    while (lru_tail && cache_stats.used + size > cache_stats.budget) glyph_cache_evict();
+
+    glyph_entry_t *e = lv_mem_alloc(size);
+    if (e == NULL) {
+        LV_LOG_ERROR("Failed to malloc glyph memory size = %d", size);
         return NULL;
     }
-    uint32_t unicode_offset = sizeof(x_header_t) + (unicode_letter - __g_xbf_hd->min) * 4;
-    uint32_t *p_pos = (uint32_t *)lv_user_font_getdata(font, unicode_offset, 4);
-    if (p_pos[0] != 0) {
-        uint32_t pos = p_pos[0];
-        glyph_dsc_t *gdsc = (glyph_dsc_t *)lv_user_font_getdata(font, pos, sizeof(glyph_dsc_t));
-        if (gdsc) {
-            return lv_user_font_getdata(font, pos + sizeof(glyph_dsc_t),
-                                        gdsc->box_w * gdsc->box_h * __g_xbf_hd->bpp / 8);
-        } else return NULL;
+    /* 文件最后一个字形的位图可能比向上取整的大小短一个字节，补零 */
+    if (FileService_pread(fp, pos + sizeof(dsc), e->bitmap, bitmap_size, &br) != FR_OK || br + 1 < bitmap_size) {
+        LV_LOG_ERROR("Failed to read glyph 0x%04x from %s", unicode, file->filename);
+        lv_mem_free(e);
+        return NULL;
     }
-    return NULL;
+    if (br < bitmap_size) e->bitmap[br] = 0;
+
+    e->file = file;
+    e->unicode = unicode;
+    e->size = size;
+    e->dsc = dsc;
+    uint32_t index = glyph_hash_index(file, unicode);
+    e->hash_next = glyph_hash[index];
+    glyph_hash[index] = e;
+    glyph_lru_push(e);
+    cache_stats.used += size;
+    cache_stats.glyphs++;
+    return e;
 }
 
-static bool lv_user_font_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out,
-                                    uint32_t unicode_letter, uint32_t unicode_letter_next) {
-    x_header_t *__g_xbf_hd = &((x_file_t *)(font->user_data))->head;
-    if (unicode_letter > __g_xbf_hd->max || unicode_letter < __g_xbf_hd->min) {
-        return NULL;
+/**
+ * 查找字形，不在缓存中时从文件读取
+ * @param font 字体
+ * @param unicode 字符
+ * @return 缓存项，字体中没有该字符时返回NULL
+ */
+static glyph_entry_t *lv_user_font_get_glyph(const lv_font_t *font, uint32_t unicode) {
+    const x_file_t *file = font->user_data;
+    if (file->table == NULL || unicode > file->head.max || unicode < file->head.min) return NULL;
+    uint32_t pos = file->table[unicode - file->head.min];
+    if (pos == 0) return NULL;
+
+    /* 同一个字形连续查找描述和位图 */
+    if (lru_head && lru_head->file == file && lru_head->unicode == unicode) {
+        cache_stats.hits++;
+        return lru_head;
     }
-    uint32_t unicode_offset = sizeof(x_header_t) + (unicode_letter - __g_xbf_hd->min) * 4;
-    uint32_t *p_pos = (uint32_t *)lv_user_font_getdata(font, unicode_offset, 4);
-    if (p_pos == NULL) return false;
-    if (p_pos[0] != 0) {
-        glyph_dsc_t *gdsc = (glyph_dsc_t *)lv_user_font_getdata(font, p_pos[0], sizeof(glyph_dsc_t));
-        dsc_out->adv_w = gdsc->adv_w;
-        dsc_out->box_h = gdsc->box_h;
-        dsc_out->box_w = gdsc->box_w;
-        dsc_out->ofs_x = gdsc->ofs_x;
-        dsc_out->ofs_y = gdsc->ofs_y;
-        dsc_out->bpp = __g_xbf_hd->bpp;
-        return true;
+
+    for (glyph_entry_t *e = glyph_hash[glyph_hash_index(file, unicode)]; e; e = e->hash_next) {
+        if (e->file == file && e->unicode == unicode) {
+            glyph_lru_unlink(e);
+            glyph_lru_push(e);
+            cache_stats.hits++;
+            return e;
+        }
     }
-    return false;
+
+    cache_stats.misses++;
+    return glyph_cache_load(file, unicode, pos);
 }
 
+static const uint8_t *lv_user_font_get_bitmap(const lv_font_t *font, uint32_t unicode_letter) {
+    glyph_entry_t *e = lv_user_font_get_glyph(font, unicode_letter);
+    return e ? e->bitmap : NULL;
+}
 
+static bool lv_user_font_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out,
+                                    uint32_t unicode_letter, uint32_t unicode_letter_next) {
+    glyph_entry_t *e = lv_user_font_get_glyph(font, unicode_letter);
+    if (e == NULL) return false;
+    dsc_out->adv_w = e->dsc.adv_w;
+    dsc_out->box_h = e->dsc.box_h;
+    dsc_out->box_w = e->dsc.box_w;
+    dsc_out->ofs_x = e->dsc.ofs_x;
+    dsc_out->ofs_y = e->dsc.ofs_y;
+    dsc_out->bpp = ((const x_file_t *) font->user_data)->head.bpp;
+    return true;
+}
 
 int lv_user_font_load(const char *dir) {
 	int ret = 0;
     int len = strlen(dir) + strlen(font_files[0].filename) + 3;
     char *path = lv_mem_alloc(len);
+    uint32_t start = lv_tick_get();
 
     for (int i = 0; i < sizeof(font_files) / sizeof(x_file_t) && ret == 0; i++) {
         font_files[i].font_obj->user_data = &font_files[i];
@@ -405,38 +509,58 @@ int lv_user_font_load(const char *dir) {
         font_files[i].font_obj->base_line = font_files[i].base_line;
         font_files[i].font_obj->line_height = font_files[i].line_height;
 
-        FIL font_binfile;
         lv_memset_00(path, len);
         strcat(path, dir);
         strcat(path, "/");
         strcat(path, font_files[i].filename);
         LV_LOG_INFO("lv user font loading %s ...\r\n", path);
-        if (f_open(&font_binfile, path, FA_READ) != FR_OK) {
+
+        /* 文件保持打开，供读取字形 */
+        FIL *fp = lv_mem_alloc(sizeof(FIL));
+        if (fp == NULL) {
+            LV_LOG_ERROR("Failed to malloc font file object");
+            ret = 1;
+            break;
+        }
+        if (FileService_open(fp, path, FA_READ) != FR_OK) {
             LV_LOG_ERROR("Failed to open font file %s", path);
+            lv_mem_free(fp);
             ret = 1;
             break;
         }
 
-        FSIZE_t read_size = 0, file_size = f_size(&font_binfile);
-
-        font_files[i].data = lv_mem_alloc(file_size);
-        if (font_files[i].data == NULL) {
-            LV_LOG_ERROR("Failed to malloc font memory size = %d", file_size);
+        UINT table_size = (font_files[i].head.max - font_files[i].head.min + 1) * sizeof(uint32_t);
+        uint32_t *table = lv_mem_alloc(table_size);
+        if (table == NULL) {
+            LV_LOG_ERROR("Failed to malloc font memory size = %d", table_size);
+            FileService_close(fp);
+            lv_mem_free(fp);
             ret = 1;
+            break;
         }
 
-        while (read_size < file_size) {
-            UINT rdsize;
-            f_read(&font_binfile, font_files[i].data + read_size, 1024, &rdsize);
-            read_size += rdsize;
-            if (rdsize < 1024) break;
-        }
-        if (read_size != file_size) {
-            LV_LOG_ERROR("Read size mismatch %d != %d", read_size, file_size);
+        /* 偏移表一次读取，FatFs直接按多扇区读入 */
+        UINT rdsize = 0;
+        if (FileService_pread(fp, sizeof(x_header_t), table, table_size, &rdsize) != FR_OK || rdsize != table_size) {
+            LV_LOG_ERROR("Read size mismatch %d != %d", rdsize, table_size);
+            lv_mem_free(table);
+            FileService_close(fp);
+            lv_mem_free(fp);
             ret = 1;
+            break;
         }
-        f_close(&font_binfile);
+
+        font_files[i].table = table;
+        font_files[i].fp = fp;
+        cache_stats.table_size += table_size;
     }
     lv_mem_free(path);
+
+    LV_LOG_USER("user fonts loaded in %d ms, offset tables %d bytes, glyph cache budget %d bytes",
+                lv_tick_elaps(start), cache_stats.table_size, cache_stats.budget);
     return ret;
 }
+
+void lv_user_font_get_cache_stats(lv_user_font_cache_stats_t *stats) {
+    *stats = cache_stats;
+}
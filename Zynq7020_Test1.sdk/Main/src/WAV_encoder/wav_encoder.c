@@ -0,0 +1,60 @@
+//
+// Created by yaoji on 2022/5/2.
+//
+
+#include "wav_encoder.h"
+#include "xstatus.h"
+#include "FileService/FileService.h"
+#include <ff.h>
+
+typedef struct {
+    char riff_id[4];                //!< "RIFF"
+    DWORD riff_size;                //!< 文件长度-8
+    char wave_id[4];                //!< "WAVE"
+    char fmt_id[4];                 //!< "fmt "
+    DWORD fmt_size;                 //!< fmt块长度，PCM格式为16
+    WORD audio_format;              //!< 1:PCM
+    WORD channels;                  //!< 声道数
+    DWORD sample_rate;              //!< 采样率
+    DWORD byte_rate;                //!< 每秒字节数
+    WORD block_align;               //!< 每帧字节数
+    WORD bits_per_sample;           //!< 采样位宽
+    char data_id[4];                //!< "data"
+    DWORD data_size;                //!< 数据长度
+}__attribute__((packed)) wav_header_t;
+
+int wav_save(const char *filename, uint32_t sample_rate, uint16_t channels, const int16_t *data, uint32_t frames) {
+    if (filename == NULL || data == NULL || channels == 0) return XST_FAILURE;
+    FIL file;
+    FRESULT res = FileService_open(&file, filename, FA_WRITE | FA_CREATE_NEW);
+    if (res != FR_OK) return XST_FAILURE;
+
+    UINT data_size = frames * channels * sizeof(int16_t);
+    wav_header_t header = {
+            .riff_id = {'R', 'I', 'F', 'F'},
+            .riff_size = sizeof(wav_header_t) - 8 + data_size,
+            .wave_id = {'W', 'A', 'V', 'E'},
+            .fmt_id = {'f', 'm', 't', ' '},
+            .fmt_size = 16,
+            .audio_format = 1,
+            .channels = channels,
+            .sample_rate = sample_rate,
+            .byte_rate = sample_rate * channels * sizeof(int16_t),
+            .block_align = channels * sizeof(int16_t),
+            .bits_per_sample = 16,
+            .data_id = {'d', 'a', 't', 'a'},
+            .data_size = data_size,
+    };
+
+    UINT bw;
+    res = FileService_write(&file, &header, sizeof(header), &bw);
+    if (res != FR_OK || bw != sizeof(header)) goto err;
+    res = FileService_write(&file, data, data_size, &bw);
+    if (res != FR_OK || bw != data_size) goto err;
+    FileService_close(&file);
+    return XST_SUCCESS;
+
+    err:
+    FileService_close(&file);
+    return XST_FAILURE;
+}
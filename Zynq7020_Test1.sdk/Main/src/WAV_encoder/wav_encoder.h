@@ -0,0 +1,21 @@
+//
+// Created by yaoji on 2022/5/2.
+//
+
+#ifndef ZYNQ7020_WAV_ENCODER_H
+#define ZYNQ7020_WAV_ENCODER_H
+
+#include <stdint.h>
+
+/**
+ * 保存16位PCM格式的wav文件
+ * @param filename 文件路径
+ * @param sample_rate 采样率
+ * @param channels 声道数
+ * @param data 采样数据，多声道时按帧交错排列
+ * @param frames 每个声道的采样点数
+ * @return XST_SUCCESS 或 XST_FAILURE
+ */
+int wav_save(const char *filename, uint32_t sample_rate, uint16_t channels, const int16_t *data, uint32_t frames);
+
+#endif //ZYNQ7020_WAV_ENCODER_H
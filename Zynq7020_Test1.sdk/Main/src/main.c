@@ -46,6 +46,10 @@
  */
 
 #include <Fatfs_init/Fatfs_Driver.h>
+#include <Fatfs_init/Encoding.h>
+#include <DiskCache/DiskCache.h>
+#include <FileService/FileService.h>
+#include <FileService/DirSnapshot.h>
 #include <VDMA_Driver/VDMA_Driver.h>
 #include "LwIP_init/LwIP_init.h"
 #include "DMA_Driver/DMA_Driver.h"
@@ -133,17 +137,25 @@ void vApplicationIdleHook(void) {
 void vApplicationDaemonTaskStartupHook() {
 }
 
+static void *cjson_malloc(size_t size) {
+    return os_malloc_tag(size, OS_MEM_TAG_CJSON);
+}
+
 static void DefaultTask(void *pvParameters) {
     vPortEnterCritical();
     cJSON_Hooks hooks = {
             .free_fn = os_free,
-            .malloc_fn = os_malloc,
+            .malloc_fn = cjson_malloc,
     };
     cJSON_InitHooks(&hooks);
 
     CHECK_STATUS(XADC_Init(&xAdcPs, XPAR_XADCPS_0_DEVICE_ID));
 
+    CHECK_STATUS(Encoding_init());
+    CHECK_STATUS(DiskCache_init());
     CHECK_STATUS(Fatfs_Init());
+    CHECK_STATUS(FileService_init());
+    CHECK_STATUS(DirSnapshot_init());
     network_init();
     udp_comm_controller_init();
 
@@ -153,6 +165,7 @@ static void DefaultTask(void *pvParameters) {
     CHECK_STATUS(I2C_Init(&iic1, XPAR_XIICPS_1_DEVICE_ID, 400e3));
     DS1337_SetDefaultInstance(&iic1);
 
+    CHECK_STATUS(DMA_Mem_init());
     CHECK_STATUS(DMA_Init(&dma0, XPAR_ADDA_AXI_DMA_AD_DA_DEVICE_ID));
     CHECK_STATUS(DMA_SetTxRing(&dma0, DMA0_TxBd, sizeof(DMA0_TxBd)));
     CHECK_STATUS(DMA_SetRxRing(&dma0, DMA0_RxBd, sizeof(DMA0_RxBd)));
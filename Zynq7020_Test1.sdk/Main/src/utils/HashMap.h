@@ -0,0 +1,157 @@
+//
+// Created by yaoji on 2022/5/10.
+//
+
+#ifndef ZYNQ7020_HASHMAP_H
+#define ZYNQ7020_HASHMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+
+/**
+ * 开放寻址哈希表
+ * HASHMAP_DEFINE(IntMap, uint32_t, int, hash_u32, hash_eq_u32) 生成类型IntMap和
+ * IntMap_init/IntMap_put/IntMap_find/IntMap_remove等函数。
+ * 线性探测，容量为2的幂，负载超过3/4时扩容，删除时后移填补空位，不使用墓碑。
+ * 每个槽保存哈希值，0表示空槽，查找时先比较哈希值再比较键。
+ * 表不持有键指向的内存(如字符串键)，由调用者保证其生命周期
+ */
+
+#define HASHMAP_MIN_CAP 8
+
+/**
+ * 整数哈希，murmur3的fmix32
+ */
+static inline uint32_t hash_u32(uint32_t key) {
+    key ^= key >> 16;
+    key *= 0x85ebca6bU;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35U;
+    key ^= key >> 16;
+    return key;
+}
+
+static inline int hash_eq_u32(uint32_t a, uint32_t b) {
+    return a == b;
+}
+
+/**
+ * 字符串哈希，FNV-1a
+ */
+static inline uint32_t hash_str(const char *key) {
+    uint32_t h = 2166136261U;
+    while (*key) {
+        h ^= (uint8_t) *key++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+static inline int hash_eq_str(const char *a, const char *b) {
+    return strcmp(a, b) == 0;
+}
+
+#define HASHMAP_DEFINE(name, key_type, value_type, hash_fn, eq_fn)                          \
+typedef struct {                                                                            \
+    uint32_t hash;                                                                          \
+    key_type key;                                                                           \
+    value_type value;                                                                       \
+} name##_Entry;                                                                             \
+                                                                                            \
+typedef struct {                                                                            \
+    name##_Entry *entries;                                                                  \
+    size_t len;                                                                             \
+    size_t cap;                                                                             \
+} name;                                                                                     \
+                                                                                            \
+static inline void name##_init(name *self) {                                                \
+    self->entries = NULL;                                                                   \
+    self->len = 0;                                                                          \
+    self->cap = 0;                                                                          \
+}                                                                                           \
+                                                                                            \
+static inline void name##_delete(name *self) {                                              \
+    os_free(self->entries);                                                                 \
+    name##_init(self);                                                                      \
+}                                                                                           \
+                                                                                            \
+static inline uint32_t name##_hash(key_type key) {                                          \
+    uint32_t h = hash_fn(key);                                                              \
+    return h ? h : 1;                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline name##_Entry *name##_slot(const name *self, key_type key, uint32_t h) {       \
+    size_t mask = self->cap - 1;                                                            \
+    for (size_t i = h & mask;; i = (i + 1) & mask) {                                        \
+        name##_Entry *e = &self->entries[i];                                                \
+        if (e->hash == 0 || (e->hash == h && eq_fn(e->key, key))) return e;                 \
+    }                                                                                       \
+}                                                                                           \
+                                                                                            \
+static inline int name##_reserve(name *self, size_t n) {                                    \
+    size_t cap = self->cap ? self->cap : HASHMAP_MIN_CAP;                                   \
+    while (n > cap / 4 * 3) cap *= 2;                                                       \
+    if (cap == self->cap) return 1;                                                         \
+    name##_Entry *old = self->entries;                                                      \
+    size_t old_cap = self->cap;                                                             \
+    self->entries = os_malloc(cap * sizeof(name##_Entry));                                  \
+    if (self->entries == NULL) {                                                            \
+        self->entries = old;                                                                \
+        return 0;                                                                           \
+    }                                                                                       \
+    memset(self->entries, 0, cap * sizeof(name##_Entry));                                   \
+    self->cap = cap;                                                                        \
+    for (size_t i = 0; i < old_cap; i++) {                                                  \
+        if (old[i].hash) *name##_slot(self, old[i].key, old[i].hash) = old[i];              \
+    }                                                                                       \
+    os_free(old);                                                                           \
+    return 1;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline value_type *name##_find(const name *self, key_type key) {                     \
+    if (self->len == 0) return NULL;                                                        \
+    name##_Entry *e = name##_slot(self, key, name##_hash(key));                             \
+    return e->hash ? &e->value : NULL;                                                      \
+}                                                                                           \
+                                                                                            \
+static inline int name##_put(name *self, key_type key, value_type value) {                  \
+    if (!name##_reserve(self, self->len + 1)) return 0;                                     \
+    uint32_t h = name##_hash(key);                                                          \
+    name##_Entry *e = name##_slot(self, key, h);                                            \
+    if (e->hash == 0) self->len++;                                                          \
+    e->hash = h;                                                                            \
+    e->key = key;                                                                           \
+    e->value = value;                                                                       \
+    return 1;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline int name##_remove(name *self, key_type key) {                                 \
+    if (self->len == 0) return 0;                                                           \
+    size_t mask = self->cap - 1;                                                            \
+    name##_Entry *e = name##_slot(self, key, name##_hash(key));                             \
+    if (e->hash == 0) return 0;                                                             \
+    size_t hole = e - self->entries;                                                        \
+    for (size_t i = (hole + 1) & mask; self->entries[i].hash; i = (i + 1) & mask) {         \
+        /* 理想位置不在(hole, i]之间的元素可以前移到空位 */                                      \
+        size_t home = self->entries[i].hash & mask;                                         \
+        if (((i - home) & mask) >= ((i - hole) & mask)) {                                   \
+            self->entries[hole] = self->entries[i];                                         \
+            hole = i;                                                                       \
+        }                                                                                   \
+    }                                                                                       \
+    self->entries[hole].hash = 0;                                                           \
+    self->len--;                                                                            \
+    return 1;                                                                               \
+}
+
+/**
+ * 遍历哈希表，it为name##_Entry指针
+ */
+#define HASHMAP_FOREACH(it, map)                                                            \
+    for (__typeof__((map)->entries) it = (map)->entries;                                    \
+         it < (map)->entries + (map)->cap; it++)                                            \
+        if (it->hash)
+
+#endif //ZYNQ7020_HASHMAP_H
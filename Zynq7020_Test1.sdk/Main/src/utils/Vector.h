@@ -0,0 +1,104 @@
+//
+// Created by yaoji on 2022/5/10.
+//
+
+#ifndef ZYNQ7020_VECTOR_H
+#define ZYNQ7020_VECTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+
+/**
+ * 类型化连续数组
+ * VECTOR_DEFINE(IntVector, int) 生成类型IntVector和IntVector_init/IntVector_push等函数，
+ * 元素直接按值存放在一段连续内存中，容量不足时按2倍扩容。
+ * VECTOR_DEFINE_INLINE额外在结构体内放inline_n个元素，不超过该数量时不分配堆内存，
+ * 此时结构体内有指向自身的指针，不能按值拷贝或返回。
+ * 成功返回1，失败返回0，与Array一致
+ */
+
+#define VECTOR_MIN_CAP 4
+
+#define VECTOR_DEFINE(name, type) VECTOR_DEFINE_INLINE(name, type, 0)
+
+#define VECTOR_DEFINE_INLINE(name, type, inline_n)                                          \
+typedef struct {                                                                            \
+    type *data;                                                                             \
+    size_t len;                                                                             \
+    size_t cap;                                                                             \
+    type inline_buf[inline_n];                                                              \
+} name;                                                                                     \
+                                                                                            \
+static inline void name##_init(name *self) {                                                \
+    self->data = (inline_n) ? self->inline_buf : NULL;                                      \
+    self->len = 0;                                                                          \
+    self->cap = (inline_n);                                                                 \
+}                                                                                           \
+                                                                                            \
+static inline void name##_delete(name *self) {                                              \
+    if (self->data != self->inline_buf) os_free(self->data);                                \
+    name##_init(self);                                                                      \
+}                                                                                           \
+                                                                                            \
+static inline int name##_reserve(name *self, size_t n) {                                    \
+    if (n <= self->cap) return 1;                                                           \
+    size_t cap = self->cap ? self->cap * 2 : VECTOR_MIN_CAP;                                \
+    while (cap < n) cap *= 2;                                                               \
+    type *p;                                                                                \
+    if ((inline_n) && self->data == self->inline_buf) {                                     \
+        p = os_malloc(cap * sizeof(type));                                                  \
+        if (p) memcpy(p, self->inline_buf, self->len * sizeof(type));                       \
+    } else {                                                                                \
+        p = os_realloc(self->data, cap * sizeof(type));                                     \
+    }                                                                                       \
+    if (p == NULL) return 0;                                                                \
+    self->data = p;                                                                         \
+    self->cap = cap;                                                                        \
+    return 1;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline type *name##_emplace(name *self) {                                            \
+    if (self->len == self->cap && !name##_reserve(self, self->len + 1)) return NULL;        \
+    return &self->data[self->len++];                                                        \
+}                                                                                           \
+                                                                                            \
+static inline int name##_push(name *self, type value) {                                     \
+    type *p = name##_emplace(self);                                                         \
+    if (p == NULL) return 0;                                                                \
+    *p = value;                                                                             \
+    return 1;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline type *name##_get(const name *self, size_t index) {                            \
+    return index < self->len ? &self->data[index] : NULL;                                   \
+}                                                                                           \
+                                                                                            \
+static inline int name##_remove(name *self, size_t index) {                                 \
+    if (index >= self->len) return 0;                                                       \
+    memmove(&self->data[index], &self->data[index + 1],                                     \
+            (self->len - index - 1) * sizeof(type));                                        \
+    self->len--;                                                                            \
+    return 1;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline int name##_resize(name *self, size_t new_len) {                               \
+    if (!name##_reserve(self, new_len)) return 0;                                           \
+    if (new_len > self->len)                                                                \
+        memset(&self->data[self->len], 0, (new_len - self->len) * sizeof(type));            \
+    self->len = new_len;                                                                    \
+    return 1;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline void name##_clear(name *self) {                                               \
+    self->len = 0;                                                                          \
+}
+
+/**
+ * 遍历数组，it为元素指针
+ */
+#define VECTOR_FOREACH(it, vec) \
+    for (__typeof__((vec)->data) it = (vec)->data; it < (vec)->data + (vec)->len; it++)
+
+#endif //ZYNQ7020_VECTOR_H
@@ -86,58 +86,70 @@ bool char_in_str(char c, char *str) {
     return false;
 }
 
-StringList str_split(const char *str, char *separator) {
-    StringList str_list = {0};
-    str_list.parent_str = str_malloc_copy(str);
-    if (str_list.parent_str == NULL) return str_list;
-
-    int start_index = 0;
-    for (int i = 0; str_list.parent_str[i] != '\0'; i++) {
-        if (char_in_str(str_list.parent_str[i], separator)) {
+int str_split(StringList *str_list, const char *str, const char *separator) {
+    StrPtrVector_init(&str_list->list);
+    size_t len = strlen(str);
+    if (len < sizeof(str_list->inline_str)) {
+        str_list->parent_str = str_list->inline_str;
+    } else {
+        str_list->parent_str = os_malloc(len + 1);
+        if (str_list->parent_str == NULL) return 0;
+    }
+    memcpy(str_list->parent_str, str, len + 1);
+
+    /* 分隔符查找表，避免每个字符都扫描一遍分隔符串 */
+    uint32_t sep_map[8] = {0};
+    for (const uint8_t *s = (const uint8_t *) separator; *s; s++)
+        sep_map[*s >> 5] |= 1U << (*s & 31);
+
+    char *p = str_list->parent_str;
+    size_t start_index = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = p[i];
+        if (sep_map[c >> 5] & (1U << (c & 31))) {
             if (start_index == i) {
                 start_index++;
             } else {
-            	str_list.parent_str[i] = 0;
-                str_list.list = os_realloc(str_list.list, sizeof(char *) * (str_list.len + 1));
-                str_list.list[str_list.len++] = str_list.parent_str + start_index;
+                p[i] = 0;
+                if (!StrPtrVector_push(&str_list->list, p + start_index)) goto err;
                 start_index = i + 1;
             }
         }
     }
-    str_list.list = os_realloc(str_list.list, sizeof(char *) * (str_list.len + 1));
-    str_list.list[str_list.len++] = str_list.parent_str + start_index;
-    return str_list;
+    if (!StrPtrVector_push(&str_list->list, p + start_index)) goto err;
+    return 1;
+
+    err:
+    StringList_free(str_list);
+    return 0;
 }
 
 char *str_join(const StringList *str_list, int num, char separator) {
     if (str_list == NULL)return NULL;
 
     int total_len = 1;
-    for (int i = 0; i < str_list->len && i < num; i++)
-        total_len += strlen(str_list->list[i]);
-    if (separator) total_len += str_list->len - 1;
+    for (int i = 0; i < str_list->list.len && i < num; i++)
+        total_len += strlen(str_list->list.data[i]);
+    if (separator) total_len += str_list->list.len - 1;
 
     char *str = os_malloc(total_len);
     if (str == NULL) return NULL;
 
     int write_index = 0;
-    for (int i = 0; i < str_list->len && i < num; i++) {
-        char *str_slice = str_list->list[i];
+    for (int i = 0; i < str_list->list.len && i < num; i++) {
+        char *str_slice = str_list->list.data[i];
         while (*str_slice) str[write_index++] = *str_slice++;
         if (separator) str[write_index++] = separator;
     }
 
-    if (separator) str[write_index - 1] = 0;
+    // 去掉最后一个分隔符，num为0时结果为空串
+    if (separator && write_index) str[write_index - 1] = 0;
     else str[write_index] = 0;
     return str;
 }
 
 void StringList_free(StringList *p) {
-    if (p->parent_str) {
-        os_free(p->parent_str);
-    } else {
-        for (int i = 0; i < p->len; i++)
-            os_free(p->list[i]);
-    }
-    os_free(p->list);
+    if (p->parent_str != p->inline_str) os_free(p->parent_str);
+    p->parent_str = NULL;
+    StrPtrVector_delete(&p->list);
 }
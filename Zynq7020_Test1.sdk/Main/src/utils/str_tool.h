@@ -6,12 +6,20 @@
 #define TELEPHONEDIRECTORY_STR_TOOL_H
 
 #include <stdbool.h>
-#include "Array.h"
+#include "Vector.h"
 
+#define STRING_LIST_INLINE_NUM 8      //!< 不超过该数量的子串不分配指针数组
+#define STRING_LIST_INLINE_STR 64     //!< 不超过该长度的字符串不分配拷贝
+
+VECTOR_DEFINE_INLINE(StrPtrVector, char *, STRING_LIST_INLINE_NUM)
+
+/**
+ * str_split的结果，短字符串和少量子串都放在结构体内，不能按值拷贝
+ */
 typedef struct {
     char *parent_str;
-    char **list;
-    int len;
+    StrPtrVector list;
+    char inline_str[STRING_LIST_INLINE_STR];
 } StringList;
 
 char *str_malloc_copy(const char *str);
@@ -21,7 +29,15 @@ int isLetter(char c);
 char *parse_string(char **input, int *len);
 
 bool char_in_str(char c, char *str);
-StringList str_split(const char *str, char *separator);
+
+/**
+ * 按分隔符拆分字符串，连续的分隔符视为一个
+ * @param str_list [out] 结果，使用后调用StringList_free
+ * @param str 字符串
+ * @param separator 分隔符集合
+ * @return 成功返回1，失败返回0
+ */
+int str_split(StringList *str_list, const char *str, const char *separator);
 char *str_join(const StringList *str_list, int num, char separator);
 void StringList_free(StringList *p);
 
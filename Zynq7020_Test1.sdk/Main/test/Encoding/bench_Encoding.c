@@ -0,0 +1,71 @@
+//
+// 文件名GBK<->UTF-8转换耗时：Encoding_init之前逐字符二分查找FatFs代码页表，之后查直接索引表
+// 用法: bench_Encoding [名称数] [重复次数]
+//
+
+#include "test_env.h"
+#include "encoding_names.h"
+#include "Fatfs_init/Encoding.h"
+#include <string.h>
+
+#define NAME_CHARS 20
+
+typedef struct {
+    double gbk_to_utf8;
+    double utf8_to_gbk;
+} bench_result_t;
+
+static bench_result_t bench(char (*gbk)[NAME_CHARS * 2 + 1], char (*utf8)[NAME_CHARS * 3 + 1], int num, int repeat) {
+    char out[NAME_CHARS * 3 + 1];
+    bench_result_t r;
+    volatile int sink = 0;
+
+    uint64_t start = test_env_now_ns();
+    for (int k = 0; k < repeat; k++)
+        for (int i = 0; i < num; i++)
+            sink += Encoding_gbk_to_utf8(out, sizeof(out), gbk[i]);
+    r.gbk_to_utf8 = (double) (test_env_now_ns() - start) / ((double) num * repeat);
+
+    start = test_env_now_ns();
+    for (int k = 0; k < repeat; k++)
+        for (int i = 0; i < num; i++)
+            sink += Encoding_utf8_to_gbk(out, sizeof(out), utf8[i]);
+    r.utf8_to_gbk = (double) (test_env_now_ns() - start) / ((double) num * repeat);
+    (void) sink;
+    return r;
+}
+
+int main(int argc, char **argv) {
+    int num = argc > 1 ? atoi(argv[1]) : 10000;
+    int repeat = argc > 2 ? atoi(argv[2]) : 20;
+    if (num < 1) num = 1;
+    if (repeat < 1) repeat = 1;
+
+    char (*gbk)[NAME_CHARS * 2 + 1] = malloc(num * sizeof(*gbk));
+    char (*utf8)[NAME_CHARS * 3 + 1] = malloc(num * sizeof(*utf8));
+    char (*ref)[NAME_CHARS * 3 + 1] = malloc(num * sizeof(*ref));
+    TEST_ASSERT(gbk && utf8 && ref);
+    for (int i = 0; i < num; i++) {
+        names_gen_gbk(gbk[i], NAME_CHARS);
+        TEST_ASSERT(Encoding_gbk_to_utf8(utf8[i], sizeof(utf8[i]), gbk[i]) >= 0);
+    }
+
+    bench_result_t search = bench(gbk, utf8, num, repeat);
+    test_env_init();
+    bench_result_t table = bench(gbk, utf8, num, repeat);
+
+    /* 两种方式的输出必须相同 */
+    for (int i = 0; i < num; i++) {
+        TEST_ASSERT(Encoding_gbk_to_utf8(ref[i], sizeof(ref[i]), gbk[i]) >= 0);
+        TEST_ASSERT(strcmp(ref[i], utf8[i]) == 0);
+    }
+
+    printf("Encoding  %d names x %d chars  repeat %d  (ns per name)\n", num, NAME_CHARS, repeat);
+    printf("%-10s %12s %12s\n", "", "FatFs search", "table");
+    printf("%-10s %12.0f %12.0f\n", "GBK->UTF8", search.gbk_to_utf8, table.gbk_to_utf8);
+    printf("%-10s %12.0f %12.0f\n", "UTF8->GBK", search.utf8_to_gbk, table.utf8_to_gbk);
+    free(gbk);
+    free(utf8);
+    free(ref);
+    return 0;
+}
@@ -0,0 +1,37 @@
+//
+// 生成测试用的文件名：ASCII和GBK汉字混合
+//
+
+#ifndef ENCODING_NAMES_H
+#define ENCODING_NAMES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+static uint32_t names_seed = 20220510;
+
+static inline uint32_t names_rand(void) {
+    names_seed = names_seed * 1103515245 + 12345;
+    return names_seed >> 8;
+}
+
+/**
+ * 生成chars个字符的GBK字符串，约一半是汉字
+ * @param out 长度至少chars * 2 + 1
+ */
+static inline void names_gen_gbk(char *out, int chars) {
+    static const char ascii[] = "abcdefghijklmnopqrstuvwxyz0123456789_-. ";
+    size_t n = 0;
+    for (int i = 0; i < chars; i++) {
+        if (names_rand() & 1) {
+            /* GB2312汉字区 */
+            out[n++] = (char) (0xB0 + names_rand() % (0xF7 - 0xB0 + 1));
+            out[n++] = (char) (0xA1 + names_rand() % (0xFE - 0xA1 + 1));
+        } else {
+            out[n++] = ascii[names_rand() % (sizeof(ascii) - 1)];
+        }
+    }
+    out[n] = 0;
+}
+
+#endif //ENCODING_NAMES_H
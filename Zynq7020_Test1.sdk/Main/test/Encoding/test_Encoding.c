@@ -0,0 +1,96 @@
+//
+// Encoding查找表与FatFs逐字符转换的结果一致，缓冲区不足时在完整字符处截断
+// 需要在Encoding_init之前取得逐字符转换的结果，不使用test_env_init
+//
+
+#include "test_env.h"
+#include "encoding_names.h"
+#include "Fatfs_init/Encoding.h"
+#include "ff.h"
+#include <string.h>
+
+#define NAME_NUM 2000
+#define NAME_MAX_CHARS 40
+
+static char gbk[NAME_NUM][NAME_MAX_CHARS * 2 + 1];
+static char utf8_ref[NAME_NUM][NAME_MAX_CHARS * 3 + 1];
+static char junk[NAME_NUM][64];
+static char junk_ref[NAME_NUM][2][64 * 3 + 1];
+
+static void gen_junk(char *out, size_t size) {
+    size_t len = 1 + names_rand() % (size - 1);
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (char) (names_rand() % 255 + 1);
+    }
+    out[len] = 0;
+}
+
+/* 每个GBK双字节码转换后再转回，有映射的必须得到原编码 */
+static void check_all_codes(void) {
+    int mapped = 0;
+    for (int lead = 0x81; lead <= 0xFE; lead++) {
+        for (int trail = 0x40; trail <= 0xFE; trail++) {
+            if (trail == 0x7F) continue;
+            char in[3] = {(char) lead, (char) trail, 0}, utf8[8], back[4];
+            TEST_ASSERT(Encoding_gbk_to_utf8(utf8, sizeof(utf8), in) > 0);
+            if (utf8[0] == '?') continue;
+            TEST_ASSERT(Encoding_utf8_to_gbk(back, sizeof(back), utf8) == 2);
+            /* 多个GBK码对应同一个Unicode时只能转回第一个 */
+            WCHAR uni = ff_oem2uni(lead << 8 | trail, FF_CODE_PAGE);
+            TEST_ASSERT(((uint8_t) back[0] << 8 | (uint8_t) back[1]) == ff_uni2oem(uni, FF_CODE_PAGE));
+            mapped++;
+        }
+    }
+    TEST_ASSERT(mapped > 20000);
+}
+
+static void check_truncate(const char *src, int to_utf8) {
+    char full[256], out[256];
+    int len = to_utf8 ? Encoding_gbk_to_utf8(full, sizeof(full), src) : Encoding_utf8_to_gbk(full, sizeof(full), src);
+    TEST_ASSERT(len >= 0);
+    for (size_t size = 1; size <= (size_t) len; size++) {
+        int n = to_utf8 ? Encoding_gbk_to_utf8(out, size, src) : Encoding_utf8_to_gbk(out, size, src);
+        TEST_ASSERT(n == -1);
+        size_t got = strlen(out);
+        TEST_ASSERT(got < size);
+        /* 截断的输出是完整输出的前缀，且不超过一个字符的差距 */
+        TEST_ASSERT(memcmp(out, full, got) == 0);
+        TEST_ASSERT(size - 1 - got < (to_utf8 ? 3u : 2u));
+    }
+}
+
+int main(void) {
+    for (int i = 0; i < NAME_NUM; i++) {
+        names_gen_gbk(gbk[i], 1 + i % NAME_MAX_CHARS);
+        gen_junk(junk[i], sizeof(junk[i]));
+    }
+
+    /* 逐字符调用ff_oem2uni/ff_uni2oem的结果作为参考 */
+    for (int i = 0; i < NAME_NUM; i++) {
+        TEST_ASSERT(Encoding_gbk_to_utf8(utf8_ref[i], sizeof(utf8_ref[i]), gbk[i]) >= 0);
+        Encoding_gbk_to_utf8(junk_ref[i][0], sizeof(junk_ref[i][0]), junk[i]);
+        Encoding_utf8_to_gbk(junk_ref[i][1], sizeof(junk_ref[i][1]), junk[i]);
+    }
+
+    test_env_init();
+    for (int i = 0; i < NAME_NUM; i++) {
+        char utf8[NAME_MAX_CHARS * 3 + 1], back[NAME_MAX_CHARS * 2 + 1], tmp[64 * 3 + 1];
+        TEST_ASSERT(Encoding_gbk_to_utf8(utf8, sizeof(utf8), gbk[i]) >= 0);
+        TEST_ASSERT(strcmp(utf8, utf8_ref[i]) == 0);
+        TEST_ASSERT(Encoding_utf8_to_gbk(back, sizeof(back), utf8) >= 0);
+        TEST_ASSERT(strcmp(back, gbk[i]) == 0);
+
+        Encoding_gbk_to_utf8(tmp, sizeof(tmp), junk[i]);
+        TEST_ASSERT(strcmp(tmp, junk_ref[i][0]) == 0);
+        Encoding_utf8_to_gbk(tmp, sizeof(tmp), junk[i]);
+        TEST_ASSERT(strcmp(tmp, junk_ref[i][1]) == 0);
+
+        if (i < 200) {
+            check_truncate(gbk[i], 1);
+            check_truncate(utf8, 0);
+        }
+    }
+    check_all_codes();
+    printf("Encoding: %d names and all GBK codes match FatFs conversion\n", NAME_NUM);
+    return 0;
+}
@@ -0,0 +1,118 @@
+//
+// FatFs的内存盘diskio，卷0和卷1各一个驱动器，test_fs_format时分配并用f_mkfs格式化
+// diskio.h的扇区号类型和f_mkfs的参数随FatFs版本变化，由CMake检测后定义
+// TEST_FATFS_LBA_T 和 TEST_FATFS_MKFS_PARM
+//
+
+#include "ff.h"
+#include "diskio.h"
+#include "test_fs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if TEST_FATFS_LBA_T
+typedef LBA_t ramdisk_lba_t;
+#else
+typedef DWORD ramdisk_lba_t;
+#endif
+
+typedef struct {
+    uint8_t *data;
+    uint32_t sectors;
+    FATFS fs;
+} ramdisk_t;
+
+static ramdisk_t disks[FF_VOLUMES];
+static volatile int inside;
+
+/* FF_FS_REENTRANT为0时FatFs不可重入，两个线程同时访问磁盘说明调用没有串行化 */
+static void ramdisk_enter(const char *func) {
+    if (__atomic_fetch_add(&inside, 1, __ATOMIC_SEQ_CST) != 0) {
+        fprintf(stderr, "ramdisk: concurrent disk access in %s\n", func);
+        abort();
+    }
+}
+
+static void ramdisk_leave(void) {
+    __atomic_sub_fetch(&inside, 1, __ATOMIC_SEQ_CST);
+}
+
+DSTATUS disk_status(BYTE pdrv) {
+    return pdrv < FF_VOLUMES && disks[pdrv].data ? 0 : STA_NOINIT;
+}
+
+DSTATUS disk_initialize(BYTE pdrv) {
+    return disk_status(pdrv);
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, ramdisk_lba_t sector, UINT count) {
+    if (disk_status(pdrv)) return RES_NOTRDY;
+    if (sector + count > disks[pdrv].sectors) return RES_PARERR;
+    ramdisk_enter(__func__);
+    memcpy(buff, disks[pdrv].data + (size_t) sector * FF_MAX_SS, (size_t) count * FF_MAX_SS);
+    ramdisk_leave();
+    return RES_OK;
+}
+
+DRESULT disk_write(BYTE pdrv, const BYTE *buff, ramdisk_lba_t sector, UINT count) {
+    if (disk_status(pdrv)) return RES_NOTRDY;
+    if (sector + count > disks[pdrv].sectors) return RES_PARERR;
+    ramdisk_enter(__func__);
+    memcpy(disks[pdrv].data + (size_t) sector * FF_MAX_SS, buff, (size_t) count * FF_MAX_SS);
+    ramdisk_leave();
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+    if (disk_status(pdrv)) return RES_NOTRDY;
+    switch (cmd) {
+        case CTRL_SYNC:
+            return RES_OK;
+        case GET_SECTOR_COUNT:
+            *(ramdisk_lba_t *) buff = disks[pdrv].sectors;
+            return RES_OK;
+        case GET_SECTOR_SIZE:
+            *(WORD *) buff = FF_MAX_SS;
+            return RES_OK;
+        case GET_BLOCK_SIZE:
+            *(DWORD *) buff = 1;
+            return RES_OK;
+        default:
+            return RES_PARERR;
+    }
+}
+
+DWORD get_fattime(void) {
+    return (DWORD) (2022 - 1980) << 25 | (DWORD) 5 << 21 | (DWORD) 1 << 16;
+}
+
+FRESULT test_fs_format(int vol, uint32_t size, uint32_t cluster) {
+    if (vol < 0 || vol >= FF_VOLUMES) return FR_INVALID_DRIVE;
+    ramdisk_t *d = &disks[vol];
+    char path[4] = {(char) ('0' + vol), ':', 0};
+    f_mount(NULL, path, 0);
+    free(d->data);
+    d->sectors = size / FF_MAX_SS;
+    d->data = calloc(d->sectors, FF_MAX_SS);
+    if (d->data == NULL) return FR_NOT_ENOUGH_CORE;
+
+    static BYTE work[FF_MAX_SS * 8];
+#if TEST_FATFS_MKFS_PARM
+    MKFS_PARM opt = {.fmt = FM_FAT32 | FM_SFD, .au_size = cluster};
+    FRESULT res = f_mkfs(path, &opt, work, sizeof(work));
+    if (res != FR_OK) {
+        opt.fmt = FM_FAT | FM_SFD;
+        res = f_mkfs(path, &opt, work, sizeof(work));
+    }
+#else
+    FRESULT res = f_mkfs(path, FM_FAT32 | FM_SFD, cluster, work, sizeof(work));
+    if (res != FR_OK) res = f_mkfs(path, FM_FAT | FM_SFD, cluster, work, sizeof(work));
+#endif
+    if (res != FR_OK) return res;
+    return f_mount(&d->fs, path, 1);
+}
+
+int test_fs_open_files(void) {
+    return -1;
+}
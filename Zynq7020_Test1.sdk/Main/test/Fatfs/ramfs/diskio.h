@@ -0,0 +1,20 @@
+//
+// 内存文件系统没有diskio层，只提供DiskCache.h等头文件需要的类型
+//
+
+#ifndef TEST_RAMFS_DISKIO_H
+#define TEST_RAMFS_DISKIO_H
+
+#include "ff.h"
+
+typedef BYTE DSTATUS;
+
+typedef enum {
+    RES_OK = 0,
+    RES_ERROR,
+    RES_WRPRT,
+    RES_NOTRDY,
+    RES_PARERR
+} DRESULT;
+
+#endif //TEST_RAMFS_DISKIO_H
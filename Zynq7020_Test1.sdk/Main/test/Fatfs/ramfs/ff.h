@@ -0,0 +1,140 @@
+//
+// 内存文件系统，实现固件用到的FatFs接口子集，没有FatFs源码时代替ff.c
+// 类型和常量与FatFs R0.13一致；FatFs不可重入，同时有两个线程进入任何f_*函数时直接abort
+//
+
+#ifndef TEST_RAMFS_FF_H
+#define TEST_RAMFS_FF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FF_DEFINED      0           /* 不是FatFs，测试代码据此区分 */
+#define FF_VOLUMES      2
+#define FF_USE_LFN      2
+#define FF_MAX_LFN      255
+#define FF_LFN_BUF      255
+#define FF_SFN_BUF      12
+#define FF_LFN_UNICODE  0
+#define FF_CODE_PAGE    936
+#define FF_MIN_SS       512
+#define FF_MAX_SS       512
+#define FF_FS_REENTRANT 0
+#define FF_FS_EXFAT     0
+
+typedef unsigned int UINT;
+typedef unsigned char BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef uint64_t QWORD;
+typedef WORD WCHAR;
+typedef char TCHAR;
+typedef DWORD FSIZE_t;
+
+typedef struct {
+    BYTE fs_type;
+    BYTE pdrv;
+    WORD csize;             //!< 簇大小(扇区)
+    WORD ssize;
+    DWORD n_fatent;         //!< 簇数 + 2
+    DWORD free_clst;
+} FATFS;
+
+typedef struct {
+    FATFS *fs;
+    WORD id;
+    BYTE attr;
+    BYTE stat;
+    DWORD sclust;
+    FSIZE_t objsize;
+} FFOBJID;
+
+typedef struct {
+    FFOBJID obj;
+    BYTE flag;
+    BYTE err;
+    FSIZE_t fptr;
+    void *node;
+} FIL;
+
+typedef struct {
+    FFOBJID obj;
+    DWORD dptr;
+    void *node;
+} DIR;
+
+typedef struct {
+    FSIZE_t fsize;
+    WORD fdate;
+    WORD ftime;
+    BYTE fattrib;
+    TCHAR altname[FF_SFN_BUF + 1];
+    TCHAR fname[FF_LFN_BUF + 1];
+} FILINFO;
+
+typedef enum {
+    FR_OK = 0,
+    FR_DISK_ERR,
+    FR_INT_ERR,
+    FR_NOT_READY,
+    FR_NO_FILE,
+    FR_NO_PATH,
+    FR_INVALID_NAME,
+    FR_DENIED,
+    FR_EXIST,
+    FR_INVALID_OBJECT,
+    FR_WRITE_PROTECTED,
+    FR_INVALID_DRIVE,
+    FR_NOT_ENABLED,
+    FR_NO_FILESYSTEM,
+    FR_MKFS_ABORTED,
+    FR_TIMEOUT,
+    FR_LOCKED,
+    FR_NOT_ENOUGH_CORE,
+    FR_TOO_MANY_OPEN_FILES,
+    FR_INVALID_PARAMETER
+} FRESULT;
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode);
+FRESULT f_close(FIL *fp);
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br);
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw);
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs);
+FRESULT f_truncate(FIL *fp);
+FRESULT f_sync(FIL *fp);
+FRESULT f_opendir(DIR *dp, const TCHAR *path);
+FRESULT f_closedir(DIR *dp);
+FRESULT f_readdir(DIR *dp, FILINFO *fno);
+FRESULT f_mkdir(const TCHAR *path);
+FRESULT f_unlink(const TCHAR *path);
+FRESULT f_rename(const TCHAR *path_old, const TCHAR *path_new);
+FRESULT f_stat(const TCHAR *path, FILINFO *fno);
+FRESULT f_getfree(const TCHAR *path, DWORD *nclst, FATFS **fatfs);
+FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt);
+
+#define f_eof(fp) ((int)((fp)->fptr == (fp)->obj.objsize))
+#define f_error(fp) ((fp)->err)
+#define f_tell(fp) ((fp)->fptr)
+#define f_size(fp) ((fp)->obj.objsize)
+#define f_rewind(fp) f_lseek((fp), 0)
+#define f_rewinddir(dp) f_readdir((dp), 0)
+
+WCHAR ff_oem2uni(WCHAR oem, WORD cp);
+WCHAR ff_uni2oem(DWORD uni, WORD cp);
+DWORD ff_wtoupper(DWORD uni);
+
+#define FA_READ             0x01
+#define FA_WRITE            0x02
+#define FA_OPEN_EXISTING    0x00
+#define FA_CREATE_NEW       0x04
+#define FA_CREATE_ALWAYS    0x08
+#define FA_OPEN_ALWAYS      0x10
+#define FA_OPEN_APPEND      0x30
+
+#define AM_RDO  0x01
+#define AM_HID  0x02
+#define AM_SYS  0x04
+#define AM_DIR  0x10
+#define AM_ARC  0x20
+
+#endif //TEST_RAMFS_FF_H
@@ -0,0 +1,530 @@
+//
+// 内存文件系统，语义按FatFs R0.13：
+// 路径不区分ASCII大小写，GBK双字节字符原样比较；写满卷时f_write返回FR_OK且bw小于btw；
+// 写模式下f_lseek超过文件尾会扩展文件；打开中的文件不能删除(同FF_FS_LOCK)
+//
+
+#include "ff.h"
+#include "test_fs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RAMFS_PATH_MAX  (FF_MAX_LFN * 2 + 8)
+
+typedef struct ramfs_node {
+    struct ramfs_node *next;
+    char path[RAMFS_PATH_MAX];      //!< 规范化路径 "0:/a/b"，根目录为 "0:"
+    int is_dir;
+    uint32_t seq;                   //!< 创建序号，目录按此顺序列出
+    uint8_t *data;
+    FSIZE_t size;
+    size_t capacity;
+    int open_count;
+} ramfs_node;
+
+typedef struct {
+    char path[RAMFS_PATH_MAX];
+    uint32_t next_seq;
+} ramfs_dir;
+
+typedef struct {
+    int formatted;
+    uint32_t size;
+    uint32_t cluster;
+    uint32_t used_clusters;
+    FATFS *fs;
+    FATFS default_fs;
+} ramfs_volume;
+
+static ramfs_node *node_list;
+static uint32_t node_seq;
+static ramfs_volume volumes[FF_VOLUMES];
+static volatile int inside;
+static int open_files;
+
+/* FatFs不可重入，检测两个线程同时进入 */
+#define RAMFS_ENTER() ramfs_enter(__func__)
+#define RAMFS_RETURN(res) do { FRESULT __res = (res); __atomic_sub_fetch(&inside, 1, __ATOMIC_SEQ_CST); return __res; } while (0)
+
+static void ramfs_enter(const char *func) {
+    if (__atomic_fetch_add(&inside, 1, __ATOMIC_SEQ_CST) != 0) {
+        fprintf(stderr, "ramfs: concurrent FatFs call in %s\n", func);
+        abort();
+    }
+}
+
+static int ramfs_is_lead(uint8_t c) {
+    return c >= 0x81 && c <= 0xFE;
+}
+
+/**
+ * 比较路径，ASCII不区分大小写，GBK双字节字符原样比较
+ */
+static int ramfs_path_equal(const char *a, const char *b) {
+    for (;;) {
+        uint8_t ca = *a++, cb = *b++;
+        if (ramfs_is_lead(ca)) {
+            if (ca != cb || *a != *b) return 0;
+            if (*a == 0) return 1;
+            a++;
+            b++;
+            continue;
+        }
+        if (ca >= 'a' && ca <= 'z') ca -= 'a' - 'A';
+        if (cb >= 'a' && cb <= 'z') cb -= 'a' - 'A';
+        if (ca != cb) return 0;
+        if (ca == 0) return 1;
+    }
+}
+
+/**
+ * 路径规范化为 "N:/a/b"，处理 "." ".." 和重复分隔符
+ */
+static FRESULT ramfs_parse(const char *path, int *vol_out, char *out) {
+    int vol = 0;
+    if (path == NULL) return FR_INVALID_NAME;
+    if (path[0] >= '0' && path[0] <= '9' && path[1] == ':') {
+        vol = path[0] - '0';
+        path += 2;
+    }
+    if (vol >= FF_VOLUMES) return FR_INVALID_DRIVE;
+    if (volumes[vol].fs == NULL) return FR_NOT_ENABLED;
+    if (!volumes[vol].formatted) return FR_NO_FILESYSTEM;
+
+    size_t len = (size_t) sprintf(out, "%d:", vol);
+    while (*path) {
+        while (*path == '/' || *path == '\\') path++;
+        if (*path == 0) break;
+        const char *start = path;
+        while (*path && *path != '/' && *path != '\\') path += ramfs_is_lead((uint8_t) *path) && path[1] ? 2 : 1;
+        size_t comp = path - start;
+        if (comp == 1 && start[0] == '.') continue;
+        if (comp == 2 && start[0] == '.' && start[1] == '.') {
+            char *slash = strrchr(out, '/');
+            if (slash) {
+                *slash = 0;
+                len = slash - out;
+            }
+            continue;
+        }
+        if (comp > FF_MAX_LFN || len + comp + 2 > RAMFS_PATH_MAX) return FR_INVALID_NAME;
+        out[len++] = '/';
+        memcpy(out + len, start, comp);
+        len += comp;
+        out[len] = 0;
+    }
+    if (vol_out) *vol_out = vol;
+    return FR_OK;
+}
+
+static int ramfs_is_root(const char *path) {
+    return strchr(path, '/') == NULL;
+}
+
+static ramfs_node *ramfs_find(const char *path) {
+    for (ramfs_node *n = node_list; n; n = n->next)
+        if (ramfs_path_equal(n->path, path)) return n;
+    return NULL;
+}
+
+/**
+ * 上级目录是否存在
+ */
+static int ramfs_parent_exists(const char *path) {
+    char parent[RAMFS_PATH_MAX];
+    strcpy(parent, path);
+    char *slash = strrchr(parent, '/');
+    if (slash == NULL) return 0;
+    *slash = 0;
+    if (ramfs_is_root(parent)) return 1;
+    ramfs_node *n = ramfs_find(parent);
+    return n && n->is_dir;
+}
+
+static int ramfs_is_child(const char *dir, const char *path) {
+    const char *slash = strrchr(path, '/');
+    if (slash == NULL) return 0;
+    size_t len = slash - path;
+    char parent[RAMFS_PATH_MAX];
+    memcpy(parent, path, len);
+    parent[len] = 0;
+    return ramfs_path_equal(parent, dir);
+}
+
+static uint32_t ramfs_clusters(const ramfs_volume *v, FSIZE_t size) {
+    return (uint32_t) ((size + v->cluster - 1) / v->cluster);
+}
+
+static uint32_t ramfs_total_clusters(const ramfs_volume *v) {
+    return v->size / v->cluster;
+}
+
+static ramfs_node *ramfs_create(const char *path, int is_dir) {
+    ramfs_node *n = calloc(1, sizeof(ramfs_node));
+    if (n == NULL) return NULL;
+    strcpy(n->path, path);
+    n->is_dir = is_dir;
+    n->seq = ++node_seq;
+    ramfs_node **tail = &node_list;
+    while (*tail) tail = &(*tail)->next;
+    *tail = n;
+    return n;
+}
+
+static void ramfs_remove(ramfs_node *n) {
+    for (ramfs_node **p = &node_list; *p; p = &(*p)->next) {
+        if (*p == n) {
+            *p = n->next;
+            break;
+        }
+    }
+    free(n->data);
+    free(n);
+}
+
+static ramfs_volume *ramfs_volume_of(const ramfs_node *n) {
+    return &volumes[n->path[0] - '0'];
+}
+
+/**
+ * 调整文件长度，超出卷容量时只扩展到能容纳的长度
+ * @return 调整后的长度
+ */
+static FSIZE_t ramfs_resize(ramfs_node *n, FSIZE_t size) {
+    ramfs_volume *v = ramfs_volume_of(n);
+    uint32_t old_clusters = ramfs_clusters(v, n->size);
+    uint32_t free_clusters = ramfs_total_clusters(v) - v->used_clusters;
+    if (ramfs_clusters(v, size) > old_clusters + free_clusters)
+        size = (FSIZE_t) (old_clusters + free_clusters) * v->cluster;
+    if (size > n->capacity) {
+        size_t capacity = n->capacity ? n->capacity : 4096;
+        while (capacity < size) capacity *= 2;
+        uint8_t *data = realloc(n->data, capacity);
+        if (data == NULL) return n->size;
+        memset(data + n->capacity, 0, capacity - n->capacity);
+        n->data = data;
+        n->capacity = capacity;
+    }
+    if (size < n->size) memset(n->data + size, 0, n->size - size);
+    v->used_clusters = v->used_clusters - old_clusters + ramfs_clusters(v, size);
+    n->size = size;
+    return size;
+}
+
+static FRESULT ramfs_not_found(const char *path) {
+    return ramfs_parent_exists(path) ? FR_NO_FILE : FR_NO_PATH;
+}
+
+FRESULT f_open(FIL *fp, const TCHAR *path, BYTE mode) {
+    if (fp == NULL) return FR_INVALID_OBJECT;
+    RAMFS_ENTER();
+    memset(fp, 0, sizeof(FIL));
+    char norm[RAMFS_PATH_MAX];
+    int vol;
+    FRESULT res = ramfs_parse(path, &vol, norm);
+    if (res != FR_OK) RAMFS_RETURN(res);
+    if (ramfs_is_root(norm)) RAMFS_RETURN(FR_INVALID_NAME);
+
+    ramfs_node *n = ramfs_find(norm);
+    if (n && n->is_dir) RAMFS_RETURN(FR_NO_FILE);
+    if (mode & (FA_CREATE_NEW | FA_CREATE_ALWAYS | FA_OPEN_ALWAYS)) {
+        if (n) {
+            if (mode & FA_CREATE_NEW) RAMFS_RETURN(FR_EXIST);
+            if (n->open_count) RAMFS_RETURN(FR_LOCKED);
+            if (mode & FA_CREATE_ALWAYS) ramfs_resize(n, 0);
+        } else {
+            if (!ramfs_parent_exists(norm)) RAMFS_RETURN(FR_NO_PATH);
+            n = ramfs_create(norm, 0);
+            if (n == NULL) RAMFS_RETURN(FR_NOT_ENOUGH_CORE);
+        }
+    } else if (n == NULL) {
+        RAMFS_RETURN(ramfs_not_found(norm));
+    }
+    if ((mode & FA_WRITE) && n->open_count) RAMFS_RETURN(FR_LOCKED);
+
+    n->open_count++;
+    open_files++;
+    fp->node = n;
+    fp->flag = mode & (FA_READ | FA_WRITE);
+    fp->obj.fs = volumes[vol].fs;
+    fp->obj.objsize = n->size;
+    fp->fptr = (mode & FA_OPEN_APPEND) == FA_OPEN_APPEND ? n->size : 0;
+    RAMFS_RETURN(FR_OK);
+}
+
+static int ramfs_valid(const FIL *fp) {
+    return fp && fp->node && fp->obj.fs;
+}
+
+FRESULT f_close(FIL *fp) {
+    RAMFS_ENTER();
+    if (!ramfs_valid(fp)) RAMFS_RETURN(FR_INVALID_OBJECT);
+    ramfs_node *n = fp->node;
+    n->open_count--;
+    open_files--;
+    fp->node = NULL;
+    fp->obj.fs = NULL;
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_read(FIL *fp, void *buff, UINT btr, UINT *br) {
+    RAMFS_ENTER();
+    *br = 0;
+    if (!ramfs_valid(fp)) RAMFS_RETURN(FR_INVALID_OBJECT);
+    if (!(fp->flag & FA_READ)) RAMFS_RETURN(FR_DENIED);
+    ramfs_node *n = fp->node;
+    FSIZE_t size = fp->obj.objsize < n->size ? fp->obj.objsize : n->size;
+    if (fp->fptr >= size) RAMFS_RETURN(FR_OK);
+    FSIZE_t remain = size - fp->fptr;
+    UINT len = btr < remain ? btr : (UINT) remain;
+    memcpy(buff, n->data + fp->fptr, len);
+    fp->fptr += len;
+    *br = len;
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_write(FIL *fp, const void *buff, UINT btw, UINT *bw) {
+    RAMFS_ENTER();
+    *bw = 0;
+    if (!ramfs_valid(fp)) RAMFS_RETURN(FR_INVALID_OBJECT);
+    if (!(fp->flag & FA_WRITE)) RAMFS_RETURN(FR_DENIED);
+    ramfs_node *n = fp->node;
+    FSIZE_t end = fp->fptr + btw;
+    if (end > n->size) end = ramfs_resize(n, end);
+    UINT len = end > fp->fptr ? (UINT) (end - fp->fptr) : 0;
+    if (len > btw) len = btw;
+    if (len) memcpy(n->data + fp->fptr, buff, len);
+    fp->fptr += len;
+    if (fp->fptr > fp->obj.objsize) fp->obj.objsize = fp->fptr;
+    *bw = len;
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_lseek(FIL *fp, FSIZE_t ofs) {
+    RAMFS_ENTER();
+    if (!ramfs_valid(fp)) RAMFS_RETURN(FR_INVALID_OBJECT);
+    ramfs_node *n = fp->node;
+    if (ofs > fp->obj.objsize) {
+        if (fp->flag & FA_WRITE) {
+            ofs = ramfs_resize(n, ofs) < ofs ? n->size : ofs;
+            fp->obj.objsize = ofs;
+        } else {
+            ofs = fp->obj.objsize;
+        }
+    }
+    fp->fptr = ofs;
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_truncate(FIL *fp) {
+    RAMFS_ENTER();
+    if (!ramfs_valid(fp)) RAMFS_RETURN(FR_INVALID_OBJECT);
+    if (!(fp->flag & FA_WRITE)) RAMFS_RETURN(FR_DENIED);
+    if (fp->fptr < fp->obj.objsize) {
+        ramfs_resize(fp->node, fp->fptr);
+        fp->obj.objsize = fp->fptr;
+    }
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_sync(FIL *fp) {
+    RAMFS_ENTER();
+    RAMFS_RETURN(ramfs_valid(fp) ? FR_OK : FR_INVALID_OBJECT);
+}
+
+FRESULT f_opendir(DIR *dp, const TCHAR *path) {
+    if (dp == NULL) return FR_INVALID_OBJECT;
+    RAMFS_ENTER();
+    memset(dp, 0, sizeof(DIR));
+    char norm[RAMFS_PATH_MAX];
+    int vol;
+    FRESULT res = ramfs_parse(path, &vol, norm);
+    if (res != FR_OK) RAMFS_RETURN(res);
+    if (!ramfs_is_root(norm)) {
+        ramfs_node *n = ramfs_find(norm);
+        if (n == NULL || !n->is_dir) RAMFS_RETURN(FR_NO_PATH);
+    }
+    ramfs_dir *d = calloc(1, sizeof(ramfs_dir));
+    if (d == NULL) RAMFS_RETURN(FR_NOT_ENOUGH_CORE);
+    strcpy(d->path, norm);
+    dp->node = d;
+    dp->obj.fs = volumes[vol].fs;
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_closedir(DIR *dp) {
+    RAMFS_ENTER();
+    if (dp == NULL || dp->node == NULL) RAMFS_RETURN(FR_INVALID_OBJECT);
+    free(dp->node);
+    dp->node = NULL;
+    dp->obj.fs = NULL;
+    RAMFS_RETURN(FR_OK);
+}
+
+static void ramfs_fill_info(const ramfs_node *n, FILINFO *fno) {
+    memset(fno, 0, sizeof(FILINFO));
+    const char *name = strrchr(n->path, '/') + 1;
+    strncpy(fno->fname, name, FF_LFN_BUF);
+    fno->fsize = n->is_dir ? 0 : n->size;
+    fno->fattrib = n->is_dir ? AM_DIR : AM_ARC;
+    fno->fdate = (WORD) ((2022 - 1980) << 9 | 5 << 5 | 1);
+}
+
+FRESULT f_readdir(DIR *dp, FILINFO *fno) {
+    RAMFS_ENTER();
+    if (dp == NULL || dp->node == NULL) RAMFS_RETURN(FR_INVALID_OBJECT);
+    ramfs_dir *d = dp->node;
+    if (fno == NULL) {
+        d->next_seq = 0;
+        RAMFS_RETURN(FR_OK);
+    }
+    for (ramfs_node *n = node_list; n; n = n->next) {
+        if (n->seq >= d->next_seq && ramfs_is_child(d->path, n->path)) {
+            ramfs_fill_info(n, fno);
+            d->next_seq = n->seq + 1;
+            RAMFS_RETURN(FR_OK);
+        }
+    }
+    memset(fno, 0, sizeof(FILINFO));
+    d->next_seq = UINT32_MAX;
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_stat(const TCHAR *path, FILINFO *fno) {
+    RAMFS_ENTER();
+    char norm[RAMFS_PATH_MAX];
+    FRESULT res = ramfs_parse(path, NULL, norm);
+    if (res != FR_OK) RAMFS_RETURN(res);
+    if (ramfs_is_root(norm)) RAMFS_RETURN(FR_INVALID_NAME);
+    ramfs_node *n = ramfs_find(norm);
+    if (n == NULL) RAMFS_RETURN(ramfs_not_found(norm));
+    if (fno) ramfs_fill_info(n, fno);
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_mkdir(const TCHAR *path) {
+    RAMFS_ENTER();
+    char norm[RAMFS_PATH_MAX];
+    int vol;
+    FRESULT res = ramfs_parse(path, &vol, norm);
+    if (res != FR_OK) RAMFS_RETURN(res);
+    if (ramfs_is_root(norm) || ramfs_find(norm)) RAMFS_RETURN(FR_EXIST);
+    if (!ramfs_parent_exists(norm)) RAMFS_RETURN(FR_NO_PATH);
+    ramfs_volume *v = &volumes[vol];
+    if (v->used_clusters >= ramfs_total_clusters(v)) RAMFS_RETURN(FR_DENIED);
+    if (ramfs_create(norm, 1) == NULL) RAMFS_RETURN(FR_NOT_ENOUGH_CORE);
+    v->used_clusters++;
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_unlink(const TCHAR *path) {
+    RAMFS_ENTER();
+    char norm[RAMFS_PATH_MAX];
+    int vol;
+    FRESULT res = ramfs_parse(path, &vol, norm);
+    if (res != FR_OK) RAMFS_RETURN(res);
+    if (ramfs_is_root(norm)) RAMFS_RETURN(FR_INVALID_NAME);
+    ramfs_node *n = ramfs_find(norm);
+    if (n == NULL) RAMFS_RETURN(ramfs_not_found(norm));
+    if (n->open_count) RAMFS_RETURN(FR_LOCKED);
+    if (n->is_dir) {
+        for (ramfs_node *c = node_list; c; c = c->next)
+            if (ramfs_is_child(n->path, c->path)) RAMFS_RETURN(FR_DENIED);
+        volumes[vol].used_clusters--;
+    } else {
+        ramfs_resize(n, 0);
+    }
+    ramfs_remove(n);
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_rename(const TCHAR *path_old, const TCHAR *path_new) {
+    RAMFS_ENTER();
+    char old_norm[RAMFS_PATH_MAX], new_norm[RAMFS_PATH_MAX];
+    int old_vol, new_vol;
+    FRESULT res = ramfs_parse(path_old, &old_vol, old_norm);
+    if (res == FR_OK) res = ramfs_parse(path_new, &new_vol, new_norm);
+    if (res != FR_OK) RAMFS_RETURN(res);
+    if (old_vol != new_vol) RAMFS_RETURN(FR_INVALID_DRIVE);
+    ramfs_node *n = ramfs_find(old_norm);
+    if (n == NULL) RAMFS_RETURN(ramfs_not_found(old_norm));
+    if (ramfs_find(new_norm)) RAMFS_RETURN(FR_EXIST);
+    if (!ramfs_parent_exists(new_norm)) RAMFS_RETURN(FR_NO_PATH);
+    if (n->open_count) RAMFS_RETURN(FR_LOCKED);
+    // 目录改名时子项的路径前缀一起替换
+    size_t old_len = strlen(n->path);
+    for (ramfs_node *c = node_list; c; c = c->next) {
+        if (c != n && n->is_dir && strncmp(c->path, n->path, old_len) == 0 && c->path[old_len] == '/') {
+            char tmp[RAMFS_PATH_MAX];
+            if (snprintf(tmp, sizeof(tmp), "%s%s", new_norm, c->path + old_len) >= (int) sizeof(tmp))
+                RAMFS_RETURN(FR_INVALID_NAME);
+            strcpy(c->path, tmp);
+        }
+    }
+    strcpy(n->path, new_norm);
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT f_getfree(const TCHAR *path, DWORD *nclst, FATFS **fatfs) {
+    RAMFS_ENTER();
+    char norm[RAMFS_PATH_MAX];
+    int vol;
+    FRESULT res = ramfs_parse(path, &vol, norm);
+    if (res != FR_OK) RAMFS_RETURN(res);
+    ramfs_volume *v = &volumes[vol];
+    *nclst = ramfs_total_clusters(v) - v->used_clusters;
+    *fatfs = v->fs;
+    RAMFS_RETURN(FR_OK);
+}
+
+static void ramfs_fill_fs(int vol) {
+    ramfs_volume *v = &volumes[vol];
+    if (v->fs == NULL) return;
+    v->fs->fs_type = 3;
+    v->fs->pdrv = (BYTE) vol;
+    v->fs->ssize = FF_MAX_SS;
+    v->fs->csize = (WORD) (v->cluster / FF_MAX_SS);
+    v->fs->n_fatent = ramfs_total_clusters(v) + 2;
+}
+
+FRESULT f_mount(FATFS *fs, const TCHAR *path, BYTE opt) {
+    int vol = 0;
+    if (path && path[0] >= '0' && path[0] <= '9' && path[1] == ':') vol = path[0] - '0';
+    if (vol >= FF_VOLUMES) return FR_INVALID_DRIVE;
+    RAMFS_ENTER();
+    volumes[vol].fs = fs;
+    if (fs == NULL) RAMFS_RETURN(FR_OK);
+    memset(fs, 0, sizeof(FATFS));
+    if (!volumes[vol].formatted) RAMFS_RETURN(opt ? FR_NO_FILESYSTEM : FR_OK);
+    ramfs_fill_fs(vol);
+    RAMFS_RETURN(FR_OK);
+}
+
+FRESULT test_fs_format(int vol, uint32_t size, uint32_t cluster) {
+    if (vol < 0 || vol >= FF_VOLUMES) return FR_INVALID_DRIVE;
+    if (cluster < FF_MAX_SS || (cluster & (cluster - 1)) || size < cluster) return FR_INVALID_PARAMETER;
+    ramfs_node **p = &node_list;
+    while (*p) {
+        if ((*p)->path[0] - '0' == vol) {
+            ramfs_node *n = *p;
+            *p = n->next;
+            free(n->data);
+            free(n);
+        } else {
+            p = &(*p)->next;
+        }
+    }
+    ramfs_volume *v = &volumes[vol];
+    v->formatted = 1;
+    v->size = size;
+    v->cluster = cluster;
+    v->used_clusters = 0;
+    if (v->fs == NULL) v->fs = &v->default_fs;
+    ramfs_fill_fs(vol);
+    return FR_OK;
+}
+
+int test_fs_open_files(void) {
+    return open_files;
+}
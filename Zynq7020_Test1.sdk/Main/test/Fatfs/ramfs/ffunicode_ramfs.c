@@ -0,0 +1,87 @@
+//
+// 没有FatFs源码时代替ffunicode.c的代码页936转换
+// 表的大小和查找方式与FatFs相同(按键排序的(键,值)对，二分查找)，映射关系是生成的：
+// 每个合法GBK双字节码按固定的乱序对应到CJK统一汉字(U+4E00~U+9FA5)，其余对应到私用区，
+// 保证汉字路径可以往返转换，但具体码位与真实GBK不同
+//
+
+#include "ff.h"
+#include <stdlib.h>
+#include <pthread.h>
+
+#define CP936_LEAD_MIN  0x81
+#define CP936_LEAD_MAX  0xFE
+#define CP936_CJK_FIRST 0x4E00
+#define CP936_CJK_LAST  0x9FA5
+#define CP936_PUA_FIRST 0xE000
+#define CP936_MAX_PAIRS ((CP936_LEAD_MAX - CP936_LEAD_MIN + 1) * 190)
+
+static WCHAR oem2uni[CP936_MAX_PAIRS * 2];
+static WCHAR uni2oem[CP936_MAX_PAIRS * 2];
+static UINT pair_num;
+static pthread_once_t table_once = PTHREAD_ONCE_INIT;
+
+static int cp936_pair_cmp(const void *a, const void *b) {
+    return (int) ((const WCHAR *) a)[0] - (int) ((const WCHAR *) b)[0];
+}
+
+static void cp936_build(void) {
+    static WCHAR uni[CP936_MAX_PAIRS];
+    UINT n = 0;
+    for (UINT u = CP936_CJK_FIRST; u <= CP936_CJK_LAST; u++) uni[n++] = (WCHAR) u;
+    // 固定种子的Fisher-Yates，汉字的GBK顺序与Unicode顺序无关
+    uint32_t seed = 0x936;
+    for (UINT i = n - 1; i > 0; i--) {
+        seed = seed * 1103515245 + 12345;
+        UINT j = (seed >> 8) % (i + 1);
+        WCHAR t = uni[i];
+        uni[i] = uni[j];
+        uni[j] = t;
+    }
+    UINT cjk = n;
+    for (UINT i = cjk; i < CP936_MAX_PAIRS; i++) uni[i] = (WCHAR) (CP936_PUA_FIRST + i - cjk);
+
+    for (UINT lead = CP936_LEAD_MIN; lead <= CP936_LEAD_MAX; lead++) {
+        for (UINT trail = 0x40; trail <= 0xFE; trail++) {
+            if (trail == 0x7F) continue;
+            oem2uni[pair_num * 2] = (WCHAR) (lead << 8 | trail);
+            oem2uni[pair_num * 2 + 1] = uni[pair_num];
+            uni2oem[pair_num * 2] = uni[pair_num];
+            uni2oem[pair_num * 2 + 1] = (WCHAR) (lead << 8 | trail);
+            pair_num++;
+        }
+    }
+    qsort(uni2oem, pair_num, sizeof(WCHAR) * 2, cp936_pair_cmp);
+}
+
+/**
+ * 与FatFs相同的16次二分查找
+ */
+static WCHAR cp936_search(const WCHAR *p, UINT num, WCHAR key) {
+    UINT i = 0, n, li = 0, hi = num - 1;
+    for (n = 16; n; n--) {
+        i = li + (hi - li) / 2;
+        if (key == p[i * 2]) break;
+        if (key > p[i * 2]) li = i;
+        else hi = i;
+    }
+    return n != 0 ? p[i * 2 + 1] : 0;
+}
+
+WCHAR ff_uni2oem(DWORD uni, WORD cp) {
+    if (uni < 0x80) return (WCHAR) uni;
+    if (uni >= 0x10000 || cp != FF_CODE_PAGE) return 0;
+    pthread_once(&table_once, cp936_build);
+    return cp936_search(uni2oem, pair_num, (WCHAR) uni);
+}
+
+WCHAR ff_oem2uni(WCHAR oem, WORD cp) {
+    if (oem < 0x80) return oem;
+    if (cp != FF_CODE_PAGE) return 0;
+    pthread_once(&table_once, cp936_build);
+    return cp936_search(oem2uni, pair_num, oem);
+}
+
+DWORD ff_wtoupper(DWORD uni) {
+    return uni >= 'a' && uni <= 'z' ? uni - ('a' - 'A') : uni;
+}
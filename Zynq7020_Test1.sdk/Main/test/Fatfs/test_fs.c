@@ -0,0 +1,33 @@
+//
+// 测试用文件系统的公共部分，只使用FatFs接口，两种后端通用
+//
+
+#include "test_fs.h"
+#include <stdlib.h>
+
+FRESULT test_fs_write_file(const char *path, const void *data, size_t len) {
+    FIL file;
+    FRESULT res = f_open(&file, path, FA_CREATE_ALWAYS | FA_WRITE);
+    if (res != FR_OK) return res;
+    UINT bw = 0;
+    res = f_write(&file, data, (UINT) len, &bw);
+    if (res == FR_OK && bw != len) res = FR_DENIED;
+    FRESULT close_res = f_close(&file);
+    return res != FR_OK ? res : close_res;
+}
+
+void *test_fs_read_file(const char *path, size_t *len) {
+    FIL file;
+    if (f_open(&file, path, FA_READ) != FR_OK) return NULL;
+    size_t size = f_size(&file);
+    void *buf = malloc(size ? size : 1);
+    UINT br = 0;
+    if (buf == NULL || f_read(&file, buf, (UINT) size, &br) != FR_OK || br != size) {
+        free(buf);
+        f_close(&file);
+        return NULL;
+    }
+    f_close(&file);
+    if (len) *len = size;
+    return buf;
+}
@@ -0,0 +1,40 @@
+//
+// 测试用文件系统：卷0和卷1放在内存中，使用FatFs(FATFS_DIR)或内存文件系统
+//
+
+#ifndef TEST_FS_H
+#define TEST_FS_H
+
+#include "ff.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * 建立一个空卷并挂载，已有的卷被清空
+ * @param vol 卷号 0 或 1
+ * @param size 卷容量(字节)，写满后f_write返回的长度小于请求长度
+ * @param cluster 簇大小(字节)，512的2的幂倍
+ * @return FR_OK 或错误码
+ */
+FRESULT test_fs_format(int vol, uint32_t size, uint32_t cluster);
+
+/**
+ * 写入整个文件，上级目录需存在
+ */
+FRESULT test_fs_write_file(const char *path, const void *data, size_t len);
+
+/**
+ * 读取整个文件
+ * @param path 路径
+ * @param len [out] 文件长度
+ * @return malloc分配的内容，需要free，失败返回NULL
+ */
+void *test_fs_read_file(const char *path, size_t *len);
+
+/**
+ * 当前打开的文件数，用于检查泄漏
+ * @return 文件数，使用FatFs时不支持，返回-1
+ */
+int test_fs_open_files(void);
+
+#endif //TEST_FS_H
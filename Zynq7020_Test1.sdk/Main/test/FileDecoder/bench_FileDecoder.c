@@ -0,0 +1,185 @@
+//
+// FileDecoder各格式的解码吞吐(MB/s)和分配峰值
+// 文件放在内存卷上，结果不含SD卡的读取时间，反映解析本身的开销
+// 用法: bench_FileDecoder [文件大小KB] [重复次数]
+//
+
+#include "test_env.h"
+#include "test_fs.h"
+#include "FileDecoder/FileDecoder.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include <string.h>
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} bench_buf_t;
+
+static void bench_append(bench_buf_t *b, const void *data, size_t len) {
+    if (b->len + len > b->cap) {
+        b->cap = (b->len + len) * 2;
+        b->data = realloc(b->data, b->cap);
+        TEST_ASSERT(b->data != NULL);
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+static void bench_printf(bench_buf_t *b, const char *fmt, int value) {
+    char tmp[32];
+    int n = snprintf(tmp, sizeof(tmp), fmt, value);
+    bench_append(b, tmp, n);
+}
+
+static uint32_t bench_rand(void) {
+    static uint32_t seed = 20220201;
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static void bench_gen_csv(bench_buf_t *b, size_t size) {
+    for (int i = 0; b->len < size; i++)
+        bench_printf(b, i % 16 == 15 ? "%d\n" : "%d,", (int) (bench_rand() % 256) - 128);
+}
+
+static void bench_gen_bin(bench_buf_t *b, size_t size) {
+    while (b->len < size) {
+        uint8_t v = bench_rand();
+        bench_append(b, &v, 1);
+    }
+}
+
+static void bench_gen_json(bench_buf_t *b, size_t size) {
+    bench_append(b, "{\"name\":\"bench\",\"data\":[", 24);
+    for (int i = 0; b->len < size; i++)
+        bench_printf(b, i ? ",%d" : "%d", (int) (bench_rand() % 256) - 128);
+    bench_append(b, "]}", 2);
+}
+
+static void bench_gen_coe(bench_buf_t *b, size_t size) {
+    static const char head[] = "; FIR\nradix=10;\ncoefficient_width=16;\ncoefdata=\n";
+    bench_append(b, head, sizeof(head) - 1);
+    for (int i = 0; b->len < size; i++)
+        bench_printf(b, i ? ",\n%d" : "%d", (int) (bench_rand() % 65536) - 32768);
+    bench_append(b, ";\n", 2);
+}
+
+static void bench_gen_mem(bench_buf_t *b, size_t size) {
+    bench_append(b, "@0\n", 3);
+    for (int i = 0; b->len < size; i++)
+        bench_printf(b, i % 8 == 7 ? "%04x\n" : "%04x ", (int) (bench_rand() % 65536));
+}
+
+static void bench_gen_wav(bench_buf_t *b, size_t size) {
+    uint32_t frames = size / 4;
+    uint32_t data_size = frames * 4;
+    uint8_t hdr[44];
+    memcpy(hdr, "RIFF", 4);
+    uint32_t riff_size = 36 + data_size;
+    memcpy(hdr + 4, &riff_size, 4);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    uint32_t fmt_size = 16, sample_rate = 48000, byte_rate = 48000 * 4;
+    uint16_t format = 1, channels = 2, block_align = 4, bits = 16;
+    memcpy(hdr + 16, &fmt_size, 4);
+    memcpy(hdr + 20, &format, 2);
+    memcpy(hdr + 22, &channels, 2);
+    memcpy(hdr + 24, &sample_rate, 4);
+    memcpy(hdr + 28, &byte_rate, 4);
+    memcpy(hdr + 32, &block_align, 2);
+    memcpy(hdr + 34, &bits, 2);
+    memcpy(hdr + 36, "data", 4);
+    memcpy(hdr + 40, &data_size, 4);
+    bench_append(b, hdr, sizeof(hdr));
+    for (uint32_t i = 0; i < frames; i++) {
+        uint32_t v = bench_rand();
+        bench_append(b, &v, 4);
+    }
+}
+
+typedef struct {
+    const char *name;
+    const char *field;
+    void (*gen)(bench_buf_t *b, size_t size);
+} bench_format_t;
+
+static const bench_format_t formats[] = {
+        {"bench.csv",  NULL,    bench_gen_csv},
+        {"bench.bin",  NULL,    bench_gen_bin},
+        {"bench.json", "data",  bench_gen_json},
+        {"bench.coe",  NULL,    bench_gen_coe},
+        {"bench.mem",  NULL,    bench_gen_mem},
+        {"bench.wav",  "声道2", bench_gen_wav},
+};
+
+static const os_mem_tag_t peak_tags[] = {OS_MEM_TAG_FILE_DECODER, OS_MEM_TAG_CJSON, OS_MEM_TAG_OTHER};
+#define PEAK_TAG_NUM (sizeof(peak_tags) / sizeof(peak_tags[0]))
+
+/**
+ * 解码repeat次
+ * @param peak [out] 各标签相对调用前的峰值
+ * @return 平均每次的耗时(ns)
+ */
+static uint64_t bench_run(const bench_format_t *f, const bench_buf_t *b, int from_file, int repeat,
+                          uint32_t peak[PEAK_TAG_NUM]) {
+    char path[32];
+    snprintf(path, sizeof(path), "0:/%s", f->name);
+    uint32_t base[PEAK_TAG_NUM];
+    for (int i = 0; i < PEAK_TAG_NUM; i++) {
+        os_mem_tag_stats_t stats;
+        os_mem_reset_tag_peak(peak_tags[i]);
+        os_mem_get_tag_stats(peak_tags[i], &stats);
+        base[i] = stats.used;
+    }
+
+    uint64_t start = test_env_now_ns();
+    for (int n = 0; n < repeat; n++) {
+        FDType type;
+        int8_t *p;
+        size_t len;
+        FDStatus status = from_file
+                          ? FileDecoder_open(path, f->field, &type, &p, &len)
+                          : FileDecoder_open_buffer(f->name, b->data, b->len, f->field, &type, &p, &len);
+        if (status != FDStatus_ok) fprintf(stderr, "%s: %s\n", f->name, FileDecoder_status_string(status));
+        TEST_ASSERT(status == FDStatus_ok);
+        os_free(p);
+    }
+    uint64_t elapsed = (test_env_now_ns() - start) / repeat;
+
+    for (int i = 0; i < PEAK_TAG_NUM; i++) {
+        os_mem_tag_stats_t stats;
+        os_mem_get_tag_stats(peak_tags[i], &stats);
+        peak[i] = stats.peak - base[i];
+    }
+    return elapsed ? elapsed : 1;
+}
+
+int main(int argc, char **argv) {
+    size_t size = (argc > 1 ? strtoul(argv[1], NULL, 10) : 1024) * 1024;
+    int repeat = argc > 2 ? atoi(argv[2]) : 5;
+    if (repeat < 1) repeat = 1;
+    test_env_init();
+    uint32_t alloc_count = test_env_alloc_count();
+
+    printf("FileDecoder  file %zu KB  repeat %d\n", size / 1024, repeat);
+    printf("%-6s %10s %10s %12s %12s %10s\n", "format", "file MB/s", "buf MB/s", "peak FD(B)", "peak cJSON", "peak/file");
+    for (int i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        const bench_format_t *f = &formats[i];
+        bench_buf_t b = {0};
+        f->gen(&b, size);
+        char path[32];
+        snprintf(path, sizeof(path), "0:/%s", f->name);
+        TEST_ASSERT(test_fs_write_file(path, b.data, b.len) == FR_OK);
+
+        uint32_t peak_file[PEAK_TAG_NUM], peak_buf[PEAK_TAG_NUM];
+        uint64_t ns_file = bench_run(f, &b, 1, repeat, peak_file);
+        uint64_t ns_buf = bench_run(f, &b, 0, repeat, peak_buf);
+        uint32_t peak = peak_file[0] + peak_file[1] + peak_file[2];
+        printf("%-6s %10.1f %10.1f %12u %12u %9.2fx\n", strchr(f->name, '.') + 1,
+               b.len * 1e3 / ns_file, b.len * 1e3 / ns_buf,
+               peak_file[0] + peak_file[2], peak_file[1], (double) peak / b.len);
+        free(b.data);
+    }
+    TEST_ASSERT(test_env_alloc_count() == alloc_count);
+    return 0;
+}
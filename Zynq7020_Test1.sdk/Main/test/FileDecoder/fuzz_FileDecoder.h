@@ -0,0 +1,40 @@
+//
+// FileDecoder模糊测试的公共部分：
+// 同一份输入分别从内存缓冲区和内存卷上的文件解码，两条路径的结果必须相同，
+// 每次调用前后各标签的分配块数必须相同
+//
+
+#ifndef FUZZ_FILEDECODER_H
+#define FUZZ_FILEDECODER_H
+
+#include "test_env.h"
+#include "test_fs.h"
+#include "FileDecoder/FileDecoder.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include <string.h>
+
+/* 按首字节选择的文件类型，顺序固定，语料文件名的前缀与之对应 */
+static const char *const fuzz_fd_names[] = {"fuzz.csv", "fuzz.bin", "fuzz.json", "fuzz.coe", "fuzz.wav", "fuzz.mem"};
+static const char *const fuzz_fd_fields[] = {NULL, NULL, "data", NULL, "声道1", NULL};
+#define FUZZ_FD_TYPE_NUM (sizeof(fuzz_fd_names) / sizeof(fuzz_fd_names[0]))
+
+/**
+ * 写入卷0根目录
+ * @param path [out] 完整路径
+ */
+static inline void fuzz_fd_write(char *path, size_t size, const char *name, const uint8_t *data, size_t len) {
+    snprintf(path, size, "0:/%s", name);
+    TEST_ASSERT(test_fs_write_file(path, data, len) == FR_OK);
+}
+
+static inline void fuzz_fd_check_result(FDStatus s1, FDStatus s2, const void *p1, const void *p2,
+                                        size_t len1, size_t len2, size_t elem) {
+    if (s1 != s2) fprintf(stderr, "buffer: %s file: %s\n", FileDecoder_status_string(s1), FileDecoder_status_string(s2));
+    TEST_ASSERT(s1 == s2);
+    if (s1 != FDStatus_ok) return;
+    TEST_ASSERT(len1 == len2);
+    TEST_ASSERT(len1 > 0 && p1 != NULL && p2 != NULL);
+    TEST_ASSERT(memcmp(p1, p2, len1 * elem) == 0);
+}
+
+#endif //FUZZ_FILEDECODER_H
@@ -0,0 +1,38 @@
+//
+// FileDecoder_open_coe / FileDecoder_open_coe_buffer，首字节最低位选择coe或mem
+//
+
+#include "fuzz_FileDecoder.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size < 1) return 0;
+    test_env_init();
+    const char *name = data[0] & 1 ? "fuzz.mem" : "fuzz.coe";
+    data++;
+    size--;
+    uint32_t before = test_env_alloc_count();
+
+    int32_t *p1 = NULL, *p2 = NULL;
+    size_t len1 = 0, len2 = 0;
+    int width1 = 0, width2 = 0;
+    FDStatus s1 = FileDecoder_open_coe_buffer(name, data, size, &p1, &len1, &width1);
+
+    char path[32];
+    fuzz_fd_write(path, sizeof(path), name, data, size);
+    FDStatus s2 = FileDecoder_open_coe(path, &p2, &len2, &width2);
+
+    fuzz_fd_check_result(s1, s2, p1, p2, len1, len2, sizeof(int32_t));
+    if (s1 == FDStatus_ok) {
+        TEST_ASSERT(width1 == width2);
+        TEST_ASSERT(width1 >= 1 && width1 <= 32);
+        /* 系数按位宽符号扩展 */
+        for (size_t i = 0; i < len1; i++) {
+            int64_t limit = (int64_t) 1 << (width1 - 1);
+            TEST_ASSERT(p1[i] >= -limit && p1[i] < limit);
+        }
+        os_free(p1);
+        os_free(p2);
+    }
+    TEST_ASSERT(test_env_alloc_count() == before);
+    return 0;
+}
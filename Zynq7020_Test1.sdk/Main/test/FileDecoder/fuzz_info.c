@@ -0,0 +1,32 @@
+//
+// 只有文件接口的FileDecoder_get_json_field和FileDecoder_get_wav_info
+//
+
+#include "fuzz_FileDecoder.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    test_env_init();
+    uint32_t before = test_env_alloc_count();
+    char path[32];
+
+    fuzz_fd_write(path, sizeof(path), "fuzz.json", data, size);
+    char **fields = NULL;
+    size_t num = 0;
+    if (FileDecoder_get_json_field(path, &fields, &num) == FDStatus_ok) {
+        for (size_t i = 0; i < num; i++) {
+            TEST_ASSERT(fields[i] != NULL);
+            os_free(fields[i]);
+        }
+        os_free(fields);
+    }
+
+    fuzz_fd_write(path, sizeof(path), "fuzz.wav", data, size);
+    FDWavInfo info;
+    if (FileDecoder_get_wav_info(path, &info) == FDStatus_ok) {
+        TEST_ASSERT(info.channels > 0);
+        TEST_ASSERT(info.format == 1 || info.format == 3);
+    }
+
+    TEST_ASSERT(test_env_alloc_count() == before);
+    return 0;
+}
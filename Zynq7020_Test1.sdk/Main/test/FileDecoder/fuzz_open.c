@@ -0,0 +1,34 @@
+//
+// FileDecoder_open / FileDecoder_open_buffer，首字节选择文件类型
+//
+
+#include "fuzz_FileDecoder.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size < 1) return 0;
+    test_env_init();
+    unsigned sel = data[0] % FUZZ_FD_TYPE_NUM;
+    const char *field = fuzz_fd_fields[sel];
+    data++;
+    size--;
+    uint32_t before = test_env_alloc_count();
+
+    FDType t1, t2;
+    int8_t *p1 = NULL, *p2 = NULL;
+    size_t len1 = 0, len2 = 0;
+    FDStatus s1 = FileDecoder_open_buffer(fuzz_fd_names[sel], data, size, field, &t1, &p1, &len1);
+
+    char path[32];
+    fuzz_fd_write(path, sizeof(path), fuzz_fd_names[sel], data, size);
+    FDStatus s2 = FileDecoder_open(path, field, &t2, &p2, &len2);
+
+    TEST_ASSERT(t1 == t2);
+    size_t elem = t1 == FDType_coe || t1 == FDType_mem ? sizeof(int16_t) : sizeof(int8_t);
+    fuzz_fd_check_result(s1, s2, p1, p2, len1, len2, elem);
+    if (s1 == FDStatus_ok) {
+        os_free(p1);
+        os_free(p2);
+    }
+    TEST_ASSERT(test_env_alloc_count() == before);
+    return 0;
+}
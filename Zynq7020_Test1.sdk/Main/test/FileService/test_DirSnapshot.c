@@ -0,0 +1,96 @@
+//
+// 经FileService修改文件系统时目录快照的失效：路径可以不带卷号、以'/'开头、用'\'分隔、
+// 大小写不同或带"."和".."(TFTP直接传入客户端的文件名)；rm -rf使被删除目录下的快照失效，
+// 名称前缀相同的其它目录不受影响
+//
+
+#include "test_env.h"
+#include "FileService/FileService.h"
+#include "FileService/DirSnapshot.h"
+#include "xstatus.h"
+#include <string.h>
+
+/**
+ * 打开快照并等待读取完成
+ */
+static DirSnapshot *open_wait(const char *dir) {
+    DirSnapshot *snap = DirSnapshot_open(dir);
+    TEST_ASSERT(snap != NULL);
+    while (!snap->complete) vTaskDelay(1);
+    return snap;
+}
+
+static void create(const char *path) {
+    FIL fp;
+    TEST_ASSERT(FileService_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+    TEST_ASSERT(FileService_close(&fp) == FR_OK);
+}
+
+/**
+ * 修改后旧快照失效，重新打开得到新内容
+ */
+static void expect_count(DirSnapshot *old, const char *dir, uint32_t count) {
+    TEST_ASSERT(old->stale);
+    DirSnapshot_release(old);
+    DirSnapshot *snap = open_wait(dir);
+    TEST_ASSERT(snap->result == FR_OK && snap->count == count);
+    DirSnapshot_release(snap);
+}
+
+static void test_paths(void) {
+    TEST_ASSERT(FileService_mkdir_p("0:/a/b") == FR_OK);
+    TEST_ASSERT(FileService_mkdir_p("0:/ab") == FR_OK);
+
+    DirSnapshot *b = open_wait("0:/a/b/");
+    DirSnapshot *a = open_wait("0:/a");
+    TEST_ASSERT(b->result == FR_OK && b->count == 0 && a->count == 1);
+
+    /* 不带卷号的相对路径 */
+    create("a/b/x.bin");
+    TEST_ASSERT(a->stale);
+    DirSnapshot_release(a);
+    expect_count(b, "0:/a/b", 1);
+
+    /* 以'/'开头、'\'分隔、重复分隔符和不同的大小写 */
+    b = open_wait("0:/a/b");
+    create("/A\\b//y.bin");
+    expect_count(b, "0:/a/b", 2);
+
+    /* "."和".." */
+    b = open_wait("0:/a/b");
+    create("0:/a/./c/../b/z.bin");
+    expect_count(b, "0:/a/b", 3);
+
+    /* 名称前缀相同的目录不受影响 */
+    a = open_wait("0:/a");
+    create("0:/ab/x.bin");
+    TEST_ASSERT(!a->stale);
+    DirSnapshot_release(a);
+}
+
+static void test_rm_rf(void) {
+    DirSnapshot *b = open_wait("0:/a/b");
+    DirSnapshot *root = open_wait("0:/");
+    TEST_ASSERT(b->count == 3);
+    TEST_ASSERT(FileService_rm_rf("a") == FR_OK);
+    TEST_ASSERT(b->stale && root->stale);
+    DirSnapshot_release(root);
+    DirSnapshot_release(b);
+
+    /* 被删除的目录不再返回缓存的内容 */
+    b = DirSnapshot_open("0:/a/b");
+    TEST_ASSERT(b != NULL);
+    while (!b->complete) vTaskDelay(1);
+    TEST_ASSERT(b->result != FR_OK);
+    DirSnapshot_release(b);
+}
+
+int main(void) {
+    test_env_init();
+    TEST_ASSERT(DirSnapshot_init() == XST_SUCCESS);
+    TEST_ASSERT(FileService_init() == XST_SUCCESS);
+    test_paths();
+    test_rm_rf();
+    printf("DirSnapshot: FileService paths and rm -rf invalidate snapshots\n");
+    return 0;
+}
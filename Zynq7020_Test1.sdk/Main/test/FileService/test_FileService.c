@@ -0,0 +1,138 @@
+//
+// 多个任务同时经文件服务访问文件系统：解码文件、定位读取、mkdir -p / rm -rf、查询空闲空间、目录快照
+// FatFs不可重入，内存卷在两个线程同时进入时abort，通过即说明所有访问都已串行化
+//
+
+#include "test_env.h"
+#include "test_fs.h"
+#include "FileService/FileService.h"
+#include "FileService/DirSnapshot.h"
+#include "Fatfs_init/Fatfs_Driver.h"
+#include "FileDecoder/FileDecoder.h"
+#include "semphr.h"
+#include "xstatus.h"
+#include <string.h>
+
+#define TEST_ROUNDS 200
+#define TEST_CSV_LEN 4096
+
+static SemaphoreHandle_t done_sem;
+static char *csv;
+static size_t csv_len;
+
+static void task_decode(void *p) {
+    (void) p;
+    for (int i = 0; i < TEST_ROUNDS; i++) {
+        FDType type;
+        int8_t *data;
+        size_t len;
+        TEST_ASSERT(FileDecoder_open("0:/data/wave.csv", NULL, &type, &data, &len) == FDStatus_ok);
+        TEST_ASSERT(type == FDType_csv && len == TEST_CSV_LEN);
+        os_free(data);
+    }
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+/* 同一个文件对象的定位和读取在一次请求中完成，其它任务移动文件指针不影响结果 */
+static void task_pread(void *p) {
+    (void) p;
+    FIL fp;
+    TEST_ASSERT(FileService_open(&fp, "0:/data/wave.csv", FA_READ) == FR_OK);
+    for (int i = 0; i < TEST_ROUNDS; i++) {
+        char buf[64];
+        UINT br;
+        FSIZE_t ofs = (FSIZE_t) i * 37 % csv_len;
+        TEST_ASSERT(FileService_pread(&fp, ofs, buf, sizeof(buf), &br) == FR_OK);
+        size_t expect = csv_len - ofs < sizeof(buf) ? csv_len - ofs : sizeof(buf);
+        TEST_ASSERT(br == expect && memcmp(buf, csv + ofs, br) == 0);
+    }
+    /* 超出文件末尾时读到0字节 */
+    UINT br = 1;
+    char c;
+    TEST_ASSERT(FileService_pread(&fp, csv_len + 10, &c, 1, &br) == FR_OK && br == 0);
+    TEST_ASSERT(FileService_close(&fp) == FR_OK);
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+static void task_tree(void *p) {
+    int id = (int) (intptr_t) p;
+    char root[32], dir[64], file[80];
+    snprintf(root, sizeof(root), "0:/tmp%d", id);
+    snprintf(dir, sizeof(dir), "%s/a/b", root);
+    snprintf(file, sizeof(file), "%s/f.bin", dir);
+    for (int i = 0; i < TEST_ROUNDS; i++) {
+        TEST_ASSERT(FileService_mkdir_p(dir) == FR_OK);
+        FIL fp;
+        UINT bw;
+        TEST_ASSERT(FileService_open(&fp, file, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK);
+        TEST_ASSERT(FileService_write(&fp, file, sizeof(file), &bw) == FR_OK && bw == sizeof(file));
+        TEST_ASSERT(FileService_close(&fp) == FR_OK);
+        TEST_ASSERT(FileService_rm_rf(root) == FR_OK);
+        FILINFO info;
+        TEST_ASSERT(FileService_stat(root, &info) == FR_NO_FILE);
+    }
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+static void task_getfree(void *p) {
+    (void) p;
+    for (int i = 0; i < TEST_ROUNDS; i++) {
+        FSIZE_t total, free_size;
+        TEST_ASSERT(Fatfs_GetVolSize("0:/", &total, &free_size) == XST_SUCCESS);
+        TEST_ASSERT(free_size <= total && total > 0);
+    }
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+static void task_snapshot(void *p) {
+    (void) p;
+    for (int i = 0; i < TEST_ROUNDS; i++) {
+        DirSnapshot *snap = DirSnapshot_open("0:/data");
+        TEST_ASSERT(snap != NULL);
+        while (!snap->complete) vTaskDelay(1);
+        TEST_ASSERT(snap->result == FR_OK && snap->count == 1);
+        DirSnapshot_release(snap);
+        /* 使缓存失效，下一轮重新扫描 */
+        DirSnapshot_invalidate("0:/data/wave.csv");
+    }
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+int main(void) {
+    test_env_init();
+    TEST_ASSERT(DirSnapshot_init() == XST_SUCCESS);
+    TEST_ASSERT(FileService_init() == XST_SUCCESS);
+
+    csv = malloc(TEST_CSV_LEN * 4);
+    for (int i = 0; i < TEST_CSV_LEN; i++)
+        csv_len += sprintf(csv + csv_len, "%d,", i % 200 - 100);
+    TEST_ASSERT(FileService_mkdir_p("0:/data") == FR_OK);
+    TEST_ASSERT(test_fs_write_file("0:/data/wave.csv", csv, csv_len) == FR_OK);
+
+    done_sem = xSemaphoreCreateCounting(8, 0);
+    static const struct {
+        TaskFunction_t code;
+        const char *name;
+        intptr_t param;
+    } tasks[] = {
+            {task_decode,   "decode",   0},
+            {task_pread,    "pread",    0},
+            {task_tree,     "tree0",    0},
+            {task_tree,     "tree1",    1},
+            {task_getfree,  "getfree",  0},
+            {task_snapshot, "snapshot", 0},
+    };
+    int task_num = sizeof(tasks) / sizeof(tasks[0]);
+    for (int i = 0; i < task_num; i++)
+        TEST_ASSERT(xTaskCreate(tasks[i].code, tasks[i].name, 1024, (void *) tasks[i].param, 2, NULL) == pdPASS);
+    for (int i = 0; i < task_num; i++)
+        TEST_ASSERT(xSemaphoreTake(done_sem, pdMS_TO_TICKS(60000)) == pdTRUE);
+    printf("FileService: %d tasks x %d rounds without concurrent FatFs access\n", task_num, TEST_ROUNDS);
+    free(csv);
+    return 0;
+}
@@ -0,0 +1,89 @@
+//
+// 分配器每次操作的耗时：固件原来的临界区包装newlib malloc，对比尺寸类 + TLSF
+// 主机上临界区、调度器挂起和屏蔽中断都由同一把锁模拟，多任务时反映的是锁的持有时间
+// 用法: bench_FreeRTOS_Mem [每个任务的操作数]
+//
+
+#include "mem_workload.h"
+#include "task.h"
+#include "semphr.h"
+
+static void *wrap_alloc(size_t size, os_mem_tag_t tag) {
+    (void) tag;
+    vPortEnterCritical();
+    void *p = malloc(size);
+    vPortExitCritical();
+    return p;
+}
+
+static void *wrap_realloc(void *p, size_t size) {
+    vPortEnterCritical();
+    p = realloc(p, size);
+    vPortExitCritical();
+    return p;
+}
+
+static void wrap_free(void *p) {
+    vPortEnterCritical();
+    free(p);
+    vPortExitCritical();
+}
+
+static const workload_ops_t wrap_ops = {
+        .alloc = wrap_alloc,
+        .realloc = wrap_realloc,
+        .free = wrap_free,
+};
+
+static const workload_ops_t os_mem_ops = {
+        .alloc = os_malloc_tag,
+        .realloc = os_realloc,
+        .free = os_free,
+};
+
+static SemaphoreHandle_t done_sem;
+
+static void task_workload(void *p) {
+    workload_run(p);
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @return 平均每次操作的纳秒数
+ */
+static double bench(const workload_ops_t *ops, int task_num, int ops_num) {
+    workload_param_t params[4];
+    uint64_t start = test_env_now_ns();
+    for (int i = 0; i < task_num; i++) {
+        params[i] = (workload_param_t) {
+                .ops = ops, .id = i + 1, .ops_num = ops_num, .large_max = 16 * 1024, .check = 0,
+        };
+        TEST_ASSERT(xTaskCreate(task_workload, "bench", 1024, &params[i], 2, NULL) == pdPASS);
+    }
+    for (int i = 0; i < task_num; i++)
+        TEST_ASSERT(xSemaphoreTake(done_sem, portMAX_DELAY) == pdTRUE);
+    return (double) (test_env_now_ns() - start) / ((double) ops_num * task_num);
+}
+
+int main(int argc, char **argv) {
+    int ops_num = argc > 1 ? atoi(argv[1]) : 2000000;
+    if (ops_num < 1) ops_num = 1;
+    done_sem = xSemaphoreCreateCounting(4, 0);
+
+    /* 先各运行一次，让newlib和TLSF的池都扩充到稳定大小 */
+    bench(&wrap_ops, 4, ops_num / 10 + 1);
+    bench(&os_mem_ops, 4, ops_num / 10 + 1);
+
+    printf("FreeRTOS_Mem  %d ops per task  (ns per op)\n", ops_num);
+    printf("%-8s %14s %14s\n", "tasks", "critical+malloc", "os_mem");
+    static const int task_nums[] = {1, 4};
+    for (int i = 0; i < 2; i++) {
+        int n = task_nums[i];
+        double wrap = bench(&wrap_ops, n, ops_num);
+        double mem = bench(&os_mem_ops, n, ops_num);
+        printf("%-8d %14.0f %14.0f\n", n, wrap, mem);
+    }
+    TEST_ASSERT(test_env_alloc_count() == 0);
+    return 0;
+}
@@ -0,0 +1,104 @@
+//
+// 分配器压力负载：每个任务持有一组槽位，随机malloc/realloc/free混合尺寸的块，
+// 块内容按(任务, 槽位, 代数)填充，释放和realloc前检查，被其他任务改写或重复分配时断言失败
+//
+
+#ifndef TEST_MEM_WORKLOAD_H
+#define TEST_MEM_WORKLOAD_H
+
+#include "test_env.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include <string.h>
+
+#define WORKLOAD_SLOTS 256
+
+typedef struct {
+    void *(*alloc)(size_t size, os_mem_tag_t tag);
+    void *(*realloc)(void *p, size_t size);
+    void (*free)(void *p);
+} workload_ops_t;
+
+typedef struct {
+    const workload_ops_t *ops;
+    int id;
+    int ops_num;
+    size_t large_max;       //!< 大块上限，约1/16的请求落在(2KB, large_max]
+    int check;              //!< 检查内容，基准测试时关闭
+} workload_param_t;
+
+typedef struct {
+    void *p;
+    size_t size;
+    uint8_t fill;
+} workload_slot_t;
+
+static inline uint32_t workload_rand(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+static inline size_t workload_size(uint32_t *seed, size_t large_max) {
+    uint32_t r = workload_rand(seed);
+    if ((r & 15) == 0 && large_max > OS_MEM_SMALL_MAX)
+        return OS_MEM_SMALL_MAX + 1 + (r >> 4) % (large_max - OS_MEM_SMALL_MAX);
+    /* 小块偏向LVGL和cJSON常见的几十字节 */
+    return (r & 16) ? 1 + (r >> 5) % 128 : 1 + (r >> 5) % OS_MEM_SMALL_MAX;
+}
+
+static inline void workload_fill(workload_slot_t *s, size_t from) {
+    if (s->size > from) memset((uint8_t *) s->p + from, s->fill, s->size - from);
+}
+
+static inline void workload_verify(const workload_slot_t *s, size_t len) {
+    const uint8_t *b = s->p;
+    for (size_t i = 0; i < len; i++)
+        TEST_ASSERT(b[i] == s->fill);
+}
+
+/**
+ * 运行一个任务的负载，结束时释放所有块
+ */
+static inline void workload_run(const workload_param_t *param) {
+    workload_slot_t slots[WORKLOAD_SLOTS] = {0};
+    uint32_t seed = 0x9E3779B9u ^ (uint32_t) param->id * 0x85EBCA6Bu;
+    const workload_ops_t *ops = param->ops;
+
+    for (int n = 0; n < param->ops_num; n++) {
+        uint32_t r = workload_rand(&seed);
+        workload_slot_t *s = &slots[r % WORKLOAD_SLOTS];
+        if (s->p == NULL) {
+            s->size = workload_size(&seed, param->large_max);
+            s->p = ops->alloc(s->size, (os_mem_tag_t) ((r >> 8) % OS_MEM_TAG_NUM));
+            TEST_ASSERT(s->p != NULL);
+            s->fill = (uint8_t) (param->id * 31 + n);
+            if (param->check) workload_fill(s, 0);
+        } else if (r & 0x10000) {
+            if (param->check) workload_verify(s, s->size);
+            ops->free(s->p);
+            s->p = NULL;
+        } else {
+            size_t size = workload_size(&seed, param->large_max);
+            if (param->check) workload_verify(s, s->size);
+            s->p = ops->realloc(s->p, size);
+            TEST_ASSERT(s->p != NULL);
+            if (param->check) {
+                workload_verify(s, size < s->size ? size : s->size);
+                size_t old = s->size;
+                s->size = size;
+                workload_fill(s, old);
+            } else {
+                s->size = size;
+            }
+        }
+    }
+    for (int i = 0; i < WORKLOAD_SLOTS; i++) {
+        if (slots[i].p == NULL) continue;
+        if (param->check) workload_verify(&slots[i], slots[i].size);
+        ops->free(slots[i].p);
+    }
+}
+
+#endif //TEST_MEM_WORKLOAD_H
@@ -0,0 +1,72 @@
+//
+// 多个任务同时随机malloc/realloc/free，检查块内容，结束后检查各标签、尺寸类和TLSF的使用量归零
+// TEST_TINY_ARENA构建使用很小的小块区和TLSF池，覆盖小块区耗尽后改由TLSF分配和TLSF扩充池
+// 用法: test_FreeRTOS_Mem [任务数] [每个任务的操作数]
+//
+
+#include "mem_workload.h"
+#include "task.h"
+#include "semphr.h"
+#include "xstatus.h"
+
+#ifdef TEST_TINY_ARENA
+#define TEST_LARGE_MAX (64 * 1024)
+#else
+#define TEST_LARGE_MAX (16 * 1024)
+#endif
+
+static SemaphoreHandle_t done_sem;
+
+static const workload_ops_t os_mem_ops = {
+        .alloc = os_malloc_tag,
+        .realloc = os_realloc,
+        .free = os_free,
+};
+
+static void task_workload(void *p) {
+    workload_run(p);
+    xSemaphoreGive(done_sem);
+    vTaskDelete(NULL);
+}
+
+int main(int argc, char **argv) {
+    int task_num = argc > 1 ? atoi(argv[1]) : 4;
+    int ops_num = argc > 2 ? atoi(argv[2]) : 200000;
+    if (task_num < 1) task_num = 1;
+    if (task_num > 16) task_num = 16;
+
+    workload_param_t params[16];
+    done_sem = xSemaphoreCreateCounting(16, 0);
+    for (int i = 0; i < task_num; i++) {
+        params[i] = (workload_param_t) {
+                .ops = &os_mem_ops, .id = i + 1, .ops_num = ops_num, .large_max = TEST_LARGE_MAX, .check = 1,
+        };
+        TEST_ASSERT(xTaskCreate(task_workload, "mem", 1024, &params[i], 2, NULL) == pdPASS);
+    }
+    for (int i = 0; i < task_num; i++)
+        TEST_ASSERT(xSemaphoreTake(done_sem, pdMS_TO_TICKS(120000)) == pdTRUE);
+
+    for (int i = 0; i < OS_MEM_TAG_NUM; i++) {
+        os_mem_tag_stats_t tag;
+        os_mem_get_tag_stats(i, &tag);
+        TEST_ASSERT(tag.count == 0 && tag.used == 0);
+        TEST_ASSERT(tag.peak > 0);
+    }
+    for (int i = 0; i < OS_MEM_CLASS_NUM; i++) {
+        os_mem_class_stats_t cls;
+        TEST_ASSERT(os_mem_get_class_stats(i, &cls) == XST_SUCCESS);
+        TEST_ASSERT(cls.used == 0);
+    }
+    os_mem_stats_t stats;
+    os_mem_get_stats(&stats);
+    TEST_ASSERT(stats.small_used == 0 && stats.large_used == 0);
+#ifdef TEST_TINY_ARENA
+    TEST_ASSERT(stats.small_reserved == OS_MEM_SMALL_ARENA);
+    TEST_ASSERT(stats.small_fallback > 0);
+    TEST_ASSERT(stats.large_total > OS_MEM_LARGE_CHUNK);
+#endif
+
+    printf("FreeRTOS_Mem: %d tasks x %d ops, small peak %zu, large peak %zu, pools %zu bytes, fallback %u\n",
+           task_num, ops_num, stats.small_peak, stats.large_peak, stats.large_total, stats.small_fallback);
+    return 0;
+}
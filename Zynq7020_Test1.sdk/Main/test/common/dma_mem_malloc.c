@@ -0,0 +1,61 @@
+//
+// DMA_Mem接口的malloc实现，带相同的统计
+// 固件的DMA_Mem.c从链接脚本的.DMA_RAM段分配并维护缓存，主机上用aligned_alloc代替，
+// 让AddressSanitizer能检查缓冲区的越界和泄漏
+//
+
+#include "DMA_Driver/DMA_Mem.h"
+#include "xstatus.h"
+#include <stdlib.h>
+#include <string.h>
+
+static DMA_Mem_Stats stats;
+
+int DMA_Mem_init() {
+    return XST_SUCCESS;
+}
+
+int DMA_Mem_alloc(DMA_Mem_Buf *buf, size_t size, DMA_Mem_Dir dir) {
+    size = (size + DMA_MEM_ALIGN - 1) & ~(size_t) (DMA_MEM_ALIGN - 1);
+    if (size == 0 || size > DMA_MEM_SIZE) return XST_FAILURE;
+    void *addr = aligned_alloc(DMA_MEM_ALIGN, size);
+    if (addr == NULL) return XST_FAILURE;
+    memset(addr, 0, size);
+    buf->addr = addr;
+    buf->size = (uint32_t) size;
+    buf->dir = dir;
+    buf->owner = DMA_MEM_OWNER_CPU;
+    uint32_t used = __atomic_add_fetch(&stats.used, (uint32_t) size, __ATOMIC_RELAXED);
+    if (used > stats.peak) stats.peak = used;
+    return XST_SUCCESS;
+}
+
+void DMA_Mem_free(DMA_Mem_Buf *buf) {
+    if (buf->addr == NULL) return;
+    __atomic_sub_fetch(&stats.used, buf->size, __ATOMIC_RELAXED);
+    free(buf->addr);
+    buf->addr = NULL;
+    buf->size = 0;
+}
+
+void DMA_Mem_to_device(DMA_Mem_Buf *buf, size_t len) {
+    if (buf->owner == DMA_MEM_OWNER_DEVICE) {
+        stats.skipped++;
+        return;
+    }
+    if (buf->dir != DMA_MEM_FROM_DEVICE) stats.flush_bytes += len ? len : buf->size;
+    buf->owner = DMA_MEM_OWNER_DEVICE;
+}
+
+void DMA_Mem_to_cpu(DMA_Mem_Buf *buf, size_t len) {
+    if (buf->owner == DMA_MEM_OWNER_CPU) {
+        stats.skipped++;
+        return;
+    }
+    if (buf->dir != DMA_MEM_TO_DEVICE) stats.invalidate_bytes += len ? len : buf->size;
+    buf->owner = DMA_MEM_OWNER_CPU;
+}
+
+void DMA_Mem_get_stats(DMA_Mem_Stats *s) {
+    *s = stats;
+}
@@ -0,0 +1,206 @@
+//
+// 没有libFuzzer(gcc)时的模糊测试入口，调用与libFuzzer相同的LLVMFuzzerTestOneInput：
+// 先逐个运行语料，再以语料为种子做固定次数的确定性变异，结果可以复现
+// 用法: fuzz_xxx [-runs=N] [-seed=N] 语料目录或文件...
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define FUZZ_MAX_LEN    (64 * 1024)
+#define FUZZ_MAX_SEEDS  (1024)
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+} fuzz_seed_t;
+
+static fuzz_seed_t seeds[FUZZ_MAX_SEEDS];
+static int seed_num;
+static uint64_t rng_state = 0x2022020100000001ull;
+static const uint8_t *volatile current_data;
+static volatile size_t current_size;
+
+/* 断言失败或ASan报错时把当前输入写到crash-input，便于复现(与libFuzzer的crash-*文件相同) */
+static void fuzz_on_crash(int sig) {
+    int fd = open("crash-input", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        if (write(fd, current_data, current_size) < 0) {}
+        close(fd);
+        static const char msg[] = "fuzz: input saved to crash-input\n";
+        if (write(2, msg, sizeof(msg) - 1) < 0) {}
+    }
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/* ASan报错后abort，走上面的信号处理 */
+const char *__asan_default_options(void) {
+    return "abort_on_error=1";
+}
+
+static void fuzz_run_one(const uint8_t *data, size_t size) {
+    current_data = data;
+    current_size = size;
+    LLVMFuzzerTestOneInput(data, size);
+}
+
+static uint32_t fuzz_rand(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t) (rng_state >> 16);
+}
+
+static void fuzz_load_file(const char *path) {
+    if (seed_num >= FUZZ_MAX_SEEDS) return;
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return;
+    uint8_t *buf = malloc(FUZZ_MAX_LEN);
+    size_t n = fread(buf, 1, FUZZ_MAX_LEN, f);
+    fclose(f);
+    seeds[seed_num].data = buf;
+    seeds[seed_num].size = n;
+    seed_num++;
+}
+
+static int fuzz_name_cmp(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+static void fuzz_load(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "fuzz: cannot open %s\n", path);
+        exit(1);
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        fuzz_load_file(path);
+        return;
+    }
+    /* 按文件名排序，保证不同机器上的变异序列相同 */
+    DIR *dir = opendir(path);
+    char *names[FUZZ_MAX_SEEDS];
+    int n = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL && n < FUZZ_MAX_SEEDS) {
+        if (ent->d_name[0] == '.') continue;
+        names[n++] = strdup(ent->d_name);
+    }
+    closedir(dir);
+    qsort(names, n, sizeof(char *), fuzz_name_cmp);
+    for (int i = 0; i < n; i++) {
+        char full[4096];
+        snprintf(full, sizeof(full), "%s/%s", path, names[i]);
+        fuzz_load_file(full);
+        free(names[i]);
+    }
+}
+
+/* 文本格式常见的记号，插入后更容易走到解析器的深处 */
+static const char *const tokens[] = {
+        ",", "\n", "\r\n", ";", "=", "-", "0x", "1e9", "99999999999", "\"", "{", "}", "[", "]", ":",
+        "radix", "coefficient_width", "coefdata", "memory_initialization_radix", "@", "//",
+        "RIFF", "WAVE", "fmt ", "data", "\xff\xff\xff\xff", "\x00\x00\x00\x00",
+};
+
+static size_t fuzz_mutate(uint8_t *buf, size_t size) {
+    int rounds = 1 + fuzz_rand() % 4;
+    while (rounds--) {
+        uint32_t pos = size ? fuzz_rand() % size : 0;
+        switch (fuzz_rand() % 7) {
+            case 0:
+                if (size) buf[pos] ^= (uint8_t) (1u << (fuzz_rand() % 8));
+                break;
+            case 1:
+                if (size) buf[pos] = (uint8_t) fuzz_rand();
+                break;
+            case 2: {
+                /* 删除一段 */
+                if (size == 0) break;
+                size_t n = 1 + fuzz_rand() % (size - pos < 16 ? size - pos : 16);
+                memmove(buf + pos, buf + pos + n, size - pos - n);
+                size -= n;
+                break;
+            }
+            case 3: {
+                /* 复制一段到别处 */
+                if (size == 0) break;
+                size_t n = 1 + fuzz_rand() % (size - pos < 64 ? size - pos : 64);
+                if (size + n > FUZZ_MAX_LEN) break;
+                uint32_t dst = fuzz_rand() % (size + 1);
+                uint8_t tmp[64];
+                memcpy(tmp, buf + pos, n);
+                memmove(buf + dst + n, buf + dst, size - dst);
+                memcpy(buf + dst, tmp, n);
+                size += n;
+                break;
+            }
+            case 4: {
+                const char *t = tokens[fuzz_rand() % (sizeof(tokens) / sizeof(tokens[0]))];
+                size_t n = strlen(t);
+                if (n == 0) n = 4;
+                if (size + n > FUZZ_MAX_LEN) break;
+                memmove(buf + pos + n, buf + pos, size - pos);
+                memcpy(buf + pos, t, n);
+                size += n;
+                break;
+            }
+            case 5: {
+                /* 与另一个种子拼接 */
+                const fuzz_seed_t *s = &seeds[fuzz_rand() % seed_num];
+                if (s->size == 0) break;
+                size_t from = fuzz_rand() % s->size;
+                size_t n = s->size - from;
+                if (pos + n > FUZZ_MAX_LEN) n = FUZZ_MAX_LEN - pos;
+                memcpy(buf + pos, s->data + from, n);
+                size = pos + n;
+                break;
+            }
+            default:
+                /* 截断 */
+                size = pos;
+                break;
+        }
+    }
+    return size;
+}
+
+int main(int argc, char **argv) {
+    long runs = 10000;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) runs = strtol(argv[i] + 6, NULL, 10);
+        else if (strncmp(argv[i], "-seed=", 6) == 0) rng_state = strtoull(argv[i] + 6, NULL, 10) | 1;
+        else if (argv[i][0] != '-') fuzz_load(argv[i]);
+    }
+    if (seed_num == 0) {
+        seeds[0].data = calloc(1, 1);
+        seed_num = 1;
+    }
+
+    signal(SIGABRT, fuzz_on_crash);
+    signal(SIGSEGV, fuzz_on_crash);
+    for (int i = 0; i < seed_num; i++)
+        fuzz_run_one(seeds[i].data, seeds[i].size);
+
+    uint8_t *buf = malloc(FUZZ_MAX_LEN);
+    for (long i = 0; i < runs; i++) {
+        const fuzz_seed_t *s = &seeds[fuzz_rand() % seed_num];
+        memcpy(buf, s->data, s->size);
+        size_t size = fuzz_mutate(buf, s->size);
+        fuzz_run_one(buf, size);
+    }
+    printf("fuzz: %d seeds, %ld mutated runs, no failure\n", seed_num, runs);
+    free(buf);
+    for (int i = 0; i < seed_num; i++) free(seeds[i].data);
+    return 0;
+}
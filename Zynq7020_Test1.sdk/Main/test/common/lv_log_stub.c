@@ -0,0 +1,10 @@
+//
+// lv_tlsf.c的断言日志，测试中不链接LVGL的其余部分
+//
+
+#include <stdio.h>
+#include <stdint.h>
+
+void _lv_log_add(int8_t level, const char *file, int line, const char *func, const char *format, ...) {
+    fprintf(stderr, "lvgl log %d %s:%d %s %s\n", level, file, line, func, format);
+}
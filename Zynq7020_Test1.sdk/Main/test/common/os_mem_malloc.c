@@ -0,0 +1,82 @@
+//
+// FreeRTOS_Mem接口的malloc实现，带相同的标签统计
+// 模糊测试链接这个文件代替FreeRTOS_Mem.c，让AddressSanitizer能检查每一块的越界和泄漏
+//
+
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    size_t size;
+    uint32_t tag;
+} os_mem_header_t;
+
+static os_mem_tag_stats_t tag_stats[OS_MEM_TAG_NUM];
+
+static void os_mem_tag_add(uint32_t tag, size_t size) {
+    os_mem_tag_stats_t *t = &tag_stats[tag];
+    __atomic_add_fetch(&t->count, 1, __ATOMIC_RELAXED);
+    uint32_t used = __atomic_add_fetch(&t->used, size, __ATOMIC_RELAXED);
+    uint32_t old = t->peak;
+    while (used > old && !__atomic_compare_exchange_n(&t->peak, &old, used, 1,
+                                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void os_mem_tag_sub(uint32_t tag, size_t size) {
+    __atomic_sub_fetch(&tag_stats[tag].count, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&tag_stats[tag].used, size, __ATOMIC_RELAXED);
+}
+
+void *os_malloc_tag(size_t __size, os_mem_tag_t tag) {
+    if (tag >= OS_MEM_TAG_NUM) tag = OS_MEM_TAG_OTHER;
+    os_mem_header_t *hdr = malloc(sizeof(os_mem_header_t) + __size);
+    if (hdr == NULL) return NULL;
+    hdr->size = __size;
+    hdr->tag = tag;
+    os_mem_tag_add(tag, __size);
+    return hdr + 1;
+}
+
+void *os_malloc(size_t __size) {
+    return os_malloc_tag(__size, OS_MEM_TAG_OTHER);
+}
+
+void *os_realloc(void *__r, size_t __size) {
+    if (__r == NULL) return os_malloc(__size);
+    if (__size == 0) {
+        os_free(__r);
+        return NULL;
+    }
+    /* 总是搬移，让悬空指针能被检查到 */
+    os_mem_header_t *hdr = (os_mem_header_t *) __r - 1;
+    void *p = os_malloc_tag(__size, hdr->tag);
+    if (p == NULL) return NULL;
+    memcpy(p, __r, hdr->size < __size ? hdr->size : __size);
+    os_free(__r);
+    return p;
+}
+
+void *os_reallocarray(void *ptr, size_t nmemb, size_t size) {
+    return os_realloc(ptr, nmemb * size);
+}
+
+void os_free(void *__r) {
+    if (__r == NULL) return;
+    os_mem_header_t *hdr = (os_mem_header_t *) __r - 1;
+    os_mem_tag_sub(hdr->tag, hdr->size);
+    free(hdr);
+}
+
+void os_mem_get_tag_stats(os_mem_tag_t tag, os_mem_tag_stats_t *stats) {
+    if (tag >= OS_MEM_TAG_NUM) {
+        memset(stats, 0, sizeof(os_mem_tag_stats_t));
+        return;
+    }
+    *stats = tag_stats[tag];
+}
+
+void os_mem_reset_tag_peak(os_mem_tag_t tag) {
+    if (tag >= OS_MEM_TAG_NUM) return;
+    __atomic_store_n(&tag_stats[tag].peak, tag_stats[tag].used, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,47 @@
+//
+// 主机测试的公共环境
+//
+
+#include "test_env.h"
+#include "test_fs.h"
+#include "Fatfs_init/Encoding.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "cJSON.h"
+#include <pthread.h>
+#include <time.h>
+
+static pthread_once_t env_once = PTHREAD_ONCE_INIT;
+
+static void *test_cjson_malloc(size_t size) {
+    return os_malloc_tag(size, OS_MEM_TAG_CJSON);
+}
+
+static void test_env_setup(void) {
+    TEST_ASSERT(Encoding_init() == 0);
+    cJSON_Hooks hooks = {
+            .free_fn = os_free,
+            .malloc_fn = test_cjson_malloc,
+    };
+    cJSON_InitHooks(&hooks);
+    TEST_ASSERT(test_fs_format(0, TEST_VOLUME_SIZE, TEST_CLUSTER_SIZE) == FR_OK);
+}
+
+void test_env_init(void) {
+    pthread_once(&env_once, test_env_setup);
+}
+
+uint64_t test_env_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+uint32_t test_env_alloc_count(void) {
+    uint32_t count = 0;
+    for (int i = 0; i < OS_MEM_TAG_NUM; i++) {
+        os_mem_tag_stats_t stats;
+        os_mem_get_tag_stats(i, &stats);
+        count += stats.count;
+    }
+    return count;
+}
@@ -0,0 +1,39 @@
+//
+// 主机测试的公共环境：编码表、cJSON钩子、内存卷，以及计时和断言
+//
+
+#ifndef TEST_ENV_H
+#define TEST_ENV_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TEST_VOLUME_SIZE    (32 * 1024 * 1024)  //!< 卷0容量
+#define TEST_CLUSTER_SIZE   (4096)              //!< 卷0簇大小，与SD卡格式化参数一致
+
+/* 失败时打印位置并退出，ctest按返回值判断 */
+#define TEST_ASSERT(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: assert failed: %s\n", __FILE__, __LINE__, #cond); \
+            abort(); \
+        } \
+    } while (0)
+
+/**
+ * 按固件DefaultTask的顺序初始化，只执行一次
+ */
+void test_env_init(void);
+
+/**
+ * 单调时钟
+ * @return 纳秒
+ */
+uint64_t test_env_now_ns(void);
+
+/**
+ * 所有标签的分配块数之和，用于检查泄漏
+ */
+uint32_t test_env_alloc_count(void);
+
+#endif //TEST_ENV_H
@@ -0,0 +1,525 @@
+//
+// httpd.c经TCP替身运行：静态网页和错误回复、请求头超时、连接数上限、关闭失败后重试，
+// WebSocket握手(请求逐字节到达，握手后紧跟的命令)、订阅、ping、关闭和协议错误，
+// 以及背压：发送缓冲区或发送队列满时整帧跳过并计数，不会写入半帧；
+// 屏幕消息按发送缓冲区分片，写入期间跳过波形，积压的连接跳过后请求关键帧，写了一半阻塞的连接断开。
+// 结束时检查订阅计数归零、屏幕消息都已交还、pcb、pbuf和cJSON没有泄漏
+//
+
+#include "test_env.h"
+#include "tcp_shim.h"
+#include "lwip_sim.h"
+#include "httpd.h"
+#include "websocket.h"
+#include "live_page.h"
+#include "LVGL_Zynq_Init/zynq_lvgl_remote.h"
+#include "xstatus.h"
+#include <string.h>
+
+#define TEST_MSG_MAX (256 * 1024)
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t fin;
+    uint32_t len;
+    uint8_t payload[TEST_MSG_MAX];
+} server_frame;
+
+static uint32_t rand_state = 0x1B873593u;
+static server_frame frame;
+
+/* ---------------------------- 波形和远程屏幕的替身 ---------------------------- */
+
+static udp_stream_sink_t stream_sink;
+static int stream_subs[UDP_STREAM_NUM];
+static zynq_lvgl_remote_sink_t screen_sink;
+static int screen_subs;
+static int screen_held;
+static int screen_keyframes;
+
+void udp_stream_set_sink(udp_stream_sink_t sink) {
+    stream_sink = sink;
+}
+
+void udp_stream_sink_subscribe(udp_stream_id stream, int subscribe) {
+    stream_subs[stream] += subscribe ? 1 : -1;
+    TEST_ASSERT(stream_subs[stream] >= 0);
+}
+
+void zynq_lvgl_remote_set_sink(zynq_lvgl_remote_sink_t sink) {
+    screen_sink = sink;
+}
+
+void zynq_lvgl_remote_subscribe(int subscribe) {
+    screen_subs += subscribe ? 1 : -1;
+    TEST_ASSERT(screen_subs >= 0);
+}
+
+void zynq_lvgl_remote_keyframe() {
+    screen_keyframes++;
+}
+
+void zynq_lvgl_remote_release() {
+    TEST_ASSERT(screen_held);
+    screen_held = 0;
+}
+
+static uint32_t test_rand(void) {
+    uint32_t x = rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rand_state = x;
+}
+
+static void push_stream(udp_stream_id stream, uint32_t seq, uint64_t timestamp_us, const void *data, uint32_t len) {
+    udp_stream_frame_t f = {
+            .seq = seq, .timestamp_us = timestamp_us, .data = data, .len = len,
+            .sample_rate = stream == UDP_STREAM_ADC ? 1000000 : 0,
+            .format = stream == UDP_STREAM_ADC ? UDP_STREAM_FORMAT_INT16 : UDP_STREAM_FORMAT_FLOAT,
+    };
+    stream_sink(stream, &f);
+}
+
+/**
+ * 远程屏幕交出一帧，消息在协议栈线程中分发
+ */
+static void push_screen(uint32_t seq, int keyframe, const void *data, uint32_t len) {
+    TEST_ASSERT(!screen_held);
+    zynq_lvgl_remote_frame_t f = {.seq = seq, .timestamp_us = seq * 200000ull, .data = data, .len = len,
+            .keyframe = (uint8_t) keyframe};
+    screen_held = 1;
+    TEST_ASSERT(screen_sink(&f) == XST_SUCCESS);
+    lwip_sim_run(NULL, NULL, lwip_sim_now_us());
+}
+
+/* --------------------------------- 客户端 --------------------------------- */
+
+/* 确认服务器发出的全部数据，确认会触发继续写入 */
+static void ack_all(struct tcp_pcb *pcb) {
+    while (tcp_shim_ack(pcb, UINT32_MAX)) {}
+}
+
+static struct tcp_pcb *http_request(const char *req) {
+    struct tcp_pcb *pcb = tcp_shim_connect(HTTPD_PORT);
+    TEST_ASSERT(pcb && tcp_shim_get_state(pcb) == TCP_SHIM_OPEN);
+    tcp_shim_send(pcb, req, strlen(req));
+    return pcb;
+}
+
+/**
+ * 发送请求，读完回复，服务器关闭连接
+ * @return 回复，free释放
+ */
+static char *http_get(const char *req, uint32_t *len) {
+    struct tcp_pcb *pcb = http_request(req);
+    ack_all(pcb);
+    TEST_ASSERT(tcp_shim_get_state(pcb) == TCP_SHIM_CLOSED);
+    const uint8_t *data = tcp_shim_received(pcb, len);
+    char *resp = malloc(*len + 1);
+    memcpy(resp, data, *len);
+    resp[*len] = 0;
+    tcp_shim_free(pcb);
+    return resp;
+}
+
+static void expect_status(const char *req, const char *status) {
+    uint32_t len;
+    char *resp = http_get(req, &len);
+    TEST_ASSERT(strncmp(resp, "HTTP/1.1 ", 9) == 0 && strncmp(resp + 9, status, strlen(status)) == 0);
+    free(resp);
+}
+
+static void ws_send(struct tcp_pcb *pcb, uint8_t b0, const void *payload, uint32_t len) {
+    uint8_t buf[14 + 256];
+    uint32_t pos = 0;
+    buf[pos++] = b0;
+    if (len < 126) {
+        buf[pos++] = 0x80 | len;
+    } else {
+        buf[pos++] = 0x80 | 126;
+        buf[pos++] = len >> 8;
+        buf[pos++] = len;
+    }
+    uint8_t mask[4];
+    for (int i = 0; i < 4; i++) buf[pos++] = mask[i] = (uint8_t) test_rand();
+    for (uint32_t i = 0; i < len; i++) buf[pos++] = ((const uint8_t *) payload)[i] ^ mask[i & 3];
+    tcp_shim_send(pcb, buf, pos);
+}
+
+static void ws_command(struct tcp_pcb *pcb, const char *json) {
+    ws_send(pcb, 0x80 | WS_OP_TEXT, json, strlen(json));
+}
+
+/**
+ * 从收到的数据中取出一个服务器帧
+ * @return 没有完整的帧返回0
+ */
+static int ws_take(struct tcp_pcb *pcb, server_frame *f) {
+    uint32_t len;
+    const uint8_t *d = tcp_shim_received(pcb, &len);
+    if (len < 2) return 0;
+    TEST_ASSERT((d[1] & 0x80) == 0 && (d[0] & 0x70) == 0);
+    uint32_t head = 2, plen = d[1] & 0x7f;
+    if (plen == 126) {
+        if (len < 4) return 0;
+        plen = (uint32_t) d[2] << 8 | d[3];
+        head = 4;
+    } else if (plen == 127) {
+        if (len < 10) return 0;
+        TEST_ASSERT(d[2] == 0 && d[3] == 0 && d[4] == 0 && d[5] == 0);
+        plen = (uint32_t) d[6] << 24 | (uint32_t) d[7] << 16 | (uint32_t) d[8] << 8 | d[9];
+        head = 10;
+    }
+    if (len < head + plen) return 0;
+    TEST_ASSERT(plen <= TEST_MSG_MAX);
+    f->fin = d[0] >> 7;
+    f->opcode = d[0] & 0x0f;
+    f->len = plen;
+    memcpy(f->payload, d + head, plen);
+    tcp_shim_consume(pcb, head + plen);
+    return 1;
+}
+
+/**
+ * 建立WebSocket连接，请求逐字节到达，握手后紧跟一个订阅命令
+ */
+static struct tcp_pcb *ws_open(const char *command) {
+    static const char req[] = "GET /ws HTTP/1.1\r\nHost: zynq\r\nUpgrade: WebSocket\r\n"
+                              "Connection: Upgrade\r\nSec-WebSocket-Key:  dGhlIHNhbXBsZSBub25jZQ== \r\n"
+                              "Sec-WebSocket-Version: 13\r\n\r\n";
+    struct tcp_pcb *pcb = tcp_shim_connect(HTTPD_PORT);
+    TEST_ASSERT(pcb && tcp_shim_get_state(pcb) == TCP_SHIM_OPEN);
+    uint8_t buf[sizeof(req) + 14 + 128];
+    uint32_t len = sizeof(req) - 1;
+    memcpy(buf, req, len);
+    if (command) {
+        /* 命令与请求头的最后一段在同一个报文中 */
+        uint32_t cmd_len = strlen(command);
+        buf[len++] = 0x80 | WS_OP_TEXT;
+        buf[len++] = 0x80 | cmd_len;
+        memset(buf + len, 0, 4);
+        len += 4;
+        memcpy(buf + len, command, cmd_len);
+        len += cmd_len;
+    }
+    uint32_t split = sizeof(req) - 8;
+    for (uint32_t i = 0; i < split; i++) tcp_shim_send(pcb, buf + i, 1);
+    tcp_shim_send(pcb, buf + split, len - split);
+
+    ack_all(pcb);
+    uint32_t resp_len;
+    const char *resp = (const char *) tcp_shim_received(pcb, &resp_len);
+    static const char expect[] = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                                 "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n\r\n";
+    TEST_ASSERT(resp_len >= sizeof(expect) - 1 && memcmp(resp, expect, sizeof(expect) - 1) == 0);
+    tcp_shim_consume(pcb, sizeof(expect) - 1);
+    TEST_ASSERT(pcb->flags & TF_NODELAY);
+    return pcb;
+}
+
+/**
+ * 服务器发出关闭帧并关闭连接
+ */
+static void expect_ws_close(struct tcp_pcb *pcb, uint16_t code) {
+    ack_all(pcb);
+    TEST_ASSERT(ws_take(pcb, &frame) && frame.opcode == WS_OP_CLOSE && frame.len == 2);
+    TEST_ASSERT((frame.payload[0] << 8 | frame.payload[1]) == code);
+    TEST_ASSERT(tcp_shim_get_state(pcb) == TCP_SHIM_CLOSED);
+    tcp_shim_free(pcb);
+}
+
+static const httpd_ws_frame_header_t *msg_header(const server_frame *f) {
+    TEST_ASSERT(f->len >= sizeof(httpd_ws_frame_header_t));
+    return (const httpd_ws_frame_header_t *) f->payload;
+}
+
+/* ---------------------------------- 测试 ---------------------------------- */
+
+static void test_http(void) {
+    uint32_t len;
+    char *resp = http_get("GET / HTTP/1.1\r\nHost: zynq\r\n\r\n", &len);
+    char *body = strstr(resp, "\r\n\r\n") + 4;
+    char content_length[48];
+    snprintf(content_length, sizeof(content_length), "Content-Length: %lu\r\n", (unsigned long) live_page_html_len);
+    TEST_ASSERT(strncmp(resp, "HTTP/1.1 200 OK\r\n", 17) == 0 && strstr(resp, content_length));
+    TEST_ASSERT(len - (body - resp) == live_page_html_len && memcmp(body, live_page_html, live_page_html_len) == 0);
+    free(resp);
+
+    expect_status("GET /index.html?x=1 HTTP/1.1\r\n\r\n", "200 OK");
+    expect_status("GET /foo HTTP/1.1\r\n\r\n", "404 Not Found");
+    expect_status("POST / HTTP/1.1\r\n\r\n", "400 Bad Request");
+    expect_status("GET /ws HTTP/1.1\r\nUpgrade: websocket\r\n\r\n", "400 Bad Request");
+    expect_status("GET /ws HTTP/1.1\r\nUpgrade: h2c\r\nSec-WebSocket-Key: x\r\n\r\n", "400 Bad Request");
+
+    /* 请求头超过HTTPD_REQ_MAX */
+    char big[HTTPD_REQ_MAX + 64];
+    memset(big, 'a', sizeof(big) - 1);
+    big[sizeof(big) - 1] = 0;
+    memcpy(big, "GET / HTTP/1.1\r\nX: ", 19);
+    expect_status(big, "400 Bad Request");
+
+    /* 请求头一直没有收完 */
+    struct tcp_pcb *pcb = http_request("GET / HT");
+    for (int i = 0; i < 20 && tcp_shim_get_state(pcb) == TCP_SHIM_OPEN; i++) tcp_shim_poll(pcb);
+    TEST_ASSERT(tcp_shim_get_state(pcb) == TCP_SHIM_ABORTED);
+    tcp_shim_free(pcb);
+
+    /* tcp_close失败后在poll中重试 */
+    tcp_shim_fail_close(1);
+    pcb = http_request("GET / HTTP/1.1\r\n\r\n");
+    ack_all(pcb);
+    TEST_ASSERT(tcp_shim_get_state(pcb) == TCP_SHIM_OPEN);
+    tcp_shim_poll(pcb);
+    TEST_ASSERT(tcp_shim_get_state(pcb) == TCP_SHIM_CLOSED);
+    tcp_shim_free(pcb);
+
+    /* 连接数上限，满了之后新连接被复位 */
+    struct tcp_pcb *conns[HTTPD_MAX_CONN];
+    for (int i = 0; i < HTTPD_MAX_CONN; i++) conns[i] = http_request("GET");
+    pcb = tcp_shim_connect(HTTPD_PORT);
+    TEST_ASSERT(pcb && tcp_shim_get_state(pcb) == TCP_SHIM_ABORTED);
+    tcp_shim_free(pcb);
+    for (int i = 0; i < HTTPD_MAX_CONN; i++) {
+        if (i & 1) tcp_shim_reset(conns[i]);
+        else tcp_shim_fin(conns[i]);
+        TEST_ASSERT(tcp_shim_get_state(conns[i]) != TCP_SHIM_OPEN);
+        tcp_shim_free(conns[i]);
+    }
+    TEST_ASSERT(tcp_shim_pcb_count() == 1);
+}
+
+static void test_websocket(void) {
+    /* 握手后紧跟的订阅命令 */
+    struct tcp_pcb *pcb = ws_open("{\"streams\":3}");
+    TEST_ASSERT(stream_subs[UDP_STREAM_ADC] == 1 && stream_subs[UDP_STREAM_FFT] == 1);
+    ws_command(pcb, "{\"streams\":2,\"fps\":0}");
+    TEST_ASSERT(stream_subs[UDP_STREAM_ADC] == 0 && stream_subs[UDP_STREAM_FFT] == 1);
+    /* 无法解析的命令被忽略 */
+    ws_command(pcb, "{\"streams\":");
+
+    ws_send(pcb, 0x80 | WS_OP_PING, "abc", 3);
+    ack_all(pcb);
+    TEST_ASSERT(ws_take(pcb, &frame) && frame.opcode == WS_OP_PONG && frame.fin && frame.len == 3);
+    TEST_ASSERT(memcmp(frame.payload, "abc", 3) == 0);
+    ws_send(pcb, 0x80 | WS_OP_PONG, NULL, 0);
+
+    /* 关闭时回复对方的关闭码，取消订阅 */
+    uint8_t code[2] = {WS_CLOSE_NORMAL >> 8, WS_CLOSE_NORMAL & 0xff};
+    ws_send(pcb, 0x80 | WS_OP_CLOSE, code, 2);
+    expect_ws_close(pcb, WS_CLOSE_NORMAL);
+    TEST_ASSERT(stream_subs[UDP_STREAM_FFT] == 0);
+
+    /* 协议错误、二进制消息、分片的文本消息和过长的帧 */
+    pcb = ws_open(NULL);
+    static const uint8_t unmasked[] = {0x81, 0x01, 'x'};
+    tcp_shim_send(pcb, unmasked, sizeof(unmasked));
+    expect_ws_close(pcb, WS_CLOSE_PROTOCOL_ERROR);
+    pcb = ws_open(NULL);
+    ws_send(pcb, 0x80 | WS_OP_BINARY, "x", 1);
+    expect_ws_close(pcb, WS_CLOSE_UNSUPPORTED);
+    pcb = ws_open(NULL);
+    ws_send(pcb, WS_OP_TEXT, "{", 1);
+    expect_ws_close(pcb, WS_CLOSE_UNSUPPORTED);
+    pcb = ws_open(NULL);
+    uint8_t big[200] = {0};
+    ws_send(pcb, 0x80 | WS_OP_TEXT, big, sizeof(big));
+    expect_ws_close(pcb, WS_CLOSE_TOO_BIG);
+
+    /* 对方直接关闭或复位 */
+    pcb = ws_open("{\"streams\":1}");
+    tcp_shim_fin(pcb);
+    TEST_ASSERT(tcp_shim_get_state(pcb) == TCP_SHIM_CLOSED && stream_subs[UDP_STREAM_ADC] == 0);
+    tcp_shim_free(pcb);
+    pcb = ws_open("{\"streams\":1}");
+    tcp_shim_reset(pcb);
+    TEST_ASSERT(stream_subs[UDP_STREAM_ADC] == 0);
+    tcp_shim_free(pcb);
+    TEST_ASSERT(tcp_shim_pcb_count() == 1);
+}
+
+/**
+ * 读出所有消息，检查都是完整的波形帧，序号递增
+ * @return 消息数
+ */
+static int read_stream_msgs(struct tcp_pcb *pcb, uint32_t *last_seq, uint32_t data_len) {
+    int count = 0;
+    while (ws_take(pcb, &frame)) {
+        const httpd_ws_frame_header_t *h = msg_header(&frame);
+        TEST_ASSERT(frame.opcode == WS_OP_BINARY && frame.fin);
+        TEST_ASSERT(h->stream == UDP_STREAM_ADC && frame.len == sizeof(*h) + data_len);
+        TEST_ASSERT(*last_seq == UINT32_MAX || h->seq > *last_seq);
+        *last_seq = h->seq;
+        count++;
+    }
+    uint32_t left;
+    tcp_shim_received(pcb, &left);
+    TEST_ASSERT(left == 0);
+    return count;
+}
+
+static void test_backpressure(void) {
+    static uint8_t data[8192];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t) test_rand();
+    struct tcp_pcb *pcb = ws_open("{\"streams\":1}");
+    uint64_t t = 1000000;
+    uint32_t seq = 0, last = UINT32_MAX;
+
+    /* 发送缓冲区满后整帧跳过，确认后继续，跳过的帧数在下一条消息中 */
+    for (int i = 0; i < 100; i++) push_stream(UDP_STREAM_ADC, seq++, t++, data, sizeof(data));
+    TEST_ASSERT(tcp_shim_get_state(pcb) == TCP_SHIM_OPEN);
+    ack_all(pcb);
+    int got = read_stream_msgs(pcb, &last, sizeof(data));
+    TEST_ASSERT(got > 0 && got < 100);
+    push_stream(UDP_STREAM_ADC, seq++, t++, data, sizeof(data));
+    ack_all(pcb);
+    TEST_ASSERT(ws_take(pcb, &frame) && msg_header(&frame)->dropped == (uint32_t) (100 - got));
+    TEST_ASSERT(msg_header(&frame)->seq == 100 && memcmp(frame.payload + sizeof(httpd_ws_frame_header_t), data,
+                                                         sizeof(data)) == 0);
+    last = 100;
+
+    /* 小帧先用完发送队列，同样整帧跳过而不是写入失败后断开 */
+    for (int i = 0; i < 2000; i++) push_stream(UDP_STREAM_ADC, seq++, t++, data, 16);
+    TEST_ASSERT(tcp_shim_get_state(pcb) == TCP_SHIM_OPEN);
+    TEST_ASSERT(pcb->snd_queuelen <= TCP_SND_QUEUELEN && pcb->snd_buf > TCP_SND_BUF / 4);
+    ack_all(pcb);
+    got = read_stream_msgs(pcb, &last, 16);
+    TEST_ASSERT(got > 0 && got < 2000);
+
+    /* 帧率限制 */
+    ws_command(pcb, "{\"fps\":10}");
+    t += 1000000;
+    for (int i = 0; i < 100; i++) push_stream(UDP_STREAM_ADC, seq++, t + i * 10000ull, data, 64);
+    ack_all(pcb);
+    TEST_ASSERT(read_stream_msgs(pcb, &last, 64) == 10);
+
+    tcp_shim_fin(pcb);
+    tcp_shim_free(pcb);
+}
+
+/**
+ * 读出一条分片的屏幕消息，中间不能插入其它消息
+ * @return 0: 消息还没有收完
+ */
+static int read_screen_msg(struct tcp_pcb *pcb, uint8_t *msg, uint32_t *len) {
+    static uint32_t pos;
+    while (ws_take(pcb, &frame)) {
+        TEST_ASSERT(frame.opcode == (pos ? WS_OP_CONTINUATION : WS_OP_BINARY));
+        memcpy(msg + pos, frame.payload, frame.len);
+        pos += frame.len;
+        if (frame.fin) {
+            *len = pos;
+            pos = 0;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void check_screen_msg(const uint8_t *msg, uint32_t len, uint32_t seq, const uint8_t *data, uint32_t data_len) {
+    const httpd_ws_frame_header_t *h = (const httpd_ws_frame_header_t *) msg;
+    TEST_ASSERT(len == sizeof(*h) + data_len && h->stream == HTTPD_STREAM_SCREEN && h->seq == seq);
+    TEST_ASSERT(memcmp(msg + sizeof(*h), data, data_len) == 0);
+}
+
+static void test_screen(void) {
+    static uint8_t data[200000], msg[TEST_MSG_MAX];
+    static uint8_t wave[8192];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t) test_rand();
+    uint32_t len, seq = 0;
+
+    struct tcp_pcb *a = ws_open("{\"streams\":5}");
+    TEST_ASSERT(screen_subs == 1);
+
+    /* 没有收到过关键帧的连接不接收增量 */
+    push_screen(seq++, 0, data, 1000);
+    TEST_ASSERT(!screen_held);
+    uint32_t rx;
+    tcp_shim_received(a, &rx);
+    TEST_ASSERT(rx == 0);
+
+    /* 关键帧超过发送缓冲区，分片写入，期间即使放得下的小波形也被跳过；所有分片写完后交还。
+     * 确认得少时空出的空间不够一个分片，正好放得下波形 */
+    push_screen(seq, 1, data, sizeof(data));
+    TEST_ASSERT(screen_held);
+    uint32_t skipped = 0;
+    int done = 0;
+    while (!done) {
+        TEST_ASSERT(tcp_shim_ack(a, 1 + test_rand() % (test_rand() & 1 ? 20000 : 500)) > 0);
+        if (screen_held) {
+            push_stream(UDP_STREAM_ADC, skipped, 1000000 + skipped, wave, 64);
+            skipped++;
+        }
+        done = read_screen_msg(a, msg, &len);
+    }
+    check_screen_msg(msg, len, seq++, data, sizeof(data));
+    TEST_ASSERT(!screen_held && skipped > 1);
+    push_stream(UDP_STREAM_ADC, skipped, 2000000, wave, sizeof(wave));
+    ack_all(a);
+    TEST_ASSERT(ws_take(a, &frame) && msg_header(&frame)->stream == UDP_STREAM_ADC);
+    TEST_ASSERT(msg_header(&frame)->dropped == skipped);
+
+    /* b的发送缓冲区积压，不开始写入；超时后跳过，空出后请求关键帧，a不受影响 */
+    struct tcp_pcb *b = ws_open("{\"streams\":5}");
+    for (int i = 0; i < 6; i++) push_stream(UDP_STREAM_ADC, 2 + i, 3000000 + i, wave, sizeof(wave));
+    ack_all(a);
+    while (ws_take(a, &frame)) {}
+    TEST_ASSERT(tcp_shim_get_state(b) == TCP_SHIM_OPEN && b->snd_buf < TCP_SND_BUF / 2);
+    push_screen(seq, 1, data, 100000);
+    for (int i = 0; i < HTTPD_SCREEN_TIMEOUT; i++) tcp_shim_poll(b);
+    TEST_ASSERT(tcp_shim_get_state(b) == TCP_SHIM_OPEN && screen_held);
+    do {
+        tcp_shim_ack(a, UINT32_MAX);
+    } while (!read_screen_msg(a, msg, &len));
+    check_screen_msg(msg, len, seq++, data, 100000);
+    TEST_ASSERT(!screen_held && screen_keyframes == 0);
+    ack_all(b);
+    TEST_ASSERT(screen_keyframes == 1);
+    while (ws_take(b, &frame)) TEST_ASSERT(msg_header(&frame)->stream == UDP_STREAM_ADC);
+
+    /* 增量只发给同步的a，b等关键帧 */
+    push_screen(seq, 0, data, 3000);
+    ack_all(a);
+    TEST_ASSERT(read_screen_msg(a, msg, &len));
+    check_screen_msg(msg, len, seq++, data, 3000);
+    tcp_shim_received(b, &rx);
+    TEST_ASSERT(rx == 0 && !screen_held);
+
+    /* 写了一部分后阻塞的连接被断开，持有的消息交还 */
+    push_screen(seq++, 1, data, sizeof(data));
+    ack_all(b);
+    while (read_screen_msg(b, msg, &len)) {}
+    for (int i = 0; i < HTTPD_SCREEN_TIMEOUT; i++) tcp_shim_poll(a);
+    TEST_ASSERT(tcp_shim_get_state(a) == TCP_SHIM_ABORTED);
+    TEST_ASSERT(!screen_held && screen_subs == 1 && stream_subs[UDP_STREAM_ADC] == 1);
+    tcp_shim_free(a);
+
+    /* 取消订阅 */
+    ws_command(b, "{\"streams\":0}");
+    TEST_ASSERT(screen_subs == 0 && stream_subs[UDP_STREAM_ADC] == 0);
+    tcp_shim_fin(b);
+    tcp_shim_free(b);
+}
+
+int main(void) {
+    static const lwip_sim_link_t link = {.pool_bufsize = 512};
+    test_env_init();
+    uint32_t alloc_count = test_env_alloc_count();
+    lwip_sim_init(&link, 1);
+    tcp_shim_init();
+    httpd_start();
+    TEST_ASSERT(tcp_shim_pcb_count() == 1 && stream_sink && screen_sink);
+
+    test_http();
+    test_websocket();
+    test_backpressure();
+    test_screen();
+
+    for (int i = 0; i < UDP_STREAM_NUM; i++) TEST_ASSERT(stream_subs[i] == 0);
+    TEST_ASSERT(screen_subs == 0 && !screen_held);
+    TEST_ASSERT(tcp_shim_pcb_count() == 1);
+    TEST_ASSERT(lwip_sim_pbuf_count() == 0);
+    TEST_ASSERT(test_env_alloc_count() == alloc_count);
+    printf("httpd: static pages, websocket handshake and commands, backpressure and screen fragments passed\n");
+    return 0;
+}
@@ -0,0 +1,207 @@
+//
+// websocket.c：握手的Sec-WebSocket-Accept(RFC 6455的示例)、服务器帧头的三种长度编码，
+// 以及客户端帧的解析：整段、逐字节和随机切分送入结果相同，格式错误和过长的帧返回对应的关闭码，
+// 随机字节流不会越界(由AddressSanitizer检查)
+//
+
+#include "test_env.h"
+#include "websocket.h"
+#include <string.h>
+
+static uint32_t rand_state = 0x6C078965u;
+
+static uint32_t test_rand(void) {
+    uint32_t x = rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rand_state = x;
+}
+
+/**
+ * 生成客户端发出的帧，带掩码
+ * @param len_form 0: 最短编码 2: 16位长度 8: 64位长度
+ * @return 帧长度
+ */
+static uint32_t client_frame(uint8_t *buf, uint8_t b0, const uint8_t *payload, uint32_t len, int len_form) {
+    uint32_t pos = 0;
+    buf[pos++] = b0;
+    if (len_form == 0 && len < 126) {
+        buf[pos++] = 0x80 | len;
+    } else if (len_form <= 2 && len <= 0xffff) {
+        buf[pos++] = 0x80 | 126;
+        buf[pos++] = len >> 8;
+        buf[pos++] = len;
+    } else {
+        buf[pos++] = 0x80 | 127;
+        for (int i = 7; i >= 0; i--) buf[pos++] = i < 4 ? (uint8_t) (len >> (i * 8)) : 0;
+    }
+    uint8_t mask[4];
+    for (int i = 0; i < 4; i++) buf[pos++] = mask[i] = (uint8_t) test_rand();
+    for (uint32_t i = 0; i < len; i++) buf[pos++] = payload[i] ^ mask[i & 3];
+    return pos;
+}
+
+static void test_accept_key(void) {
+    char accept[WS_ACCEPT_KEY_LEN + 1];
+    const char *key = "dGhlIHNhbXBsZSBub25jZQ==";
+    ws_accept_key(key, strlen(key), accept);
+    TEST_ASSERT(strcmp(accept, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == 0);
+}
+
+static void test_frame_header(void) {
+    uint8_t h[WS_HEADER_MAX];
+    TEST_ASSERT(ws_frame_header(h, WS_OP_BINARY, 0) == 2 && h[0] == 0x82 && h[1] == 0);
+    TEST_ASSERT(ws_frame_header(h, WS_OP_TEXT, 125) == 2 && h[0] == 0x81 && h[1] == 125);
+    TEST_ASSERT(ws_frame_header(h, WS_OP_BINARY, 126) == 4 && h[1] == 126 && h[2] == 0 && h[3] == 126);
+    TEST_ASSERT(ws_frame_header(h, WS_OP_BINARY, 0xffff) == 4 && h[2] == 0xff && h[3] == 0xff);
+    TEST_ASSERT(ws_frame_header(h, WS_OP_BINARY, 0x10000) == 10 && h[1] == 127);
+    static const uint8_t len64[8] = {0, 0, 0, 0, 0, 1, 0, 0};
+    TEST_ASSERT(memcmp(h + 2, len64, 8) == 0);
+    TEST_ASSERT(ws_fragment_header(h, WS_OP_BINARY, 0, 10) == 2 && h[0] == 0x02);
+    TEST_ASSERT(ws_fragment_header(h, WS_OP_CONTINUATION, 0, 10) == 2 && h[0] == 0x00);
+    TEST_ASSERT(ws_fragment_header(h, WS_OP_CONTINUATION, 1, 10) == 2 && h[0] == 0x80);
+}
+
+typedef struct {
+    uint8_t opcode;
+    uint8_t fin;
+    uint8_t len;
+    uint8_t payload[WS_CONTROL_MAX];
+} expect_frame;
+
+/**
+ * 把data按split切分送入解析器，检查依次得到的帧
+ * @param split 0: 整段 1: 逐字节 其他: 随机长度
+ */
+static void feed_frames(const uint8_t *data, uint32_t len, const expect_frame *expect, int num, int split) {
+    ws_parser parser;
+    ws_parser_reset(&parser);
+    int got = 0;
+    uint32_t pos = 0;
+    while (pos < len) {
+        uint32_t chunk = split == 0 ? len - pos : split == 1 ? 1 : 1 + test_rand() % 40;
+        chunk = chunk > len - pos ? len - pos : chunk;
+        const uint8_t *p = data + pos;
+        uint32_t left = chunk;
+        while (left) {
+            uint32_t used;
+            ws_parse_result res = ws_parser_feed(&parser, p, left, &used);
+            TEST_ASSERT(res != WS_PARSE_ERROR && used <= left);
+            p += used;
+            left -= used;
+            if (res == WS_PARSE_MORE) {
+                TEST_ASSERT(left == 0);
+                break;
+            }
+            TEST_ASSERT(got < num);
+            TEST_ASSERT(parser.opcode == expect[got].opcode && parser.fin == expect[got].fin);
+            TEST_ASSERT(parser.payload_len == expect[got].len);
+            TEST_ASSERT(memcmp(parser.payload, expect[got].payload, expect[got].len) == 0);
+            got++;
+        }
+        pos += chunk;
+    }
+    TEST_ASSERT(got == num);
+}
+
+static void test_parse(void) {
+    static expect_frame expect[64];
+    static uint8_t stream[64 * (14 + WS_CONTROL_MAX)];
+    static const int len_forms[] = {0, 2, 8};
+    for (int round = 0; round < 200; round++) {
+        int num = 1 + (int) (test_rand() % 64);
+        uint32_t len = 0;
+        for (int i = 0; i < num; i++) {
+            static const uint8_t ops[] = {WS_OP_TEXT, WS_OP_BINARY, WS_OP_CONTINUATION, WS_OP_PING, WS_OP_PONG,
+                                          WS_OP_CLOSE};
+            expect_frame *e = &expect[i];
+            e->opcode = ops[test_rand() % sizeof(ops)];
+            e->fin = (e->opcode & 0x08) ? 1 : (uint8_t) (test_rand() & 1);
+            e->len = (uint8_t) (test_rand() % (WS_CONTROL_MAX + 1));
+            for (int j = 0; j < e->len; j++) e->payload[j] = (uint8_t) test_rand();
+            /* 数据帧的长度编码不要求最短，126和127形式的短帧也能接收；控制帧只能用7位长度 */
+            int form = (e->opcode & 0x08) ? 0 : len_forms[test_rand() % 3];
+            len += client_frame(stream + len, (e->fin ? 0x80 : 0) | e->opcode, e->payload, e->len, form);
+        }
+        for (int split = 0; split < 3; split++) feed_frames(stream, len, expect, num, split);
+    }
+}
+
+/**
+ * 送入一个错误的帧，检查关闭码和出错时消耗的长度不超过帧头
+ */
+static void expect_error(const uint8_t *data, uint32_t len, uint16_t code) {
+    ws_parser parser;
+    ws_parser_reset(&parser);
+    uint32_t used;
+    TEST_ASSERT(ws_parser_feed(&parser, data, len, &used) == WS_PARSE_ERROR);
+    TEST_ASSERT(parser.close_code == code && used <= 14);
+}
+
+static void test_errors(void) {
+    uint8_t buf[16 + 256];
+    uint8_t payload[256] = {0};
+
+    /* RSV置位、没有掩码 */
+    client_frame(buf, 0x81 | 0x40, payload, 4, 0);
+    expect_error(buf, 10, WS_CLOSE_PROTOCOL_ERROR);
+    static const uint8_t unmasked[] = {0x81, 0x02, 'h', 'i'};
+    expect_error(unmasked, sizeof(unmasked), WS_CLOSE_PROTOCOL_ERROR);
+
+    /* 控制帧分片或超过125字节 */
+    client_frame(buf, WS_OP_PING, payload, 4, 0);
+    expect_error(buf, 10, WS_CLOSE_PROTOCOL_ERROR);
+    uint32_t len = client_frame(buf, 0x80 | WS_OP_PING, payload, 126, 0);
+    expect_error(buf, len, WS_CLOSE_PROTOCOL_ERROR);
+
+    /* 数据帧超过WS_CONTROL_MAX，两种长度编码 */
+    len = client_frame(buf, 0x82, payload, 200, 2);
+    expect_error(buf, len, WS_CLOSE_TOO_BIG);
+    static const uint8_t huge[] = {0x82, 0xff, 0, 0, 0, 1, 0, 0, 0, 5, 1, 2, 3, 4};
+    expect_error(huge, sizeof(huge), WS_CLOSE_TOO_BIG);
+
+    /* 不完整的帧等待更多数据 */
+    ws_parser parser;
+    ws_parser_reset(&parser);
+    len = client_frame(buf, 0x81, payload, 100, 0);
+    uint32_t used;
+    TEST_ASSERT(ws_parser_feed(&parser, buf, len - 1, &used) == WS_PARSE_MORE && used == len - 1);
+    TEST_ASSERT(ws_parser_feed(&parser, buf + len - 1, 1, &used) == WS_PARSE_FRAME && used == 1);
+}
+
+/* 随机字节流：每次返回后消耗的长度不超过输入，出错后重新开始 */
+static void test_garbage(void) {
+    uint8_t buf[512];
+    ws_parser parser;
+    ws_parser_reset(&parser);
+    for (int round = 0; round < 20000; round++) {
+        uint32_t len = test_rand() % sizeof(buf);
+        for (uint32_t i = 0; i < len; i++) buf[i] = (uint8_t) test_rand();
+        /* 让一部分帧头合法，覆盖负载的解析 */
+        if (len > 2 && (test_rand() & 1)) {
+            buf[0] &= 0x8f;
+            buf[1] = 0x80 | (buf[1] & 0x7f) % 126;
+        }
+        uint32_t pos = 0;
+        while (pos < len) {
+            uint32_t used;
+            ws_parse_result res = ws_parser_feed(&parser, buf + pos, len - pos, &used);
+            TEST_ASSERT(used <= len - pos);
+            pos += used;
+            if (res == WS_PARSE_ERROR) ws_parser_reset(&parser);
+            else if (res == WS_PARSE_FRAME) TEST_ASSERT(parser.payload_len <= WS_CONTROL_MAX);
+            else break;
+        }
+    }
+}
+
+int main(void) {
+    test_accept_key();
+    test_frame_header();
+    test_parse();
+    test_errors();
+    test_garbage();
+    printf("websocket: accept key, frame headers, split parsing and malformed frames passed\n");
+    return 0;
+}
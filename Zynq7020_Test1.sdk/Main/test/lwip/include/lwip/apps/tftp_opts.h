@@ -0,0 +1,18 @@
+//
+// 主机测试用的lwIP替身：TFTP选项，取lwIP 2.0.2的默认值，固件的lwip202配置没有修改
+//
+
+#ifndef TEST_LWIP_TFTP_OPTS_H
+#define TEST_LWIP_TFTP_OPTS_H
+
+#include "lwip/opt.h"
+
+#define TFTP_DEBUG              LWIP_DBG_OFF
+#define TFTP_PORT               69
+#define TFTP_TIMEOUT_MSECS      10000
+#define TFTP_MAX_RETRIES        5
+#define TFTP_TIMER_MSECS        50
+#define TFTP_MAX_FILENAME_LEN   20
+#define TFTP_MAX_MODE_LEN       7
+
+#endif //TEST_LWIP_TFTP_OPTS_H
@@ -0,0 +1,21 @@
+//
+// 主机测试用的lwIP替身：与lwIP 2.0.2的tftp_server.h相同的接口
+//
+
+#ifndef TEST_LWIP_TFTP_SERVER_H
+#define TEST_LWIP_TFTP_SERVER_H
+
+#include "lwip/apps/tftp_opts.h"
+#include "lwip/err.h"
+#include "lwip/pbuf.h"
+
+struct tftp_context {
+    void *(*open)(const char *fname, const char *mode, u8_t write);
+    void (*close)(void *handle);
+    int (*read)(void *handle, void *buf, int bytes);
+    int (*write)(void *handle, struct pbuf *p);
+};
+
+err_t tftp_init(const struct tftp_context *ctx);
+
+#endif //TEST_LWIP_TFTP_SERVER_H
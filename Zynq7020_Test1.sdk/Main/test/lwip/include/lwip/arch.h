@@ -0,0 +1,21 @@
+//
+// 主机测试用的lwIP替身：基本类型，与lwIP 2.0.2的arch.h同名
+//
+
+#ifndef TEST_LWIP_ARCH_H
+#define TEST_LWIP_ARCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t u8_t;
+typedef int8_t s8_t;
+typedef uint16_t u16_t;
+typedef int16_t s16_t;
+typedef uint32_t u32_t;
+typedef int32_t s32_t;
+typedef uintptr_t mem_ptr_t;
+
+#define LWIP_UNUSED_ARG(x) (void) (x)
+
+#endif //TEST_LWIP_ARCH_H
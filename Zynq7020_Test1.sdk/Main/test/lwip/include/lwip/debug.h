@@ -0,0 +1,19 @@
+//
+// 主机测试用的lwIP替身：调试输出全部关闭，断言使用assert
+//
+
+#ifndef TEST_LWIP_DEBUG_H
+#define TEST_LWIP_DEBUG_H
+
+#include <assert.h>
+
+#define LWIP_DBG_OFF        0x00U
+#define LWIP_DBG_ON         0x80U
+#define LWIP_DBG_TRACE      0x40U
+#define LWIP_DBG_STATE      0x20U
+
+#define LWIP_DEBUGF(debug, message) do { } while (0)
+#define LWIP_ASSERT(message, assertion) assert((assertion) && (message))
+#define LWIP_ERROR(message, expression, handler) do { if (!(expression)) { handler; } } while (0)
+
+#endif //TEST_LWIP_DEBUG_H
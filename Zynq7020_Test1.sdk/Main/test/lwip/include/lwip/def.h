@@ -0,0 +1,29 @@
+//
+// 主机测试用的lwIP替身：字节序和常用宏
+//
+
+#ifndef TEST_LWIP_DEF_H
+#define TEST_LWIP_DEF_H
+
+#include "lwip/arch.h"
+#include <strings.h>
+
+#define LWIP_MAX(x, y)  (((x) > (y)) ? (x) : (y))
+#define LWIP_MIN(x, y)  (((x) < (y)) ? (x) : (y))
+#define LWIP_ARRAYSIZE(x) (sizeof(x) / sizeof((x)[0]))
+
+#define PP_HTONS(x) ((u16_t) ((((x) & 0x00ffU) << 8) | (((x) & 0xff00U) >> 8)))
+#define PP_NTOHS(x) PP_HTONS(x)
+#define PP_HTONL(x) ((((x) & 0x000000ffUL) << 24) | (((x) & 0x0000ff00UL) << 8) | \
+                     (((x) & 0x00ff0000UL) >> 8) | (((x) & 0xff000000UL) >> 24))
+#define PP_NTOHL(x) PP_HTONL(x)
+
+/* 不包含arpa/inet.h，其中的recv等声明与lwIP应用的同名静态函数冲突；主机为小端 */
+#define lwip_htons(x) ((u16_t) __builtin_bswap16((u16_t) (x)))
+#define lwip_ntohs(x) lwip_htons(x)
+#define lwip_htonl(x) ((u32_t) __builtin_bswap32((u32_t) (x)))
+#define lwip_ntohl(x) lwip_htonl(x)
+#define lwip_stricmp(a, b) strcasecmp(a, b)
+#define lwip_strnicmp(a, b, n) strncasecmp(a, b, n)
+
+#endif //TEST_LWIP_DEF_H
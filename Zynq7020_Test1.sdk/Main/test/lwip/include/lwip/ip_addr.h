@@ -0,0 +1,40 @@
+//
+// 主机测试用的lwIP替身：只有IPv4，与固件的lwip202配置一致
+//
+
+#ifndef TEST_LWIP_IP_ADDR_H
+#define TEST_LWIP_IP_ADDR_H
+
+#include "lwip/def.h"
+
+typedef struct ip4_addr {
+    u32_t addr;
+} ip4_addr_t;
+
+typedef ip4_addr_t ip_addr_t;
+
+enum lwip_ip_addr_type {
+    IPADDR_TYPE_V4 = 0U,
+    IPADDR_TYPE_V6 = 6U,
+    IPADDR_TYPE_ANY = 46U
+};
+
+extern const ip_addr_t ip_addr_any;
+
+#define IP_ADDR_ANY         (&ip_addr_any)
+#define IP_ANY_TYPE         IP_ADDR_ANY
+#define IPADDR_ANY          ((u32_t) 0x00000000UL)
+
+#define IP4_ADDR(ipaddr, a, b, c, d) \
+        (ipaddr)->addr = PP_HTONL(((u32_t) ((a) & 0xff) << 24) | ((u32_t) ((b) & 0xff) << 16) | \
+                                  ((u32_t) ((c) & 0xff) << 8) | (u32_t) ((d) & 0xff))
+#define IP_ADDR4(ipaddr, a, b, c, d) IP4_ADDR(ipaddr, a, b, c, d)
+
+#define ip_addr_cmp(addr1, addr2)       ((addr1)->addr == (addr2)->addr)
+#define ip_addr_copy(dest, src)         ((dest).addr = (src).addr)
+#define ip_addr_set(dest, src)          ((dest)->addr = (src) == NULL ? 0 : (src)->addr)
+#define ip_addr_set_any(is_ipv6, ipaddr) ((void) (is_ipv6), (ipaddr)->addr = IPADDR_ANY)
+#define ip_addr_isany(ipaddr)           ((ipaddr) == NULL || (ipaddr)->addr == IPADDR_ANY)
+#define ip_addr_debug_print(debug, ipaddr) ((void) (ipaddr))
+
+#endif //TEST_LWIP_IP_ADDR_H
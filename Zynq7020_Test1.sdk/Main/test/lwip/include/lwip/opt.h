@@ -0,0 +1,26 @@
+//
+// 主机测试用的lwIP替身：与固件lwip202配置相关的选项
+//
+
+#ifndef TEST_LWIP_OPT_H
+#define TEST_LWIP_OPT_H
+
+#include "lwip/arch.h"
+#include "lwip/debug.h"
+#include <string.h>
+
+#define LWIP_UDP    1
+#define LWIP_TCP    1
+#define LWIP_IPV4   1
+#define LWIP_IPV6   0
+
+/* 与BSP的lwip202配置一致(system.mss的tcp_snd_buf)，TCP_SND_QUEUELEN按lwip202生成的lwipopts.h */
+#define TCP_MSS             1460
+#define TCP_SND_BUF         65535
+#define TCP_SND_QUEUELEN    (16 * TCP_SND_BUF / TCP_MSS)
+#define TCP_WND             (2 * TCP_MSS)
+
+#define MEMCPY(dst, src, len)       memcpy(dst, src, len)
+#define SMEMCPY(dst, src, len)      memcpy(dst, src, len)
+
+#endif //TEST_LWIP_OPT_H
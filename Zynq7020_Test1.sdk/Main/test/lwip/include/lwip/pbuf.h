@@ -0,0 +1,57 @@
+//
+// 主机测试用的lwIP替身：pbuf，接口和语义与lwIP 2.0.2一致，每个pbuf单独malloc，越界和泄漏由ASan检查
+//
+
+#ifndef TEST_LWIP_PBUF_H
+#define TEST_LWIP_PBUF_H
+
+#include "lwip/opt.h"
+#include "lwip/err.h"
+
+/* 协议头预留长度，与固件一致: 以太网14 + IP 20 + 传输层20 */
+#define PBUF_LINK_HLEN          14
+#define PBUF_IP_HLEN            20
+#define PBUF_TRANSPORT_HLEN     20
+
+typedef enum {
+    PBUF_TRANSPORT,
+    PBUF_IP,
+    PBUF_LINK,
+    PBUF_RAW_TX,
+    PBUF_RAW
+} pbuf_layer;
+
+typedef enum {
+    PBUF_RAM,
+    PBUF_ROM,
+    PBUF_REF,
+    PBUF_POOL
+} pbuf_type;
+
+#define PBUF_FLAG_IS_CUSTOM 0x02U
+
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len;
+    u16_t len;
+    u8_t type;
+    u8_t flags;
+    u16_t ref;
+};
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type);
+void pbuf_realloc(struct pbuf *p, u16_t size);
+u8_t pbuf_header(struct pbuf *p, s16_t header_size);
+void pbuf_ref(struct pbuf *p);
+u8_t pbuf_free(struct pbuf *p);
+u16_t pbuf_clen(const struct pbuf *p);
+void pbuf_cat(struct pbuf *head, struct pbuf *tail);
+void pbuf_chain(struct pbuf *head, struct pbuf *tail);
+err_t pbuf_copy(struct pbuf *p_to, const struct pbuf *p_from);
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset);
+err_t pbuf_take(struct pbuf *buf, const void *dataptr, u16_t len);
+u8_t pbuf_get_at(const struct pbuf *p, u16_t offset);
+u16_t pbuf_memfind(const struct pbuf *p, const void *mem, u16_t mem_len, u16_t start_offset);
+
+#endif //TEST_LWIP_PBUF_H
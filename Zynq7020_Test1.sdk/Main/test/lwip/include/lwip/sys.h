@@ -0,0 +1,12 @@
+//
+// 主机测试用的lwIP替身：sys_now返回lwip_sim的虚拟时间
+//
+
+#ifndef TEST_LWIP_SYS_H
+#define TEST_LWIP_SYS_H
+
+#include "lwip/opt.h"
+
+u32_t sys_now(void);
+
+#endif //TEST_LWIP_SYS_H
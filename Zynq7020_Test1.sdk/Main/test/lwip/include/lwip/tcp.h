@@ -0,0 +1,78 @@
+//
+// 主机测试用的lwIP替身：TCP raw API，连接的另一端由测试程序经tcp_shim.h驱动
+//
+
+#ifndef TEST_LWIP_TCP_H
+#define TEST_LWIP_TCP_H
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+#include "lwip/ip_addr.h"
+
+struct tcp_pcb;
+
+typedef err_t (*tcp_accept_fn)(void *arg, struct tcp_pcb *newpcb, err_t err);
+typedef err_t (*tcp_recv_fn)(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
+typedef err_t (*tcp_sent_fn)(void *arg, struct tcp_pcb *tpcb, u16_t len);
+typedef err_t (*tcp_poll_fn)(void *arg, struct tcp_pcb *tpcb);
+typedef void (*tcp_err_fn)(void *arg, err_t err);
+
+#define TCP_WRITE_FLAG_COPY 0x01
+#define TCP_WRITE_FLAG_MORE 0x02
+
+#define TF_NODELAY 0x40U
+
+struct tcp_pcb {
+    void *callback_arg;
+    tcp_accept_fn accept;
+    tcp_recv_fn recv;
+    tcp_sent_fn sent;
+    tcp_poll_fn poll;
+    tcp_err_fn errf;
+    u8_t pollinterval;
+    u8_t flags;
+    u16_t local_port;
+    u16_t mss;
+    u16_t snd_buf;                      //!< 发送缓冲区剩余空间
+    u16_t snd_queuelen;                 //!< 发送队列中的pbuf数
+    /* 以下只由tcp_shim.c使用 */
+    struct tcp_pcb *next;
+    u8_t shim_state;
+    u8_t listening;
+    u32_t unrecved;                     //!< 交给recv回调但还没有tcp_recved的字节数
+    u8_t *tx;                           //!< 已写入、对方还没有确认的数据
+    u32_t tx_len;
+    u32_t tx_cap;
+    u32_t tx_output;                    //!< tx中已tcp_output的长度
+    u16_t *segs;                        //!< tx中每段的长度，确认完一段才释放它占用的队列项
+    u32_t seg_num;
+    u32_t seg_cap;
+    u32_t seg_acked;                    //!< 第一段中已确认的长度
+    u8_t *rx;                           //!< 对方收到的数据
+    u32_t rx_len;
+    u32_t rx_cap;
+};
+
+#define tcp_sndbuf(pcb)         ((pcb)->snd_buf)
+#define tcp_sndqueuelen(pcb)    ((pcb)->snd_queuelen)
+#define tcp_mss(pcb)            ((pcb)->mss)
+#define tcp_nagle_disable(pcb)  ((pcb)->flags |= TF_NODELAY)
+#define tcp_nagle_enable(pcb)   ((pcb)->flags &= (u8_t) ~TF_NODELAY)
+
+struct tcp_pcb *tcp_new(void);
+struct tcp_pcb *tcp_new_ip_type(u8_t type);
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port);
+struct tcp_pcb *tcp_listen(struct tcp_pcb *pcb);
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept);
+void tcp_arg(struct tcp_pcb *pcb, void *arg);
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv);
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent);
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval);
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err);
+void tcp_recved(struct tcp_pcb *pcb, u16_t len);
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags);
+err_t tcp_output(struct tcp_pcb *pcb);
+err_t tcp_close(struct tcp_pcb *pcb);
+void tcp_abort(struct tcp_pcb *pcb);
+
+#endif //TEST_LWIP_TCP_H
@@ -0,0 +1,19 @@
+//
+// 主机测试用的lwIP替身：协议栈线程就是运行lwip_sim_run的线程，其他线程的回调排队后在其中执行
+//
+
+#ifndef TEST_LWIP_TCPIP_H
+#define TEST_LWIP_TCPIP_H
+
+#include "lwip/opt.h"
+#include "lwip/err.h"
+#include "lwip/timeouts.h"
+
+typedef void (*tcpip_callback_fn)(void *ctx);
+
+err_t tcpip_callback_with_block(tcpip_callback_fn function, void *ctx, u8_t block);
+
+#define tcpip_callback(f, ctx)              tcpip_callback_with_block(f, ctx, 1)
+#define tcpip_try_callback(f, ctx)          tcpip_callback_with_block(f, ctx, 0)
+
+#endif //TEST_LWIP_TCPIP_H
@@ -0,0 +1,16 @@
+//
+// 主机测试用的lwIP替身：定时器按lwip_sim的虚拟时钟触发
+//
+
+#ifndef TEST_LWIP_TIMEOUTS_H
+#define TEST_LWIP_TIMEOUTS_H
+
+#include "lwip/opt.h"
+#include "lwip/err.h"
+
+typedef void (*sys_timeout_handler)(void *arg);
+
+void sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg);
+void sys_untimeout(sys_timeout_handler handler, void *arg);
+
+#endif //TEST_LWIP_TIMEOUTS_H
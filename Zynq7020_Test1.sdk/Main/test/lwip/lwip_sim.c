@@ -0,0 +1,661 @@
+//
+// lwIP替身：pbuf、UDP、定时器和tcpip回调，以及虚拟时钟上的网络模拟
+//
+
+#include "lwip_sim.h"
+#include "lwip/timeouts.h"
+#include "lwip/tcpip.h"
+#include "lwip/sys.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_EPHEMERAL_PORT 49152
+
+typedef enum {
+    SIM_EVENT_TIMER,
+    SIM_EVENT_PACKET,
+} sim_event_kind;
+
+typedef struct sim_event {
+    struct sim_event *next;
+    uint64_t t;                     //!< 触发时刻(纳秒)
+    uint64_t seq;                   //!< 同一时刻按加入顺序
+    sim_event_kind kind;
+    sys_timeout_handler handler;
+    void *arg;
+    ip_addr_t src, dst;
+    u16_t src_port, dst_port;
+    u16_t len;
+    uint8_t data[];
+} sim_event;
+
+typedef struct sim_callback {
+    struct sim_callback *next;
+    tcpip_callback_fn fn;
+    void *ctx;
+} sim_callback;
+
+typedef struct sim_job {
+    struct sim_job *next;
+    uint64_t done;
+} sim_job;
+
+typedef struct {
+    struct pbuf p;
+    uint8_t *start;                 //!< 数据区起始，pbuf_header不能越过
+} sim_pbuf;
+
+const ip_addr_t ip_addr_any = {IPADDR_ANY};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+/* 以下由lock保护 */
+static uint64_t now;
+static uint64_t event_seq;
+static sim_event *events;
+static sim_callback *callbacks, **callbacks_tail = &callbacks;
+static sim_job *jobs;
+static uint32_t rand_state;
+static lwip_sim_link_t link;
+static lwip_sim_stats_t stats;
+
+/* 以下只在协议栈线程中访问 */
+static struct udp_pcb *pcbs;
+static lwip_sim_peer_t server;
+static lwip_sim_peer_t *peers;
+static uint32_t peer_num;
+static u16_t next_port = SIM_EPHEMERAL_PORT;
+
+static int pbuf_live;
+static int pcb_live;
+
+static uint32_t sim_rand(void) {
+    uint32_t x = rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rand_state = x;
+}
+
+static int sim_chance(uint32_t ppm) {
+    return ppm && sim_rand() % 1000000u < ppm;
+}
+
+/* 需要持有lock */
+static void event_insert(sim_event *e) {
+    e->seq = event_seq++;
+    sim_event **pp = &events;
+    while (*pp && (*pp)->t <= e->t) pp = &(*pp)->next;
+    e->next = *pp;
+    *pp = e;
+    pthread_cond_broadcast(&cond);
+}
+
+/* --------------------------------- pbuf --------------------------------- */
+
+static u16_t pbuf_layer_offset(pbuf_layer layer) {
+    switch (layer) {
+        case PBUF_TRANSPORT:
+            return PBUF_LINK_HLEN + PBUF_IP_HLEN + PBUF_TRANSPORT_HLEN;
+        case PBUF_IP:
+            return PBUF_LINK_HLEN + PBUF_IP_HLEN;
+        case PBUF_LINK:
+            return PBUF_LINK_HLEN;
+        default:
+            return 0;
+    }
+}
+
+static struct pbuf *pbuf_new(u16_t offset, u16_t len, pbuf_type type) {
+    size_t data = type == PBUF_RAM || type == PBUF_POOL ? (size_t) offset + len : 0;
+    sim_pbuf *sp = malloc(sizeof(sim_pbuf) + data);
+    if (sp == NULL) return NULL;
+    sp->start = (uint8_t *) (sp + 1);
+    struct pbuf *p = &sp->p;
+    p->next = NULL;
+    p->payload = data ? sp->start + offset : NULL;
+    p->tot_len = len;
+    p->len = len;
+    p->type = (u8_t) type;
+    p->flags = 0;
+    p->ref = 1;
+    __atomic_add_fetch(&pbuf_live, 1, __ATOMIC_RELAXED);
+    return p;
+}
+
+struct pbuf *pbuf_alloc(pbuf_layer layer, u16_t length, pbuf_type type) {
+    u16_t offset = pbuf_layer_offset(layer);
+    if (type != PBUF_POOL) return pbuf_new(offset, length, type);
+
+    /* 按pool_bufsize拆成链，与PBUF_POOL_BUFSIZE一样包含首段的协议头预留 */
+    u16_t bufsize = link.pool_bufsize ? link.pool_bufsize : UINT16_MAX;
+    struct pbuf *head = NULL, *tail = NULL;
+    u16_t rem = length;
+    do {
+        u16_t seg = LWIP_MIN(rem, (u16_t) (bufsize - (head ? 0 : offset)));
+        struct pbuf *q = pbuf_new(head ? 0 : offset, seg, PBUF_POOL);
+        if (q == NULL) {
+            if (head) pbuf_free(head);
+            return NULL;
+        }
+        q->tot_len = rem;
+        if (tail) tail->next = q;
+        else head = q;
+        tail = q;
+        rem -= seg;
+    } while (rem);
+    return head;
+}
+
+void pbuf_realloc(struct pbuf *p, u16_t size) {
+    if (size >= p->tot_len) return;
+    u16_t shrink = (u16_t) (p->tot_len - size);
+    u16_t rem = size;
+    struct pbuf *q = p;
+    while (rem > q->len) {
+        rem = (u16_t) (rem - q->len);
+        q->tot_len = (u16_t) (q->tot_len - shrink);
+        q = q->next;
+    }
+    q->len = rem;
+    q->tot_len = rem;
+    if (q->next) pbuf_free(q->next);
+    q->next = NULL;
+}
+
+u8_t pbuf_header(struct pbuf *p, s16_t header_size) {
+    if (header_size == 0) return 0;
+    if (header_size < 0) {
+        if (-header_size > p->len) return 1;
+    } else if (p->type == PBUF_RAM || p->type == PBUF_POOL) {
+        if ((uint8_t *) p->payload - header_size < ((sim_pbuf *) p)->start) return 1;
+    } else {
+        return 1;
+    }
+    p->payload = (uint8_t *) p->payload - header_size;
+    p->len = (u16_t) (p->len + header_size);
+    p->tot_len = (u16_t) (p->tot_len + header_size);
+    return 0;
+}
+
+void pbuf_ref(struct pbuf *p) {
+    if (p) p->ref++;
+}
+
+u8_t pbuf_free(struct pbuf *p) {
+    u8_t count = 0;
+    while (p != NULL) {
+        LWIP_ASSERT("pbuf ref > 0", p->ref > 0);
+        if (--p->ref) break;
+        struct pbuf *next = p->next;
+        free(p);
+        __atomic_sub_fetch(&pbuf_live, 1, __ATOMIC_RELAXED);
+        count++;
+        p = next;
+    }
+    return count;
+}
+
+u16_t pbuf_clen(const struct pbuf *p) {
+    u16_t len = 0;
+    for (; p; p = p->next) len++;
+    return len;
+}
+
+void pbuf_cat(struct pbuf *head, struct pbuf *tail) {
+    struct pbuf *p = head;
+    for (; p->next; p = p->next) p->tot_len = (u16_t) (p->tot_len + tail->tot_len);
+    p->tot_len = (u16_t) (p->tot_len + tail->tot_len);
+    p->next = tail;
+}
+
+void pbuf_chain(struct pbuf *head, struct pbuf *tail) {
+    pbuf_cat(head, tail);
+    pbuf_ref(tail);
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset) {
+    u16_t copied = 0;
+    for (; p && len; p = p->next) {
+        if (offset >= p->len) {
+            offset = (u16_t) (offset - p->len);
+            continue;
+        }
+        u16_t n = LWIP_MIN((u16_t) (p->len - offset), len);
+        memcpy((uint8_t *) dataptr + copied, (uint8_t *) p->payload + offset, n);
+        copied = (u16_t) (copied + n);
+        len = (u16_t) (len - n);
+        offset = 0;
+    }
+    return copied;
+}
+
+err_t pbuf_take(struct pbuf *buf, const void *dataptr, u16_t len) {
+    if (buf == NULL || buf->tot_len < len) return ERR_ARG;
+    u16_t done = 0;
+    for (struct pbuf *q = buf; done < len; q = q->next) {
+        u16_t n = LWIP_MIN(q->len, (u16_t) (len - done));
+        memcpy(q->payload, (const uint8_t *) dataptr + done, n);
+        done = (u16_t) (done + n);
+    }
+    return ERR_OK;
+}
+
+err_t pbuf_copy(struct pbuf *p_to, const struct pbuf *p_from) {
+    if (p_to == NULL || p_from == NULL || p_to->tot_len < p_from->tot_len) return ERR_ARG;
+    u16_t offset = 0;
+    for (const struct pbuf *q = p_from; q; q = q->next) {
+        /* 按目标链的分段逐段拷贝 */
+        u16_t done = 0;
+        while (done < q->len) {
+            struct pbuf *t = p_to;
+            u16_t pos = (u16_t) (offset + done);
+            while (pos >= t->len) {
+                pos = (u16_t) (pos - t->len);
+                t = t->next;
+            }
+            u16_t n = LWIP_MIN((u16_t) (t->len - pos), (u16_t) (q->len - done));
+            memcpy((uint8_t *) t->payload + pos, (uint8_t *) q->payload + done, n);
+            done = (u16_t) (done + n);
+        }
+        offset = (u16_t) (offset + q->len);
+    }
+    return ERR_OK;
+}
+
+u8_t pbuf_get_at(const struct pbuf *p, u16_t offset) {
+    for (; p; p = p->next) {
+        if (offset < p->len) return ((uint8_t *) p->payload)[offset];
+        offset = (u16_t) (offset - p->len);
+    }
+    return 0;
+}
+
+u16_t pbuf_memfind(const struct pbuf *p, const void *mem, u16_t mem_len, u16_t start_offset) {
+    if (p->tot_len < mem_len + start_offset) return 0xFFFF;
+    u16_t max = (u16_t) (p->tot_len - mem_len);
+    for (u32_t i = start_offset; i <= max; i++) {
+        u16_t j = 0;
+        while (j < mem_len && pbuf_get_at(p, (u16_t) (i + j)) == ((const uint8_t *) mem)[j]) j++;
+        if (j == mem_len) return (u16_t) i;
+    }
+    return 0xFFFF;
+}
+
+/* ---------------------------------- 网络 ---------------------------------- */
+
+static lwip_sim_peer_t *host_find(const ip_addr_t *addr) {
+    if (ip_addr_cmp(addr, &server.addr)) return &server;
+    for (lwip_sim_peer_t *p = peers; p; p = p->next)
+        if (ip_addr_cmp(addr, &p->addr)) return p;
+    return NULL;
+}
+
+/* 串行时间(纳秒) */
+static uint64_t wire_ns(u16_t len) {
+    if (link.rate_mbps == 0) return 0;
+    return ((uint64_t) len + LWIP_SIM_HEADER_LEN) * 8 * 1000 / link.rate_mbps;
+}
+
+static void transmit(lwip_sim_peer_t *src, u16_t src_port, const ip_addr_t *dst_addr, u16_t dst_port,
+                     const struct pbuf *p, const void *data, u16_t len) {
+    pthread_mutex_lock(&lock);
+    stats.packets++;
+    stats.bytes += len;
+    uint64_t ser = wire_ns(len);
+    uint64_t depart = LWIP_MAX(now, src->tx_free) + ser;
+    src->tx_free = depart;
+    lwip_sim_peer_t *dst = host_find(dst_addr);
+    if (dst == NULL || sim_chance(link.loss_ppm)) {
+        if (dst) stats.lost++;
+        else stats.unreachable++;
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+    uint64_t out = LWIP_MAX(depart, dst->rx_free) + ser;
+    dst->rx_free = out;
+
+    sim_event *e = malloc(sizeof(sim_event) + len);
+    LWIP_ASSERT("event alloc", e != NULL);
+    e->t = out + (uint64_t) link.delay_us * 1000;
+    e->kind = SIM_EVENT_PACKET;
+    e->src = src->addr;
+    e->src_port = src_port;
+    e->dst = *dst_addr;
+    e->dst_port = dst_port;
+    e->len = len;
+    if (p) pbuf_copy_partial(p, e->data, len, 0);
+    else memcpy(e->data, data, len);
+    event_insert(e);
+    pthread_mutex_unlock(&lock);
+}
+
+static void deliver(sim_event *e) {
+    if (ip_addr_cmp(&e->dst, &server.addr)) {
+        struct udp_pcb *pcb = pcbs;
+        while (pcb && pcb->local_port != e->dst_port) pcb = pcb->next;
+        if (pcb == NULL) {
+            pthread_mutex_lock(&lock);
+            stats.unreachable++;
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        /* 网卡收到的报文在PBUF_POOL中，长报文是链 */
+        struct pbuf *p = pbuf_alloc(PBUF_RAW, e->len, PBUF_POOL);
+        LWIP_ASSERT("rx pbuf", p != NULL);
+        pbuf_take(p, e->data, e->len);
+        if (pcb->recv) pcb->recv(pcb->recv_arg, pcb, p, &e->src, e->src_port);
+        else pbuf_free(p);
+        return;
+    }
+    for (lwip_sim_peer_t *peer = peers; peer; peer = peer->next) {
+        if (ip_addr_cmp(&peer->addr, &e->dst) && peer->port == e->dst_port) {
+            peer->recv(peer->arg, e->data, e->len, &e->src, e->src_port);
+            return;
+        }
+    }
+    pthread_mutex_lock(&lock);
+    stats.unreachable++;
+    pthread_mutex_unlock(&lock);
+}
+
+void lwip_sim_init(const lwip_sim_link_t *l, uint32_t seed) {
+    pthread_mutex_lock(&lock);
+    LWIP_ASSERT("no jobs left", jobs == NULL);
+    while (events) {
+        sim_event *e = events;
+        events = e->next;
+        free(e);
+    }
+    while (callbacks) {
+        sim_callback *c = callbacks;
+        callbacks = c->next;
+        free(c);
+    }
+    callbacks_tail = &callbacks;
+    now = 0;
+    event_seq = 0;
+    rand_state = seed ? seed : 1;
+    link = *l;
+    memset(&stats, 0, sizeof(stats));
+    pthread_mutex_unlock(&lock);
+
+    while (pcbs) udp_remove(pcbs);
+    memset(&server, 0, sizeof(server));
+    IP4_ADDR(&server.addr, 10, 0, 0, 1);
+    peers = NULL;
+    peer_num = 0;
+    next_port = SIM_EPHEMERAL_PORT;
+}
+
+void lwip_sim_set_link(const lwip_sim_link_t *l) {
+    pthread_mutex_lock(&lock);
+    link = *l;
+    pthread_mutex_unlock(&lock);
+}
+
+const ip_addr_t *lwip_sim_server_addr(void) {
+    return &server.addr;
+}
+
+void lwip_sim_peer_open(lwip_sim_peer_t *peer, u16_t port, lwip_sim_recv_fn recv, void *arg) {
+    memset(peer, 0, sizeof(*peer));
+    peer_num++;
+    IP4_ADDR(&peer->addr, 10, 0, (peer_num + 1) >> 8, (peer_num + 1) & 0xff);
+    peer->port = port;
+    peer->recv = recv;
+    peer->arg = arg;
+    peer->next = peers;
+    peers = peer;
+}
+
+void lwip_sim_peer_close(lwip_sim_peer_t *peer) {
+    for (lwip_sim_peer_t **pp = &peers; *pp; pp = &(*pp)->next) {
+        if (*pp == peer) {
+            *pp = peer->next;
+            break;
+        }
+    }
+}
+
+void lwip_sim_peer_send(lwip_sim_peer_t *peer, const void *data, uint16_t len, u16_t port) {
+    transmit(peer, peer->port, &server.addr, port, NULL, data, len);
+}
+
+/* ----------------------------------- UDP ---------------------------------- */
+
+struct udp_pcb *udp_new(void) {
+    struct udp_pcb *pcb = calloc(1, sizeof(struct udp_pcb));
+    if (pcb) __atomic_add_fetch(&pcb_live, 1, __ATOMIC_RELAXED);
+    return pcb;
+}
+
+struct udp_pcb *udp_new_ip_type(u8_t type) {
+    LWIP_UNUSED_ARG(type);
+    return udp_new();
+}
+
+void udp_remove(struct udp_pcb *pcb) {
+    for (struct udp_pcb **pp = &pcbs; *pp; pp = &(*pp)->next) {
+        if (*pp == pcb) {
+            *pp = pcb->next;
+            break;
+        }
+    }
+    free(pcb);
+    __atomic_sub_fetch(&pcb_live, 1, __ATOMIC_RELAXED);
+}
+
+static int port_used(u16_t port) {
+    for (struct udp_pcb *p = pcbs; p; p = p->next)
+        if (p->local_port == port) return 1;
+    return 0;
+}
+
+err_t udp_bind(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+    int listed = 0;
+    for (struct udp_pcb *p = pcbs; p; p = p->next) {
+        if (p == pcb) listed = 1;
+        else if (port && p->local_port == port) return ERR_USE;
+    }
+    if (port == 0) {
+        do {
+            port = next_port++;
+            if (next_port == 0) next_port = SIM_EPHEMERAL_PORT;
+        } while (port_used(port));
+    }
+    pcb->local_port = port;
+    ip_addr_set(&pcb->local_ip, ipaddr);
+    if (!listed) {
+        pcb->next = pcbs;
+        pcbs = pcb;
+    }
+    return ERR_OK;
+}
+
+err_t udp_connect(struct udp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+    if (pcb->local_port == 0 && udp_bind(pcb, IP_ADDR_ANY, 0) != ERR_OK) return ERR_USE;
+    ip_addr_set(&pcb->remote_ip, ipaddr);
+    pcb->remote_port = port;
+    return ERR_OK;
+}
+
+void udp_disconnect(struct udp_pcb *pcb) {
+    ip_addr_set_any(0, &pcb->remote_ip);
+    pcb->remote_port = 0;
+}
+
+void udp_recv(struct udp_pcb *pcb, udp_recv_fn recv, void *recv_arg) {
+    pcb->recv = recv;
+    pcb->recv_arg = recv_arg;
+}
+
+err_t udp_sendto(struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *dst_ip, u16_t dst_port) {
+    if (pcb->local_port == 0 && udp_bind(pcb, IP_ADDR_ANY, 0) != ERR_OK) return ERR_USE;
+    transmit(&server, pcb->local_port, dst_ip, dst_port, p, NULL, p->tot_len);
+    return ERR_OK;
+}
+
+err_t udp_send(struct udp_pcb *pcb, struct pbuf *p) {
+    return udp_sendto(pcb, p, &pcb->remote_ip, pcb->remote_port);
+}
+
+/* ------------------------------ 定时器和回调 ------------------------------ */
+
+void lwip_sim_timeout_us(uint64_t us, sys_timeout_handler handler, void *arg) {
+    sim_event *e = malloc(sizeof(sim_event));
+    LWIP_ASSERT("event alloc", e != NULL);
+    e->kind = SIM_EVENT_TIMER;
+    e->handler = handler;
+    e->arg = arg;
+    pthread_mutex_lock(&lock);
+    e->t = now + us * 1000;
+    event_insert(e);
+    pthread_mutex_unlock(&lock);
+}
+
+void sys_timeout(u32_t msecs, sys_timeout_handler handler, void *arg) {
+    lwip_sim_timeout_us((uint64_t) msecs * 1000, handler, arg);
+}
+
+void sys_untimeout(sys_timeout_handler handler, void *arg) {
+    pthread_mutex_lock(&lock);
+    for (sim_event **pp = &events; *pp; pp = &(*pp)->next) {
+        sim_event *e = *pp;
+        if (e->kind == SIM_EVENT_TIMER && e->handler == handler && e->arg == arg) {
+            *pp = e->next;
+            free(e);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+u32_t sys_now(void) {
+    return (u32_t) (lwip_sim_now_us() / 1000);
+}
+
+err_t tcpip_callback_with_block(tcpip_callback_fn function, void *ctx, u8_t block) {
+    sim_callback *c = malloc(sizeof(sim_callback));
+    if (c == NULL) return ERR_MEM;
+    c->next = NULL;
+    c->fn = function;
+    c->ctx = ctx;
+    pthread_mutex_lock(&lock);
+    if (!block && sim_chance(link.callback_drop_ppm)) {
+        stats.callbacks_dropped++;
+        pthread_mutex_unlock(&lock);
+        free(c);
+        return ERR_MEM;
+    }
+    *callbacks_tail = c;
+    callbacks_tail = &c->next;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+    return ERR_OK;
+}
+
+/* ---------------------------------- 时钟 ---------------------------------- */
+
+uint64_t lwip_sim_now_us(void) {
+    pthread_mutex_lock(&lock);
+    uint64_t t = now / 1000;
+    pthread_mutex_unlock(&lock);
+    return t;
+}
+
+void *lwip_sim_job_begin(uint64_t done_us) {
+    sim_job *job = malloc(sizeof(sim_job));
+    LWIP_ASSERT("job alloc", job != NULL);
+    pthread_mutex_lock(&lock);
+    job->done = LWIP_MAX(done_us * 1000, now);
+    job->next = jobs;
+    jobs = job;
+    pthread_mutex_unlock(&lock);
+    return job;
+}
+
+void lwip_sim_job_wait(void *job) {
+    sim_job *j = job;
+    pthread_mutex_lock(&lock);
+    while (now < j->done) pthread_cond_wait(&cond, &lock);
+    pthread_mutex_unlock(&lock);
+}
+
+void lwip_sim_job_end(void *job) {
+    pthread_mutex_lock(&lock);
+    for (sim_job **pp = &jobs; *pp; pp = &(*pp)->next) {
+        if (*pp == job) {
+            *pp = ((sim_job *) job)->next;
+            break;
+        }
+    }
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&lock);
+    free(job);
+}
+
+int lwip_sim_run(int (*done)(void *arg), void *arg, uint64_t limit_us) {
+    uint64_t limit = limit_us * 1000;
+    for (;;) {
+        if (done && done(arg)) return 1;
+
+        pthread_mutex_lock(&lock);
+        sim_callback *c = callbacks;
+        if (c) {
+            callbacks = c->next;
+            if (callbacks == NULL) callbacks_tail = &callbacks;
+            pthread_mutex_unlock(&lock);
+            c->fn(c->ctx);
+            free(c);
+            continue;
+        }
+
+        /* 已到完成时刻的作业结束前时钟不能前进，它排队的回调要先执行 */
+        uint64_t next = events ? events->t : UINT64_MAX;
+        int job_due = 0;
+        for (sim_job *j = jobs; j; j = j->next) {
+            if (j->done <= now) job_due = 1;
+            next = LWIP_MIN(next, j->done);
+        }
+        if (job_due) {
+            pthread_cond_wait(&cond, &lock);
+            pthread_mutex_unlock(&lock);
+            continue;
+        }
+        if (next == UINT64_MAX || next > limit) {
+            pthread_mutex_unlock(&lock);
+            return 0;
+        }
+        if (next > now) {
+            now = next;
+            pthread_cond_broadcast(&cond);
+        }
+        sim_event *e = events;
+        if (e && e->t <= now) events = e->next;
+        else e = NULL;
+        pthread_mutex_unlock(&lock);
+
+        if (e) {
+            if (e->kind == SIM_EVENT_TIMER) e->handler(e->arg);
+            else deliver(e);
+            free(e);
+        }
+    }
+}
+
+void lwip_sim_get_stats(lwip_sim_stats_t *s) {
+    pthread_mutex_lock(&lock);
+    *s = stats;
+    pthread_mutex_unlock(&lock);
+}
+
+int lwip_sim_pbuf_count(void) {
+    return __atomic_load_n(&pbuf_live, __ATOMIC_RELAXED);
+}
+
+int lwip_sim_pcb_count(void) {
+    return __atomic_load_n(&pcb_live, __ATOMIC_RELAXED);
+}
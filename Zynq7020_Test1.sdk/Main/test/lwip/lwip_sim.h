@@ -0,0 +1,134 @@
+//
+// lwIP替身的网络和时钟模拟
+// 虚拟时钟只在没有可执行的工作时前进：先执行排队的tcpip回调，再等到期的外部作业结束，
+// 然后跳到下一个事件(报文到达、定时器、外部作业完成)的时刻，所以结果与主机速度无关。
+// 被测代码的udp_pcb都在服务器地址上，测试程序用lwip_sim_peer_t模拟对端主机。
+// 每台主机一个网口，报文在发送端网口和交换机到接收端的出口各串行一次，再加单向延迟
+//
+
+#ifndef TEST_LWIP_SIM_H
+#define TEST_LWIP_SIM_H
+
+#include "lwip/udp.h"
+#include "lwip/timeouts.h"
+#include <stdint.h>
+
+#define LWIP_SIM_HEADER_LEN 42          //!< 以太网 + IP + UDP头，计入串行时间
+
+typedef struct {
+    uint32_t delay_us;                  //!< 单向延迟，RTT为两倍
+    uint32_t rate_mbps;                 //!< 每个网口的速率，0为不限
+    uint32_t loss_ppm;                  //!< 每个报文的丢失概率(百万分之一)
+    uint16_t pool_bufsize;              //!< 收到的报文按该长度拆成PBUF_POOL链，0为不拆
+    uint32_t callback_drop_ppm;         //!< 不阻塞的tcpip_callback失败的概率(百万分之一)，模拟消息队列满
+} lwip_sim_link_t;
+
+typedef struct {
+    uint32_t packets;                   //!< 发出的报文数
+    uint64_t bytes;                     //!< 发出的UDP负载字节数
+    uint32_t lost;                      //!< 被丢弃的报文数
+    uint32_t unreachable;               //!< 目的端口没有pcb的报文数
+    uint32_t callbacks_dropped;         //!< 按callback_drop_ppm失败的回调数
+} lwip_sim_stats_t;
+
+typedef struct lwip_sim_peer lwip_sim_peer_t;
+
+/**
+ * 对端收到报文，在协议栈线程中执行
+ * @param data 负载，回调返回后失效
+ */
+typedef void (*lwip_sim_recv_fn)(void *arg, const uint8_t *data, uint16_t len, const ip_addr_t *addr, u16_t port);
+
+struct lwip_sim_peer {
+    lwip_sim_peer_t *next;
+    ip_addr_t addr;
+    u16_t port;
+    lwip_sim_recv_fn recv;
+    void *arg;
+    uint64_t tx_free;                   //!< 网口空闲的时刻
+    uint64_t rx_free;                   //!< 交换机到该主机的出口空闲的时刻
+};
+
+/**
+ * 清空所有pcb、对端、事件和统计，时钟归零
+ * @param link 网络参数
+ * @param seed 丢包的随机种子
+ */
+void lwip_sim_init(const lwip_sim_link_t *link, uint32_t seed);
+
+/**
+ * 修改网络参数，已经在途的报文不受影响
+ */
+void lwip_sim_set_link(const lwip_sim_link_t *link);
+
+/**
+ * 被测代码的地址，udp_pcb都绑定在该地址上
+ */
+const ip_addr_t *lwip_sim_server_addr(void);
+
+/**
+ * 添加一台对端主机，地址按添加顺序分配
+ * @param peer 由调用者保存，lwip_sim_peer_close或lwip_sim_init之前不能释放
+ * @param port 对端的端口
+ */
+void lwip_sim_peer_open(lwip_sim_peer_t *peer, u16_t port, lwip_sim_recv_fn recv, void *arg);
+
+/**
+ * 移除对端主机，之后发给它的报文被丢弃
+ */
+void lwip_sim_peer_close(lwip_sim_peer_t *peer);
+
+/**
+ * 对端向服务器地址发送一个报文
+ */
+void lwip_sim_peer_send(lwip_sim_peer_t *peer, const void *data, uint16_t len, u16_t port);
+
+/**
+ * 在协议栈线程中，经过us微秒后调用handler，与sys_timeout共用定时器，可以用sys_untimeout取消
+ */
+void lwip_sim_timeout_us(uint64_t us, sys_timeout_handler handler, void *arg);
+
+/**
+ * 执行事件直到done返回非0、没有任何事件或虚拟时间超过limit_us
+ * 调用的线程就是协议栈线程
+ * @param done 每个事件之后检查，为NULL时一直运行
+ * @param limit_us 绝对的虚拟时间上限
+ * @return done返回非0时为1，否则为0
+ */
+int lwip_sim_run(int (*done)(void *arg), void *arg, uint64_t limit_us);
+
+/**
+ * 当前虚拟时间(微秒)，可以在任意线程中调用
+ */
+uint64_t lwip_sim_now_us(void);
+
+/**
+ * 开始一个在其他线程中执行、在虚拟时间done_us完成的作业，用于给文件服务等加上耗时。
+ * 时钟不会越过done_us，直到作业结束
+ * @return 作业，传给lwip_sim_job_wait和lwip_sim_job_end
+ */
+void *lwip_sim_job_begin(uint64_t done_us);
+
+/**
+ * 在执行作业的线程中等到虚拟时间到达作业的完成时刻
+ */
+void lwip_sim_job_wait(void *job);
+
+/**
+ * 作业结束，之前由该作业排队的tcpip回调都会在时钟前进之前执行
+ */
+void lwip_sim_job_end(void *job);
+
+void lwip_sim_get_stats(lwip_sim_stats_t *stats);
+
+/**
+ * 未释放的pbuf数
+ */
+int lwip_sim_pbuf_count(void);
+
+/**
+ * 未删除的udp_pcb数
+ */
+int lwip_sim_pcb_count(void);
+
+#endif //TEST_LWIP_SIM_H
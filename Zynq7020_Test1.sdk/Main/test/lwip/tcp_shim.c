@@ -0,0 +1,262 @@
+//
+// TCP替身
+//
+
+#include "tcp_shim.h"
+#include <stdlib.h>
+#include <string.h>
+
+static struct tcp_pcb *pcbs;
+static int close_fail;
+
+static void buf_append(u8_t **buf, u32_t *len, u32_t *cap, const void *data, u32_t n) {
+    if (*len + n > *cap) {
+        *cap = LWIP_MAX(*cap * 2, *len + n);
+        *buf = realloc(*buf, *cap);
+        LWIP_ASSERT("shim buffer", *buf != NULL);
+    }
+    memcpy(*buf + *len, data, n);
+    *len += n;
+}
+
+static void seg_push(struct tcp_pcb *pcb, u16_t len) {
+    if (pcb->seg_num == pcb->seg_cap) {
+        pcb->seg_cap = LWIP_MAX(pcb->seg_cap * 2, 64);
+        pcb->segs = realloc(pcb->segs, pcb->seg_cap * sizeof(u16_t));
+        LWIP_ASSERT("shim segments", pcb->segs != NULL);
+    }
+    pcb->segs[pcb->seg_num++] = len;
+}
+
+/* 回调返回ERR_ABRT时服务器必须已经调用了tcp_abort */
+static err_t check_abort(struct tcp_pcb *pcb, err_t err) {
+    LWIP_ASSERT("ERR_ABRT without tcp_abort", err != ERR_ABRT || pcb->shim_state == TCP_SHIM_ABORTED);
+    return err;
+}
+
+/* ------------------------------ 服务器的接口 ------------------------------ */
+
+struct tcp_pcb *tcp_new(void) {
+    struct tcp_pcb *pcb = calloc(1, sizeof(struct tcp_pcb));
+    if (pcb == NULL) return NULL;
+    pcb->mss = TCP_MSS;
+    pcb->snd_buf = TCP_SND_BUF;
+    pcb->shim_state = TCP_SHIM_OPEN;
+    pcb->next = pcbs;
+    pcbs = pcb;
+    return pcb;
+}
+
+struct tcp_pcb *tcp_new_ip_type(u8_t type) {
+    LWIP_UNUSED_ARG(type);
+    return tcp_new();
+}
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+    LWIP_UNUSED_ARG(ipaddr);
+    for (struct tcp_pcb *p = pcbs; p; p = p->next)
+        if (p != pcb && p->listening && p->shim_state == TCP_SHIM_OPEN && p->local_port == port) return ERR_USE;
+    pcb->local_port = port;
+    return ERR_OK;
+}
+
+struct tcp_pcb *tcp_listen(struct tcp_pcb *pcb) {
+    pcb->listening = 1;
+    return pcb;
+}
+
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept) {
+    pcb->accept = accept;
+}
+
+void tcp_arg(struct tcp_pcb *pcb, void *arg) {
+    pcb->callback_arg = arg;
+}
+
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv) {
+    pcb->recv = recv;
+}
+
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent) {
+    pcb->sent = sent;
+}
+
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval) {
+    pcb->poll = poll;
+    pcb->pollinterval = interval;
+}
+
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err) {
+    pcb->errf = err;
+}
+
+void tcp_recved(struct tcp_pcb *pcb, u16_t len) {
+    LWIP_ASSERT("tcp_recved more than received", len <= pcb->unrecved);
+    pcb->unrecved -= len;
+}
+
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags) {
+    LWIP_UNUSED_ARG(apiflags);
+    if (pcb->shim_state != TCP_SHIM_OPEN || pcb->listening) return ERR_CONN;
+    if (len > pcb->snd_buf) return ERR_MEM;
+    /* 每次写入至少占用一个队列项，按MSS分段，不与上次写入合并 */
+    u32_t segs = len ? (len + pcb->mss - 1u) / pcb->mss : 0;
+    if (pcb->snd_queuelen + segs > TCP_SND_QUEUELEN) return ERR_MEM;
+    buf_append(&pcb->tx, &pcb->tx_len, &pcb->tx_cap, dataptr, len);
+    for (u32_t off = 0; off < len; off += pcb->mss) seg_push(pcb, (u16_t) LWIP_MIN(pcb->mss, len - off));
+    pcb->snd_buf -= len;
+    pcb->snd_queuelen += segs;
+    return ERR_OK;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb) {
+    pcb->tx_output = pcb->tx_len;
+    return ERR_OK;
+}
+
+err_t tcp_close(struct tcp_pcb *pcb) {
+    if (close_fail > 0 && !pcb->listening) {
+        close_fail--;
+        return ERR_MEM;
+    }
+    /* 关闭时已写入的数据随FIN发出 */
+    pcb->tx_output = pcb->tx_len;
+    pcb->shim_state = TCP_SHIM_CLOSED;
+    return ERR_OK;
+}
+
+void tcp_abort(struct tcp_pcb *pcb) {
+    tcp_err_fn errf = pcb->errf;
+    void *arg = pcb->callback_arg;
+    pcb->shim_state = TCP_SHIM_ABORTED;
+    pcb->tx_len = pcb->tx_output = 0;
+    if (errf) errf(arg, ERR_ABRT);
+}
+
+/* ------------------------------ 测试程序的接口 ------------------------------ */
+
+void tcp_shim_init(void) {
+    while (pcbs) {
+        pcbs->shim_state = TCP_SHIM_ABORTED;
+        tcp_shim_free(pcbs);
+    }
+    close_fail = 0;
+}
+
+struct tcp_pcb *tcp_shim_connect(u16_t port) {
+    struct tcp_pcb *listener = pcbs;
+    while (listener && !(listener->listening && listener->shim_state == TCP_SHIM_OPEN && listener->local_port == port))
+        listener = listener->next;
+    if (listener == NULL || listener->accept == NULL) return NULL;
+
+    struct tcp_pcb *pcb = tcp_new();
+    LWIP_ASSERT("pcb alloc", pcb != NULL);
+    pcb->local_port = port;
+    err_t err = check_abort(pcb, listener->accept(listener->callback_arg, pcb, ERR_OK));
+    /* accept失败时协议栈复位连接 */
+    if (err != ERR_OK && err != ERR_ABRT) tcp_abort(pcb);
+    return pcb;
+}
+
+err_t tcp_shim_send(struct tcp_pcb *pcb, const void *data, uint32_t len) {
+    const u8_t *src = data;
+    do {
+        if (pcb->shim_state != TCP_SHIM_OPEN) return ERR_CLSD;
+        u16_t n = (u16_t) LWIP_MIN(len, 0xffffu);
+        struct pbuf *p = pbuf_alloc(PBUF_RAW, n, PBUF_POOL);
+        LWIP_ASSERT("rx pbuf", p != NULL);
+        pbuf_take(p, src, n);
+        pcb->unrecved += n;
+        if (pcb->recv == NULL) {
+            /* 与tcp_recv_null一样确认并丢弃 */
+            pcb->unrecved -= n;
+            pbuf_free(p);
+        } else {
+            err_t err = check_abort(pcb, pcb->recv(pcb->callback_arg, pcb, p, ERR_OK));
+            LWIP_ASSERT("refused data is not supported", err == ERR_OK || err == ERR_ABRT);
+            if (err != ERR_OK) return err;
+        }
+        src += n;
+        len -= n;
+    } while (len);
+    return ERR_OK;
+}
+
+uint32_t tcp_shim_ack(struct tcp_pcb *pcb, uint32_t len) {
+    if (pcb->shim_state == TCP_SHIM_ABORTED) return 0;
+    u32_t n = LWIP_MIN(len, pcb->tx_output);
+    if (n == 0) return 0;
+    buf_append(&pcb->rx, &pcb->rx_len, &pcb->rx_cap, pcb->tx, n);
+    memmove(pcb->tx, pcb->tx + n, pcb->tx_len - n);
+    pcb->tx_len -= n;
+    pcb->tx_output -= n;
+    pcb->snd_buf += n;
+    pcb->seg_acked += n;
+    u32_t done = 0;
+    while (done < pcb->seg_num && pcb->seg_acked >= pcb->segs[done]) pcb->seg_acked -= pcb->segs[done++];
+    memmove(pcb->segs, pcb->segs + done, (pcb->seg_num - done) * sizeof(u16_t));
+    pcb->seg_num -= done;
+    pcb->snd_queuelen -= done;
+    if (pcb->shim_state == TCP_SHIM_OPEN && pcb->sent)
+        check_abort(pcb, pcb->sent(pcb->callback_arg, pcb, (u16_t) n));
+    return n;
+}
+
+err_t tcp_shim_poll(struct tcp_pcb *pcb) {
+    if (pcb->shim_state != TCP_SHIM_OPEN || pcb->poll == NULL) return ERR_OK;
+    return check_abort(pcb, pcb->poll(pcb->callback_arg, pcb));
+}
+
+err_t tcp_shim_fin(struct tcp_pcb *pcb) {
+    if (pcb->shim_state != TCP_SHIM_OPEN) return ERR_CLSD;
+    if (pcb->recv == NULL) return tcp_close(pcb);
+    return check_abort(pcb, pcb->recv(pcb->callback_arg, pcb, NULL, ERR_OK));
+}
+
+void tcp_shim_reset(struct tcp_pcb *pcb) {
+    if (pcb->shim_state != TCP_SHIM_OPEN) return;
+    tcp_err_fn errf = pcb->errf;
+    pcb->shim_state = TCP_SHIM_ABORTED;
+    pcb->tx_len = pcb->tx_output = 0;
+    if (errf) errf(pcb->callback_arg, ERR_RST);
+}
+
+const uint8_t *tcp_shim_received(struct tcp_pcb *pcb, uint32_t *len) {
+    *len = pcb->rx_len;
+    return pcb->rx;
+}
+
+void tcp_shim_consume(struct tcp_pcb *pcb, uint32_t len) {
+    LWIP_ASSERT("consume", len <= pcb->rx_len);
+    memmove(pcb->rx, pcb->rx + len, pcb->rx_len - len);
+    pcb->rx_len -= len;
+}
+
+tcp_shim_state tcp_shim_get_state(const struct tcp_pcb *pcb) {
+    return (tcp_shim_state) pcb->shim_state;
+}
+
+void tcp_shim_free(struct tcp_pcb *pcb) {
+    LWIP_ASSERT("pcb still owned by the server", pcb->shim_state != TCP_SHIM_OPEN);
+    for (struct tcp_pcb **pp = &pcbs; *pp; pp = &(*pp)->next) {
+        if (*pp == pcb) {
+            *pp = pcb->next;
+            break;
+        }
+    }
+    free(pcb->tx);
+    free(pcb->segs);
+    free(pcb->rx);
+    free(pcb);
+}
+
+void tcp_shim_fail_close(int count) {
+    close_fail = count;
+}
+
+int tcp_shim_pcb_count(void) {
+    int count = 0;
+    for (struct tcp_pcb *p = pcbs; p; p = p->next)
+        if (p->shim_state == TCP_SHIM_OPEN) count++;
+    return count;
+}
@@ -0,0 +1,87 @@
+//
+// TCP替身的对端：测试程序扮演客户端，逐步送入数据、确认服务器发出的数据、触发poll，
+// 没有网络时序，服务器的发送缓冲区只在测试程序确认时空出，可以精确构造背压。
+// 服务器tcp_close或tcp_abort之后pcb仍保留给测试程序读取收到的数据，由tcp_shim_free释放
+//
+
+#ifndef TEST_TCP_SHIM_H
+#define TEST_TCP_SHIM_H
+
+#include "lwip/tcp.h"
+#include <stdint.h>
+
+typedef enum {
+    TCP_SHIM_OPEN,                      //!< 服务器持有pcb
+    TCP_SHIM_CLOSED,                    //!< 服务器tcp_close，未确认的数据仍可确认
+    TCP_SHIM_ABORTED,                   //!< 服务器tcp_abort或对端复位，未确认的数据丢弃
+} tcp_shim_state;
+
+/**
+ * 释放所有pcb，之后tcp_close按ok返回
+ */
+void tcp_shim_init(void);
+
+/**
+ * 连接监听port的pcb，调用accept回调
+ * @return 连接，服务器拒绝时状态为TCP_SHIM_ABORTED；没有监听返回NULL
+ */
+struct tcp_pcb *tcp_shim_connect(u16_t port);
+
+/**
+ * 客户端发送数据，整段作为一个PBUF_POOL链交给recv回调，链按lwip_sim的pool_bufsize拆分
+ * @return recv回调的返回值，服务器不再接收时返回ERR_CLSD
+ */
+err_t tcp_shim_send(struct tcp_pcb *pcb, const void *data, uint32_t len);
+
+/**
+ * 客户端确认服务器已tcp_output的数据，发送缓冲区空出，数据移到收到的数据中，然后调用sent回调
+ * @param len 最多确认的长度
+ * @return 实际确认的长度
+ */
+uint32_t tcp_shim_ack(struct tcp_pcb *pcb, uint32_t len);
+
+/**
+ * 调用poll回调
+ */
+err_t tcp_shim_poll(struct tcp_pcb *pcb);
+
+/**
+ * 客户端关闭，recv回调收到NULL
+ */
+err_t tcp_shim_fin(struct tcp_pcb *pcb);
+
+/**
+ * 客户端复位，err回调收到ERR_RST，服务器不再持有pcb
+ */
+void tcp_shim_reset(struct tcp_pcb *pcb);
+
+/**
+ * 取出客户端收到的数据
+ * @param len [out] 长度
+ * @return 数据，在下一次tcp_shim_consume/tcp_shim_ack之前有效
+ */
+const uint8_t *tcp_shim_received(struct tcp_pcb *pcb, uint32_t *len);
+
+/**
+ * 丢弃收到的数据的前len字节
+ */
+void tcp_shim_consume(struct tcp_pcb *pcb, uint32_t len);
+
+tcp_shim_state tcp_shim_get_state(const struct tcp_pcb *pcb);
+
+/**
+ * 测试程序释放连接，服务器必须已经不再持有pcb
+ */
+void tcp_shim_free(struct tcp_pcb *pcb);
+
+/**
+ * 之后count次tcp_close返回ERR_MEM，用于覆盖关闭失败后重试
+ */
+void tcp_shim_fail_close(int count);
+
+/**
+ * 服务器持有的pcb数，包括监听的pcb
+ */
+int tcp_shim_pcb_count(void);
+
+#endif //TEST_TCP_SHIM_H
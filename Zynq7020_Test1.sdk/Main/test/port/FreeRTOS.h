@@ -0,0 +1,48 @@
+//
+// 主机测试用的FreeRTOS移植，任务为pthread线程，临界区和调度器挂起共用一把递归锁
+//
+
+#ifndef TEST_PORT_FREERTOS_H
+#define TEST_PORT_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE         ((BaseType_t) 0)
+#define pdTRUE          ((BaseType_t) 1)
+#define pdPASS          (pdTRUE)
+#define pdFAIL          (pdFALSE)
+#define errQUEUE_EMPTY  ((BaseType_t) 0)
+#define errQUEUE_FULL   ((BaseType_t) 0)
+
+#define portMAX_DELAY           ((TickType_t) 0xffffffffUL)
+#define configTICK_RATE_HZ      (1000)
+#define portTICK_PERIOD_MS      ((TickType_t) 1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t) (((TickType_t) (ms) * (TickType_t) configTICK_RATE_HZ) / (TickType_t) 1000))
+#define configMAX_PRIORITIES    (8)
+#define configMINIMAL_STACK_SIZE (200)
+#define configUSE_TRACE_FACILITY 0
+#define configASSERT(x)         assert(x)
+
+#define portYIELD_FROM_ISR(x)   ((void) (x))
+#define portBASE_TYPE           BaseType_t
+
+void vPortEnterCritical(void);
+void vPortExitCritical(void);
+UBaseType_t ulPortSetInterruptMask(void);
+void vPortClearInterruptMask(UBaseType_t ulNewMaskValue);
+
+#define taskENTER_CRITICAL()    vPortEnterCritical()
+#define taskEXIT_CRITICAL()     vPortExitCritical()
+#define portENTER_CRITICAL()    vPortEnterCritical()
+#define portEXIT_CRITICAL()     vPortExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR()       ulPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)    vPortClearInterruptMask(x)
+
+#endif //TEST_PORT_FREERTOS_H
@@ -0,0 +1,402 @@
+//
+// 主机测试用的FreeRTOS移植
+// 任务是pthread线程，没有优先级调度；临界区和vTaskSuspendAll共用一把递归锁，
+// 与单核上关中断/挂起调度器一样保证互斥，但不会阻止其他线程运行不相关的代码
+//
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+struct tskTaskControlBlock {
+    pthread_t thread;
+    TaskFunction_t code;
+    void *param;
+    UBaseType_t priority;
+    char name[16];
+    pthread_mutex_t notify_lock;
+    pthread_cond_t notify_cond;
+    uint32_t notify_value;
+    struct tskTaskControlBlock *next;   //!< 所有控制块串成链表，进程退出前一直可达
+};
+
+typedef enum {
+    QUEUE_TYPE_QUEUE,
+    QUEUE_TYPE_SEMAPHORE,
+    QUEUE_TYPE_RECURSIVE_MUTEX,
+} QueueType;
+
+struct QueueDefinition {
+    QueueType type;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    TaskHandle_t owner;             //!< 递归互斥锁的持有者
+    UBaseType_t depth;              //!< 递归互斥锁的嵌套深度
+    uint8_t *storage;
+};
+
+static pthread_mutex_t critical_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static __thread TaskHandle_t current_task;
+static volatile UBaseType_t task_num = 1;
+static TaskHandle_t task_list;
+static struct timespec start_time;
+static pthread_once_t start_once = PTHREAD_ONCE_INIT;
+
+static void port_start_time(void) {
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+
+static uint64_t port_now_ms(void) {
+    pthread_once(&start_once, port_start_time);
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) (now.tv_sec - start_time.tv_sec) * 1000 + (now.tv_nsec - start_time.tv_nsec) / 1000000;
+}
+
+uint64_t getTime_millis(void) {
+    return port_now_ms();
+}
+
+/**
+ * 计算等待的截止时间
+ * @return 0为不等待，1为等到deadline，2为一直等待
+ */
+static int port_deadline(TickType_t ticks, struct timespec *deadline) {
+    if (ticks == 0) return 0;
+    if (ticks == portMAX_DELAY) return 2;
+    clock_gettime(CLOCK_REALTIME, deadline);
+    uint64_t ns = deadline->tv_nsec + (uint64_t) ticks * portTICK_PERIOD_MS * 1000000;
+    deadline->tv_sec += ns / 1000000000;
+    deadline->tv_nsec = ns % 1000000000;
+    return 1;
+}
+
+/**
+ * 在cond上等待，返回0表示超时
+ */
+static int port_wait(pthread_cond_t *cond, pthread_mutex_t *lock, int mode, const struct timespec *deadline) {
+    if (mode == 0) return 0;
+    if (mode == 2) return pthread_cond_wait(cond, lock) == 0;
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+void vPortEnterCritical(void) {
+    pthread_mutex_lock(&critical_lock);
+}
+
+void vPortExitCritical(void) {
+    pthread_mutex_unlock(&critical_lock);
+}
+
+/* 屏蔽中断与临界区共用一把锁 */
+UBaseType_t ulPortSetInterruptMask(void) {
+    pthread_mutex_lock(&critical_lock);
+    return 0;
+}
+
+void vPortClearInterruptMask(UBaseType_t ulNewMaskValue) {
+    (void) ulNewMaskValue;
+    pthread_mutex_unlock(&critical_lock);
+}
+
+void vTaskSuspendAll(void) {
+    pthread_mutex_lock(&critical_lock);
+}
+
+BaseType_t xTaskResumeAll(void) {
+    pthread_mutex_unlock(&critical_lock);
+    return pdFALSE;
+}
+
+BaseType_t xTaskGetSchedulerState(void) {
+    return taskSCHEDULER_RUNNING;
+}
+
+static TaskHandle_t port_task_alloc(const char *name, UBaseType_t priority) {
+    TaskHandle_t task = calloc(1, sizeof(struct tskTaskControlBlock));
+    if (task == NULL) return NULL;
+    strncpy(task->name, name ? name : "", sizeof(task->name) - 1);
+    task->priority = priority;
+    pthread_mutex_init(&task->notify_lock, NULL);
+    pthread_cond_init(&task->notify_cond, NULL);
+    task->next = task_list;
+    while (!__atomic_compare_exchange_n(&task_list, &task->next, task, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    return task;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    // 主线程和非xTaskCreate创建的线程第一次调用时分配控制块，退出时不释放
+    if (current_task == NULL) current_task = port_task_alloc("main", 1);
+    return current_task;
+}
+
+static void *port_task_entry(void *p) {
+    TaskHandle_t task = p;
+    current_task = task;
+    task->code(task->param);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *pcName, uint32_t usStackDepth,
+                       void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask) {
+    (void) usStackDepth;
+    TaskHandle_t task = port_task_alloc(pcName, uxPriority);
+    if (task == NULL) return pdFAIL;
+    task->code = pxTaskCode;
+    task->param = pvParameters;
+    if (pthread_create(&task->thread, NULL, port_task_entry, task) != 0) return pdFAIL;
+    pthread_detach(task->thread);
+    __atomic_add_fetch(&task_num, 1, __ATOMIC_RELAXED);
+    if (pxCreatedTask) *pxCreatedTask = task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+    // 只支持任务删除自己，控制块保留，其他任务可能还持有句柄
+    if (xTaskToDelete == NULL || xTaskToDelete == current_task) {
+        __atomic_sub_fetch(&task_num, 1, __ATOMIC_RELAXED);
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t xTicksToDelay) {
+    struct timespec ts = {
+            .tv_sec = xTicksToDelay * portTICK_PERIOD_MS / 1000,
+            .tv_nsec = (long) (xTicksToDelay * portTICK_PERIOD_MS % 1000) * 1000000,
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t) (port_now_ms() / portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCountFromISR(void) {
+    return xTaskGetTickCount();
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t xTask) {
+    if (xTask == NULL) xTask = xTaskGetCurrentTaskHandle();
+    return xTask->priority;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask) {
+    (void) xTask;
+    return 0;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+    return task_num;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify) {
+    pthread_mutex_lock(&xTaskToNotify->notify_lock);
+    xTaskToNotify->notify_value++;
+    pthread_cond_signal(&xTaskToNotify->notify_cond);
+    pthread_mutex_unlock(&xTaskToNotify->notify_lock);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken) {
+    if (pxHigherPriorityTaskWoken) *pxHigherPriorityTaskWoken = pdFALSE;
+    xTaskNotifyGive(xTaskToNotify);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline;
+    int mode = port_deadline(xTicksToWait, &deadline);
+    pthread_mutex_lock(&task->notify_lock);
+    while (task->notify_value == 0) {
+        if (!port_wait(&task->notify_cond, &task->notify_lock, mode, &deadline)) break;
+    }
+    uint32_t value = task->notify_value;
+    if (value) task->notify_value = xClearCountOnExit ? 0 : value - 1;
+    pthread_mutex_unlock(&task->notify_lock);
+    return value;
+}
+
+static QueueHandle_t port_queue_create(QueueType type, UBaseType_t length, UBaseType_t item_size) {
+    QueueHandle_t q = calloc(1, sizeof(struct QueueDefinition));
+    if (q == NULL) return NULL;
+    if (item_size) {
+        q->storage = malloc(length * item_size);
+        if (q->storage == NULL) {
+            free(q);
+            return NULL;
+        }
+    }
+    q->type = type;
+    q->length = length;
+    q->item_size = item_size;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    return q;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+    return port_queue_create(QUEUE_TYPE_QUEUE, uxQueueLength, uxItemSize);
+}
+
+void vQueueDelete(QueueHandle_t xQueue) {
+    if (xQueue == NULL) return;
+    pthread_mutex_destroy(&xQueue->lock);
+    pthread_cond_destroy(&xQueue->not_empty);
+    pthread_cond_destroy(&xQueue->not_full);
+    free(xQueue->storage);
+    free(xQueue);
+}
+
+static BaseType_t port_queue_send(QueueHandle_t q, const void *item, TickType_t wait, int front) {
+    struct timespec deadline;
+    int mode = port_deadline(wait, &deadline);
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->length) {
+        if (!port_wait(&q->not_full, &q->lock, mode, &deadline)) {
+            pthread_mutex_unlock(&q->lock);
+            return errQUEUE_FULL;
+        }
+    }
+    if (q->item_size) {
+        UBaseType_t pos;
+        if (front) {
+            q->head = (q->head + q->length - 1) % q->length;
+            pos = q->head;
+        } else {
+            pos = (q->head + q->count) % q->length;
+        }
+        memcpy(q->storage + pos * q->item_size, item, q->item_size);
+    }
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait) {
+    return port_queue_send(xQueue, pvItemToQueue, xTicksToWait, 0);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait) {
+    return port_queue_send(xQueue, pvItemToQueue, xTicksToWait, 1);
+}
+
+static BaseType_t port_queue_receive(QueueHandle_t q, void *buf, TickType_t wait, int peek) {
+    struct timespec deadline;
+    int mode = port_deadline(wait, &deadline);
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0) {
+        if (!port_wait(&q->not_empty, &q->lock, mode, &deadline)) {
+            pthread_mutex_unlock(&q->lock);
+            return errQUEUE_EMPTY;
+        }
+    }
+    if (q->item_size) memcpy(buf, q->storage + q->head * q->item_size, q->item_size);
+    if (!peek) {
+        if (q->item_size) q->head = (q->head + 1) % q->length;
+        q->count--;
+        pthread_cond_signal(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait) {
+    return port_queue_receive(xQueue, pvBuffer, xTicksToWait, 0);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait) {
+    return port_queue_receive(xQueue, pvBuffer, xTicksToWait, 1);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t xQueue, const void *pvItemToQueue) {
+    pthread_mutex_lock(&xQueue->lock);
+    xQueue->count = 0;
+    xQueue->head = 0;
+    pthread_mutex_unlock(&xQueue->lock);
+    return xQueueSendToBack(xQueue, pvItemToQueue, 0);
+}
+
+BaseType_t xQueueReset(QueueHandle_t xQueue) {
+    pthread_mutex_lock(&xQueue->lock);
+    xQueue->count = 0;
+    xQueue->head = 0;
+    pthread_cond_broadcast(&xQueue->not_full);
+    pthread_mutex_unlock(&xQueue->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue) {
+    pthread_mutex_lock(&xQueue->lock);
+    UBaseType_t count = xQueue->count;
+    pthread_mutex_unlock(&xQueue->lock);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t xQueue) {
+    pthread_mutex_lock(&xQueue->lock);
+    UBaseType_t spaces = xQueue->length - xQueue->count;
+    pthread_mutex_unlock(&xQueue->lock);
+    return spaces;
+}
+
+/* 信号量是长度为计数上限、不带数据的队列，可用计数为count */
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount) {
+    QueueHandle_t q = port_queue_create(QUEUE_TYPE_SEMAPHORE, uxMaxCount, 0);
+    if (q) q->count = uxInitialCount;
+    return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+    QueueHandle_t q = port_queue_create(QUEUE_TYPE_RECURSIVE_MUTEX, 1, 0);
+    if (q) q->count = 1;
+    return q;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime) {
+    return port_queue_receive(xSemaphore, NULL, xBlockTime, 0);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore) {
+    return port_queue_send(xSemaphore, NULL, 0, 0);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t xMutex, TickType_t xBlockTime) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (xMutex->owner == self) {
+        xMutex->depth++;
+        return pdPASS;
+    }
+    if (xSemaphoreTake(xMutex, xBlockTime) != pdPASS) return pdFAIL;
+    xMutex->owner = self;
+    xMutex->depth = 1;
+    return pdPASS;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t xMutex) {
+    if (xMutex->owner != xTaskGetCurrentTaskHandle()) return pdFAIL;
+    if (--xMutex->depth) return pdPASS;
+    xMutex->owner = NULL;
+    return xSemaphoreGive(xMutex);
+}
@@ -0,0 +1,29 @@
+//
+// 主机测试用的FreeRTOS队列接口
+//
+
+#ifndef TEST_PORT_QUEUE_H
+#define TEST_PORT_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct QueueDefinition *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize);
+void vQueueDelete(QueueHandle_t xQueue);
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait);
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait);
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait);
+BaseType_t xQueueOverwrite(QueueHandle_t xQueue, const void *pvItemToQueue);
+BaseType_t xQueueReset(QueueHandle_t xQueue);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t xQueue);
+
+#define xQueueSend(q, item, wait) xQueueSendToBack(q, item, wait)
+#define xQueueSendFromISR(q, item, woken) xQueueSendToBack(q, item, 0)
+#define xQueueSendToBackFromISR(q, item, woken) xQueueSendToBack(q, item, 0)
+#define xQueueReceiveFromISR(q, buf, woken) xQueueReceive(q, buf, 0)
+#define xQueueOverwriteFromISR(q, item, woken) xQueueOverwrite(q, item)
+
+#endif //TEST_PORT_QUEUE_H
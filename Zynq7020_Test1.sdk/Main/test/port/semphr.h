@@ -0,0 +1,25 @@
+//
+// 主机测试用的FreeRTOS信号量接口
+//
+
+#ifndef TEST_PORT_SEMPHR_H
+#define TEST_PORT_SEMPHR_H
+
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t xMutex, TickType_t xBlockTime);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t xMutex);
+
+#define vSemaphoreDelete(s) vQueueDelete(s)
+#define xSemaphoreGiveFromISR(s, woken) xSemaphoreGive(s)
+#define xSemaphoreTakeFromISR(s, woken) xSemaphoreTake(s, 0)
+
+#endif //TEST_PORT_SEMPHR_H
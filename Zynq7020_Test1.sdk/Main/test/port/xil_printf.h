@@ -0,0 +1,9 @@
+#ifndef TEST_PORT_XIL_PRINTF_H
+#define TEST_PORT_XIL_PRINTF_H
+
+#include <stdio.h>
+
+/* 测试输出只保留测试程序自己的打印 */
+#define xil_printf(...) ((void) 0)
+
+#endif //TEST_PORT_XIL_PRINTF_H
@@ -0,0 +1,11 @@
+#ifndef TEST_PORT_XSCUGIC_H
+#define TEST_PORT_XSCUGIC_H
+
+#include "xil_types.h"
+
+/* 中断控制器只出现在驱动的声明中 */
+typedef struct {
+    u32 IsReady;
+} XScuGic;
+
+#endif //TEST_PORT_XSCUGIC_H
@@ -0,0 +1,7 @@
+#ifndef TEST_PORT_XSTATUS_H
+#define TEST_PORT_XSTATUS_H
+
+#define XST_SUCCESS 0L
+#define XST_FAILURE 1L
+
+#endif //TEST_PORT_XSTATUS_H
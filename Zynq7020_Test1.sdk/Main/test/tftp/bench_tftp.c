@@ -0,0 +1,81 @@
+//
+// TFTP吞吐：同一文件按不同的blksize/windowsize读写，时间为网络模拟的虚拟时间，与主机速度无关。
+// 网络为100Mbit/s、RTT 1ms，后端是内存文件，只反映协议本身的往返次数
+// 用法: bench_tftp [文件大小MiB]
+//
+
+#include "test_env.h"
+#include "tftp_client.h"
+#include "tftp_mem_backend.h"
+#include <string.h>
+
+typedef struct {
+    const char *name;
+    uint16_t blksize;
+    uint16_t windowsize;
+} bench_config;
+
+static const bench_config configs[] = {
+        {"512/1 (no options)", 0, 0},
+        {"1468/1", 1468, 1},
+        {"1468/4", 1468, 4},
+        {"1468/8", 1468, 8},
+};
+
+/**
+ * @return 虚拟时间(微秒)
+ */
+static uint64_t bench(const bench_config *cfg, int write, const uint8_t *data, uint32_t size) {
+    static const lwip_sim_link_t link = {.delay_us = 500, .rate_mbps = 100};
+    static tftp_client c;
+    lwip_sim_init(&link, 1);
+    tftp_mem_backend_init(0, 1);
+    TEST_ASSERT(tftp_init_ext(&tftp_mem_backend) == ERR_OK);
+    tftp_mem_backend_put("bench.bin", data, size);
+
+    tftp_client_opts opts = {
+            .filename = "bench.bin", .write = write, .blksize = cfg->blksize, .windowsize = cfg->windowsize,
+            .data = data, .size = size,
+    };
+    tftp_client_start(&c, 1000, &opts);
+    TEST_ASSERT(lwip_sim_run(tftp_client_finished, &c, UINT64_MAX / 1000));
+    TEST_ASSERT(c.state == TFTP_CLIENT_DONE);
+    uint64_t us = c.end_us - c.start_us;
+
+    lwip_sim_run(NULL, NULL, UINT64_MAX / 1000);
+    if (write) {
+        uint32_t len;
+        const uint8_t *got = tftp_mem_backend_get("bench.bin", &len);
+        TEST_ASSERT(got && len == size && memcmp(got, data, size) == 0);
+    } else {
+        TEST_ASSERT(c.recv_len == size && memcmp(c.recv_data, data, size) == 0);
+    }
+    tftp_client_free(&c);
+    TEST_ASSERT(lwip_sim_pbuf_count() == 0);
+    return us;
+}
+
+int main(int argc, char **argv) {
+    int mib = argc > 1 ? atoi(argv[1]) : 4;
+    if (mib < 1) mib = 1;
+    uint32_t size = (uint32_t) mib * 1024 * 1024;
+    uint8_t *data = malloc(size);
+    for (uint32_t i = 0; i < size; i++) data[i] = (uint8_t) (i * 2654435761u >> 24);
+
+    printf("tftp  %d MiB, 100 Mbit/s, RTT 1 ms  (virtual time)\n", mib);
+    printf("%-20s %10s %8s %8s %10s %8s %8s\n", "blksize/window", "read ms", "MB/s", "speedup",
+           "write ms", "MB/s", "speedup");
+    uint64_t base[2] = {0};
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        uint64_t t[2];
+        for (int w = 0; w <= 1; w++) {
+            t[w] = bench(&configs[i], w, data, size);
+            if (i == 0) base[w] = t[w];
+        }
+        printf("%-20s %10.1f %8.2f %7.1fx %10.1f %8.2f %7.1fx\n", configs[i].name,
+               t[0] / 1000.0, size / (double) t[0], (double) base[0] / t[0],
+               t[1] / 1000.0, size / (double) t[1], (double) base[1] / t[1]);
+    }
+    free(data);
+    return 0;
+}
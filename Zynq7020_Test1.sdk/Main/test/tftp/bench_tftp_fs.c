@@ -0,0 +1,123 @@
+//
+// TFTP经文件服务读写SD卡的吞吐：4个文件依次传输与同时传输，簇大小4K/32K/128K各测一遍，时间为虚拟时间。
+// 网络为100Mbit/s、RTT 1ms，blksize 1468、windowsize 8；
+// 文件服务按fs_model计时(每个请求150us，10MB/s，经过磁盘缓存的读写另加拷贝)
+// 用法: bench_tftp_fs [每个文件大小MiB]
+//
+
+#include "test_env.h"
+#include "test_fs.h"
+#include "tftp_client.h"
+#include "fs_model.h"
+#include "tftp_user.h"
+#include "tftp_server_ext.h"
+#include "FileService/FileService.h"
+#include "Fatfs_init/Fatfs_Driver.h"
+#include "DMA_Driver/DMA_Mem.h"
+#include "xstatus.h"
+#include <string.h>
+
+#define BENCH_FILES 4
+
+static const uint32_t clusters[] = {4 * 1024, 32 * 1024, 128 * 1024};
+
+static const lwip_sim_link_t link = {.delay_us = 500, .rate_mbps = 100};
+static const fs_model_params sd = {.op_us = 150, .rate_kbps = 10 * 1024, .cache_kbps = 200 * 1024};
+static tftp_client clients[BENCH_FILES];
+static uint16_t next_port = 1000;
+
+static int all_finished(void *arg) {
+    int n = *(int *) arg;
+    for (int i = 0; i < n; i++)
+        if (!tftp_client_finished(&clients[i])) return 0;
+    return 1;
+}
+
+static void file_name(char *buf, size_t size, int write, int i) {
+    snprintf(buf, size, write ? "0:/b/w%u.bin" : "0:/b/r%u.bin", (unsigned) i % 10);
+}
+
+/**
+ * 传输BENCH_FILES个文件，concurrent为0时一个结束再开始下一个
+ * @return 虚拟时间(微秒)
+ */
+static uint64_t bench(int write, int concurrent, uint8_t *const *data, uint32_t size, fs_model_stats *fs) {
+    char names[BENCH_FILES][TFTP_MAX_FILENAME_LEN + 1];
+    lwip_sim_init(&link, 1);
+    fs_model_init(&sd);
+    tftp_start();
+
+    uint64_t start = lwip_sim_now_us();
+    for (int i = 0; i < BENCH_FILES; i++) {
+        file_name(names[i], sizeof(names[i]), write, i);
+        tftp_client_opts opts = {
+                .filename = names[i], .write = write, .blksize = 1468, .windowsize = 8,
+                .data = data[i], .size = size,
+        };
+        tftp_client_start(&clients[i], next_port++, &opts);
+        if (!concurrent || i == BENCH_FILES - 1) {
+            int n = i + 1;
+            TEST_ASSERT(lwip_sim_run(all_finished, &n, UINT64_MAX / 1000));
+        }
+    }
+    uint64_t us = lwip_sim_now_us() - start;
+    fs_model_get_stats(fs);
+
+    lwip_sim_run(NULL, NULL, UINT64_MAX / 1000);
+    for (int i = 0; i < BENCH_FILES; i++) {
+        TEST_ASSERT(clients[i].state == TFTP_CLIENT_DONE);
+        if (write) {
+            size_t len;
+            uint8_t *got = test_fs_read_file(names[i], &len);
+            TEST_ASSERT(got && len == size && memcmp(got, data[i], size) == 0);
+            free(got);
+        } else {
+            TEST_ASSERT(clients[i].recv_len == size && memcmp(clients[i].recv_data, data[i], size) == 0);
+        }
+        tftp_client_free(&clients[i]);
+    }
+    TEST_ASSERT(lwip_sim_pbuf_count() == 0);
+    return us;
+}
+
+int main(int argc, char **argv) {
+    int mib = argc > 1 ? atoi(argv[1]) : 4;
+    if (mib < 1) mib = 1;
+    uint32_t size = (uint32_t) mib * 1024 * 1024;
+    test_env_init();
+    TEST_ASSERT(test_fs_format(0, TEST_VOLUME_SIZE, TEST_CLUSTER_SIZE) == FR_OK);
+    TEST_ASSERT(FileService_init() == XST_SUCCESS);
+    TEST_ASSERT(DMA_Mem_init() == XST_SUCCESS);
+    TEST_ASSERT(Fatfs_Init() == XST_SUCCESS);
+
+    uint8_t *data[BENCH_FILES];
+    for (int i = 0; i < BENCH_FILES; i++) {
+        data[i] = malloc(size);
+        for (uint32_t j = 0; j < size; j++) data[i][j] = (uint8_t) ((j + i * 7919u) * 2654435761u >> 24);
+    }
+
+    printf("tftp + FileService  %d x %d MiB, 100 Mbit/s, RTT 1 ms, 1468/8  (virtual time)\n", BENCH_FILES, mib);
+    printf("%-8s %-22s %10s %8s %12s\n", "cluster", "", "ms", "MB/s", "fs ops/MiB");
+    for (size_t c = 0; c < sizeof(clusters) / sizeof(clusters[0]); c++) {
+        /* 重新格式化，下载的源文件和上传的文件同时存在 */
+        char name[TFTP_MAX_FILENAME_LEN + 1];
+        TEST_ASSERT(test_fs_format(0, size * BENCH_FILES * 2 + TEST_VOLUME_SIZE, clusters[c]) == FR_OK);
+        TEST_ASSERT(FileService_mkdir_p("0:/b") == FR_OK);
+        for (int i = 0; i < BENCH_FILES; i++) {
+            file_name(name, sizeof(name), 0, i);
+            TEST_ASSERT(test_fs_write_file(name, data[i], size) == FR_OK);
+        }
+
+        for (int write = 0; write <= 1; write++) {
+            for (int concurrent = 0; concurrent <= 1; concurrent++) {
+                fs_model_stats fs;
+                uint64_t us = bench(write, concurrent, data, size, &fs);
+                printf("%3u KiB  %-5s %-16s %10.1f %8.2f %12.1f\n", (unsigned) (clusters[c] / 1024),
+                       write ? "write" : "read", concurrent ? "concurrent" : "one at a time", us / 1000.0,
+                       (double) size * BENCH_FILES / (double) us, fs.ops / (double) (mib * BENCH_FILES));
+            }
+        }
+    }
+    for (int i = 0; i < BENCH_FILES; i++) free(data[i]);
+    return 0;
+}
@@ -0,0 +1,122 @@
+//
+// 文件服务的耗时模型
+//
+
+#include "fs_model.h"
+#include "lwip_sim.h"
+#include "DiskCache/DiskCache.h"
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+
+#define FS_MODEL_SLOTS 32
+
+typedef struct {
+    FileService_Request *req;
+    FileService_Callback callback;
+    void *job;
+} fs_model_slot;
+
+BaseType_t __real_FileService_post(FileService_Request *req, TickType_t timeout);
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static fs_model_params params;
+static fs_model_stats stats;
+static fs_model_slot slots[FS_MODEL_SLOTS];
+static uint64_t busy_until;
+
+/**
+ * 读写的字节数，其他请求为0
+ */
+static uint32_t fs_model_io_len(const FileService_Request *req) {
+    if (req->op == FS_OP_READ || req->op == FS_OP_PREAD || req->op == FS_OP_WRITE) return req->len;
+    if (req->op != FS_OP_WRITEV) return 0;
+    const FileService_IoVec *iov = req->buf;
+    uint32_t len = 0;
+    for (UINT i = 0; i < req->len; i++) len += iov[i].len;
+    return len;
+}
+
+static uint64_t fs_model_cost(uint32_t len) {
+    uint64_t us = params.op_us + (uint64_t) len * 1000000 / ((uint64_t) params.rate_kbps * 1024);
+    if (params.cache_kbps && len && len < DISK_CACHE_BYPASS * DISK_CACHE_SECTOR_SIZE)
+        us += (uint64_t) len * 1000000 / ((uint64_t) params.cache_kbps * 1024);
+    return us;
+}
+
+static void fs_model_done(FileService_Request *req) {
+    fs_model_slot slot = {0};
+    pthread_mutex_lock(&lock);
+    for (int i = 0; i < FS_MODEL_SLOTS; i++) {
+        if (slots[i].req == req) {
+            slot = slots[i];
+            slots[i].req = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    assert(slot.req != NULL);
+
+    lwip_sim_job_wait(slot.job);
+    req->callback = slot.callback;
+    /* 回调可能释放请求 */
+    slot.callback(req);
+    lwip_sim_job_end(slot.job);
+}
+
+BaseType_t __wrap_FileService_post(FileService_Request *req, TickType_t timeout) {
+    fs_model_slot *slot = NULL;
+    pthread_mutex_lock(&lock);
+    for (int i = 0; i < FS_MODEL_SLOTS && slot == NULL; i++)
+        if (slots[i].req == NULL) slot = &slots[i];
+    assert(slot != NULL);
+    uint32_t len = fs_model_io_len(req);
+    uint64_t cost = fs_model_cost(len);
+    uint64_t start = LWIP_MAX(lwip_sim_now_us(), busy_until);
+    uint64_t done = start + cost;
+    busy_until = done;
+    stats.ops++;
+    stats.busy_us += cost;
+    if (len) {
+        stats.io_ops++;
+        stats.io_bytes += len;
+    }
+    slot->req = req;
+    slot->callback = req->callback;
+    slot->job = lwip_sim_job_begin(done);
+    req->callback = fs_model_done;
+    void *job = slot->job;
+    pthread_mutex_unlock(&lock);
+
+    BaseType_t ret = __real_FileService_post(req, timeout);
+    if (ret != pdTRUE) {
+        pthread_mutex_lock(&lock);
+        req->callback = slot->callback;
+        slot->req = NULL;
+        /* 队列满，请求没有执行 */
+        if (busy_until == done) busy_until -= cost;
+        stats.ops--;
+        stats.busy_us -= cost;
+        if (len) {
+            stats.io_ops--;
+            stats.io_bytes -= len;
+        }
+        pthread_mutex_unlock(&lock);
+        lwip_sim_job_end(job);
+    }
+    return ret;
+}
+
+void fs_model_init(const fs_model_params *p) {
+    pthread_mutex_lock(&lock);
+    params = *p;
+    memset(&stats, 0, sizeof(stats));
+    busy_until = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+void fs_model_get_stats(fs_model_stats *s) {
+    pthread_mutex_lock(&lock);
+    *s = stats;
+    pthread_mutex_unlock(&lock);
+}
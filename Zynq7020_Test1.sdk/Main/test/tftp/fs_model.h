@@ -0,0 +1,33 @@
+//
+// 文件服务的耗时模型：以-Wl,--wrap=FileService_post截获异步请求，按SD卡的耗时在lwip_sim的虚拟时钟上完成。
+// 请求在文件服务任务中照常执行，完成回调等到虚拟时间到达完成时刻才调用，
+// 请求按提交顺序串行，与文件服务任务一致
+//
+
+#ifndef TEST_FS_MODEL_H
+#define TEST_FS_MODEL_H
+
+#include "FileService/FileService.h"
+#include <stdint.h>
+
+typedef struct {
+    uint32_t op_us;             //!< 每个请求的固定耗时(命令、FatFs表项和簇链)
+    uint32_t rate_kbps;         //!< 读写速率(KB/s)
+    uint32_t cache_kbps;        //!< 短于DiskCache旁路长度的读写经过磁盘缓存多一次拷贝的速率(KB/s)，0为不计
+} fs_model_params;
+
+typedef struct {
+    uint32_t ops;               //!< 请求数
+    uint32_t io_ops;            //!< 读写请求数
+    uint64_t io_bytes;          //!< 读写字节数
+    uint64_t busy_us;           //!< 累计耗时
+} fs_model_stats;
+
+/**
+ * 设置参数并清零统计，没有请求在执行时调用
+ */
+void fs_model_init(const fs_model_params *params);
+
+void fs_model_get_stats(fs_model_stats *stats);
+
+#endif //TEST_FS_MODEL_H
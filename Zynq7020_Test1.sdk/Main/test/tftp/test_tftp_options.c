@@ -0,0 +1,256 @@
+//
+// tftp_server.c的选项协商和窗口传输：OACK内容、选项取值的限制、重复请求和对端错误，
+// 各种块长和窗口的读写逐字节比较，以及丢包、后端挂起和通知丢失时的随机传输。
+// 每项结束后等服务器的会话全部超时关闭，检查pcb、pbuf和后端句柄没有泄漏
+// 用法: test_tftp_options [随机传输次数]
+//
+
+#include "test_env.h"
+#include "tftp_client.h"
+#include "tftp_mem_backend.h"
+#include <string.h>
+
+#define TEST_FILE_MAX (256 * 1024)
+
+typedef struct {
+    lwip_sim_peer_t peer;
+    uint8_t data[1600];
+    uint16_t len;
+    u16_t port;
+    int count;
+} raw_peer;
+
+static uint8_t file_data[TEST_FILE_MAX];
+static uint32_t rand_state = 0x2545F491u;
+
+static uint32_t test_rand(void) {
+    uint32_t x = rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rand_state = x;
+}
+
+static void setup(const lwip_sim_link_t *link, uint32_t pending_ppm) {
+    lwip_sim_init(link, test_rand());
+    tftp_mem_backend_init(pending_ppm, test_rand());
+    TEST_ASSERT(tftp_init_ext(&tftp_mem_backend) == ERR_OK);
+}
+
+/* 等服务器的会话都关闭，写请求完成后的会话要等超时 */
+static void drain(void) {
+    lwip_sim_run(NULL, NULL, lwip_sim_now_us() + 600 * 1000000ull);
+    TEST_ASSERT(lwip_sim_pcb_count() == 1);
+    TEST_ASSERT(lwip_sim_pbuf_count() == 0);
+    TEST_ASSERT(tftp_mem_backend_open_count() == 0);
+}
+
+static void raw_recv(void *arg, const uint8_t *data, uint16_t len, const ip_addr_t *addr, u16_t port) {
+    raw_peer *r = arg;
+    LWIP_UNUSED_ARG(addr);
+    memcpy(r->data, data, LWIP_MIN(len, sizeof(r->data)));
+    r->len = len;
+    r->port = port;
+    r->count++;
+}
+
+static int raw_got(void *arg) {
+    raw_peer *r = arg;
+    return r->count > 0;
+}
+
+/* 发送一个报文，等待一个回复 */
+static void raw_exchange(raw_peer *r, const void *pkt, uint16_t len, u16_t port) {
+    r->count = 0;
+    lwip_sim_peer_send(&r->peer, pkt, len, port);
+    TEST_ASSERT(lwip_sim_run(raw_got, r, lwip_sim_now_us() + 1000000));
+}
+
+static uint16_t make_request(uint8_t *buf, int write, const char *name, const char *const *opts, int opt_num) {
+    buf[0] = 0;
+    buf[1] = write ? 2 : 1;
+    size_t pos = 2;
+    const char *fields[16] = {name, "octet"};
+    for (int i = 0; i < opt_num; i++) fields[2 + i] = opts[i];
+    for (int i = 0; i < 2 + opt_num; i++) {
+        strcpy((char *) buf + pos, fields[i]);
+        pos += strlen(fields[i]) + 1;
+    }
+    return (uint16_t) pos;
+}
+
+static void expect_oack(const raw_peer *r, const char *const *opts, int opt_num) {
+    TEST_ASSERT(r->data[0] == 0 && r->data[1] == 6);
+    size_t pos = 2;
+    for (int i = 0; i < opt_num; i++) {
+        TEST_ASSERT(pos < r->len && strcmp((const char *) r->data + pos, opts[i]) == 0);
+        pos += strlen(opts[i]) + 1;
+    }
+    TEST_ASSERT(pos == r->len);
+}
+
+static void raw_error(raw_peer *r) {
+    static const uint8_t err[] = {0, 5, 0, 0, 'x', 0};
+    lwip_sim_peer_send(&r->peer, err, sizeof(err), r->port);
+    lwip_sim_run(NULL, NULL, lwip_sim_now_us() + 10000);
+    TEST_ASSERT(lwip_sim_pcb_count() == 1);
+}
+
+static void test_negotiation(void) {
+    static const lwip_sim_link_t link = {.delay_us = 500, .rate_mbps = 100};
+    setup(&link, 0);
+    tftp_mem_backend_put("a.bin", file_data, 5000);
+
+    raw_peer r;
+    lwip_sim_peer_open(&r.peer, 1000, raw_recv, &r);
+    uint8_t pkt[256];
+    uint16_t len;
+
+    /* 读请求回复实际大小 */
+    static const char *const all[] = {"blksize", "1468", "windowsize", "8", "tsize", "0"};
+    static const char *const all_ack[] = {"blksize", "1468", "windowsize", "8", "tsize", "5000"};
+    len = make_request(pkt, 0, "a.bin", all, 6);
+    raw_exchange(&r, pkt, len, TFTP_PORT);
+    expect_oack(&r, all_ack, 6);
+    TEST_ASSERT(r.port != TFTP_PORT && lwip_sim_pcb_count() == 2);
+
+    /* 重复的请求重发OACK，不建立新会话 */
+    u16_t session_port = r.port;
+    raw_exchange(&r, pkt, len, TFTP_PORT);
+    expect_oack(&r, all_ack, 6);
+    TEST_ASSERT(r.port == session_port && lwip_sim_pcb_count() == 2);
+
+    /* 对端的ERROR关闭会话 */
+    raw_error(&r);
+
+    /* 超过上限的取值按上限回复 */
+    static const char *const big[] = {"blksize", "65464", "windowsize", "64"};
+    static const char *const big_ack[] = {"blksize", "1468", "windowsize", "8"};
+    len = make_request(pkt, 0, "a.bin", big, 4);
+    raw_exchange(&r, pkt, len, TFTP_PORT);
+    expect_oack(&r, big_ack, 4);
+    raw_error(&r);
+
+    /* 选项名不区分大小写，非法取值和不认识的选项不出现在OACK中 */
+    static const char *const odd[] = {"BLKSIZE", "4", "foo", "1", "WindowSize", "2"};
+    static const char *const odd_ack[] = {"windowsize", "2"};
+    len = make_request(pkt, 0, "a.bin", odd, 6);
+    raw_exchange(&r, pkt, len, TFTP_PORT);
+    expect_oack(&r, odd_ack, 2);
+    raw_error(&r);
+
+    /* 没有选项时直接发第一块 */
+    len = make_request(pkt, 0, "a.bin", NULL, 0);
+    raw_exchange(&r, pkt, len, TFTP_PORT);
+    TEST_ASSERT(r.len == 4 + 512 && r.data[1] == 3 && r.data[3] == 1);
+    TEST_ASSERT(memcmp(r.data + 4, file_data, 512) == 0);
+    raw_error(&r);
+
+    /* 写请求回显对方的tsize */
+    static const char *const wr[] = {"tsize", "12345", "blksize", "1024"};
+    static const char *const wr_ack[] = {"blksize", "1024", "tsize", "12345"};
+    len = make_request(pkt, 1, "b.bin", wr, 4);
+    raw_exchange(&r, pkt, len, TFTP_PORT);
+    expect_oack(&r, wr_ack, 4);
+    raw_error(&r);
+
+    len = make_request(pkt, 1, "b.bin", NULL, 0);
+    raw_exchange(&r, pkt, len, TFTP_PORT);
+    TEST_ASSERT(r.len == 4 && r.data[1] == 4 && r.data[3] == 0);
+    raw_error(&r);
+
+    /* 不存在的文件和过长的文件名 */
+    len = make_request(pkt, 0, "none.bin", all, 6);
+    raw_exchange(&r, pkt, len, TFTP_PORT);
+    TEST_ASSERT(r.data[1] == 5 && r.data[3] == 1);
+    len = make_request(pkt, 0, "0:/a/very/long/file/name.bin", NULL, 0);
+    raw_exchange(&r, pkt, len, TFTP_PORT);
+    TEST_ASSERT(r.data[1] == 5 && r.data[3] == 2);
+    TEST_ASSERT(lwip_sim_pcb_count() == 1);
+
+    lwip_sim_peer_close(&r.peer);
+    drain();
+}
+
+/**
+ * 运行一次传输，检查结果
+ * @return 虚拟时间(微秒)
+ */
+static uint64_t transfer(int write, uint16_t blksize, uint16_t windowsize, int tsize, uint32_t size) {
+    static tftp_client c;
+    static uint16_t port = 2000;
+    const char *name = write ? "up.bin" : "down.bin";
+    for (uint32_t i = 0; i < size; i++) file_data[i] = (uint8_t) test_rand();
+    if (!write) tftp_mem_backend_put(name, file_data, size);
+
+    tftp_client_opts opts = {
+            .filename = name, .write = write, .blksize = blksize, .windowsize = windowsize,
+            .tsize = tsize, .data = file_data, .size = size,
+    };
+    tftp_client_start(&c, port++, &opts);
+    TEST_ASSERT(lwip_sim_run(tftp_client_finished, &c, lwip_sim_now_us() + 600 * 1000000ull));
+    if (c.state != TFTP_CLIENT_DONE) {
+        fprintf(stderr, "%s %u bytes blksize %u windowsize %u: state %d error %u %s\n", write ? "write" : "read",
+                size, blksize, windowsize, c.state, c.error_code, c.error_msg);
+    }
+    TEST_ASSERT(c.state == TFTP_CLIENT_DONE);
+
+    uint16_t expect_blk = blksize >= 8 ? LWIP_MIN(blksize, TFTP_MAX_BLKSIZE) : 512;
+    uint16_t expect_win = windowsize ? LWIP_MIN(windowsize, TFTP_MAX_WINDOWSIZE) : 1;
+    TEST_ASSERT(c.blksize == expect_blk && c.windowsize == expect_win);
+    if (tsize) TEST_ASSERT(c.oack_tsize == size);
+    drain();
+    if (write) {
+        /* 服务器在数据写入后才确认最后一块，文件在会话关闭时提交 */
+        uint32_t len;
+        const uint8_t *data = tftp_mem_backend_get(name, &len);
+        TEST_ASSERT(data && len == size && memcmp(data, file_data, size) == 0);
+    } else {
+        TEST_ASSERT(c.recv_len == size && (size == 0 || memcmp(c.recv_data, file_data, size) == 0));
+    }
+    tftp_client_free(&c);
+    return c.end_us - c.start_us;
+}
+
+static void test_transfers(void) {
+    static const lwip_sim_link_t link = {.delay_us = 500, .rate_mbps = 100, .pool_bufsize = 512};
+    static const uint16_t configs[][2] = {{0, 0}, {512, 1}, {1468, 1}, {1468, 4}, {1468, 8}, {8, 3}, {1000, 0}};
+    setup(&link, 0);
+    for (size_t i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        uint16_t blk = configs[i][0] ? configs[i][0] : 512;
+        const uint32_t sizes[] = {0, 1, blk - 1u, blk, blk + 1u, blk * 8u, 100000 + 13};
+        for (size_t j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+            for (int write = 0; write <= 1; write++)
+                transfer(write, configs[i][0], configs[i][1], (int) (j & 1), sizes[j]);
+        }
+    }
+}
+
+static void test_lossy(int rounds) {
+    static const uint16_t blksizes[] = {0, 8, 512, 1024, 1468, 2000};
+    static const uint16_t windows[] = {0, 1, 2, 4, 8, 16};
+    lwip_sim_link_t link = {
+            .delay_us = 500, .rate_mbps = 100, .pool_bufsize = 512, .callback_drop_ppm = 300000,
+    };
+    setup(&link, 100000);
+    for (int i = 0; i < rounds; i++) {
+        link.loss_ppm = 20000 + test_rand() % 60000;
+        lwip_sim_set_link(&link);
+        uint16_t blk = blksizes[test_rand() % 6];
+        uint32_t size = test_rand() % (blk == 8 ? 4096 : 64 * 1024);
+        transfer(test_rand() & 1, blk, windows[test_rand() % 6], test_rand() & 1, size);
+    }
+}
+
+int main(int argc, char **argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 200;
+    test_negotiation();
+    test_transfers();
+    test_lossy(rounds);
+
+    lwip_sim_stats_t stats;
+    lwip_sim_get_stats(&stats);
+    printf("tftp options: negotiation, transfers and %d lossy rounds passed (%u lost, %u wakeups dropped)\n",
+           rounds, stats.lost, stats.callbacks_dropped);
+    return 0;
+}
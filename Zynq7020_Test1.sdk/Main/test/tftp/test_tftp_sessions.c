@@ -0,0 +1,239 @@
+//
+// tftp_user.c经文件服务读写文件：最多TFTP_MAX_SESSIONS个上传和下载同时进行，
+// 文件服务按SD卡耗时在虚拟时钟上完成(fs_model)，网络有丢包、协议栈消息丢失和PBUF_POOL链。
+// 第五个请求被拒绝，不存在的文件返回错误；客户端给出的不带卷号的文件名使目录快照失效；每轮结束后等会话全部关闭，
+// 检查pcb、pbuf、打开的文件、DMA缓冲区和会话结构体没有泄漏，上传的文件逐字节比较
+// 用法: test_tftp_sessions [轮数]
+//
+
+#include "test_env.h"
+#include "test_fs.h"
+#include "tftp_client.h"
+#include "fs_model.h"
+#include "tftp_user.h"
+#include "tftp_server_ext.h"
+#include "FileService/FileService.h"
+#include "FileService/DirSnapshot.h"
+#include "Fatfs_init/Fatfs_Driver.h"
+#include "FreeRTOS_Mem/FreeRTOS_Mem.h"
+#include "DMA_Driver/DMA_Mem.h"
+#include "xstatus.h"
+#include <string.h>
+
+#define TEST_CLIENTS    (TFTP_MAX_SESSIONS + 1)
+#define TEST_FILE_MAX   (384 * 1024)
+
+typedef struct {
+    tftp_client c;
+    char name[TFTP_MAX_FILENAME_LEN + 1];
+    uint8_t *data;
+    uint32_t size;
+    int write;
+    int expect_error;                   //!< 读不存在的文件或请求被拒绝，预期收到ERROR
+} test_session;
+
+static test_session sessions[TEST_CLIENTS];
+static int session_num;
+static uint16_t next_port = 2000;
+static uint32_t rand_state = 0x9E3779B9u;
+
+static uint32_t test_rand(void) {
+    uint32_t x = rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rand_state = x;
+}
+
+static int all_finished(void *arg) {
+    LWIP_UNUSED_ARG(arg);
+    for (int i = 0; i < session_num; i++)
+        if (!tftp_client_finished(&sessions[i].c)) return 0;
+    return 1;
+}
+
+static void setup(void) {
+    test_env_init();
+    TEST_ASSERT(DirSnapshot_init() == XST_SUCCESS);
+    TEST_ASSERT(FileService_init() == XST_SUCCESS);
+    TEST_ASSERT(DMA_Mem_init() == XST_SUCCESS);
+    TEST_ASSERT(Fatfs_Init() == XST_SUCCESS);
+    TEST_ASSERT(FileService_mkdir_p("0:/d") == FR_OK);
+}
+
+/**
+ * 重置网络和时钟，文件服务模型的忙碌时刻也要一起清零，否则新时钟上的请求排在旧的完成时刻之后
+ */
+static void start_sim(const lwip_sim_link_t *link) {
+    static const fs_model_params sd = {.op_us = 150, .rate_kbps = 10 * 1024, .cache_kbps = 200 * 1024};
+    lwip_sim_init(link, test_rand());
+    fs_model_init(&sd);
+    tftp_start();
+}
+
+/**
+ * 准备一个会话，读请求的文件在此时写入，文件服务空闲时才能直接访问文件系统
+ */
+static test_session *add_session(int write, uint32_t size) {
+    test_session *s = &sessions[session_num];
+    s->write = write;
+    s->size = size;
+    s->expect_error = 0;
+    s->data = realloc(s->data, size ? size : 1);
+    for (uint32_t i = 0; i < size; i++) s->data[i] = (uint8_t) test_rand();
+    if (write) {
+        snprintf(s->name, sizeof(s->name), "0:/u%d/w%d.bin", session_num, session_num);
+    } else {
+        snprintf(s->name, sizeof(s->name), "0:/d/r%d.bin", session_num);
+        TEST_ASSERT(test_fs_write_file(s->name, s->data, size) == FR_OK);
+    }
+    session_num++;
+    return s;
+}
+
+static void start_session(test_session *s, uint16_t blksize, uint16_t windowsize) {
+    tftp_client_opts opts = {
+            .filename = s->name, .write = s->write, .blksize = blksize, .windowsize = windowsize,
+            .tsize = (int) (test_rand() & 1), .data = s->data, .size = s->size,
+    };
+    tftp_client_start(&s->c, next_port++, &opts);
+}
+
+/* 等服务器的会话都关闭，检查泄漏，再比较结果 */
+static void finish_round(void) {
+    lwip_sim_run(NULL, NULL, lwip_sim_now_us() + 600 * 1000000ull);
+    TEST_ASSERT(lwip_sim_pcb_count() == 1);
+    TEST_ASSERT(lwip_sim_pbuf_count() == 0);
+    TEST_ASSERT(test_fs_open_files() <= 0);
+    DMA_Mem_Stats dma;
+    DMA_Mem_get_stats(&dma);
+    TEST_ASSERT(dma.used == 0);
+    os_mem_tag_stats_t tag;
+    os_mem_get_tag_stats(OS_MEM_TAG_LWIP_APPS, &tag);
+    TEST_ASSERT(tag.count == 0);
+
+    for (int i = 0; i < session_num; i++) {
+        test_session *s = &sessions[i];
+        if (s->expect_error) {
+            TEST_ASSERT(s->c.state == TFTP_CLIENT_ERROR);
+        } else if (s->write) {
+            size_t len;
+            uint8_t *got = test_fs_read_file(s->name, &len);
+            TEST_ASSERT(got && len == s->size && memcmp(got, s->data, len) == 0);
+            free(got);
+        } else {
+            TEST_ASSERT(s->c.recv_len == s->size && (s->size == 0 || memcmp(s->c.recv_data, s->data, s->size) == 0));
+        }
+        tftp_client_free(&s->c);
+    }
+    session_num = 0;
+}
+
+static void run_round(void) {
+    TEST_ASSERT(lwip_sim_run(all_finished, NULL, lwip_sim_now_us() + 3600 * 1000000ull));
+    for (int i = 0; i < session_num; i++) {
+        test_session *s = &sessions[i];
+        if (s->c.state != TFTP_CLIENT_DONE && !s->expect_error) {
+            fprintf(stderr, "%s %s %u bytes: state %d error %u %s\n", s->write ? "write" : "read", s->name,
+                    s->size, s->c.state, s->c.error_code, s->c.error_msg);
+        }
+        TEST_ASSERT(s->c.state == (s->expect_error ? TFTP_CLIENT_ERROR : TFTP_CLIENT_DONE));
+    }
+    finish_round();
+}
+
+/* 会话都被占用时新的请求返回错误，已有的传输不受影响 */
+static void test_limit(void) {
+    static const lwip_sim_link_t link = {.delay_us = 500, .rate_mbps = 100, .pool_bufsize = 512};
+    start_sim(&link);
+    for (int i = 0; i < TFTP_MAX_SESSIONS; i++) add_session(i & 1, 256 * 1024);
+    test_session *extra = add_session(0, 1000);
+    extra->expect_error = 1;
+    for (int i = 0; i < TFTP_MAX_SESSIONS; i++) start_session(&sessions[i], 512, 1);
+    lwip_sim_run(NULL, NULL, lwip_sim_now_us() + 50000);
+    start_session(extra, 0, 0);
+    TEST_ASSERT(lwip_sim_run(tftp_client_finished, &extra->c, lwip_sim_now_us() + 1000000));
+    TEST_ASSERT(extra->c.state == TFTP_CLIENT_ERROR && strcmp(extra->c.error_msg, "Too many connections") == 0);
+    for (int i = 0; i < TFTP_MAX_SESSIONS; i++)
+        TEST_ASSERT(sessions[i].c.state == TFTP_CLIENT_RUNNING);
+    run_round();
+}
+
+static int snapshot_complete(void *arg) {
+    return ((DirSnapshot *) arg)->complete;
+}
+
+/* 扫描任务经文件服务在虚拟时钟上完成，提交请求之前没有事件，lwip_sim_run会立即返回 */
+static DirSnapshot *open_snapshot(const char *dir) {
+    DirSnapshot *snap = DirSnapshot_open(dir);
+    TEST_ASSERT(snap);
+    while (!lwip_sim_run(snapshot_complete, snap, lwip_sim_now_us() + 1000)) vTaskDelay(1);
+    /* 扫描任务在最后一个请求的作业结束前就已被唤醒，等作业结束 */
+    lwip_sim_run(NULL, NULL, lwip_sim_now_us());
+    TEST_ASSERT(snap->result == FR_OK);
+    return snap;
+}
+
+/* 上传的文件名原样交给FatFs，不带卷号或以'/'开头时也要使目录快照失效 */
+static void test_snapshot(void) {
+    static const char *const names[] = {"s/a.bin", "/S//b.bin", "\\s\\c.bin"};
+    static const lwip_sim_link_t link = {.delay_us = 500, .rate_mbps = 100};
+    start_sim(&link);
+    TEST_ASSERT(FileService_mkdir_p("0:/s") == FR_OK);
+    for (uint32_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        DirSnapshot *snap = open_snapshot("0:/s");
+        TEST_ASSERT(snap->count == i);
+        test_session *s = add_session(1, 3000);
+        strcpy(s->name, names[i]);
+        start_session(s, 0, 0);
+        run_round();
+        TEST_ASSERT(snap->stale);
+        DirSnapshot_release(snap);
+    }
+    DirSnapshot *snap = open_snapshot("0:/s");
+    TEST_ASSERT(snap->count == sizeof(names) / sizeof(names[0]));
+    DirSnapshot_release(snap);
+}
+
+static void test_mixed(int rounds) {
+    static const uint16_t blksizes[] = {0, 512, 1024, 1468};
+    static const uint16_t windows[] = {0, 1, 4, 8};
+    lwip_sim_link_t link = {
+            .delay_us = 500, .rate_mbps = 100, .pool_bufsize = 512, .callback_drop_ppm = 300000,
+    };
+    start_sim(&link);
+    for (int r = 0; r < rounds; r++) {
+        link.loss_ppm = 10000 + test_rand() % 60000;
+        lwip_sim_set_link(&link);
+        int n = 1 + (int) (test_rand() % TFTP_MAX_SESSIONS);
+        for (int i = 0; i < n; i++) {
+            /* 大小覆盖空文件、不足一块和跨过多个环形缓冲区块 */
+            uint32_t size = test_rand() % 4 == 0 ? test_rand() % 2048 : test_rand() % TEST_FILE_MAX;
+            test_session *s = add_session((int) (test_rand() & 1), size);
+            if (!s->write && test_rand() % 16 == 0) {
+                strcpy(s->name, "0:/d/none.bin");
+                s->expect_error = 1;
+            }
+        }
+        for (int i = 0; i < n; i++)
+            start_session(&sessions[i], blksizes[test_rand() % 4], windows[test_rand() % 4]);
+        run_round();
+    }
+}
+
+int main(int argc, char **argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 40;
+    setup();
+    test_limit();
+    test_snapshot();
+    test_mixed(rounds);
+
+    fs_model_stats fs;
+    fs_model_get_stats(&fs);
+    lwip_sim_stats_t net;
+    lwip_sim_get_stats(&net);
+    printf("tftp sessions: limit, snapshots and %d concurrent rounds passed (%u fs requests, %u lost, %u wakeups dropped)\n",
+           rounds, fs.ops, net.lost, net.callbacks_dropped);
+    for (int i = 0; i < TEST_CLIENTS; i++) free(sessions[i].data);
+    return 0;
+}
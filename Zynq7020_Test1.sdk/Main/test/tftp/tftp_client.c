@@ -0,0 +1,275 @@
+//
+// 模拟的TFTP客户端
+//
+
+#include "tftp_client.h"
+#include "lwip/timeouts.h"
+#include "lwip/apps/tftp_opts.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TFTP_RRQ   1
+#define TFTP_WRQ   2
+#define TFTP_DATA  3
+#define TFTP_ACK   4
+#define TFTP_ERROR 5
+#define TFTP_OACK  6
+
+#define CLIENT_PACKET_MAX (4 + 65464)
+
+static void client_tmr(void *arg);
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t) (v >> 8);
+    p[1] = (uint8_t) v;
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t) (p[0] << 8 | p[1]);
+}
+
+static void client_arm(tftp_client *c) {
+    sys_untimeout(client_tmr, c);
+    lwip_sim_timeout_us(c->opts.timeout_us, client_tmr, c);
+}
+
+static void client_end(tftp_client *c, tftp_client_state state) {
+    c->state = state;
+    c->end_us = lwip_sim_now_us();
+    sys_untimeout(client_tmr, c);
+}
+
+static void client_send(tftp_client *c, const uint8_t *buf, uint16_t len) {
+    lwip_sim_peer_send(&c->peer, buf, len, c->server_port ? c->server_port : TFTP_PORT);
+}
+
+static size_t put_option(uint8_t *buf, size_t pos, const char *name, uint32_t value) {
+    return pos + sprintf((char *) buf + pos, "%s%c%u", name, 0, (unsigned) value) + 1;
+}
+
+static void send_request(tftp_client *c) {
+    uint8_t buf[256];
+    put_u16(buf, c->opts.write ? TFTP_WRQ : TFTP_RRQ);
+    size_t pos = 2 + sprintf((char *) buf + 2, "%s%c%s", c->opts.filename, 0, "octet") + 1;
+    if (c->opts.blksize) pos = put_option(buf, pos, "blksize", c->opts.blksize);
+    if (c->opts.windowsize) pos = put_option(buf, pos, "windowsize", c->opts.windowsize);
+    if (c->opts.tsize) pos = put_option(buf, pos, "tsize", c->opts.write ? c->opts.size : 0);
+    client_send(c, buf, (uint16_t) pos);
+}
+
+static void send_ack(tftp_client *c, uint32_t block) {
+    uint8_t buf[4];
+    put_u16(buf, TFTP_ACK);
+    put_u16(buf + 2, (uint16_t) block);
+    client_send(c, buf, 4);
+}
+
+/* 写: 从base开始发送一个窗口 */
+static void send_window(tftp_client *c) {
+    static uint8_t buf[CLIENT_PACKET_MAX];
+    c->last_block = c->opts.size / c->blksize + 1;
+    uint32_t end = LWIP_MIN(c->base + c->windowsize, c->last_block + 1);
+    for (uint32_t b = c->base; b < end; b++) {
+        uint32_t offset = (b - 1) * c->blksize;
+        uint32_t len = LWIP_MIN(c->opts.size - offset, c->blksize);
+        put_u16(buf, TFTP_DATA);
+        put_u16(buf + 2, (uint16_t) b);
+        memcpy(buf + 4, c->opts.data + offset, len);
+        client_send(c, buf, (uint16_t) (4 + len));
+        c->sent_blocks++;
+    }
+}
+
+static void client_tmr(void *arg) {
+    tftp_client *c = arg;
+    if (++c->retries > TFTP_CLIENT_RETRIES) {
+        client_end(c, TFTP_CLIENT_TIMEOUT);
+        return;
+    }
+    if (c->server_port == 0) {
+        send_request(c);
+    } else if (c->opts.write) {
+        send_window(c);
+    } else {
+        send_ack(c, c->base - 1);
+    }
+    lwip_sim_timeout_us(c->opts.timeout_us, client_tmr, c);
+}
+
+/**
+ * 解析OACK，只接受请求过的选项，取值不能超过请求值
+ * @return 0 成功 -1 不符合协议
+ */
+static int parse_oack(tftp_client *c, const uint8_t *data, uint16_t len) {
+    char opts[512];
+    len = (uint16_t) LWIP_MIN(len, sizeof(opts) - 1);
+    memcpy(opts, data, len);
+    opts[len] = 0;
+    char *name = opts, *end = opts + len;
+    while (name < end) {
+        char *value = name + strlen(name) + 1;
+        if (value >= end) return -1;
+        unsigned long v = strtoul(value, NULL, 10);
+        if (strcasecmp(name, "blksize") == 0) {
+            if (!c->opts.blksize || v < 8 || v > c->opts.blksize) return -1;
+            c->blksize = (uint16_t) v;
+        } else if (strcasecmp(name, "windowsize") == 0) {
+            if (!c->opts.windowsize || v < 1 || v > c->opts.windowsize) return -1;
+            c->windowsize = (uint16_t) v;
+        } else if (strcasecmp(name, "tsize") == 0) {
+            if (!c->opts.tsize) return -1;
+            c->oack_tsize = (uint32_t) v;
+        } else {
+            return -1;
+        }
+        name = value + strlen(value) + 1;
+    }
+    return 0;
+}
+
+static void recv_ack(tftp_client *c, uint16_t block) {
+    uint16_t acked = (uint16_t) (block - (uint16_t) (c->base - 1));
+    if (acked > c->windowsize) return;
+    if (acked) {
+        c->base += acked;
+        c->retries = 0;
+        if (c->base > c->last_block && c->last_block) {
+            client_end(c, TFTP_CLIENT_DONE);
+            return;
+        }
+    }
+    /* 确认了整个窗口时发下一个窗口，重复的ACK说明窗口有丢失，从确认的下一块重发 */
+    send_window(c);
+    client_arm(c);
+}
+
+static void recv_data(tftp_client *c, uint16_t block, const uint8_t *data, uint16_t len) {
+    if (len > c->blksize) {
+        client_end(c, TFTP_CLIENT_PROTOCOL);
+        return;
+    }
+    if (block != (uint16_t) c->base) {
+        /* 重复或乱序，每个缺口只确认一次最后按序的块 */
+        if (!c->gap_acked) {
+            send_ack(c, c->base - 1);
+            c->gap_acked = 1;
+            c->win_count = 0;
+        }
+        return;
+    }
+    if (c->recv_len + len > c->recv_cap) {
+        c->recv_cap = LWIP_MAX(c->recv_cap * 2, c->recv_len + len + 4096);
+        c->recv_data = realloc(c->recv_data, c->recv_cap);
+    }
+    if (len) memcpy(c->recv_data + c->recv_len, data, len);
+    c->recv_len += len;
+    c->base++;
+    c->gap_acked = 0;
+    c->retries = 0;
+    c->win_count++;
+    if (len < c->blksize) {
+        send_ack(c, block);
+        client_end(c, TFTP_CLIENT_DONE);
+        return;
+    }
+    if (c->win_count >= c->windowsize) {
+        send_ack(c, block);
+        c->win_count = 0;
+    }
+    client_arm(c);
+}
+
+static void client_recv(void *arg, const uint8_t *data, uint16_t len, const ip_addr_t *addr, u16_t port) {
+    tftp_client *c = arg;
+    LWIP_UNUSED_ARG(addr);
+    if (len < 4) return;
+    uint16_t op = get_u16(data);
+
+    if (c->server_port == 0) {
+        c->server_port = port;
+    } else if (port != c->server_port) {
+        c->foreign++;
+        return;
+    }
+
+    if (c->state != TFTP_CLIENT_RUNNING) {
+        /* 最后的ACK丢失，服务器重发了最后一块 */
+        if (c->state == TFTP_CLIENT_DONE && !c->opts.write && op == TFTP_DATA &&
+            get_u16(data + 2) == (uint16_t) (c->base - 1)) {
+            send_ack(c, c->base - 1);
+        }
+        return;
+    }
+
+    switch (op) {
+        case TFTP_OACK:
+            if (c->oack) {
+                /* 请求重发后服务器重发的OACK */
+                if (!c->opts.write && c->base == 1) send_ack(c, 0);
+                break;
+            }
+            if (c->base != 1 || parse_oack(c, data + 2, (uint16_t) (len - 2)) != 0) {
+                client_end(c, TFTP_CLIENT_PROTOCOL);
+                break;
+            }
+            c->oack = 1;
+            c->retries = 0;
+            if (c->opts.write) {
+                send_window(c);
+            } else {
+                send_ack(c, 0);
+            }
+            client_arm(c);
+            break;
+        case TFTP_ACK:
+            if (!c->opts.write) {
+                client_end(c, TFTP_CLIENT_PROTOCOL);
+                break;
+            }
+            recv_ack(c, get_u16(data + 2));
+            break;
+        case TFTP_DATA:
+            if (c->opts.write) {
+                client_end(c, TFTP_CLIENT_PROTOCOL);
+                break;
+            }
+            recv_data(c, get_u16(data + 2), data + 4, (uint16_t) (len - 4));
+            break;
+        case TFTP_ERROR:
+            c->error_code = get_u16(data + 2);
+            snprintf(c->error_msg, sizeof(c->error_msg), "%.*s", (int) (len - 4), (const char *) data + 4);
+            client_end(c, TFTP_CLIENT_ERROR);
+            break;
+        default:
+            client_end(c, TFTP_CLIENT_PROTOCOL);
+            break;
+    }
+}
+
+void tftp_client_start(tftp_client *c, u16_t port, const tftp_client_opts *opts) {
+    memset(c, 0, sizeof(*c));
+    c->opts = *opts;
+    if (c->opts.timeout_us == 0) c->opts.timeout_us = TFTP_CLIENT_TIMEOUT_US;
+    c->state = TFTP_CLIENT_RUNNING;
+    c->blksize = 512;
+    c->windowsize = 1;
+    c->oack_tsize = (uint32_t) -1;
+    c->base = 1;
+    c->start_us = lwip_sim_now_us();
+    lwip_sim_peer_open(&c->peer, port, client_recv, c);
+    send_request(c);
+    client_arm(c);
+}
+
+void tftp_client_free(tftp_client *c) {
+    sys_untimeout(client_tmr, c);
+    lwip_sim_peer_close(&c->peer);
+    free(c->recv_data);
+    c->recv_data = NULL;
+    c->recv_len = c->recv_cap = 0;
+}
+
+int tftp_client_finished(void *c) {
+    return ((tftp_client *) c)->state != TFTP_CLIENT_RUNNING;
+}
@@ -0,0 +1,75 @@
+//
+// 模拟的TFTP客户端，运行在lwip_sim的对端主机上
+// 支持blksize/windowsize/tsize选项，读写都按RFC 7440的窗口方式：
+// 写时每收到一个ACK从确认的下一块重发整个窗口，读时收满一个窗口或发现缺块时确认最后一个按序的块，
+// 超时重发上一个窗口或ACK
+//
+
+#ifndef TEST_TFTP_CLIENT_H
+#define TEST_TFTP_CLIENT_H
+
+#include "lwip_sim.h"
+
+#define TFTP_CLIENT_TIMEOUT_US  200000  //!< 默认重发超时
+#define TFTP_CLIENT_RETRIES     50
+
+typedef enum {
+    TFTP_CLIENT_RUNNING,
+    TFTP_CLIENT_DONE,
+    TFTP_CLIENT_ERROR,                  //!< 收到ERROR报文，错误码在error_code中
+    TFTP_CLIENT_TIMEOUT,                //!< 重发次数用完
+    TFTP_CLIENT_PROTOCOL,               //!< 服务器的回复不符合协议
+} tftp_client_state;
+
+typedef struct {
+    const char *filename;
+    int write;                          //!< 1 上传 0 下载
+    uint16_t blksize;                   //!< 请求的选项，0为不请求
+    uint16_t windowsize;
+    int tsize;                          //!< 请求tsize，写时带上文件大小，读时带0
+    uint32_t timeout_us;                //!< 0为TFTP_CLIENT_TIMEOUT_US
+    const uint8_t *data;                //!< 上传的内容
+    uint32_t size;
+} tftp_client_opts;
+
+typedef struct {
+    lwip_sim_peer_t peer;
+    tftp_client_opts opts;
+    tftp_client_state state;
+    u16_t server_port;                  //!< 服务器的传输端口，收到第一个回复后确定
+    uint16_t blksize;                   //!< 协商结果
+    uint16_t windowsize;
+    int oack;                           //!< 收到了OACK
+    uint32_t oack_tsize;                //!< OACK中的tsize，-1为没有
+    uint32_t base;                      //!< 写: 最早的未确认块号，读: 期望的下一块号(都不回绕)
+    uint32_t last_block;                //!< 写: 最后一块的块号
+    uint16_t win_count;                 //!< 读: 上次ACK后按序收到的块数
+    int gap_acked;                      //!< 读: 已为当前缺块发送过ACK
+    int retries;
+    uint8_t *recv_data;                 //!< 下载的内容，malloc分配
+    uint32_t recv_len;
+    uint32_t recv_cap;
+    uint16_t error_code;
+    char error_msg[64];
+    uint64_t start_us;
+    uint64_t end_us;
+    uint32_t sent_blocks;               //!< 写: 发出的数据块数，包括重发
+    uint32_t foreign;                   //!< 来自其他端口的报文数
+} tftp_client;
+
+/**
+ * 在本地端口port上开始一次传输，立即发出请求
+ */
+void tftp_client_start(tftp_client *c, u16_t port, const tftp_client_opts *opts);
+
+/**
+ * 释放下载的内容并移除对端，在此之前客户端会确认服务器重发的最后一块
+ */
+void tftp_client_free(tftp_client *c);
+
+/**
+ * 用于lwip_sim_run，c为tftp_client *
+ */
+int tftp_client_finished(void *c);
+
+#endif //TEST_TFTP_CLIENT_H
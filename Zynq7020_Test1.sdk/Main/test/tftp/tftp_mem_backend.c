@@ -0,0 +1,164 @@
+//
+// TFTP服务器的内存文件后端
+//
+
+#include "tftp_mem_backend.h"
+#include "lwip_sim.h"
+#include "lwip/timeouts.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MEM_FILES 16
+#define MEM_READY_MAX_US 2000
+
+typedef struct {
+    char name[TFTP_MAX_FILENAME_LEN + 1];
+    uint8_t *data;
+    uint32_t len;
+} mem_file;
+
+typedef struct {
+    mem_file *file;                 //!< 读请求的文件
+    char name[TFTP_MAX_FILENAME_LEN + 1];
+    uint8_t *data;                  //!< 写请求的内容，close时替换文件
+    uint32_t len;
+    uint32_t cap;
+    uint32_t pos;
+    int write;
+    int blocked;                    //!< 返回过TFTP_IO_PENDING，等待就绪
+    int flushed;
+} mem_handle;
+
+static mem_file files[MEM_FILES];
+static uint32_t pending_ppm;
+static uint32_t rand_state;
+static int open_count;
+
+static uint32_t mem_rand(void) {
+    uint32_t x = rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rand_state = x;
+}
+
+static mem_file *mem_find(const char *name) {
+    for (int i = 0; i < MEM_FILES; i++)
+        if (files[i].data && strcmp(files[i].name, name) == 0) return &files[i];
+    return NULL;
+}
+
+static void mem_ready(void *arg) {
+    mem_handle *h = arg;
+    h->blocked = 0;
+    tftp_io_ready(h);
+}
+
+/* 按概率挂起，就绪前的调用都返回挂起 */
+static int mem_pending(mem_handle *h) {
+    if (!h->blocked && pending_ppm && mem_rand() % 1000000u < pending_ppm) {
+        h->blocked = 1;
+        lwip_sim_timeout_us(mem_rand() % MEM_READY_MAX_US, mem_ready, h);
+    }
+    return h->blocked;
+}
+
+static void *mem_open(const char *fname, const char *mode, u8_t write) {
+    LWIP_UNUSED_ARG(mode);
+    mem_file *f = mem_find(fname);
+    if (!write && f == NULL) return NULL;
+    mem_handle *h = calloc(1, sizeof(mem_handle));
+    h->file = f;
+    h->write = write;
+    strncpy(h->name, fname, TFTP_MAX_FILENAME_LEN);
+    open_count++;
+    return h;
+}
+
+static void mem_close(void *handle) {
+    mem_handle *h = handle;
+    sys_untimeout(mem_ready, h);
+    if (h->write && h->flushed) tftp_mem_backend_put(h->name, h->data, h->len);
+    free(h->data);
+    free(h);
+    open_count--;
+}
+
+static int mem_read(void *handle, void *buf, int bytes) {
+    mem_handle *h = handle;
+    if (mem_pending(h)) return TFTP_IO_PENDING;
+    uint32_t len = LWIP_MIN((uint32_t) bytes, h->file->len - h->pos);
+    memcpy(buf, h->file->data + h->pos, len);
+    h->pos += len;
+    return (int) len;
+}
+
+static int mem_write(void *handle, struct pbuf *p) {
+    mem_handle *h = handle;
+    if (mem_pending(h)) return TFTP_IO_PENDING;
+    if (h->len + p->tot_len > h->cap) {
+        h->cap = LWIP_MAX(h->cap * 2, h->len + p->tot_len);
+        h->data = realloc(h->data, h->cap);
+    }
+    pbuf_copy_partial(p, h->data + h->len, p->tot_len, 0);
+    h->len += p->tot_len;
+    return p->tot_len;
+}
+
+static int mem_size(void *handle) {
+    mem_handle *h = handle;
+    if (mem_pending(h)) return TFTP_IO_PENDING;
+    return (int) h->file->len;
+}
+
+static int mem_flush(void *handle) {
+    mem_handle *h = handle;
+    if (mem_pending(h)) return TFTP_IO_PENDING;
+    h->flushed = 1;
+    return 0;
+}
+
+const struct tftp_ext_context tftp_mem_backend = {
+        .base = {
+                .open = mem_open,
+                .close = mem_close,
+                .read = mem_read,
+                .write = mem_write,
+        },
+        .size = mem_size,
+        .flush = mem_flush,
+};
+
+void tftp_mem_backend_init(uint32_t ppm, uint32_t seed) {
+    for (int i = 0; i < MEM_FILES; i++) {
+        free(files[i].data);
+        files[i].data = NULL;
+    }
+    pending_ppm = ppm;
+    rand_state = seed ? seed : 1;
+    open_count = 0;
+}
+
+void tftp_mem_backend_put(const char *name, const uint8_t *data, uint32_t len) {
+    mem_file *f = mem_find(name);
+    for (int i = 0; f == NULL && i < MEM_FILES; i++)
+        if (files[i].data == NULL) f = &files[i];
+    LWIP_ASSERT("too many files", f != NULL);
+    free(f->data);
+    /* 空文件也分配，data非NULL表示文件存在 */
+    f->data = malloc(len + 1);
+    if (len) memcpy(f->data, data, len);
+    f->len = len;
+    strncpy(f->name, name, TFTP_MAX_FILENAME_LEN);
+}
+
+const uint8_t *tftp_mem_backend_get(const char *name, uint32_t *len) {
+    mem_file *f = mem_find(name);
+    if (f == NULL) return NULL;
+    *len = f->len;
+    return f->data;
+}
+
+int tftp_mem_backend_open_count(void) {
+    return open_count;
+}
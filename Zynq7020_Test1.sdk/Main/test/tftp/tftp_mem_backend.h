@@ -0,0 +1,37 @@
+//
+// TFTP服务器的内存文件后端，用于单独测试tftp_server.c的协议处理
+// 可以按概率让read/write/size/flush返回TFTP_IO_PENDING，一段时间后调用tftp_io_ready，覆盖挂起和恢复
+//
+
+#ifndef TEST_TFTP_MEM_BACKEND_H
+#define TEST_TFTP_MEM_BACKEND_H
+
+#include "tftp_server_ext.h"
+#include <stdint.h>
+
+extern const struct tftp_ext_context tftp_mem_backend;
+
+/**
+ * 清空所有文件
+ * @param pending_ppm 每次调用返回TFTP_IO_PENDING的概率(百万分之一)
+ * @param seed 随机种子
+ */
+void tftp_mem_backend_init(uint32_t pending_ppm, uint32_t seed);
+
+/**
+ * 添加或替换文件，内容被复制
+ */
+void tftp_mem_backend_put(const char *name, const uint8_t *data, uint32_t len);
+
+/**
+ * 文件内容，写请求在close之后可见
+ * @return 不存在时返回NULL
+ */
+const uint8_t *tftp_mem_backend_get(const char *name, uint32_t *len);
+
+/**
+ * 未关闭的句柄数
+ */
+int tftp_mem_backend_open_count(void);
+
+#endif //TEST_TFTP_MEM_BACKEND_H
@@ -0,0 +1,203 @@
+//
+// 容器耗时：Array(每个元素单独分配)、List(链表)与Vector(按值连续存放)的压入、遍历和释放，
+// 四者加HashMap按id查找(udp_comm按消息id找处理函数)，以及str_split
+// 用法: bench_containers [重复次数]
+//
+
+#include "test_env.h"
+#include "Array.h"
+#include "List.h"
+#include "Vector.h"
+#include "HashMap.h"
+#include "str_tool.h"
+
+#define BENCH_ELEMENTS 100
+
+typedef struct {
+    NodeBase base;
+    uint32_t id;
+    void *fun;
+} bench_node_t;
+
+typedef struct {
+    uint32_t id;
+    void *fun;
+} bench_item_t;
+
+VECTOR_DEFINE(ItemVector, bench_item_t)
+
+HASHMAP_DEFINE(ItemMap, uint32_t, void *, hash_u32, hash_eq_u32)
+
+static volatile uintptr_t sink;
+
+static double bench_array(int repeat) {
+    uint64_t start = test_env_now_ns();
+    for (int k = 0; k < repeat; k++) {
+        Array a;
+        Array_init(&a);
+        for (uint32_t i = 0; i < BENCH_ELEMENTS; i++) {
+            bench_node_t node = {.id = i, .fun = &a};
+            TEST_ASSERT(Array_push(&a, &node, sizeof(node)));
+        }
+        for (size_t i = 0; i < a.len; i++)
+            sink += ((bench_node_t *) Array_get(&a, i))->id;
+        Array_delete(&a);
+    }
+    return (double) (test_env_now_ns() - start) / repeat;
+}
+
+static double bench_list(int repeat) {
+    uint64_t start = test_env_now_ns();
+    for (int k = 0; k < repeat; k++) {
+        List l;
+        List_init(&l);
+        for (uint32_t i = 0; i < BENCH_ELEMENTS; i++) {
+            bench_node_t node = {.id = i, .fun = &l};
+            TEST_ASSERT(List_pushBack(&l, &node, sizeof(node)));
+        }
+        for (ListNode *it = l.head; it != NULL; it = it->next)
+            sink += ((bench_node_t *) it->data)->id;
+        List_delete(&l);
+    }
+    return (double) (test_env_now_ns() - start) / repeat;
+}
+
+static double bench_vector(int repeat) {
+    uint64_t start = test_env_now_ns();
+    for (int k = 0; k < repeat; k++) {
+        ItemVector v;
+        ItemVector_init(&v);
+        for (uint32_t i = 0; i < BENCH_ELEMENTS; i++)
+            TEST_ASSERT(ItemVector_push(&v, (bench_item_t) {.id = i, .fun = &v}));
+        VECTOR_FOREACH(it, &v)
+            sink += it->id;
+        ItemVector_delete(&v);
+    }
+    return (double) (test_env_now_ns() - start) / repeat;
+}
+
+/*
+ * 按id查找：每轮查找BENCH_ELEMENTS次，id按步长37打乱，容器只建一次
+ */
+#define LOOKUP_ID(k, i) (((uint32_t) (k) + (i) * 37u) % BENCH_ELEMENTS)
+
+static double lookup_array(int repeat) {
+    Array a;
+    Array_init(&a);
+    for (uint32_t i = 0; i < BENCH_ELEMENTS; i++) {
+        bench_node_t node = {.id = i, .fun = &a};
+        TEST_ASSERT(Array_push(&a, &node, sizeof(node)));
+    }
+    uint64_t start = test_env_now_ns();
+    for (int k = 0; k < repeat; k++) {
+        for (uint32_t i = 0; i < BENCH_ELEMENTS; i++) {
+            uint32_t id = LOOKUP_ID(k, i);
+            for (size_t j = 0; j < a.len; j++) {
+                bench_node_t *node = Array_get(&a, j);
+                if (node->id == id) {
+                    sink += (uintptr_t) node->fun;
+                    break;
+                }
+            }
+        }
+    }
+    double ns = (double) (test_env_now_ns() - start) / repeat;
+    Array_delete(&a);
+    return ns;
+}
+
+static double lookup_list(int repeat) {
+    List l;
+    List_init(&l);
+    for (uint32_t i = 0; i < BENCH_ELEMENTS; i++) {
+        bench_node_t node = {.id = i, .fun = &l};
+        TEST_ASSERT(List_pushBack(&l, &node, sizeof(node)));
+    }
+    uint64_t start = test_env_now_ns();
+    for (int k = 0; k < repeat; k++) {
+        for (uint32_t i = 0; i < BENCH_ELEMENTS; i++) {
+            uint32_t id = LOOKUP_ID(k, i);
+            for (ListNode *it = l.head; it != NULL; it = it->next) {
+                bench_node_t *node = (bench_node_t *) it->data;
+                if (node->id == id) {
+                    sink += (uintptr_t) node->fun;
+                    break;
+                }
+            }
+        }
+    }
+    double ns = (double) (test_env_now_ns() - start) / repeat;
+    List_delete(&l);
+    return ns;
+}
+
+static double lookup_vector(int repeat) {
+    ItemVector v;
+    ItemVector_init(&v);
+    for (uint32_t i = 0; i < BENCH_ELEMENTS; i++)
+        TEST_ASSERT(ItemVector_push(&v, (bench_item_t) {.id = i, .fun = &v}));
+    uint64_t start = test_env_now_ns();
+    for (int k = 0; k < repeat; k++) {
+        for (uint32_t i = 0; i < BENCH_ELEMENTS; i++) {
+            uint32_t id = LOOKUP_ID(k, i);
+            VECTOR_FOREACH(it, &v) {
+                if (it->id == id) {
+                    sink += (uintptr_t) it->fun;
+                    break;
+                }
+            }
+        }
+    }
+    double ns = (double) (test_env_now_ns() - start) / repeat;
+    ItemVector_delete(&v);
+    return ns;
+}
+
+static double lookup_hashmap(int repeat) {
+    ItemMap m;
+    ItemMap_init(&m);
+    for (uint32_t i = 0; i < BENCH_ELEMENTS; i++)
+        TEST_ASSERT(ItemMap_put(&m, i, &m));
+    uint64_t start = test_env_now_ns();
+    for (int k = 0; k < repeat; k++) {
+        for (uint32_t i = 0; i < BENCH_ELEMENTS; i++) {
+            void **fun = ItemMap_find(&m, LOOKUP_ID(k, i));
+            sink += (uintptr_t) *fun;
+        }
+    }
+    double ns = (double) (test_env_now_ns() - start) / repeat;
+    ItemMap_delete(&m);
+    return ns;
+}
+
+static double bench_split(int repeat) {
+    uint64_t start = test_env_now_ns();
+    for (int k = 0; k < repeat; k++) {
+        StringList list;
+        TEST_ASSERT(str_split(&list, "0:/wave/user/2022/05/10/sin.csv", "\\/"));
+        sink += list.list.len;
+        StringList_free(&list);
+    }
+    return (double) (test_env_now_ns() - start) / repeat;
+}
+
+int main(int argc, char **argv) {
+    int repeat = argc > 1 ? atoi(argv[1]) : 200000;
+    if (repeat < 1) repeat = 1;
+
+    /* 预热分配器 */
+    bench_array(repeat / 10 + 1);
+    bench_list(repeat / 10 + 1);
+    bench_vector(repeat / 10 + 1);
+
+    printf("containers  repeat %d  (ns per round)\n", repeat);
+    printf("%d pushes + walk + delete   Array %8.0f   List %8.0f   Vector %8.0f\n", BENCH_ELEMENTS,
+           bench_array(repeat), bench_list(repeat), bench_vector(repeat));
+    int lookups = repeat / 10 + 1;
+    printf("%d lookups by id            Array %8.0f   List %8.0f   Vector %8.0f   HashMap %8.0f\n",
+           BENCH_ELEMENTS, lookup_array(lookups), lookup_list(lookups), lookup_vector(lookups),
+           lookup_hashmap(lookups));
+    printf("str_split 7 tokens          %8.0f\n", bench_split(repeat));
+    TEST_ASSERT(test_env_alloc_count() == 0);
+    return 0;
+}
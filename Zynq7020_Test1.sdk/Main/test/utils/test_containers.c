@@ -0,0 +1,198 @@
+//
+// Vector、HashMap和str_split/str_join：结构体内元素与堆内存之间的切换、删除后移、
+// 哈希表的扩容和删除后的探测链，拆分与拼接
+// os_malloc由malloc实现，越界和泄漏由ASan检查
+//
+
+#include "test_env.h"
+#include "Vector.h"
+#include "HashMap.h"
+#include "str_tool.h"
+#include <string.h>
+
+VECTOR_DEFINE(IntVector, int)
+
+VECTOR_DEFINE_INLINE(SmallVector, int, 4)
+
+HASHMAP_DEFINE(IntMap, uint32_t, int, hash_u32, hash_eq_u32)
+
+HASHMAP_DEFINE(StrMap, const char *, int, hash_str, hash_eq_str)
+
+/* 让所有键落在同一个理想位置，删除时检查探测链的后移 */
+static uint32_t hash_collide(uint32_t key) {
+    return key << 16 | 1;
+}
+
+HASHMAP_DEFINE(CollideMap, uint32_t, int, hash_collide, hash_eq_u32)
+
+static void test_vector(void) {
+    IntVector v;
+    IntVector_init(&v);
+    TEST_ASSERT(IntVector_get(&v, 0) == NULL);
+    for (int i = 0; i < 100; i++)
+        TEST_ASSERT(IntVector_push(&v, i));
+    TEST_ASSERT(v.len == 100 && v.cap >= 100);
+
+    /* 删除偶数，剩余元素保持顺序 */
+    for (size_t i = 0; i < v.len; i++)
+        TEST_ASSERT(IntVector_remove(&v, i));
+    TEST_ASSERT(v.len == 50);
+    int expect = 1;
+    VECTOR_FOREACH(it, &v) {
+        TEST_ASSERT(*it == expect);
+        expect += 2;
+    }
+    TEST_ASSERT(!IntVector_remove(&v, 50));
+
+    TEST_ASSERT(IntVector_resize(&v, 60));
+    TEST_ASSERT(*IntVector_get(&v, 49) == 99 && *IntVector_get(&v, 59) == 0);
+    TEST_ASSERT(IntVector_resize(&v, 10) && v.len == 10);
+    *IntVector_emplace(&v) = -1;
+    TEST_ASSERT(*IntVector_get(&v, 10) == -1);
+    IntVector_clear(&v);
+    TEST_ASSERT(v.len == 0 && v.data != NULL);
+    IntVector_delete(&v);
+    TEST_ASSERT(v.data == NULL && v.cap == 0);
+}
+
+static void test_vector_inline(void) {
+    SmallVector v;
+    SmallVector_init(&v);
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT(SmallVector_push(&v, i));
+    TEST_ASSERT(v.data == v.inline_buf && test_env_alloc_count() == 0);
+
+    /* 超过结构体内容量后搬到堆上，原有元素保留 */
+    TEST_ASSERT(SmallVector_push(&v, 4));
+    TEST_ASSERT(v.data != v.inline_buf && test_env_alloc_count() == 1);
+    for (int i = 0; i < 5; i++)
+        TEST_ASSERT(*SmallVector_get(&v, i) == i);
+    SmallVector_delete(&v);
+    TEST_ASSERT(v.data == v.inline_buf && v.cap == 4 && test_env_alloc_count() == 0);
+}
+
+#define TEST_MAP_KEYS 512
+
+static void test_hashmap(void) {
+    static int ref[TEST_MAP_KEYS];          //!< 0为不存在
+    uint32_t rand_state = 0x12345678u;
+    IntMap m;
+    IntMap_init(&m);
+    TEST_ASSERT(IntMap_find(&m, 1) == NULL && !IntMap_remove(&m, 1));
+
+    /* 随机插入、覆盖和删除，与数组逐项比较 */
+    size_t len = 0;
+    for (int k = 0; k < 20000; k++) {
+        rand_state = rand_state * 1664525u + 1013904223u;
+        uint32_t key = (rand_state >> 8) % TEST_MAP_KEYS;
+        if (rand_state & 0x80000000u) {
+            TEST_ASSERT(IntMap_put(&m, key, k + 1));
+            if (ref[key] == 0) len++;
+            ref[key] = k + 1;
+        } else {
+            TEST_ASSERT(IntMap_remove(&m, key) == (ref[key] != 0));
+            if (ref[key]) len--;
+            ref[key] = 0;
+        }
+        TEST_ASSERT(m.len == len && m.len <= m.cap / 4 * 3);
+    }
+    for (uint32_t key = 0; key < TEST_MAP_KEYS; key++) {
+        int *v = IntMap_find(&m, key);
+        TEST_ASSERT(ref[key] ? v && *v == ref[key] : v == NULL);
+    }
+    size_t count = 0;
+    HASHMAP_FOREACH(it, &m) {
+        TEST_ASSERT(it->key < TEST_MAP_KEYS && it->value == ref[it->key]);
+        count++;
+    }
+    TEST_ASSERT(count == len);
+    IntMap_delete(&m);
+    TEST_ASSERT(m.entries == NULL && m.cap == 0 && test_env_alloc_count() == 0);
+
+    /* 同一探测链上删除中间的键，后面的键仍能找到 */
+    CollideMap c;
+    CollideMap_init(&c);
+    for (uint32_t key = 0; key < 6; key++)
+        TEST_ASSERT(CollideMap_put(&c, key, (int) key));
+    TEST_ASSERT(CollideMap_remove(&c, 2) && CollideMap_remove(&c, 0));
+    for (uint32_t key = 0; key < 6; key++) {
+        int *v = CollideMap_find(&c, key);
+        TEST_ASSERT(key == 0 || key == 2 ? v == NULL : v && *v == (int) key);
+    }
+    CollideMap_delete(&c);
+
+    /* 字符串键按内容比较，表不复制键 */
+    StrMap s;
+    StrMap_init(&s);
+    char key[8];
+    TEST_ASSERT(StrMap_put(&s, "wave", 1) && StrMap_put(&s, "sin.csv", 2));
+    strcpy(key, "wave");
+    TEST_ASSERT(StrMap_find(&s, key) && *StrMap_find(&s, key) == 1);
+    TEST_ASSERT(StrMap_put(&s, "wave", 3) && s.len == 2 && *StrMap_find(&s, key) == 3);
+    TEST_ASSERT(StrMap_find(&s, "wav") == NULL);
+    StrMap_delete(&s);
+    TEST_ASSERT(test_env_alloc_count() == 0);
+}
+
+static void test_split(const char *str, const char *sep, int num, const char *const *tokens, int inline_str) {
+    StringList list;
+    TEST_ASSERT(str_split(&list, str, sep));
+    TEST_ASSERT((list.parent_str == list.inline_str) == inline_str);
+    TEST_ASSERT(list.list.len == (size_t) num);
+    for (int i = 0; i < num; i++)
+        TEST_ASSERT(strcmp(list.list.data[i], tokens[i]) == 0);
+    StringList_free(&list);
+    TEST_ASSERT(test_env_alloc_count() == 0);
+}
+
+static void test_str_split(void) {
+    static const char *const path[] = {"0:", "wave", "sin.csv"};
+    test_split("0:/wave/sin.csv", "\\/", 3, path, 1);
+    /* 连续分隔符视为一个 */
+    test_split("0:\\\\wave//sin.csv", "\\/", 3, path, 1);
+    /* 结尾分隔符留下一个空串 */
+    static const char *const trail[] = {"a", "b", ""};
+    test_split("a/b/", "/", 3, trail, 1);
+    static const char *const one[] = {"abc"};
+    test_split("abc", ",", 1, one, 1);
+
+    /* 长字符串和超过8个子串时使用堆内存 */
+    static const char *const many[] = {"0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11"};
+    test_split("0,1,2,3,4,5,6,7,8,9,10,11", ",", 12, many, 1);
+    char long_str[200];
+    const char *long_tokens[20];
+    char token_buf[20][8];
+    size_t len = 0;
+    for (int i = 0; i < 20; i++) {
+        snprintf(token_buf[i], sizeof(token_buf[i]), "tok%02d", i);
+        long_tokens[i] = token_buf[i];
+        len += sprintf(long_str + len, "%s%s", i ? " \t" : "", token_buf[i]);
+    }
+    test_split(long_str, " \t", 20, long_tokens, 0);
+}
+
+static void test_str_join(void) {
+    StringList list;
+    TEST_ASSERT(str_split(&list, "0:/a/b/c", "/"));
+    static const char *const expect[] = {"", "0:", "0:/a", "0:/a/b", "0:/a/b/c"};
+    for (int num = 0; num <= 4; num++) {
+        char *s = str_join(&list, num, '/');
+        TEST_ASSERT(s && strcmp(s, expect[num]) == 0);
+        os_free(s);
+    }
+    char *s = str_join(&list, 4, 0);
+    TEST_ASSERT(s && strcmp(s, "0:abc") == 0);
+    os_free(s);
+    StringList_free(&list);
+    TEST_ASSERT(test_env_alloc_count() == 0);
+}
+
+int main(void) {
+    test_vector();
+    test_vector_inline();
+    test_hashmap();
+    test_str_split();
+    test_str_join();
+    printf("utils: Vector, HashMap, str_split and str_join passed\n");
+    return 0;
+}